@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <shared_mutex>
+
+/// <summary>
+/// An index of address ranges, which maps an address back to the range that contains it.
+/// Ranges are kept sorted by their start address, so that insertion, removal and look up all take logarithmic time.
+/// Ranges may overlap (like buffers that alias the same memory), in which case look up returns the containing range with the highest start address.
+/// Every range also stores the highest end address of itself and all ranges before it, so that look up can stop as soon as no earlier range reaches the address (which keeps misses fast even when a few large ranges exist).
+/// This is thread-safe: Look ups from multiple threads can happen at the same time, while insertion and removal are exclusive.
+/// </summary>
+template <typename TValue>
+class address_range_map
+{
+public:
+	/// <summary>
+	/// Adds a range to the index.
+	/// </summary>
+	/// <param name="start">First address in the range.</param>
+	/// <param name="size">Number of bytes in the range.</param>
+	/// <param name="value">Value to associate with the range.</param>
+	void insert(uint64_t start, uint64_t size, const TValue &value)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+		auto it = _ranges.emplace(start, range { size, 0, value });
+
+		const uint64_t end = start + size;
+		it->second.max_end = (it == _ranges.begin()) ? end : std::max(std::prev(it)->second.max_end, end);
+
+		// Update the maximum end address of the following ranges, until reaching one that already extends at least as far
+		for (++it; it != _ranges.end() && it->second.max_end < end; ++it)
+			it->second.max_end = end;
+	}
+
+	/// <summary>
+	/// Removes the range with the specified start address and value from the index.
+	/// </summary>
+	/// <returns><see langword="true"/> if the range was found and removed, <see langword="false"/> otherwise.</returns>
+	bool erase(uint64_t start, const TValue &value)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+		const auto [beg, end] = _ranges.equal_range(start);
+		for (auto it = beg; it != end; ++it)
+		{
+			if (it->second.value != value)
+				continue;
+
+			it = _ranges.erase(it);
+
+			// Recompute the maximum end address of the following ranges, until reaching one that did not depend on the removed range
+			uint64_t max_end = (it == _ranges.begin()) ? 0 : std::prev(it)->second.max_end;
+			for (; it != _ranges.end(); ++it)
+			{
+				max_end = std::max(max_end, it->first + it->second.size);
+				if (max_end == it->second.max_end)
+					break;
+				it->second.max_end = max_end;
+			}
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Finds the range that contains the specified <paramref name="address"/>.
+	/// </summary>
+	/// <param name="address">Address to look up.</param>
+	/// <param name="out_value">Pointer to a variable that is set to the value associated with the range.</param>
+	/// <param name="out_offset">Pointer to a variable that is set to the offset of the address from the start of the range.</param>
+	/// <param name="out_size">Optional pointer to a variable that is set to the number of bytes in the range.</param>
+	/// <returns><see langword="true"/> if a range containing the address was found, <see langword="false"/> otherwise.</returns>
+	bool find(uint64_t address, TValue *out_value, uint64_t *out_offset, uint64_t *out_size = nullptr) const
+	{
+		const std::shared_lock<std::shared_mutex> lock(_mutex);
+
+		// Start with the range that starts closest before the address, which is the one containing it, unless ranges overlap
+		for (auto it = _ranges.upper_bound(address); it != _ranges.begin();)
+		{
+			--it;
+
+			// Neither this range nor any before it extends up to the address, so can stop searching
+			if (it->second.max_end <= address)
+				break;
+
+			const uint64_t offset = address - it->first;
+			if (offset < it->second.size)
+			{
+				*out_value = it->second.value;
+				*out_offset = offset;
+				if (out_size != nullptr)
+					*out_size = it->second.size;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Gets the number of ranges in the index.
+	/// </summary>
+	size_t size() const
+	{
+		const std::shared_lock<std::shared_mutex> lock(_mutex);
+
+		return _ranges.size();
+	}
+
+private:
+	struct range
+	{
+		uint64_t size;
+		uint64_t max_end; // Highest end address of this range and all ranges sorted before it
+		TValue value;
+	};
+
+	mutable std::shared_mutex _mutex;
+	std::multimap<uint64_t, range> _ranges;
+};
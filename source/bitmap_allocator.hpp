@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cassert>
+#include <cstdint>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+/// <summary>
+/// A lock-free allocator of slots in fixed-size pools, which keeps track of the free slots in 64-bit bitmaps.
+/// Allocation searches for a bitmap word with a free slot (starting at the word that was last allocated from or freed into) and claims the slot with a single atomic compare-and-swap, freeing a slot is a single atomic "and".
+/// Pools can be added at any time (see <see cref="add_pool"/>), but are never removed. What a slot is used for (like a descriptor in a descriptor heap) is up to the caller.
+/// The pool table is split into chunks that double in size, so that it can grow without moving pools that other threads may be accessing.
+/// </summary>
+template <uint32_t POOL_SIZE>
+class bitmap_allocator
+{
+	static_assert(POOL_SIZE != 0 && (POOL_SIZE % 64) == 0, "Pool size has to be a multiple of 64");
+
+	static constexpr uint32_t WORDS_PER_POOL = POOL_SIZE / 64;
+
+	struct pool
+	{
+		std::atomic<uint64_t> words[WORDS_PER_POOL];
+		uint64_t user_data;
+	};
+
+public:
+	/// <summary>
+	/// Gets the number of pools that were added to this allocator.
+	/// </summary>
+	uint32_t num_pools() const { return _num_pools.load(std::memory_order_acquire); }
+
+	/// <summary>
+	/// Adds a new pool with all slots free.
+	/// This may be called concurrently with <see cref="allocate"/> and <see cref="free"/>, but not with itself, so the caller has to serialize calls to this.
+	/// </summary>
+	/// <param name="user_data">Value to associate with the pool (like the address of the memory its slots refer to), which can be queried via <see cref="get_user_data"/>.</param>
+	/// <returns>Index of the new pool.</returns>
+	uint32_t add_pool(uint64_t user_data = 0)
+	{
+		const uint32_t index = _num_pools.load(std::memory_order_relaxed);
+
+		// Pools of a chunk are created all at once, when the first of them is added
+		uint32_t chunk = 0, offset = 0;
+		chunk_of_pool(index, chunk, offset);
+		if (offset == 0)
+			_chunks[chunk] = std::make_unique<pool[]>(size_t(1) << chunk);
+
+		pool &new_pool = _chunks[chunk][offset];
+		for (uint32_t i = 0; i < WORDS_PER_POOL; ++i)
+			new_pool.words[i].store(0, std::memory_order_relaxed);
+		new_pool.user_data = user_data;
+
+		// Publish the pool only after it was initialized (this also publishes the chunk it is in, since it is only accessed for pools below this count)
+		_num_pools.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	/// <summary>
+	/// Gets the value that was associated with a pool when it was added.
+	/// </summary>
+	/// <param name="pool">Index of a pool that was returned by <see cref="add_pool"/> or <see cref="allocate"/>.</param>
+	uint64_t get_user_data(uint32_t pool) const
+	{
+		assert(pool < num_pools());
+
+		return get_pool(pool).user_data;
+	}
+
+	/// <summary>
+	/// Allocates a free slot in any of the pools.
+	/// </summary>
+	/// <param name="pool">Set to the index of the pool the slot was allocated in.</param>
+	/// <param name="index">Set to the index of the slot within that pool.</param>
+	/// <returns><see langword="true"/> if a slot was allocated, or <see langword="false"/> if all slots in all pools are in use.</returns>
+	bool allocate(uint32_t &pool, uint32_t &index)
+	{
+		const uint32_t num_words = num_pools() * WORDS_PER_POOL;
+		if (num_words == 0)
+			return false;
+
+		uint32_t word_index = _hint.load(std::memory_order_relaxed);
+		if (word_index >= num_words)
+			word_index = 0;
+
+		for (uint32_t i = 0; i < num_words; ++i, word_index = (word_index + 1 < num_words) ? word_index + 1 : 0)
+		{
+			std::atomic<uint64_t> &word = get_pool(word_index / WORDS_PER_POOL).words[word_index % WORDS_PER_POOL];
+
+			// Retry on the same word as long as it has free slots, since another thread may just have claimed a different slot in it
+			for (uint64_t bits = word.load(std::memory_order_relaxed); bits != ~0ull;)
+			{
+				const uint32_t bit = index_of_lowest_bit(~bits);
+				if (word.compare_exchange_weak(bits, bits | (1ull << bit), std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					_hint.store(word_index, std::memory_order_relaxed);
+
+					pool = word_index / WORDS_PER_POOL;
+					index = (word_index % WORDS_PER_POOL) * 64 + bit;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// Frees a slot that was previously allocated via <see cref="allocate"/>.
+	/// </summary>
+	/// <param name="pool">Index of the pool the slot was allocated in.</param>
+	/// <param name="index">Index of the slot within that pool.</param>
+	void free(uint32_t pool, uint32_t index)
+	{
+		assert(pool < num_pools() && index < POOL_SIZE);
+
+		const uint64_t mask = 1ull << (index % 64);
+		[[maybe_unused]] const uint64_t bits = get_pool(pool).words[index / 64].fetch_and(~mask, std::memory_order_release);
+		assert((bits & mask) != 0); // Slot was not allocated
+
+		// Start the next search at this word, since it is now known to have a free slot
+		_hint.store(pool * WORDS_PER_POOL + index / 64, std::memory_order_relaxed);
+	}
+
+private:
+	/// <summary>
+	/// Chunk 'n' holds the '2^n' pools starting at index '2^n - 1'.
+	/// </summary>
+	static inline void chunk_of_pool(uint32_t pool, uint32_t &chunk, uint32_t &offset)
+	{
+		chunk = index_of_highest_bit(pool + 1ull);
+		offset = pool + 1 - (1u << chunk);
+	}
+
+	pool &get_pool(uint32_t index) const
+	{
+		uint32_t chunk = 0, offset = 0;
+		chunk_of_pool(index, chunk, offset);
+		return _chunks[chunk][offset];
+	}
+
+	static inline uint32_t index_of_lowest_bit(uint64_t mask)
+	{
+		assert(mask != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(mask)))
+			return index;
+		_BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+		return index + 32;
+#else
+		return __builtin_ctzll(mask);
+#endif
+	}
+	static inline uint32_t index_of_highest_bit(uint64_t mask)
+	{
+		assert(mask != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+		unsigned long index;
+		_BitScanReverse64(&index, mask);
+		return index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanReverse(&index, static_cast<unsigned long>(mask >> 32)))
+			return index + 32;
+		_BitScanReverse(&index, static_cast<unsigned long>(mask));
+		return index;
+#else
+		return 63 - __builtin_clzll(mask);
+#endif
+	}
+
+	// Enough chunks for every pool index below the maximum pool count of '2^32 - 1'
+	std::unique_ptr<pool[]> _chunks[32];
+	std::atomic<uint32_t> _num_pools = 0;
+	std::atomic<uint32_t> _hint = 0;
+};
@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+/// <summary>
+/// A hash table with open addressing that supports look ups from any number of threads without taking a lock, while other threads are adding, updating or removing entries.
+/// Keys are distributed over a fixed number of shards, each of which is a separate table that grows independently, so that writers only synchronize with other writers to the same shard rather than with the whole table.
+/// Values are read and written as a sequence of atomic words guarded by a per-entry sequence counter, so a look up only retries when it overlaps a write to the very same entry.
+/// Removed entries leave their key in place, so that probe sequences of other keys are not broken, and are reused by later insertions. Once too many entries are occupied, the shard is rehashed into a new table sized for the live entries only.
+/// Tables that were replaced are freed by the next write to the shard that happens while no look up is in progress on it, since look ups on other threads may still be reading from them until then.
+/// The key value "zero" marks empty entries, so do not use it.
+/// </summary>
+template <typename TKey, typename TValue, uint32_t NUM_SHARDS = 256>
+class concurrent_flat_map
+{
+	static_assert(std::is_integral_v<TKey> && sizeof(TKey) <= sizeof(uint64_t), "Key has to be an integer");
+	static_assert(std::is_trivially_copyable_v<TValue>, "Value has to be trivially copyable");
+	static_assert(NUM_SHARDS != 0 && (NUM_SHARDS & (NUM_SHARDS - 1)) == 0, "Number of shards has to be a power of two");
+
+	static constexpr uint32_t log2(uint32_t value) { return value > 1 ? 1 + log2(value >> 1) : 0; }
+
+	static constexpr uint32_t SHARD_BITS = log2(NUM_SHARDS);
+	static constexpr uint32_t INITIAL_CAPACITY_LOG2 = 6;
+	static constexpr size_t VALUE_WORDS = (sizeof(TValue) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+	/// <summary>
+	/// Special key indicating that the entry is empty.
+	/// </summary>
+	static constexpr TKey no_value = (TKey)0;
+
+	concurrent_flat_map()
+	{
+		for (shard &s : _shards)
+			s.current.store(s.add_table(INITIAL_CAPACITY_LOG2), std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Gets a copy of the value associated with the specified <paramref name="key"/>.
+	/// This never blocks and may be called concurrently with any other operation.
+	/// </summary>
+	/// <param name="key">Key to look up.</param>
+	/// <param name="value">Set to the value associated with the key.</param>
+	/// <returns><see langword="true"/> if the key was found, <see langword="false"/> otherwise.</returns>
+	bool find(TKey key, TValue &value) const
+	{
+		assert(key != no_value);
+
+		const uint64_t hash = hash_key(key);
+		const shard &sh = _shards[shard_index(hash)];
+
+		// Announce the look up before loading the table, so that writers do not free it while it is being read (see 'shard::reclaim_tables')
+		sh.readers.fetch_add(1, std::memory_order_seq_cst);
+
+		const table *const t = sh.current.load(std::memory_order_seq_cst);
+		const slot *const s = t->find(key, hash);
+		const bool found = s != nullptr && s->load(key, value);
+
+		sh.readers.fetch_sub(1, std::memory_order_release);
+
+		return found;
+	}
+
+	/// <summary>
+	/// Adds the specified key-value pair to the table, or replaces the value if the key already exists.
+	/// </summary>
+	/// <param name="key">Key to add.</param>
+	/// <param name="value">Value to associate with the key.</param>
+	void insert_or_assign(TKey key, const TValue &value)
+	{
+		assert(key != no_value);
+
+		const uint64_t hash = hash_key(key);
+		shard &sh = _shards[shard_index(hash)];
+
+		const std::unique_lock<std::mutex> lock(sh.mutex);
+
+		sh.reclaim_tables();
+
+		table *t = sh.current.load(std::memory_order_relaxed);
+
+		slot *removed = nullptr;
+		if (slot *const s = t->find(key, hash, &removed))
+		{
+			if (!s->valid.load(std::memory_order_relaxed))
+				t->live_count++;
+			s->store(&value);
+			return;
+		}
+
+		// Reuse the entry of a removed key in the probe sequence, which does not make the probe sequences of any other keys longer
+		if (removed != nullptr)
+		{
+			removed->store(&value, key);
+			t->live_count++;
+			return;
+		}
+
+		// Keep the fraction of occupied entries (including removed ones) below one half, so that probe sequences stay short
+		if ((t->count + 1) * 2 > t->mask + 1)
+		{
+			// Size the new table for the live entries only (with room to grow), which drops removed entries and may even shrink the table
+			uint32_t capacity_log2 = INITIAL_CAPACITY_LOG2;
+			while ((size_t(1) << capacity_log2) < (t->live_count + 1) * 4)
+				capacity_log2++;
+
+			table *const new_table = sh.add_table(capacity_log2);
+			new_table->rehash_from(*t);
+
+			// Publish the new table only after all entries were copied into it
+			sh.current.store(new_table, std::memory_order_seq_cst);
+			t = new_table;
+		}
+
+		slot &s = t->find_empty(hash);
+		s.store(&value);
+		t->count++;
+		t->live_count++;
+
+		// Publish the key only after the value was written, so that look ups never see a key without its value
+		s.key.store(static_cast<uint64_t>(key), std::memory_order_release);
+	}
+
+	/// <summary>
+	/// Removes the value associated with the specified <paramref name="key"/> from the table.
+	/// </summary>
+	/// <param name="key">Key to look up.</param>
+	/// <returns><see langword="true"/> if the key existed and was removed, <see langword="false"/> otherwise.</returns>
+	bool erase(TKey key)
+	{
+		TValue value;
+		return erase(key, value);
+	}
+	/// <summary>
+	/// Removes the value associated with the specified <paramref name="key"/> from the table.
+	/// </summary>
+	/// <param name="key">Key to look up.</param>
+	/// <param name="value">Set to the value that was associated with the key.</param>
+	/// <returns><see langword="true"/> if the key existed and was removed, <see langword="false"/> otherwise.</returns>
+	bool erase(TKey key, TValue &value)
+	{
+		if (key == no_value)
+			return false;
+
+		const uint64_t hash = hash_key(key);
+		shard &sh = _shards[shard_index(hash)];
+
+		const std::unique_lock<std::mutex> lock(sh.mutex);
+
+		sh.reclaim_tables();
+
+		table *const t = sh.current.load(std::memory_order_relaxed);
+
+		slot *const s = t->find(key, hash);
+		if (s == nullptr || !s->load(key, value))
+			return false;
+
+		// Keep the key in place, so that the probe sequences of other keys are not broken (the entry is reused by a later insertion, or dropped on the next rehash)
+		s->store(nullptr);
+		t->live_count--;
+		return true;
+	}
+
+private:
+	struct slot
+	{
+		std::atomic<uint64_t> key;
+		std::atomic<uint32_t> sequence;
+		std::atomic<uint32_t> valid;
+		std::atomic<uint64_t> words[VALUE_WORDS];
+
+		// Only called by writers, which are serialized by the shard mutex
+		// Changing the key of an entry that already has one is only allowed for a removed entry, and is guarded by the sequence counter like the value, so that look ups of the old key do not see the new value
+		void store(const TValue *value, TKey new_key = no_value)
+		{
+			const uint32_t seq = sequence.load(std::memory_order_relaxed);
+			sequence.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			if (new_key != no_value)
+				key.store(static_cast<uint64_t>(new_key), std::memory_order_relaxed);
+
+			if (value != nullptr)
+			{
+				uint64_t data[VALUE_WORDS] = {};
+				std::memcpy(data, value, sizeof(TValue));
+				for (size_t i = 0; i < VALUE_WORDS; ++i)
+					words[i].store(data[i], std::memory_order_relaxed);
+			}
+			valid.store(value != nullptr ? 1 : 0, std::memory_order_relaxed);
+
+			sequence.store(seq + 2, std::memory_order_release);
+		}
+		bool load(TKey expected_key, TValue &value) const
+		{
+			uint64_t data[VALUE_WORDS];
+			for (uint32_t seq_beg, seq_end;;)
+			{
+				// An odd sequence number means a write is in progress
+				if (seq_beg = sequence.load(std::memory_order_acquire); (seq_beg & 1) != 0)
+					continue;
+
+				for (size_t i = 0; i < VALUE_WORDS; ++i)
+					data[i] = words[i].load(std::memory_order_relaxed);
+				const bool is_valid = valid.load(std::memory_order_relaxed) != 0;
+				const bool is_same_key = key.load(std::memory_order_relaxed) == static_cast<uint64_t>(expected_key);
+
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (seq_end = sequence.load(std::memory_order_relaxed); seq_beg != seq_end)
+					continue; // The value was changed while copying it, so try again
+
+				// The entry may have been reused for a different key after the key was removed and the caller found it
+				if (!is_valid || !is_same_key)
+					return false;
+
+				std::memcpy(&value, data, sizeof(TValue));
+				return true;
+			}
+		}
+	};
+
+	struct table
+	{
+		explicit table(uint32_t capacity_log2) :
+			capacity_log2(capacity_log2),
+			mask((size_t(1) << capacity_log2) - 1),
+			slots(new slot[size_t(1) << capacity_log2])
+		{
+			// Atomics are not initialized by their default constructor
+			for (size_t i = 0; i <= mask; ++i)
+			{
+				slots[i].key.store(no_value, std::memory_order_relaxed);
+				slots[i].sequence.store(0, std::memory_order_relaxed);
+				slots[i].valid.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		size_t start_index(uint64_t hash) const
+		{
+			// Use the bits right below those that select the shard, since the lowest bits of the multiplicative hash are of poor quality
+			return static_cast<size_t>((hash << SHARD_BITS) >> (64 - capacity_log2));
+		}
+
+		slot *find(TKey key, uint64_t hash, slot **first_removed = nullptr) const
+		{
+			for (size_t i = start_index(hash);; i = (i + 1) & mask)
+			{
+				const uint64_t test_key = slots[i].key.load(std::memory_order_acquire);
+				if (test_key == static_cast<uint64_t>(key))
+					return &slots[i];
+				if (test_key == no_value)
+					return nullptr; // Load factor is always below one, so this eventually hits an empty entry
+
+				// Only writers ask for removed entries, so reading 'valid' without synchronization is fine here
+				if (first_removed != nullptr && *first_removed == nullptr && !slots[i].valid.load(std::memory_order_relaxed))
+					*first_removed = &slots[i];
+			}
+		}
+		slot &find_empty(uint64_t hash)
+		{
+			for (size_t i = start_index(hash);; i = (i + 1) & mask)
+				if (slots[i].key.load(std::memory_order_relaxed) == no_value)
+					return slots[i];
+		}
+
+		void rehash_from(const table &old)
+		{
+			for (size_t i = 0; i <= old.mask; ++i)
+			{
+				const slot &old_slot = old.slots[i];
+
+				// Drop keys of removed values
+				const uint64_t key = old_slot.key.load(std::memory_order_relaxed);
+				if (key == no_value || !old_slot.valid.load(std::memory_order_relaxed))
+					continue;
+
+				slot &s = find_empty(hash_key(static_cast<TKey>(key)));
+				for (size_t k = 0; k < VALUE_WORDS; ++k)
+					s.words[k].store(old_slot.words[k].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				s.valid.store(1, std::memory_order_relaxed);
+				s.key.store(key, std::memory_order_relaxed);
+				count++;
+				live_count++;
+			}
+		}
+
+		const uint32_t capacity_log2;
+		const size_t mask;
+		size_t count = 0; // Number of entries that have a key, including removed ones
+		size_t live_count = 0; // Number of entries that have a value
+		const std::unique_ptr<slot[]> slots;
+	};
+
+	struct alignas(64) shard
+	{
+		table *add_table(uint32_t capacity_log2)
+		{
+			return tables.emplace_back(std::make_unique<table>(capacity_log2)).get();
+		}
+
+		// Frees the tables that were replaced by the current one if no look up is in progress, which is only called by writers while holding the shard mutex
+		// A look up that still reads a replaced table has announced itself before loading the table pointer, which in turn happened before the writer replaced it, so it is seen here
+		void reclaim_tables()
+		{
+			if (tables.size() <= 1 || readers.load(std::memory_order_seq_cst) != 0)
+				return;
+
+			table *const t = current.load(std::memory_order_relaxed);
+			for (auto it = tables.begin(); it != tables.end();)
+				it = (it->get() != t) ? tables.erase(it) : std::next(it);
+		}
+
+		std::atomic<table *> current;
+		mutable std::atomic<uint32_t> readers = 0;
+		std::mutex mutex;
+		// Tables this shard used, including those that were replaced but could not be freed yet
+		std::vector<std::unique_ptr<table>> tables;
+	};
+
+	static inline uint64_t hash_key(TKey key)
+	{
+		// Fibonacci hashing, which spreads keys that only differ in their lower bits (like addresses with a fixed stride) over the upper bits
+		return static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+	}
+	static inline uint32_t shard_index(uint64_t hash)
+	{
+		return SHARD_BITS != 0 ? static_cast<uint32_t>(hash >> (64 - SHARD_BITS)) : 0;
+	}
+
+	shard _shards[NUM_SHARDS];
+};
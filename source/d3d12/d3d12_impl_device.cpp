@@ -554,10 +554,8 @@ void reshade::d3d12::device_impl::destroy_resource_view(api::resource_view handl
 
 	D3D12_CPU_DESCRIPTOR_HANDLE descriptor_handle = { static_cast<SIZE_T>(handle.handle) };
 
-	const std::unique_lock<std::shared_mutex> lock(_resource_mutex);
-
-	const auto iter = _views.find(descriptor_handle.ptr);
-	if (iter != _views.end() && (iter->second.second.flags & api::resource_view_flags::shader_visible) != 0)
+	// Remove the view before freeing its descriptor, since another thread may allocate the same descriptor for a new view as soon as it is freed, which this would then remove again
+	if (view_info info; _views.erase(descriptor_handle.ptr, info) && (info.desc.flags & api::resource_view_flags::shader_visible) != 0)
 	{
 		D3D12_GPU_DESCRIPTOR_HANDLE handle_gpu;
 		_gpu_view_heap.convert_handle(descriptor_handle, handle_gpu);
@@ -571,7 +569,6 @@ void reshade::d3d12::device_impl::destroy_resource_view(api::resource_view handl
 		for (UINT i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
 			_view_heaps[i].free(descriptor_handle);
 	}
-	_views.erase(descriptor_handle.ptr);	
 }
 
 reshade::api::resource reshade::d3d12::device_impl::get_resource_from_view(api::resource_view view) const
@@ -580,10 +577,8 @@ reshade::api::resource reshade::d3d12::device_impl::get_resource_from_view(api::
 
 	D3D12_CPU_DESCRIPTOR_HANDLE descriptor_handle = { static_cast<SIZE_T>(view.handle) };
 
-	const std::shared_lock<std::shared_mutex> lock(_resource_mutex);
-
-	if (const auto it = _views.find(descriptor_handle.ptr); it != _views.end())
-		return to_handle(it->second.first);
+	if (view_info info; _views.find(descriptor_handle.ptr, info))
+		return to_handle(info.resource);
 	else
 		return assert(false), api::resource { 0 };
 }
@@ -593,10 +588,8 @@ reshade::api::resource_view_desc reshade::d3d12::device_impl::get_resource_view_
 
 	D3D12_CPU_DESCRIPTOR_HANDLE descriptor_handle = { static_cast<SIZE_T>(view.handle) };
 
-	const std::shared_lock<std::shared_mutex> lock(_resource_mutex);
-
-	if (const auto it = _views.find(descriptor_handle.ptr); it != _views.end())
-		return it->second.second;
+	if (view_info info; _views.find(descriptor_handle.ptr, info))
+		return info.desc;
 	else
 		return assert(false), api::resource_view_desc();
 }
@@ -607,9 +600,7 @@ uint32_t reshade::d3d12::device_impl::get_resource_view_descriptor_index(api::re
 
 	D3D12_CPU_DESCRIPTOR_HANDLE descriptor_handle = { static_cast<SIZE_T>(view.handle) };
 
-	const std::shared_lock<std::shared_mutex> lock(_resource_mutex);
-	const auto iter = _views.find(descriptor_handle.ptr);
-	if (iter != _views.end() && (iter->second.second.flags & api::resource_view_flags::shader_visible) != 0)
+	if (view_info info; _views.find(descriptor_handle.ptr, info) && (info.desc.flags & api::resource_view_flags::shader_visible) != 0)
 	{
 		D3D12_GPU_DESCRIPTOR_HANDLE handle_gpu;
 		_gpu_view_heap.convert_handle(descriptor_handle, handle_gpu);
@@ -1206,6 +1197,12 @@ bool reshade::d3d12::device_impl::allocate_descriptor_sets(uint32_t count, api::
 				!_gpu_view_heap.allocate_static(total_count, base_handle, base_handle_gpu) :
 				!_gpu_sampler_heap.allocate_static(total_count, base_handle, base_handle_gpu))
 			{
+				// Report the state of the heap, to tell apart a heap that is full from one that is too fragmented to fit the descriptor set
+				if (heap_type != D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER)
+					LOG(ERROR) << "Failed to allocate " << total_count << " descriptor(s) in the shader resource view heap (" << _gpu_view_heap.get_static_free_count() << " free, largest free block " << _gpu_view_heap.get_static_largest_free_block() << ", fragmentation " << _gpu_view_heap.get_static_fragmentation() << ")!";
+				else
+					LOG(ERROR) << "Failed to allocate " << total_count << " descriptor(s) in the sampler heap (" << _gpu_sampler_heap.get_static_free_count() << " free, largest free block " << _gpu_sampler_heap.get_static_largest_free_block() << ", fragmentation " << _gpu_sampler_heap.get_static_fragmentation() << ")!";
+
 				free_descriptor_sets(count - i - 1, out_sets);
 				goto exit_failure;
 			}
@@ -1449,11 +1446,9 @@ void reshade::d3d12::device_impl::register_resource(ID3D12Resource *resource)
 	if (const D3D12_RESOURCE_DESC desc = resource->GetDesc();
 		desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
 	{
-		const std::unique_lock<std::shared_mutex> lock(_resource_mutex);
-
 		const D3D12_GPU_VIRTUAL_ADDRESS address = resource->GetGPUVirtualAddress();
 		if (address != 0)
-			_buffer_gpu_addresses.emplace_back(resource, D3D12_GPU_VIRTUAL_ADDRESS_RANGE { address, desc.Width });
+			_buffer_gpu_addresses.insert(address, desc.Width, resource);
 	}
 #endif
 }
@@ -1465,24 +1460,9 @@ void reshade::d3d12::device_impl::unregister_resource(ID3D12Resource *resource)
 	if (const D3D12_RESOURCE_DESC desc = resource->GetDesc();
 		desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
 	{
-		const std::unique_lock<std::shared_mutex> lock(_resource_mutex);
-
-		const auto it = std::find_if(_buffer_gpu_addresses.begin(), _buffer_gpu_addresses.end(), [resource](const auto &buffer_info) { return buffer_info.first == resource; });
-		if (it != _buffer_gpu_addresses.end())
-			_buffer_gpu_addresses.erase(it);
-	}
-#endif
-
-#if 0
-	const std::unique_lock<std::shared_mutex> lock(_resource_mutex);
-
-	// Remove all views that referenced this resource
-	for (auto it = _views.begin(); it != _views.end();)
-	{
-		if (it->second.first == resource)
-			it = _views.erase(it);
-		else
-			++it;
+		const D3D12_GPU_VIRTUAL_ADDRESS address = resource->GetGPUVirtualAddress();
+		if (address != 0)
+			_buffer_gpu_addresses.erase(address, resource);
 	}
 #endif
 }
@@ -1546,20 +1526,11 @@ bool reshade::d3d12::device_impl::resolve_gpu_address(D3D12_GPU_VIRTUAL_ADDRESS
 	if (!address)
 		return true;
 
-	const std::shared_lock<std::shared_mutex> lock(_resource_mutex);
-
-	for (const auto &buffer_info : _buffer_gpu_addresses)
+	// The index has its own lock, so this does not contend with resource view registration
+	if (ID3D12Resource *resource = nullptr;
+		_buffer_gpu_addresses.find(address, &resource, &out_buffer_range->offset, &out_buffer_range->size))
 	{
-		if (address < buffer_info.second.StartAddress)
-			continue;
-
-		const UINT64 address_offset = address - buffer_info.second.StartAddress;
-		if (address_offset >= buffer_info.second.SizeInBytes)
-			continue;
-
-		out_buffer_range->buffer = to_handle(buffer_info.first);
-		out_buffer_range->offset = address_offset;
-		out_buffer_range->size = buffer_info.second.SizeInBytes;
+		out_buffer_range->buffer = to_handle(resource);
 		return true;
 	}
 
@@ -1572,9 +1543,19 @@ void reshade::d3d12::device_impl::register_descriptor_heap(D3D12DescriptorHeap *
 	const auto it = _descriptor_heaps.push_back(heap);
 
 	heap->initialize_descriptor_base_handle(std::distance(_descriptor_heaps.begin(), it));
+
+	// Keep track of the GPU handle range of shader visible heaps, so that GPU descriptor handles can be mapped back to the heap they belong to without querying every heap
+	if (heap->_orig_base_gpu_handle.ptr != 0)
+	{
+		const D3D12_DESCRIPTOR_HEAP_DESC desc = heap->_orig->GetDesc();
+		_descriptor_heap_gpu_ranges.insert(heap->_orig_base_gpu_handle.ptr, static_cast<uint64_t>(desc.NumDescriptors) * _descriptor_handle_size[desc.Type], heap);
+	}
 }
 void reshade::d3d12::device_impl::unregister_descriptor_heap(D3D12DescriptorHeap *heap)
 {
+	if (heap->_orig_base_gpu_handle.ptr != 0)
+		_descriptor_heap_gpu_ranges.erase(heap->_orig_base_gpu_handle.ptr, heap);
+
 	size_t num_heaps = _descriptor_heaps.size();
 
 	for (size_t heap_index = 0; heap_index < num_heaps; ++heap_index)
@@ -1647,17 +1628,12 @@ void D3D12DescriptorHeap::initialize_descriptor_base_handle(size_t heap_index)
 reshade::api::descriptor_set reshade::d3d12::device_impl::convert_to_descriptor_set(D3D12_GPU_DESCRIPTOR_HANDLE handle, uint8_t extra_data) const
 {
 #if RESHADE_ADDON && !RESHADE_ADDON_LITE
-	for (D3D12DescriptorHeap *const heap : _descriptor_heaps)
+	D3D12DescriptorHeap *heap = nullptr;
+	uint64_t offset = 0;
+	if (_descriptor_heap_gpu_ranges.find(handle.ptr, &heap, &offset))
 	{
-		if (heap == nullptr || handle.ptr < heap->_orig_base_gpu_handle.ptr)
-			continue;
-
-		D3D12_DESCRIPTOR_HEAP_DESC desc = heap->_orig->GetDesc();
-		if (handle.ptr >= offset_descriptor_handle(heap->_orig_base_gpu_handle, desc.NumDescriptors, desc.Type).ptr)
-			continue;
-
 		D3D12_CPU_DESCRIPTOR_HANDLE handle_cpu = { 0 };
-		handle_cpu.ptr = heap->_internal_base_cpu_handle.ptr + static_cast<SIZE_T>(handle.ptr - heap->_orig_base_gpu_handle.ptr);
+		handle_cpu.ptr = heap->_internal_base_cpu_handle.ptr + static_cast<SIZE_T>(offset);
 
 		return convert_to_descriptor_set(handle_cpu, extra_data);
 	}
@@ -7,6 +7,8 @@
 
 #include "addon_manager.hpp"
 #include "descriptor_heap.hpp"
+#include "address_range_map.hpp"
+#include "concurrent_flat_map.hpp"
 #include <unordered_map>
 #include <concurrent_vector.h>
 #include <dxgi.h>
@@ -139,15 +141,12 @@ namespace reshade::d3d12
 
 		inline void register_resource_view(D3D12_CPU_DESCRIPTOR_HANDLE handle, ID3D12Resource *resource, const api::resource_view_desc &desc)
 		{
-			const std::unique_lock<std::shared_mutex> lock(_resource_mutex);
-			_views.insert_or_assign(handle.ptr, std::make_pair(resource, desc));
+			_views.insert_or_assign(handle.ptr, { resource, desc });
 		}
 		inline void register_resource_view(D3D12_CPU_DESCRIPTOR_HANDLE handle, D3D12_CPU_DESCRIPTOR_HANDLE source_handle)
 		{
-			const std::unique_lock<std::shared_mutex> lock(_resource_mutex);
-
-			if (const auto it = _views.find(source_handle.ptr); it != _views.end())
-				_views.insert_or_assign(handle.ptr, it->second);
+			if (view_info info; _views.find(source_handle.ptr, info))
+				_views.insert_or_assign(handle.ptr, info);
 			else
 				assert(false);
 		}
@@ -155,6 +154,12 @@ namespace reshade::d3d12
 		void init_allocator();
 
 	private:
+		struct view_info
+		{
+			ID3D12Resource *resource;
+			api::resource_view_desc desc;
+		};
+
 		std::vector<command_queue_impl *> _queues;
 
 		UINT _descriptor_handle_size[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
@@ -163,12 +168,13 @@ namespace reshade::d3d12
 		descriptor_heap_gpu<D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 128, 128> _gpu_sampler_heap;
 		descriptor_heap_gpu<D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 50000, 2048> _gpu_view_heap;
 
-		mutable std::shared_mutex _resource_mutex;
 #if RESHADE_ADDON && !RESHADE_ADDON_LITE
 		concurrency::concurrent_vector<D3D12DescriptorHeap *> _descriptor_heaps;
-		std::vector<std::pair<ID3D12Resource *, D3D12_GPU_VIRTUAL_ADDRESS_RANGE>> _buffer_gpu_addresses; // TODO: Replace with interval tree
+		address_range_map<ID3D12Resource *> _buffer_gpu_addresses;
+		address_range_map<D3D12DescriptorHeap *> _descriptor_heap_gpu_ranges;
 #endif
-		std::unordered_map<SIZE_T, std::pair<ID3D12Resource *, api::resource_view_desc>> _views;
+		// Views are looked up by their CPU descriptor handle, which happens from many threads at once, so use a table that does not need a lock for that
+		concurrent_flat_map<SIZE_T, view_info> _views;
 		std::unordered_map<ID3D12Resource *, D3D12MA::Allocation*> _alloc_map;
 
 		com_ptr<ID3D12PipelineState> _mipmap_pipeline;
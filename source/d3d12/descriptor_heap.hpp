@@ -7,22 +7,26 @@
 
 #include <vector>
 #include <cassert>
+#include <mutex>
 #include <shared_mutex>
 #include <d3d12.h>
 #include "com_ptr.hpp"
+#include "bitmap_allocator.hpp"
+#include "concurrent_flat_map.hpp"
+#include "tlsf_allocator.hpp"
 
 namespace reshade::d3d12
 {
 	class descriptor_heap_cpu
 	{
-		struct heap_info
+		struct heap_range
 		{
-			com_ptr<ID3D12DescriptorHeap> heap;
-			std::vector<bool> state;
-			SIZE_T heap_base = 0;
+			SIZE_T heap_base;
+			uint32_t pool;
 		};
 
-		const UINT pool_size = 1024;
+		// Descriptors are allocated from heaps of a fixed size, which are created on demand
+		static constexpr UINT pool_size = 1024;
 
 	public:
 		descriptor_heap_cpu(ID3D12Device *device, D3D12_DESCRIPTOR_HEAP_TYPE type) :
@@ -33,80 +37,68 @@ namespace reshade::d3d12
 
 		bool allocate(D3D12_CPU_DESCRIPTOR_HANDLE &handle)
 		{
-			const std::unique_lock<std::shared_mutex> lock(_mutex);
-
-			for (int attempt = 0; attempt < 2; ++attempt)
+			uint32_t pool = 0, index = 0;
+			for (uint32_t num_pools = _allocator.num_pools(); !_allocator.allocate(pool, index); num_pools = _allocator.num_pools())
 			{
-				for (heap_info &heap_info : _heap_infos)
-				{
-					// Find free empty in the heap
-					if (const auto it = std::find(heap_info.state.begin(), heap_info.state.end(), false);
-						it != heap_info.state.end())
-					{
-						const size_t index = it - heap_info.state.begin();
-						heap_info.state[index] = true; // Mark this entry as being in use
-
-						handle.ptr = heap_info.heap_base + index * _increment_size;
-						return true;
-					}
-				}
-
-				// No more space available in the existing heaps, so create a new one and try again
-				if (!allocate_heap())
-					break;
+				// No more space available in the existing heaps, so create a new one and try again (unless another thread already did so in the meantime)
+				const std::unique_lock<std::mutex> lock(_heap_mutex);
+
+				if (_allocator.num_pools() == num_pools && !allocate_heap())
+					return false;
 			}
 
-			return false;
+			handle.ptr = static_cast<SIZE_T>(_allocator.get_user_data(pool)) + index * _increment_size;
+			return true;
 		}
 
 		void free(D3D12_CPU_DESCRIPTOR_HANDLE handle)
 		{
-			const std::unique_lock<std::shared_mutex> lock(_mutex);
-
-			for (heap_info &heap_info : _heap_infos)
-			{
-				const SIZE_T heap_beg = heap_info.heap_base;
-				const SIZE_T heap_end = heap_info.heap_base + pool_size * _increment_size;
+			const SIZE_T heap_span = pool_size * _increment_size;
+			const SIZE_T block = handle.ptr / heap_span;
 
-				if (handle.ptr >= heap_beg && handle.ptr < heap_end)
-				{
-					const SIZE_T index = (handle.ptr - heap_beg) / _increment_size;
+			// Heaps are indexed by the block of 'heap_span' bytes their base falls into (offset by one, since zero is not a valid key)
+			// Heaps do not overlap, so at most one starts in each block and the one containing the handle has to start in the same block as it or the one before
+			heap_range range;
+			if ((!_heap_ranges.find(block + 1, range) || handle.ptr < range.heap_base) && (block == 0 || !_heap_ranges.find(block, range)))
+				return;
+			if (handle.ptr < range.heap_base || handle.ptr - range.heap_base >= heap_span)
+				return; // Handle does not belong to this allocator
 
-					// Mark free slot in the descriptor heap
-					heap_info.state[index] = false;
-					break;
-				}
-			}
+			// Mark free slot in the descriptor heap
+			_allocator.free(range.pool, static_cast<uint32_t>((handle.ptr - range.heap_base) / _increment_size));
 		}
 
 	private:
 		bool allocate_heap()
 		{
-			heap_info &heap_info = _heap_infos.emplace_back();
-
 			D3D12_DESCRIPTOR_HEAP_DESC desc;
 			desc.Type = _type;
 			desc.NumDescriptors = pool_size;
 			desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 			desc.NodeMask = 0;
 
-			if (FAILED(_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap_info.heap))))
-			{
-				_heap_infos.pop_back();
+			com_ptr<ID3D12DescriptorHeap> heap;
+			if (FAILED(_device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap))))
 				return false;
-			}
 
-			heap_info.heap_base = heap_info.heap->GetCPUDescriptorHandleForHeapStart().ptr;
-			heap_info.state.resize(pool_size);
+			const SIZE_T heap_base = heap->GetCPUDescriptorHandleForHeapStart().ptr;
+			_heaps.push_back(std::move(heap));
+
+			// Add the heap to the look up used by 'free' before making its descriptors available, so that they can be freed as soon as they were allocated
+			const uint32_t pool = _allocator.num_pools();
+			_heap_ranges.insert_or_assign(heap_base / (pool_size * _increment_size) + 1, heap_range { heap_base, pool });
+			_allocator.add_pool(heap_base);
 
 			return true;
 		}
 
 		ID3D12Device *const _device;
-		std::vector<heap_info> _heap_infos;
+		std::vector<com_ptr<ID3D12DescriptorHeap>> _heaps;
+		bitmap_allocator<pool_size> _allocator;
+		concurrent_flat_map<SIZE_T, heap_range, 16> _heap_ranges;
 		SIZE_T _increment_size;
 		D3D12_DESCRIPTOR_HEAP_TYPE _type;
-		std::shared_mutex _mutex;
+		std::mutex _heap_mutex;
 	};
 
 	template <D3D12_DESCRIPTOR_HEAP_TYPE type, UINT static_size, UINT transient_size>
@@ -140,32 +132,17 @@ namespace reshade::d3d12
 
 			const std::unique_lock<std::shared_mutex> lock(_mutex);
 
-			// First try to allocate from the list of freed blocks
-			for (auto block = _free_list.begin(); block != _free_list.end(); ++block)
-			{
-				if (count <= (block->second - block->first) / _increment_size)
-				{
-					base_handle.ptr = _static_heap_base + static_cast<SIZE_T>(block->first - _static_heap_base_gpu);
-					base_handle_gpu.ptr = block->first;
-
-					// Remove the allocated range from the freed block and optionally remove it from the free list if no space is left afterwards
-					block->first += count * _increment_size;
-					if (block->first == block->second)
-						_free_list.erase(block);
-
-					return true;
-				}
-			}
-
-			// Otherwise follow a linear allocation schema
-			if (_current_static_index + count > static_size)
-				return false; // The heap is full
+			uint32_t index = 0;
+			if (!_static_allocator.allocate(count, index))
+				return false; // The heap is full (or too fragmented)
 
-			const SIZE_T offset = _current_static_index * _increment_size;
+			const SIZE_T offset = static_cast<SIZE_T>(index) * _increment_size;
 			base_handle.ptr = _static_heap_base + offset;
 			base_handle_gpu.ptr = _static_heap_base_gpu + offset;
 
-			_current_static_index += count;
+			// Keep track of the highest index that was ever allocated, since descriptors below it may be referenced by index
+			if (index + count > _current_static_index)
+				_current_static_index = index + count;
 
 			return true;
 		}
@@ -199,45 +176,7 @@ namespace reshade::d3d12
 
 			const std::unique_lock<std::shared_mutex> lock(_mutex);
 
-			// First try to append to an existing freed block
-			for (auto block = _free_list.begin(); block != _free_list.end(); ++block)
-			{
-				if (handle.ptr == block->second)
-				{
-					block->second += count * _increment_size;
-
-					// Try and merge with other blocks that are adjacent
-					for (auto block_adj = _free_list.begin(); block_adj != _free_list.end(); ++block_adj)
-					{
-						if (block_adj->first == block->second)
-						{
-							block->second = block_adj->second;
-							_free_list.erase(block_adj);
-							break;
-						}
-					}
-					return;
-				}
-				if (handle.ptr == (block->first - (count * _increment_size)))
-				{
-					block->first -= count * _increment_size;
-
-					// Try and merge with other blocks that are adjacent
-					for (auto block_adj = _free_list.begin(); block_adj != _free_list.end(); ++block_adj)
-					{
-						if (block_adj->second == block->first)
-						{
-							block->first = block_adj->first;
-							_free_list.erase(block_adj);
-							break;
-						}
-					}
-					return;
-				}
-			}
-
-			// Otherwise add a new block to the free list
-			_free_list.emplace_back(handle.ptr, handle.ptr + count * _increment_size);
+			_static_allocator.free(static_cast<uint32_t>((handle.ptr - _static_heap_base_gpu) / _increment_size), count);
 		}
 
 		bool contains(D3D12_GPU_DESCRIPTOR_HANDLE handle_gpu) const
@@ -252,7 +191,7 @@ namespace reshade::d3d12
 
 		bool convert_handle(D3D12_GPU_DESCRIPTOR_HANDLE handle_gpu, D3D12_CPU_DESCRIPTOR_HANDLE &out_handle_cpu) const
 		{
-			if (contains(handle_cpu))
+			if (contains(handle_gpu))
 			{
 				out_handle_cpu.ptr = _static_heap_base + static_cast<SIZE_T>(handle_gpu.ptr - _static_heap_base_gpu);
 				return true;
@@ -301,6 +240,31 @@ namespace reshade::d3d12
 
 		uint32_t get_static_alloc_count() const { return _current_static_index; }
 
+		/// <summary>
+		/// Gets the number of descriptors in the static range that are not allocated.
+		/// </summary>
+		uint32_t get_static_free_count()
+		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
+			return _static_allocator.free_size();
+		}
+		/// <summary>
+		/// Gets the number of descriptors in the largest contiguous free block of the static range, which is the largest descriptor set that can currently be allocated.
+		/// </summary>
+		uint32_t get_static_largest_free_block()
+		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
+			return _static_allocator.largest_free_range();
+		}
+		/// <summary>
+		/// Gets the fraction of free descriptors in the static range that are not part of the largest free block (0 means no fragmentation).
+		/// </summary>
+		float get_static_fragmentation()
+		{
+			const std::shared_lock<std::shared_mutex> lock(_mutex);
+			return _static_allocator.fragmentation();
+		}
+
 		uint32_t get_temp_alloc_count() const { return _current_transient_tail % transient_size; }
 
 		ID3D12DescriptorHeap *get() const { assert(_heap != nullptr); return _heap.get(); }
@@ -314,7 +278,7 @@ namespace reshade::d3d12
 		UINT64 _transient_heap_base_gpu;
 		SIZE_T _current_static_index = 0;
 		UINT64 _current_transient_tail = 0;
-		std::vector<std::pair<UINT64, UINT64>> _free_list;
+		tlsf_allocator _static_allocator { static_size };
 		std::shared_mutex _mutex;
 	};
 }
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "effect_arena.hpp"
+#include <mutex>
+#include <cassert>
+#include <cstdint>
+#include <cstring> // std::memcpy
+
+static thread_local reshadefx::arena *s_current_arena = nullptr;
+
+void *reshadefx::arena::allocate(size_t size, size_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+	const auto align = [alignment](const char *p) {
+		return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(p) + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1));
+	};
+
+	char *result = align(_cur);
+
+	if (_cur == nullptr || size > static_cast<size_t>(_end - result))
+	{
+		// Large allocations get a block of their own, so that the remaining space in the current block is not wasted
+		if (size + alignment > _block_size / 4)
+		{
+			_blocks.push_back(std::make_unique<char[]>(size + alignment));
+			_bytes_allocated += size;
+			return align(_blocks.back().get());
+		}
+
+		_blocks.push_back(std::make_unique<char[]>(_block_size));
+		_cur = _blocks.back().get();
+		_end = _cur + _block_size;
+
+		result = align(_cur);
+	}
+
+	_cur = result + size;
+	_bytes_allocated += size;
+
+	return result;
+}
+
+reshadefx::arena *reshadefx::arena::current()
+{
+	return s_current_arena;
+}
+
+reshadefx::arena::scope::scope(arena &target) : _previous(s_current_arena)
+{
+	s_current_arena = &target;
+}
+reshadefx::arena::scope::~scope()
+{
+	s_current_arena = _previous;
+}
+
+std::string_view reshadefx::string_pool::intern(const std::string_view &str)
+{
+	if (const auto it = _strings.find(str); it != _strings.end())
+		return *it;
+
+	// Keep strings null-terminated, so that they can be passed to functions expecting a C string
+	char *const data = static_cast<char *>(_arena.allocate(str.size() + 1, 1));
+	std::memcpy(data, str.data(), str.size());
+	data[str.size()] = '\0';
+
+	return *_strings.emplace(data, str.size()).first;
+}
+
+std::string_view reshadefx::intern_global_string(const std::string_view &str)
+{
+	static std::mutex s_mutex;
+	static reshadefx::arena s_arena(4096);
+	static reshadefx::string_pool s_strings(s_arena);
+
+	const std::lock_guard<std::mutex> lock(s_mutex);
+
+	return s_strings.intern(str);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstddef> // std::max_align_t
+#include <memory> // std::unique_ptr
+#include <vector>
+#include <string_view>
+#include <unordered_set>
+
+namespace reshadefx
+{
+	/// <summary>
+	/// A monotonic memory allocator, which hands out memory from large blocks and only releases it all at once when it is destroyed.
+	/// This makes allocating the many small short-lived objects created during a compilation very cheap, since it neither involves the heap nor any locking.
+	/// </summary>
+	class arena
+	{
+	public:
+		/// <summary>
+		/// Default size of a memory block.
+		/// </summary>
+		static constexpr size_t default_block_size = 64 * 1024;
+
+		explicit arena(size_t block_size = default_block_size) : _block_size(block_size) {}
+
+		arena(const arena &) = delete;
+		arena &operator=(const arena &) = delete;
+
+		/// <summary>
+		/// Allocates a chunk of memory from the arena, which stays valid until the arena is destroyed.
+		/// </summary>
+		void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		/// <summary>
+		/// Gets the total number of bytes handed out by this arena so far.
+		/// </summary>
+		size_t bytes_allocated() const { return _bytes_allocated; }
+		/// <summary>
+		/// Gets the number of memory blocks this arena requested from the heap so far.
+		/// </summary>
+		size_t num_blocks() const { return _blocks.size(); }
+
+		/// <summary>
+		/// Gets the arena that was made current on the calling thread by an <see cref="arena::scope"/>, or <see langword="nullptr"/> if there is none.
+		/// </summary>
+		static arena *current();
+
+		/// <summary>
+		/// Makes an arena the current one on the calling thread for the lifetime of this object, so that any <see cref="arena_allocator"/> created in that time allocates from it.
+		/// </summary>
+		class scope
+		{
+		public:
+			explicit scope(arena &target);
+			~scope();
+
+			scope(const scope &) = delete;
+			scope &operator=(const scope &) = delete;
+
+		private:
+			arena *_previous;
+		};
+
+	private:
+		size_t _block_size;
+		size_t _bytes_allocated = 0;
+		char *_cur = nullptr, *_end = nullptr;
+		std::vector<std::unique_ptr<char[]>> _blocks;
+	};
+
+	/// <summary>
+	/// An allocator for standard containers that allocates from an <see cref="arena"/>.
+	/// When no arena is current at the time the allocator is created, it falls back to the heap, so that containers using it work the same outside of a compilation.
+	/// </summary>
+	template <typename T>
+	class arena_allocator
+	{
+	public:
+		using value_type = T;
+		// Containers should take over the memory of the container they are moved from, without copying any elements
+		using propagate_on_container_copy_assignment = std::false_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		arena_allocator() : _arena(arena::current()) {}
+		explicit arena_allocator(arena *source) : _arena(source) {}
+		template <typename U>
+		arena_allocator(const arena_allocator<U> &other) : _arena(other._arena) {}
+
+		T *allocate(size_t n)
+		{
+			if (_arena != nullptr)
+				return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+			else
+				return static_cast<T *>(::operator new(n * sizeof(T)));
+		}
+		void deallocate(T *p, size_t)
+		{
+			// Memory handed out by an arena is only released when the arena is destroyed
+			if (_arena == nullptr)
+				::operator delete(p);
+		}
+
+		/// <summary>
+		/// Copies of a container use the arena current at the time of the copy, rather than the one of the source container, since they may outlive it.
+		/// </summary>
+		arena_allocator select_on_container_copy_construction() const { return arena_allocator(); }
+
+		template <typename U>
+		friend bool operator==(const arena_allocator &lhs, const arena_allocator<U> &rhs) { return lhs._arena == rhs._arena; }
+		template <typename U>
+		friend bool operator!=(const arena_allocator &lhs, const arena_allocator<U> &rhs) { return lhs._arena != rhs._arena; }
+
+	private:
+		template <typename U>
+		friend class arena_allocator;
+
+		arena *_arena;
+	};
+
+	/// <summary>
+	/// A set of unique strings, so that every string only needs to be stored once and can then be passed around as a view without allocating.
+	/// </summary>
+	class string_pool
+	{
+	public:
+		explicit string_pool(arena &storage) : _arena(storage), _strings(0, std::hash<std::string_view>(), std::equal_to<std::string_view>(), arena_allocator<std::string_view>(&storage)) {}
+
+		/// <summary>
+		/// Adds a string to the pool if it does not exist yet.
+		/// </summary>
+		/// <returns>A view of the pooled string, which stays valid for the lifetime of the pool.</returns>
+		std::string_view intern(const std::string_view &str);
+
+	private:
+		arena &_arena;
+		std::unordered_set<std::string_view, std::hash<std::string_view>, std::equal_to<std::string_view>, arena_allocator<std::string_view>> _strings;
+	};
+
+	/// <summary>
+	/// Interns a string in a pool shared by the whole process. This is thread-safe.
+	/// Only use this for the few strings referenced by data that may outlive a compilation (like the source file names in a <see cref="location"/>), since the pool is never cleared.
+	/// </summary>
+	/// <returns>A view of the pooled string, which stays valid until the process exits.</returns>
+	std::string_view intern_global_string(const std::string_view &str);
+}
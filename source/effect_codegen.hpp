@@ -170,7 +170,7 @@ namespace reshadefx
 		/// <param name="res_type">Data type of the call result.</param>
 		/// <param name="args">List of SSA IDs representing the call arguments.</param>
 		/// <returns>New SSA ID with the result of the function call.</returns>
-		virtual id emit_call(const location &loc, id function, const type &res_type, const std::vector<expression> &args) = 0;
+		virtual id emit_call(const location &loc, id function, const type &res_type, const expression_list &args) = 0;
 		/// <summary>
 		/// Adds an intrinsic function call to the output.
 		/// </summary>
@@ -179,14 +179,14 @@ namespace reshadefx
 		/// <param name="res_type">Data type of the call result.</param>
 		/// <param name="args">List of SSA IDs representing the call arguments.</param>
 		/// <returns>New SSA ID with the result of the function call.</returns>
-		virtual id emit_call_intrinsic(const location &loc, id function, const type &res_type, const std::vector<expression> &args) = 0;
+		virtual id emit_call_intrinsic(const location &loc, id function, const type &res_type, const expression_list &args) = 0;
 		/// <summary>
 		/// Adds a type constructor call to the output.
 		/// </summary>
 		/// <param name="type">Data type to construct.</param>
 		/// <param name="args">List of SSA IDs representing the scalar constructor arguments.</param>
 		/// <returns>New SSA ID with the constructed value.</returns>
-		virtual id emit_construct(const location &loc, const type &type, const std::vector<expression> &args) = 0;
+		virtual id emit_construct(const location &loc, const type &type, const expression_list &args) = 0;
 
 		/// <summary>
 		/// Adds a structured branch control flow to the output.
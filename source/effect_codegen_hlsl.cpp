@@ -8,8 +8,10 @@
 #include <cmath> // signbit, isinf, isnan
 #include <cstdio> // snprintf
 #include <cassert>
+#include <cctype> // isalnum
 #include <cstring> // stricmp
-#include <algorithm> // std::find_if, std::max
+#include <limits>
+#include <algorithm> // std::count, std::find, std::find_if, std::max
 
 using namespace reshadefx;
 
@@ -35,8 +37,15 @@ private:
 		expression,
 	};
 
+	struct declaration
+	{
+		size_t end_offset;
+		std::vector<std::string> names;
+	};
+
 	std::string _cbuffer_block;
-	std::string _current_location;
+	std::string_view _current_location;
+	std::vector<declaration> _declarations, _cbuffer_declarations;
 	std::unordered_map<id, std::string> _names;
 	std::unordered_map<id, std::string> _blocks;
 	unsigned int _shader_model = 0;
@@ -50,6 +59,9 @@ private:
 	{
 		module = std::move(_module);
 
+		// Keep track of where each block starts in the final code, so that the declarations in them can be found again
+		size_t cbuffer_offset = std::string::npos;
+
 		if (_shader_model >= 40)
 		{
 			module.hlsl += "struct __sampler2D { Texture2D t; SamplerState s; };\n";
@@ -101,13 +113,160 @@ private:
 					"float4 __asfloat(int4 v) { return float4(__asfloat(v.x), __asfloat(v.y), __asfloat(v.z), __asfloat(v.w)); }\n";
 
 			if (!_cbuffer_block.empty())
+				cbuffer_offset = module.hlsl.size(),
 				module.hlsl += _cbuffer_block;
 
 			// Offsets were multiplied in 'define_uniform', so adjust total size here accordingly
 			module.total_uniform_size *= 4;
 		}
 
+		const size_t global_block_offset = module.hlsl.size();
 		module.hlsl += _blocks.at(0);
+
+		// Split code into declarations (with the code before the first one being shared by all)
+		std::vector<std::pair<size_t, const std::vector<std::string> *>> declarations;
+		const auto add_declarations = [&declarations](const std::vector<declaration> &block_declarations, size_t block_offset, size_t block_size) {
+			declarations.emplace_back(block_offset, nullptr);
+			for (const declaration &decl : block_declarations)
+				declarations.emplace_back(block_offset + decl.end_offset, &decl.names);
+			// Code after the last declaration in a block is always used
+			if (block_declarations.empty() || block_declarations.back().end_offset != block_size)
+				declarations.emplace_back(block_offset + block_size, nullptr);
+		};
+
+		if (cbuffer_offset != std::string::npos)
+			add_declarations(_cbuffer_declarations, cbuffer_offset, _cbuffer_block.size());
+		add_declarations(_declarations, global_block_offset, _blocks.at(0).size());
+
+		const std::vector<std::vector<size_t>> references = find_declaration_references(module.hlsl, declarations);
+
+		for (entry_point &entry_point : module.entry_points)
+			find_entry_point_code(module.hlsl, declarations, references, entry_point);
+	}
+
+	/// <summary>
+	/// Finds the declarations the code of each declaration references, by looking up all identifiers in it.
+	/// This may find some that are not actually used (e.g. when a local variable has the same name as a global one), but never misses any.
+	/// </summary>
+	/// <param name="code">Code of the entire module.</param>
+	/// <param name="declarations">List of end offsets of all declarations in the code, along with the names they define (or <see langword="nullptr"/> for code that is always used).</param>
+	static std::vector<std::vector<size_t>> find_declaration_references(const std::string &code, const std::vector<std::pair<size_t, const std::vector<std::string> *>> &declarations)
+	{
+		std::unordered_map<std::string_view, size_t> lookup;
+		for (size_t i = 0; i < declarations.size(); ++i)
+			if (declarations[i].second != nullptr)
+				for (const std::string &name : *declarations[i].second)
+					lookup.emplace(name, i);
+
+		std::vector<std::vector<size_t>> references(declarations.size());
+		std::vector<size_t> last_referenced_by(declarations.size(), std::numeric_limits<size_t>::max());
+
+		for (size_t i = 0, offset = 0; i < declarations.size(); offset = declarations[i++].first)
+		{
+			for (const size_t end = declarations[i].first; offset < end;)
+			{
+				const char c = code[offset];
+
+				if (c == '#' && (offset == 0 || code[offset - 1] == '\n'))
+				{
+					// Skip preprocessor directives, which includes file names in '#line' directives
+					while (offset < end && code[offset] != '\n')
+						++offset;
+				}
+				else if (c == '\"')
+				{
+					for (++offset; offset < end && code[offset] != '\"'; ++offset)
+						continue;
+					++offset;
+				}
+				else if (isalnum(static_cast<unsigned char>(c)) || c == '_')
+				{
+					const size_t begin = offset;
+					while (offset < end && (isalnum(static_cast<unsigned char>(code[offset])) || code[offset] == '_'))
+						++offset;
+
+					if (c >= '0' && c <= '9')
+						continue; // Numbers cannot reference anything
+
+					if (const auto it = lookup.find(std::string_view(code.data() + begin, offset - begin));
+						it != lookup.end() && it->second != i && last_referenced_by[it->second] != i)
+					{
+						last_referenced_by[it->second] = i;
+						references[i].push_back(it->second);
+					}
+				}
+				else
+				{
+					++offset;
+				}
+			}
+		}
+
+		return references;
+	}
+
+	/// <summary>
+	/// Finds the code of only those declarations an entry point uses (directly or through other declarations), so that the HLSL compiler does not have to parse the whole module for every entry point.
+	/// </summary>
+	static void find_entry_point_code(const std::string &code, const std::vector<std::pair<size_t, const std::vector<std::string> *>> &declarations, const std::vector<std::vector<size_t>> &references, entry_point &entry_point)
+	{
+		bool entry_point_found = false;
+		std::vector<bool> used(declarations.size());
+		std::vector<size_t> stack;
+
+		for (size_t i = 0; i < declarations.size(); ++i)
+		{
+			if (declarations[i].second == nullptr)
+			{
+				stack.push_back(i);
+			}
+			else if (std::find(declarations[i].second->begin(), declarations[i].second->end(), entry_point.name) != declarations[i].second->end())
+			{
+				stack.push_back(i);
+				entry_point_found = true;
+			}
+		}
+
+		// Leave ranges empty if the entry point function could not be found, so that the whole module is used instead
+		if (!entry_point_found)
+			return;
+
+		while (!stack.empty())
+		{
+			const size_t i = stack.back();
+			stack.pop_back();
+
+			if (used[i])
+				continue;
+			used[i] = true;
+
+			for (const size_t referenced : references[i])
+				if (!used[referenced])
+					stack.push_back(referenced);
+		}
+
+		// Only store where the used code is, the actual code is built from that when compiling the entry point (see 'get_entry_point_hlsl')
+		entry_point.hlsl_ranges.clear();
+
+		for (size_t i = 0, offset = 0; i < declarations.size(); offset = declarations[i++].first)
+		{
+			if (!used[i] || offset == declarations[i].first)
+				continue;
+
+			// Merge with the previous range if they are adjacent
+			if (!entry_point.hlsl_ranges.empty() && entry_point.hlsl_ranges.back().second == offset)
+				entry_point.hlsl_ranges.back().second = static_cast<uint32_t>(declarations[i].first);
+			else
+				entry_point.hlsl_ranges.emplace_back(static_cast<uint32_t>(offset), static_cast<uint32_t>(declarations[i].first));
+		}
+	}
+
+	void end_declaration(std::vector<declaration> &declarations, const std::string &block, std::vector<std::string> names)
+	{
+		declarations.push_back({ block.size(), std::move(names) });
+
+		// Write the file name with the next location again, since the declaration it was written with may be stripped from the code of an entry point
+		_current_location = {};
 	}
 
 	template <bool is_param = false, bool is_decl = true>
@@ -278,11 +437,15 @@ private:
 		// Avoid writing the file name every time to reduce output text size
 		if constexpr (force_source)
 		{
-			s += " \"" + loc.source + '\"';
+			s += " \"";
+			s += loc.source;
+			s += '\"';
 		}
 		else if (loc.source != _current_location)
 		{
-			s += " \"" + loc.source + '\"';
+			s += " \"";
+			s += loc.source;
+			s += '\"';
 
 			_current_location = loc.source;
 		}
@@ -404,6 +567,8 @@ private:
 
 		code += "};\n";
 
+		end_declaration(_declarations, code, { id_to_name(info.definition) });
+
 		return info.definition;
 	}
 	id   define_texture(const location &loc, texture_info &info) override
@@ -431,6 +596,8 @@ private:
 				code += "[[vk::binding(" + std::to_string(info.binding + 1) + ", 2)]] "; // Descriptor set 2
 
 			code += "Texture2D __srgb" + info.unique_name + " : register(t" + std::to_string(info.binding + 1) + ");\n";
+
+			end_declaration(_declarations, code, { "__" + info.unique_name, "__srgb" + info.unique_name });
 		}
 
 		_module.textures.push_back(info);
@@ -471,6 +638,8 @@ private:
 					code += "[[vk::binding(" + std::to_string(info.binding) + ", 1)]] "; // Descriptor set 1
 
 				code += "SamplerState __s" + std::to_string(info.binding) + " : register(s" + std::to_string(info.binding) + ");\n";
+
+				end_declaration(_declarations, code, { "__s" + std::to_string(info.binding) });
 			}
 
 			assert(info.srgb == 0 || info.srgb == 1);
@@ -479,6 +648,8 @@ private:
 			write_location(code, loc);
 
 			code += "static const __sampler2D " + id_to_name(info.id) + " = { " + (info.srgb ? "__srgb" : "__") + info.texture_name + ", __s" + std::to_string(info.binding) + " };\n";
+
+			end_declaration(_declarations, code, { id_to_name(info.id) });
 		}
 		else
 		{
@@ -497,6 +668,8 @@ private:
 				code += texture->semantic + "_PIXEL_SIZE"; // Expect application to set inverse texture size via a define if it is not known here
 
 			code += ") }; \n";
+
+			end_declaration(_declarations, code, { id_to_name(info.id) });
 		}
 
 		_module.samplers.push_back(info);
@@ -549,6 +722,8 @@ private:
 			}
 
 			code += "> " + info.unique_name + " : register(u" + std::to_string(info.binding) + ");\n";
+
+			end_declaration(_declarations, code, { info.unique_name });
 		}
 
 		_module.storages.push_back(info);
@@ -580,6 +755,8 @@ private:
 				write_type<false, false>(code, info.type);
 			code += "(SPEC_CONSTANT_" + info.name + ");\n";
 
+			end_declaration(_declarations, code, { id_to_name(res) });
+
 			_module.spec_constants.push_back(info);
 		}
 		else
@@ -634,6 +811,10 @@ private:
 
 			_cbuffer_block += ";\n";
 
+			// Uniforms have explicit register assignments in shader model 3, so unused ones can be removed without affecting the layout of the others
+			if (_shader_model < 40)
+				end_declaration(_cbuffer_declarations, _cbuffer_block, { id_to_name(res) });
+
 			_module.uniforms.push_back(info);
 		}
 
@@ -667,6 +848,9 @@ private:
 
 		code += ";\n";
 
+		if (global)
+			end_declaration(_declarations, code, { id_to_name(res) });
+
 		return res;
 	}
 	id   define_function(const location &loc, function_info &info) override
@@ -736,7 +920,7 @@ private:
 				return;
 		}
 
-		_module.entry_points.push_back({ func.unique_name, stype });
+		_module.entry_points.push_back({ func.unique_name, stype, {} });
 
 		// Only have to rewrite the entry point function signature in shader model 3 and for compute (to write "numthreads" attribute)
 		if (_shader_model >= 40 && stype != shader_type::cs)
@@ -1159,7 +1343,7 @@ private:
 
 		return res;
 	}
-	id   emit_call(const location &loc, id function, const type &res_type, const std::vector<expression> &args) override
+	id   emit_call(const location &loc, id function, const type &res_type, const expression_list &args) override
 	{
 #ifndef NDEBUG
 		for (const expression &arg : args)
@@ -1199,7 +1383,7 @@ private:
 
 		return res;
 	}
-	id   emit_call_intrinsic(const location &loc, id intrinsic, const type &res_type, const std::vector<expression> &args) override
+	id   emit_call_intrinsic(const location &loc, id intrinsic, const type &res_type, const expression_list &args) override
 	{
 #ifndef NDEBUG
 		for (const expression &arg : args)
@@ -1255,7 +1439,7 @@ private:
 
 		return res;
 	}
-	id   emit_construct(const location &loc, const type &type, const std::vector<expression> &args) override
+	id   emit_construct(const location &loc, const type &type, const expression_list &args) override
 	{
 #ifndef NDEBUG
 		for (const auto &arg : args)
@@ -1717,7 +1901,11 @@ private:
 	{
 		assert(_last_block != 0);
 
-		_blocks.at(0) += "{\n" + _blocks.at(_last_block) + "}\n";
+		std::string &code = _blocks.at(0);
+
+		code += "{\n" + _blocks.at(_last_block) + "}\n";
+
+		end_declaration(_declarations, code, { id_to_name(_functions.back()->definition) });
 	}
 };
 
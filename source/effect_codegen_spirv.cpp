@@ -8,6 +8,7 @@
 #include <cassert>
 #include <cstring> // memcmp
 #include <algorithm> // std::find_if, std::max
+#include <functional> // std::hash
 #include <unordered_set>
 
 // Use the C++ variant of the SPIR-V headers
@@ -113,6 +114,27 @@ struct spirv_basic_block
 	}
 };
 
+static inline void hash_combine(size_t &seed, size_t value)
+{
+	seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+static inline size_t hash_type(const type &info)
+{
+	// Only hash the members that are compared by the equality operator of 'type'
+	size_t seed = std::hash<uint32_t>()(info.base);
+	hash_combine(seed, std::hash<uint32_t>()(info.rows));
+	hash_combine(seed, std::hash<uint32_t>()(info.cols));
+	hash_combine(seed, std::hash<int>()(info.array_length));
+	hash_combine(seed, std::hash<uint32_t>()(info.definition));
+	return seed;
+}
+static inline size_t hash_constant_data(size_t seed, const constant &data)
+{
+	for (size_t i = 0; i < 16; ++i)
+		hash_combine(seed, std::hash<uint32_t>()(data.as_uint[i]));
+	return seed;
+}
+
 class codegen_spirv final : public codegen
 {
 public:
@@ -134,17 +156,52 @@ private:
 		{
 			return lhs.type == rhs.type && lhs.is_ptr == rhs.is_ptr && lhs.array_stride == rhs.array_stride && lhs.storage == rhs.storage;
 		}
+
+		struct hash
+		{
+			size_t operator()(const type_lookup &lookup) const
+			{
+				size_t seed = hash_type(lookup.type);
+				hash_combine(seed, std::hash<bool>()(lookup.is_ptr));
+				hash_combine(seed, std::hash<uint32_t>()(lookup.array_stride));
+				hash_combine(seed, std::hash<uint32_t>()(lookup.storage.first));
+				hash_combine(seed, std::hash<uint32_t>()(lookup.storage.second));
+				return seed;
+			}
+		};
 	};
-	struct function_blocks
+	struct constant_lookup
 	{
-		spirv_basic_block declaration;
-		spirv_basic_block variables;
-		spirv_basic_block definition;
-		type return_type;
-		std::vector<type> param_types;
-		bool is_entry_point = false;
+		reshadefx::type type;
+		reshadefx::constant data;
 
-		friend bool operator==(const function_blocks &lhs, const function_blocks &rhs)
+		friend bool operator==(const constant_lookup &lhs, const constant_lookup &rhs)
+		{
+			if (!(lhs.type == rhs.type && std::memcmp(&lhs.data.as_uint[0], &rhs.data.as_uint[0], sizeof(uint32_t) * 16) == 0 && lhs.data.array_data.size() == rhs.data.array_data.size()))
+				return false;
+			for (size_t i = 0; i < lhs.data.array_data.size(); ++i)
+				if (std::memcmp(&lhs.data.array_data[i].as_uint[0], &rhs.data.array_data[i].as_uint[0], sizeof(uint32_t) * 16) != 0)
+					return false;
+			return true;
+		}
+
+		struct hash
+		{
+			size_t operator()(const constant_lookup &lookup) const
+			{
+				size_t seed = hash_constant_data(hash_type(lookup.type), lookup.data);
+				for (const constant &elem : lookup.data.array_data)
+					seed = hash_constant_data(seed, elem);
+				return seed;
+			}
+		};
+	};
+	struct function_type_lookup
+	{
+		reshadefx::type return_type;
+		std::vector<reshadefx::type> param_types;
+
+		friend bool operator==(const function_type_lookup &lhs, const function_type_lookup &rhs)
 		{
 			if (lhs.param_types.size() != rhs.param_types.size())
 				return false;
@@ -153,6 +210,26 @@ private:
 					return false;
 			return lhs.return_type == rhs.return_type;
 		}
+
+		struct hash
+		{
+			size_t operator()(const function_type_lookup &lookup) const
+			{
+				size_t seed = hash_type(lookup.return_type);
+				for (const reshadefx::type &param_type : lookup.param_types)
+					hash_combine(seed, hash_type(param_type));
+				return seed;
+			}
+		};
+	};
+	struct function_blocks
+	{
+		spirv_basic_block declaration;
+		spirv_basic_block variables;
+		spirv_basic_block definition;
+		type return_type;
+		std::vector<type> param_types;
+		bool is_entry_point = false;
 	};
 
 	spirv_basic_block _entries;
@@ -163,12 +240,12 @@ private:
 	spirv_basic_block _types_and_constants;
 	spirv_basic_block _variables;
 
-	std::unordered_set<spv::Id> _spec_constants;
+	std::unordered_map<spv::Id, size_t> _spec_constants; // Maps each specialization constant to the index of its instruction in '_types_and_constants'
 	std::unordered_set<spv::Capability> _capabilities;
-	std::vector<std::pair<type_lookup, spv::Id>> _type_lookup;
-	std::vector<std::tuple<type, constant, spv::Id>> _constant_lookup;
-	std::vector<std::pair<function_blocks, spv::Id>> _function_type_lookup;
-	std::unordered_map<std::string, spv::Id> _string_lookup;
+	std::unordered_map<type_lookup, spv::Id, type_lookup::hash> _type_lookup;
+	std::unordered_map<constant_lookup, spv::Id, constant_lookup::hash> _constant_lookup;
+	std::unordered_map<function_type_lookup, spv::Id, function_type_lookup::hash> _function_type_lookup;
+	std::unordered_map<std::string_view, spv::Id> _string_lookup;
 	std::unordered_map<spv::Id, std::pair<spv::StorageClass, spv::ImageFormat>> _storage_lookup;
 	std::unordered_map<std::string, uint32_t> _semantic_to_location;
 
@@ -199,7 +276,7 @@ private:
 			file = it->second;
 		else {
 			add_instruction(spv::OpString, 0, _debug_a, file)
-				.add_string(loc.source.c_str());
+				.add_string(loc.source.data()); // Source file names are interned and therefore null-terminated
 			_string_lookup.emplace(loc.source, file);
 		}
 
@@ -356,12 +433,9 @@ private:
 
 		const type_lookup lookup { info, is_ptr, array_stride, { storage, format } };
 
-		{	const auto it = std::find_if(_type_lookup.begin(), _type_lookup.end(),
-				[&lookup](const auto &lookup_it) {
-					return lookup_it.first == lookup; });
-			if (it != _type_lookup.end())
-				return it->second;
-		}
+		if (const auto it = _type_lookup.find(lookup);
+			it != _type_lookup.end())
+			return it->second;
 
 		spv::Id type, elem_type;
 		if (is_ptr)
@@ -506,18 +580,17 @@ private:
 			}
 		}
 
-		_type_lookup.push_back({ lookup, type });
+		_type_lookup.emplace(lookup, type);
 
 		return type;
 	}
 	spv::Id convert_type(const function_blocks &info)
 	{
-		{	const auto it = std::find_if(_function_type_lookup.begin(), _function_type_lookup.end(),
-				[&lookup = info](const auto &lookup_it) {
-					return lookup_it.first == lookup; });
-			if (it != _function_type_lookup.end())
-				return it->second;
-		}
+		function_type_lookup lookup { info.return_type, info.param_types };
+
+		if (const auto it = _function_type_lookup.find(lookup);
+			it != _function_type_lookup.end())
+			return it->second;
 
 		auto return_type = convert_type(info.return_type);
 		assert(return_type != 0);
@@ -531,7 +604,7 @@ private:
 		inst.add(return_type);
 		inst.add(param_type_ids.begin(), param_type_ids.end());
 
-		_function_type_lookup.push_back({ info, inst.result });;
+		_function_type_lookup.emplace(std::move(lookup), inst.result);
 
 		return inst.result;
 	}
@@ -803,17 +876,22 @@ private:
 
 					if (info.type.is_array())
 					{
-						elem_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
-							[elem = base_inst.operands[i]](const auto &it) { return it.result == elem; });
+						elem_inst = _types_and_constants.instructions[_spec_constants.at(base_inst.operands[i])];
 
 						assert(initializer_value.array_data.size() == base_inst.operands.size());
 						initializer_value = initializer_value.array_data[i];
 					}
 
+					// Elements of scalar arrays are not composites, so there are no rows to iterate over
+					if (elem_inst.op != spv::OpSpecConstantComposite)
+					{
+						add_spec_constant(elem_inst, info, initializer_value, 0);
+						continue;
+					}
+
 					for (size_t row = 0; row < elem_inst.operands.size(); ++row)
 					{
-						const spirv_instruction &row_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
-							[elem = elem_inst.operands[row]](const auto &it) { return it.result == elem; });
+						const spirv_instruction &row_inst = _types_and_constants.instructions[_spec_constants.at(elem_inst.operands[row])];
 
 						if (row_inst.op != spv::OpSpecConstantComposite)
 						{
@@ -823,8 +901,7 @@ private:
 
 						for (size_t col = 0; col < row_inst.operands.size(); ++col)
 						{
-							const spirv_instruction &col_inst = *std::find_if(_types_and_constants.instructions.rbegin(), _types_and_constants.instructions.rend(),
-								[elem = row_inst.operands[col]](const auto &it) { return it.result == elem; });
+							const spirv_instruction &col_inst = _types_and_constants.instructions[_spec_constants.at(row_inst.operands[col])];
 
 							add_spec_constant(col_inst, info, initializer_value, row * info.type.cols + col);
 						}
@@ -1004,11 +1081,11 @@ private:
 				return;
 		}
 
-		_module.entry_points.push_back({ func.unique_name, stype });
+		_module.entry_points.push_back({ func.unique_name, stype, {} });
 
 		spv::Id position_variable = 0, point_size_variable = 0;
 		std::vector<spv::Id> inputs_and_outputs;
-		std::vector<expression> call_params;
+		expression_list call_params;
 
 		// Generate the glue entry point function
 		function_info entry_point;
@@ -1415,7 +1492,7 @@ private:
 					type cast_type = op.to;
 					cast_type.base = op.from.base;
 
-					std::vector<expression> args;
+					expression_list args;
 					for (unsigned int c = 0; c < op.to.components(); ++c)
 						args.emplace_back().reset_to_rvalue(exp.location, result, op.from);
 
@@ -1730,16 +1807,9 @@ private:
 	{
 		if (!spec_constant) // Specialization constants cannot reuse other constants
 		{
-			const auto it = std::find_if(_constant_lookup.begin(), _constant_lookup.end(),
-				[&type, &data](auto &x) {
-					if (!(std::get<0>(x) == type && std::memcmp(&std::get<1>(x).as_uint[0], &data.as_uint[0], sizeof(uint32_t) * 16) == 0 && std::get<1>(x).array_data.size() == data.array_data.size()))
-						return false;
-					for (size_t i = 0; i < data.array_data.size(); ++i)
-						if (std::memcmp(&std::get<1>(x).array_data[i].as_uint[0], &data.array_data[i].as_uint[0], sizeof(uint32_t) * 16) != 0)
-							return false;
-					return true; });
-			if (it != _constant_lookup.end())
-				return std::get<2>(*it); // Re-use existing constant instead of duplicating the definition
+			if (const auto it = _constant_lookup.find({ type, data });
+				it != _constant_lookup.end())
+				return it->second; // Re-use existing constant instead of duplicating the definition
 		}
 
 		spv::Id result;
@@ -1820,9 +1890,15 @@ private:
 		}
 
 		if (spec_constant) // Keep track of all specialization constants
-			_spec_constants.insert(result);
+		{
+			// Single row vectors reuse the instruction of their element, which was added already
+			assert(_spec_constants.find(result) != _spec_constants.end() || _types_and_constants.instructions.back().result == result);
+			_spec_constants.emplace(result, _types_and_constants.instructions.size() - 1);
+		}
 		else
-			_constant_lookup.push_back({ type, data, result });
+		{
+			_constant_lookup.emplace(constant_lookup { type, data }, result);
+		}
 
 		return result;
 	}
@@ -2003,7 +2079,7 @@ private:
 
 		return inst.result;
 	}
-	id   emit_call(const location &loc, id function, const type &res_type, const std::vector<expression> &args) override
+	id   emit_call(const location &loc, id function, const type &res_type, const expression_list &args) override
 	{
 #ifndef NDEBUG
 		for (const expression &arg : args)
@@ -2019,7 +2095,7 @@ private:
 
 		return inst.result;
 	}
-	id   emit_call_intrinsic(const location &loc, id intrinsic, const type &res_type, const std::vector<expression> &args) override
+	id   emit_call_intrinsic(const location &loc, id intrinsic, const type &res_type, const expression_list &args) override
 	{
 #ifndef NDEBUG
 		for (const expression &arg : args)
@@ -2041,7 +2117,7 @@ private:
 			return assert(false), 0;
 		}
 	}
-	id   emit_construct(const location &loc, const type &type, const std::vector<expression> &args) override
+	id   emit_construct(const location &loc, const type &type, const expression_list &args) override
 	{
 #ifndef NDEBUG
 		for (const expression &arg : args)
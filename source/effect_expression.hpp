@@ -153,7 +153,7 @@ namespace reshadefx
 		bool is_lvalue = false;
 		bool is_constant = false;
 		reshadefx::location location;
-		std::vector<operation> chain;
+		std::vector<operation, arena_allocator<operation>> chain;
 
 		/// <summary>
 		/// Initializes the expression to a l-value.
@@ -222,4 +222,9 @@ namespace reshadefx
 		/// <param name="rhs">Constant value to use as right-hand side of the binary operation.</param>
 		bool evaluate_constant_expression(reshadefx::tokenid op, const reshadefx::constant &rhs);
 	};
+
+	/// <summary>
+	/// A list of expressions (e.g. the arguments to a function call), which is allocated from the current compilation arena
+	/// </summary>
+	using expression_list = std::vector<expression, arena_allocator<expression>>;
 }
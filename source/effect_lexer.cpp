@@ -4,9 +4,26 @@
  */
 
 #include "effect_lexer.hpp"
+#include "effect_perfect_hash.hpp"
 #include <cassert>
+#include <cstdint>
+#include <algorithm> // std::min
+#include <iterator> // std::size
 #include <unordered_map> // Used for static lookup tables
 
+// Define "RESHADEFX_LEXER_NO_SIMD" to only build the scalar code path (which is what the SIMD code paths are tested against)
+#if defined(RESHADEFX_LEXER_NO_SIMD)
+#elif defined(__AVX2__)
+	#include <immintrin.h>
+	#define RESHADEFX_LEXER_SIMD_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RESHADEFX_LEXER_SIMD_WIDTH 16
+#endif
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
 using namespace reshadefx;
 
 enum token_type
@@ -198,7 +215,13 @@ static const std::unordered_map<tokenid, std::string> token_lookup = {
 	{ tokenid::sampler, "sampler" },
 	{ tokenid::storage, "storage" },
 };
-static const std::unordered_map<std::string, tokenid> keyword_lookup = {
+struct keyword
+{
+	std::string_view name;
+	tokenid id;
+};
+
+static constexpr keyword keyword_list[] = {
 	{ "asm", tokenid::reserved },
 	{ "asm_fragment", tokenid::reserved },
 	{ "auto", tokenid::reserved },
@@ -432,7 +455,7 @@ static const std::unordered_map<std::string, tokenid> keyword_lookup = {
 	{ "volatile", tokenid::volatile_ },
 	{ "while", tokenid::while_ }
 };
-static const std::unordered_map<std::string, tokenid> pp_directive_lookup = {
+static constexpr keyword pp_directive_list[] = {
 	{ "define", tokenid::hash_def },
 	{ "undef", tokenid::hash_undef },
 	{ "if", tokenid::hash_if },
@@ -447,6 +470,174 @@ static const std::unordered_map<std::string, tokenid> pp_directive_lookup = {
 	{ "include", tokenid::hash_include },
 };
 
+// Perfect hash tables which translate an identifier to the index of the matching keyword in the lists above
+static constexpr perfect_hash_table<std::size(keyword_list)> keyword_lookup(keyword_list, &keyword::name);
+static constexpr perfect_hash_table<std::size(pp_directive_list)> pp_directive_lookup(pp_directive_list, &keyword::name);
+
+static_assert(keyword_lookup.valid() && pp_directive_lookup.valid(), "keywords have to be unique");
+
+static inline bool is_space(char c)
+{
+	return type_lookup[uint8_t(c)] == SPACE;
+}
+static inline bool is_identifier_char(char c)
+{
+	return type_lookup[uint8_t(c)] == IDENT || type_lookup[uint8_t(c)] == DIGIT;
+}
+
+#ifdef RESHADEFX_LEXER_SIMD_WIDTH
+
+static inline uint32_t index_of_lowest_bit(uint32_t mask)
+{
+	assert(mask != 0);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+static inline uint32_t index_of_highest_bit(uint32_t mask)
+{
+	assert(mask != 0);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse(&index, mask);
+	return index;
+#else
+	return 31 - __builtin_clz(mask);
+#endif
+}
+
+// Thin wrappers around the SSE2 or AVX2 intrinsics, so that the scanning functions below can be written only once
+#if RESHADEFX_LEXER_SIMD_WIDTH == 32
+using simd_vector = __m256i;
+
+static inline simd_vector simd_load(const char *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+static inline simd_vector simd_set(char c) { return _mm256_set1_epi8(c); }
+static inline simd_vector simd_or(simd_vector a, simd_vector b) { return _mm256_or_si256(a, b); }
+static inline simd_vector simd_and(simd_vector a, simd_vector b) { return _mm256_and_si256(a, b); }
+static inline simd_vector simd_equal(simd_vector a, simd_vector b) { return _mm256_cmpeq_epi8(a, b); }
+static inline simd_vector simd_sub(simd_vector a, simd_vector b) { return _mm256_sub_epi8(a, b); }
+static inline simd_vector simd_min(simd_vector a, simd_vector b) { return _mm256_min_epu8(a, b); }
+static inline uint32_t simd_mask(simd_vector v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+#else
+using simd_vector = __m128i;
+
+static inline simd_vector simd_load(const char *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+static inline simd_vector simd_set(char c) { return _mm_set1_epi8(c); }
+static inline simd_vector simd_or(simd_vector a, simd_vector b) { return _mm_or_si128(a, b); }
+static inline simd_vector simd_and(simd_vector a, simd_vector b) { return _mm_and_si128(a, b); }
+static inline simd_vector simd_equal(simd_vector a, simd_vector b) { return _mm_cmpeq_epi8(a, b); }
+static inline simd_vector simd_sub(simd_vector a, simd_vector b) { return _mm_sub_epi8(a, b); }
+static inline simd_vector simd_min(simd_vector a, simd_vector b) { return _mm_min_epu8(a, b); }
+static inline uint32_t simd_mask(simd_vector v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+#endif
+
+// Sets all bytes to 0xFF that are in the inclusive range [first, last]
+static inline simd_vector simd_in_range(simd_vector v, char first, char last)
+{
+	const simd_vector offset = simd_sub(v, simd_set(first));
+	return simd_equal(simd_min(offset, simd_set(last - first)), offset);
+}
+
+#endif
+
+// These functions scan a whole block of characters at once when SIMD is available, falling back to one character at a time for the remainder
+// They never read beyond 'end', except for the terminating null character at 'end' itself, which every input string has
+static const char *find_end_of_space(const char *p, const char *const end)
+{
+#ifdef RESHADEFX_LEXER_SIMD_WIDTH
+	// Most runs are short (like the single space between two tokens), so check the first few characters one at a time before setting up any vector compares
+	for (const char *const scalar_end = p + std::min<ptrdiff_t>(end - p, 4); p < scalar_end; ++p)
+		if (!is_space(*p))
+			return p;
+
+	for (; end - p >= RESHADEFX_LEXER_SIMD_WIDTH; p += RESHADEFX_LEXER_SIMD_WIDTH)
+	{
+		const simd_vector v = simd_load(p);
+		// Space characters are ' ', '\t', '\v', '\f' and '\r' (but not '\n', which is in the middle of that range)
+		const uint32_t mask = simd_mask(simd_or(simd_equal(v, simd_set(' ')), simd_in_range(v, '\t', '\r'))) & ~simd_mask(simd_equal(v, simd_set('\n')));
+		if (mask != (RESHADEFX_LEXER_SIMD_WIDTH == 32 ? 0xFFFFFFFF : 0xFFFF))
+			return p + index_of_lowest_bit(~mask);
+	}
+#endif
+	while (p < end && is_space(*p))
+		p++;
+	return p;
+}
+static const char *find_end_of_identifier(const char *p, [[maybe_unused]] const char *const end)
+{
+#ifdef RESHADEFX_LEXER_SIMD_WIDTH
+	// Same as above, most identifiers are short
+	for (const char *const scalar_end = p + std::min<ptrdiff_t>(end - p, 8); p < scalar_end; ++p)
+		if (!is_identifier_char(*p))
+			return p;
+
+	for (; end - p >= RESHADEFX_LEXER_SIMD_WIDTH; p += RESHADEFX_LEXER_SIMD_WIDTH)
+	{
+		const simd_vector v = simd_load(p);
+		const uint32_t mask = simd_mask(simd_or(simd_or(simd_in_range(v, 'a', 'z'), simd_in_range(v, 'A', 'Z')), simd_or(simd_in_range(v, '0', '9'), simd_equal(v, simd_set('_')))));
+		if (mask != (RESHADEFX_LEXER_SIMD_WIDTH == 32 ? 0xFFFFFFFF : 0xFFFF))
+			return p + index_of_lowest_bit(~mask);
+	}
+#endif
+	// Identifiers always end at the terminating null character, so no need to check against 'end' here
+	while (is_identifier_char(*p))
+		p++;
+	return p;
+}
+static const char *find_end_of_line(const char *p, const char *const end)
+{
+#ifdef RESHADEFX_LEXER_SIMD_WIDTH
+	for (; end - p >= RESHADEFX_LEXER_SIMD_WIDTH; p += RESHADEFX_LEXER_SIMD_WIDTH)
+	{
+		const uint32_t mask = simd_mask(simd_equal(simd_load(p), simd_set('\n')));
+		if (mask != 0)
+			return p + index_of_lowest_bit(mask);
+	}
+#endif
+	while (p < end && *p != '\n')
+		p++;
+	return p;
+}
+static const char *find_end_of_block_comment(const char *p, const char *const end, uint32_t &num_new_lines, const char *&last_new_line)
+{
+#ifdef RESHADEFX_LEXER_SIMD_WIDTH
+	for (; end - p >= RESHADEFX_LEXER_SIMD_WIDTH; p += RESHADEFX_LEXER_SIMD_WIDTH)
+	{
+		const simd_vector v = simd_load(p);
+		// Load the same block shifted by one character to find '*' followed by '/' (this reads at most up to the terminating null character)
+		const uint32_t end_mask = simd_mask(simd_and(simd_equal(v, simd_set('*')), simd_equal(simd_load(p + 1), simd_set('/'))));
+		uint32_t new_line_mask = simd_mask(simd_equal(v, simd_set('\n')));
+
+		// Only count new lines up to the end of the comment
+		if (end_mask != 0)
+			new_line_mask &= (end_mask & (0 - end_mask)) - 1;
+
+		if (new_line_mask != 0)
+		{
+			last_new_line = p + index_of_highest_bit(new_line_mask);
+			for (; new_line_mask != 0; new_line_mask &= new_line_mask - 1)
+				num_new_lines++;
+		}
+
+		if (end_mask != 0)
+			return p + index_of_lowest_bit(end_mask);
+	}
+#endif
+	for (; p < end; ++p)
+	{
+		if (*p == '\n')
+			num_new_lines++,
+			last_new_line = p;
+		else if (p[0] == '*' && p[1] == '/')
+			break;
+	}
+	return p;
+}
+
 static inline bool is_octal_digit(char c)
 {
 	return static_cast<unsigned>(c - '0') < 8;
@@ -648,20 +839,27 @@ next_token:
 		}
 		else if (_cur[1] == '*')
 		{
-			while (_cur < _end)
+			uint32_t num_new_lines = 0;
+			const char *last_new_line = nullptr;
+			// Start search at the '*' of the comment opening already, so that '/*/' is treated as a complete comment
+			const char *const comment_end = find_end_of_block_comment(_cur + 1, _end, num_new_lines, last_new_line);
+
+			if (last_new_line != nullptr)
 			{
-				if (*_cur == '\n')
-				{
-					_cur_location.line++;
-					_cur_location.column = 1;
-				}
-				else if (_cur[0] == '*' && _cur[1] == '/')
-				{
-					skip(2);
-					break;
-				}
-				skip(1);
+				// Column counting includes the new line character itself
+				_cur_location.line += num_new_lines;
+				_cur_location.column = 1 + static_cast<unsigned int>(comment_end - last_new_line);
+			}
+			else
+			{
+				_cur_location.column += static_cast<unsigned int>(comment_end - _cur);
 			}
+
+			_cur = comment_end;
+
+			if (_cur < _end)
+				skip(2); // Skip the closing '*/'
+
 			if (_ignore_comments)
 				goto next_token;
 			tok.id = tokenid::multi_line_comment;
@@ -777,15 +975,13 @@ void reshadefx::lexer::skip(size_t length)
 }
 void reshadefx::lexer::skip_space()
 {
-	// Skip each character until a space is found
-	while (type_lookup[uint8_t(*_cur)] == SPACE && _cur < _end)
-		skip(1);
+	// Skip each character until a non-space is found
+	skip(find_end_of_space(_cur, _end) - _cur);
 }
 void reshadefx::lexer::skip_to_next_line()
 {
 	// Skip each character until a new line feed is found
-	while (*_cur != '\n' && _cur < _end)
-		skip(1);
+	skip(find_end_of_line(_cur, _end) - _cur);
 }
 
 void reshadefx::lexer::reset_to_offset(size_t offset)
@@ -796,10 +992,10 @@ void reshadefx::lexer::reset_to_offset(size_t offset)
 
 void reshadefx::lexer::parse_identifier(token &tok) const
 {
-	auto *const begin = _cur, *end = begin;
+	auto *const begin = _cur;
 
-	// Skip to the end of the identifier sequence
-	do end++; while (type_lookup[uint8_t(*end)] == IDENT || type_lookup[uint8_t(*end)] == DIGIT);
+	// Skip to the end of the identifier sequence (the first character is part of it already, unless this is a directive at the very end of the input, as in "#")
+	auto *const end = begin < _end ? find_end_of_identifier(begin + 1, _end) : begin;
 
 	tok.id = tokenid::identifier;
 	tok.offset = input_offset();
@@ -809,9 +1005,9 @@ void reshadefx::lexer::parse_identifier(token &tok) const
 	if (_ignore_keywords)
 		return;
 
-	if (const auto it = keyword_lookup.find(tok.literal_as_string);
-		it != keyword_lookup.end())
-		tok.id = it->second;
+	if (const size_t index = keyword_lookup.find(tok.literal_as_string);
+		index != keyword_lookup.npos)
+		tok.id = keyword_list[index].id;
 }
 bool reshadefx::lexer::parse_pp_directive(token &tok)
 {
@@ -819,10 +1015,10 @@ bool reshadefx::lexer::parse_pp_directive(token &tok)
 	skip_space(); // Skip any space between the '#' and directive
 	parse_identifier(tok);
 
-	if (const auto it = pp_directive_lookup.find(tok.literal_as_string);
-		it != pp_directive_lookup.end())
+	if (const size_t index = pp_directive_lookup.find(tok.literal_as_string);
+		index != pp_directive_lookup.npos)
 	{
-		tok.id = it->second;
+		tok.id = pp_directive_list[index].id;
 		return true;
 	}
 	else if (!_ignore_line_directives && tok.literal_as_string == "line") // The #line directive needs special handling
@@ -846,7 +1042,7 @@ bool reshadefx::lexer::parse_pp_directive(token &tok)
 			token temptok;
 			parse_string_literal(temptok, false);
 
-			_cur_location.source = std::move(temptok.literal_as_string);
+			_cur_location.source = intern_global_string(temptok.literal_as_string);
 		}
 
 		// Do not return the #line directive as token to the caller
@@ -6,6 +6,8 @@
 #pragma once
 
 #include "effect_token.hpp"
+#include <memory> // std::shared_ptr
+#include <string_view>
 
 namespace reshadefx
 {
@@ -15,6 +17,9 @@ namespace reshadefx
 	class lexer
 	{
 	public:
+		/// <summary>
+		/// Creates a lexical analyzer that takes ownership of the specified <paramref name="input"/> string.
+		/// </summary>
 		explicit lexer(
 			std::string input,
 			bool ignore_comments = true,
@@ -24,7 +29,7 @@ namespace reshadefx
 			bool ignore_keywords = false,
 			bool escape_string_literals = true,
 			const location &start_location = location()) :
-			_input(std::move(input)),
+			_input_storage(std::move(input)),
 			_cur_location(start_location),
 			_ignore_comments(ignore_comments),
 			_ignore_whitespace(ignore_whitespace),
@@ -33,17 +38,41 @@ namespace reshadefx
 			_ignore_keywords(ignore_keywords),
 			_escape_string_literals(escape_string_literals)
 		{
-			_cur = _input.data();
-			_end = _cur + _input.size();
+			set_input(_input_storage);
+		}
+		/// <summary>
+		/// Creates a lexical analyzer that works directly on the specified shared <paramref name="input"/> buffer, without copying it.
+		/// </summary>
+		explicit lexer(
+			std::shared_ptr<const std::string> input,
+			bool ignore_comments = true,
+			bool ignore_whitespace = true,
+			bool ignore_pp_directives = true,
+			bool ignore_line_directives = false,
+			bool ignore_keywords = false,
+			bool escape_string_literals = true,
+			const location &start_location = location()) :
+			_input_buffer(std::move(input)),
+			_cur_location(start_location),
+			_ignore_comments(ignore_comments),
+			_ignore_whitespace(ignore_whitespace),
+			_ignore_pp_directives(ignore_pp_directives),
+			_ignore_line_directives(ignore_line_directives),
+			_ignore_keywords(ignore_keywords),
+			_escape_string_literals(escape_string_literals)
+		{
+			set_input(*_input_buffer);
 		}
 
 		lexer(const lexer &lexer) { operator=(lexer); }
 		lexer &operator=(const lexer &lexer)
 		{
-			_input = lexer._input;
+			// Shared input buffers are shared with the copy too, only owned input strings have to be copied
+			_input_storage = lexer._input_storage;
+			_input_buffer = lexer._input_buffer;
+			set_input(_input_buffer != nullptr ? *_input_buffer : _input_storage);
 			_cur_location = lexer._cur_location;
-			reset_to_offset(lexer._cur - lexer._input.data());
-			_end = _input.data() + _input.size();
+			reset_to_offset(lexer.input_offset());
 			_ignore_comments = lexer._ignore_comments;
 			_ignore_whitespace = lexer._ignore_whitespace;
 			_ignore_pp_directives = lexer._ignore_pp_directives;
@@ -62,8 +91,8 @@ namespace reshadefx
 		/// <summary>
 		/// Gets the input string this lexical analyzer works on.
 		/// </summary>
-		/// <returns>Constant reference to the input string.</returns>
-		const std::string &input_string() const { return _input; }
+		/// <returns>View of the input string, which stays valid for the lifetime of this lexical analyzer.</returns>
+		std::string_view input_string() const { return _input; }
 
 		/// <summary>
 		/// Performs lexical analysis on the input string and return the next token in sequence.
@@ -87,6 +116,14 @@ namespace reshadefx
 		void reset_to_offset(size_t offset);
 
 	private:
+		void set_input(const std::string &input)
+		{
+			// Input is expected to be null-terminated, since lexical analysis stops at the first null character
+			_input = input;
+			_cur = _input.data();
+			_end = _cur + _input.size();
+		}
+
 		/// <summary>
 		/// Skips an arbitrary amount of characters in the input string.
 		/// </summary>
@@ -98,7 +135,9 @@ namespace reshadefx
 		void parse_string_literal(token &tok, bool escape);
 		void parse_numeric_literal(token &tok) const;
 
-		std::string _input;
+		std::string _input_storage;
+		std::shared_ptr<const std::string> _input_buffer;
+		std::string_view _input;
 		location _cur_location;
 		const std::string::value_type *_cur, *_end;
 		bool _ignore_comments;
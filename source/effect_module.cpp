@@ -0,0 +1,472 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "effect_module.hpp"
+#include <cstring> // std::memcpy
+#include <algorithm> // std::count
+#include <type_traits>
+
+static constexpr uint32_t MODULE_MAGIC = 0x4D584652; // "RFXM"
+static constexpr uint32_t MODULE_VERSION = 2;
+
+// Maximum nesting depth of array constants accepted when reading, so that corrupted data cannot cause a stack overflow
+static constexpr uint32_t MAX_ARRAY_DEPTH = 16;
+
+class module_writer
+{
+public:
+	explicit module_writer(std::string &data) : _data(data) {}
+
+	template <typename T>
+	std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> write(T value)
+	{
+		_data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	template <typename T, size_t N>
+	void write(const T (&values)[N])
+	{
+		for (const T &value : values)
+			write(value);
+	}
+	template <typename T1, typename T2>
+	void write(const std::pair<T1, T2> &value)
+	{
+		write(value.first);
+		write(value.second);
+	}
+	template <typename T>
+	void write(const std::vector<T> &values)
+	{
+		write(static_cast<uint32_t>(values.size()));
+		for (const T &value : values)
+			write(value);
+	}
+
+	void write(const std::string &value)
+	{
+		write(static_cast<uint32_t>(value.size()));
+		_data.append(value);
+	}
+	void write(const std::vector<uint32_t> &values)
+	{
+		write(static_cast<uint32_t>(values.size()));
+		_data.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(uint32_t));
+	}
+
+	void write(const reshadefx::type &value)
+	{
+		write(value.base);
+		write(value.rows);
+		write(value.cols);
+		write(value.qualifiers);
+		write(value.array_length);
+		write(value.definition);
+	}
+	void write(const reshadefx::constant &value)
+	{
+		write(value.as_uint);
+		write(value.string_data);
+		write(value.array_data);
+	}
+	void write(const reshadefx::annotation &value)
+	{
+		write(value.type);
+		write(value.name);
+		write(value.value);
+	}
+
+	void write(const reshadefx::entry_point &value)
+	{
+		write(value.name);
+		write(value.type);
+		write(value.hlsl_ranges);
+	}
+	void write(const reshadefx::texture_info &value)
+	{
+		write(value.id);
+		write(value.binding);
+		write(value.name);
+		write(value.semantic);
+		write(value.unique_name);
+		write(value.annotations);
+		write(value.width);
+		write(value.height);
+		write(value.levels);
+		write(value.format);
+		write(value.render_target);
+		write(value.storage_access);
+	}
+	void write(const reshadefx::sampler_info &value)
+	{
+		write(value.id);
+		write(value.binding);
+		write(value.texture_binding);
+		write(value.name);
+		write(value.unique_name);
+		write(value.texture_name);
+		write(value.annotations);
+		write(value.filter);
+		write(value.address_u);
+		write(value.address_v);
+		write(value.address_w);
+		write(value.min_lod);
+		write(value.max_lod);
+		write(value.lod_bias);
+		write(value.srgb);
+	}
+	void write(const reshadefx::storage_info &value)
+	{
+		write(value.id);
+		write(value.binding);
+		write(value.name);
+		write(value.unique_name);
+		write(value.texture_name);
+		write(value.format);
+		write(value.level);
+	}
+	void write(const reshadefx::uniform_info &value)
+	{
+		write(value.name);
+		write(value.type);
+		write(value.size);
+		write(value.offset);
+		write(value.annotations);
+		write(value.has_initializer_value);
+		write(value.initializer_value);
+	}
+	void write(const reshadefx::pass_info &value)
+	{
+		write(value.name);
+		write(value.render_target_names);
+		write(value.vs_entry_point);
+		write(value.ps_entry_point);
+		write(value.cs_entry_point);
+		write(value.generate_mipmaps);
+		write(value.clear_render_targets);
+		write(value.srgb_write_enable);
+		write(value.blend_enable);
+		write(value.stencil_enable);
+		write(value.color_write_mask);
+		write(value.stencil_read_mask);
+		write(value.stencil_write_mask);
+		write(value.blend_op);
+		write(value.blend_op_alpha);
+		write(value.src_blend);
+		write(value.dest_blend);
+		write(value.src_blend_alpha);
+		write(value.dest_blend_alpha);
+		write(value.stencil_comparison_func);
+		write(value.stencil_reference_value);
+		write(value.stencil_op_pass);
+		write(value.stencil_op_fail);
+		write(value.stencil_op_depth_fail);
+		write(value.num_vertices);
+		write(value.topology);
+		write(value.viewport_width);
+		write(value.viewport_height);
+		write(value.viewport_dispatch_z);
+		write(value.samplers);
+		write(value.storages);
+	}
+	void write(const reshadefx::technique_info &value)
+	{
+		write(value.name);
+		write(value.passes);
+		write(value.annotations);
+	}
+
+private:
+	std::string &_data;
+};
+
+class module_reader
+{
+public:
+	explicit module_reader(const std::string_view &data) : _cur(data.data()), _end(data.data() + data.size()) {}
+
+	/// <summary>
+	/// Gets a boolean indicating whether all reads so far were within the bounds of the data.
+	/// </summary>
+	bool ok() const { return !_failed; }
+	/// <summary>
+	/// Gets a boolean indicating whether all data was read.
+	/// </summary>
+	bool at_end() const { return _cur == _end; }
+
+	template <typename T>
+	std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>> read(T &value)
+	{
+		if (!check(sizeof(value)))
+			return;
+		std::memcpy(&value, _cur, sizeof(value));
+		_cur += sizeof(value);
+	}
+	template <typename T, size_t N>
+	void read(T (&values)[N])
+	{
+		for (T &value : values)
+			read(value);
+	}
+	template <typename T1, typename T2>
+	void read(std::pair<T1, T2> &value)
+	{
+		read(value.first);
+		read(value.second);
+	}
+	template <typename T>
+	void read(std::vector<T> &values)
+	{
+		uint32_t size = 0;
+		read(size);
+		// Every element takes up at least one byte, which limits the amount of elements that can be in the remaining data
+		if (!check(size))
+			return;
+		values.resize(size);
+		for (T &value : values)
+			read(value);
+	}
+
+	void read(std::string &value)
+	{
+		uint32_t size = 0;
+		read(size);
+		if (!check(size))
+			return;
+		value.assign(_cur, size);
+		_cur += size;
+	}
+	void read(std::vector<uint32_t> &values)
+	{
+		uint32_t size = 0;
+		read(size);
+		if (!check(static_cast<size_t>(size) * sizeof(uint32_t)))
+			return;
+		values.resize(size);
+		if (size != 0) // Data of an empty vector may be a null pointer
+			std::memcpy(values.data(), _cur, size * sizeof(uint32_t));
+		_cur += size * sizeof(uint32_t);
+	}
+
+	void read(reshadefx::type &value)
+	{
+		read(value.base);
+		read(value.rows);
+		read(value.cols);
+		read(value.qualifiers);
+		read(value.array_length);
+		read(value.definition);
+	}
+	void read(reshadefx::constant &value)
+	{
+		read(value.as_uint);
+		read(value.string_data);
+
+		// Array constants can only be nested as deep as array types can be, so reject anything deeper than that
+		if (_array_depth++ >= MAX_ARRAY_DEPTH)
+			_failed = true;
+		else
+			read(value.array_data);
+		_array_depth--;
+	}
+	void read(reshadefx::annotation &value)
+	{
+		read(value.type);
+		read(value.name);
+		read(value.value);
+	}
+
+	void read(reshadefx::entry_point &value)
+	{
+		read(value.name);
+		read(value.type);
+		read(value.hlsl_ranges);
+	}
+	void read(reshadefx::texture_info &value)
+	{
+		read(value.id);
+		read(value.binding);
+		read(value.name);
+		read(value.semantic);
+		read(value.unique_name);
+		read(value.annotations);
+		read(value.width);
+		read(value.height);
+		read(value.levels);
+		read(value.format);
+		read(value.render_target);
+		read(value.storage_access);
+	}
+	void read(reshadefx::sampler_info &value)
+	{
+		read(value.id);
+		read(value.binding);
+		read(value.texture_binding);
+		read(value.name);
+		read(value.unique_name);
+		read(value.texture_name);
+		read(value.annotations);
+		read(value.filter);
+		read(value.address_u);
+		read(value.address_v);
+		read(value.address_w);
+		read(value.min_lod);
+		read(value.max_lod);
+		read(value.lod_bias);
+		read(value.srgb);
+	}
+	void read(reshadefx::storage_info &value)
+	{
+		read(value.id);
+		read(value.binding);
+		read(value.name);
+		read(value.unique_name);
+		read(value.texture_name);
+		read(value.format);
+		read(value.level);
+	}
+	void read(reshadefx::uniform_info &value)
+	{
+		read(value.name);
+		read(value.type);
+		read(value.size);
+		read(value.offset);
+		read(value.annotations);
+		read(value.has_initializer_value);
+		read(value.initializer_value);
+	}
+	void read(reshadefx::pass_info &value)
+	{
+		read(value.name);
+		read(value.render_target_names);
+		read(value.vs_entry_point);
+		read(value.ps_entry_point);
+		read(value.cs_entry_point);
+		read(value.generate_mipmaps);
+		read(value.clear_render_targets);
+		read(value.srgb_write_enable);
+		read(value.blend_enable);
+		read(value.stencil_enable);
+		read(value.color_write_mask);
+		read(value.stencil_read_mask);
+		read(value.stencil_write_mask);
+		read(value.blend_op);
+		read(value.blend_op_alpha);
+		read(value.src_blend);
+		read(value.dest_blend);
+		read(value.src_blend_alpha);
+		read(value.dest_blend_alpha);
+		read(value.stencil_comparison_func);
+		read(value.stencil_reference_value);
+		read(value.stencil_op_pass);
+		read(value.stencil_op_fail);
+		read(value.stencil_op_depth_fail);
+		read(value.num_vertices);
+		read(value.topology);
+		read(value.viewport_width);
+		read(value.viewport_height);
+		read(value.viewport_dispatch_z);
+		read(value.samplers);
+		read(value.storages);
+	}
+	void read(reshadefx::technique_info &value)
+	{
+		read(value.name);
+		read(value.passes);
+		read(value.annotations);
+	}
+
+private:
+	bool check(size_t size)
+	{
+		if (_failed || size > static_cast<size_t>(_end - _cur))
+			_failed = true;
+		return !_failed;
+	}
+
+	const char *_cur, *_end;
+	bool _failed = false;
+	uint32_t _array_depth = 0;
+};
+
+void reshadefx::serialize_module(const module &module, std::string &data)
+{
+	data.clear();
+
+	module_writer writer(data);
+	writer.write(MODULE_MAGIC);
+	writer.write(MODULE_VERSION);
+
+	writer.write(module.hlsl);
+	writer.write(module.spirv);
+	writer.write(module.entry_points);
+	writer.write(module.textures);
+	writer.write(module.samplers);
+	writer.write(module.storages);
+	writer.write(module.uniforms);
+	writer.write(module.spec_constants);
+	writer.write(module.techniques);
+	writer.write(module.total_uniform_size);
+	writer.write(module.num_texture_bindings);
+	writer.write(module.num_sampler_bindings);
+	writer.write(module.num_storage_bindings);
+}
+
+bool reshadefx::deserialize_module(module &module, const std::string_view &data)
+{
+	module_reader reader(data);
+
+	uint32_t magic = 0, version = 0;
+	reader.read(magic);
+	reader.read(version);
+	if (!reader.ok() || magic != MODULE_MAGIC || version != MODULE_VERSION)
+		return false;
+
+	reshadefx::module result;
+	reader.read(result.hlsl);
+	reader.read(result.spirv);
+	reader.read(result.entry_points);
+	reader.read(result.textures);
+	reader.read(result.samplers);
+	reader.read(result.storages);
+	reader.read(result.uniforms);
+	reader.read(result.spec_constants);
+	reader.read(result.techniques);
+	reader.read(result.total_uniform_size);
+	reader.read(result.num_texture_bindings);
+	reader.read(result.num_sampler_bindings);
+	reader.read(result.num_storage_bindings);
+
+	if (!reader.ok() || !reader.at_end())
+		return false;
+
+	// Code ranges are used to index into the code, so make sure they are in bounds
+	for (const entry_point &entry_point : result.entry_points)
+		for (size_t i = 0, offset = 0; i < entry_point.hlsl_ranges.size(); offset = entry_point.hlsl_ranges[i++].second)
+			if (entry_point.hlsl_ranges[i].first < offset || entry_point.hlsl_ranges[i].second < entry_point.hlsl_ranges[i].first || entry_point.hlsl_ranges[i].second > result.hlsl.size())
+				return false;
+
+	module = std::move(result);
+	return true;
+}
+
+std::string reshadefx::get_entry_point_hlsl(const module &module, const entry_point &entry_point)
+{
+	if (entry_point.hlsl_ranges.empty())
+		return module.hlsl;
+
+	std::string code;
+	code.reserve(module.hlsl.size());
+
+	size_t offset = 0;
+	for (const auto &[begin, end] : entry_point.hlsl_ranges)
+	{
+		code.append(std::count(module.hlsl.begin() + offset, module.hlsl.begin() + begin, '\n'), '\n');
+		code.append(module.hlsl, begin, end - begin);
+		offset = end;
+	}
+	code.append(std::count(module.hlsl.begin() + offset, module.hlsl.end(), '\n'), '\n');
+
+	return code;
+}
@@ -248,6 +248,8 @@ namespace reshadefx
 	{
 		std::string name;
 		shader_type type;
+		// Begin and end offsets of the parts of the module HLSL code this entry point uses, in ascending order (empty if it needs all of it, see 'get_entry_point_hlsl')
+		std::vector<std::pair<uint32_t, uint32_t>> hlsl_ranges;
 	};
 
 	/// <summary>
@@ -333,4 +335,26 @@ namespace reshadefx
 		uint32_t num_sampler_bindings = 0;
 		uint32_t num_storage_bindings = 0;
 	};
+
+	/// <summary>
+	/// Builds the HLSL code to compile the specified entry point of a module with, which only has the declarations this entry point uses.
+	/// All other code is replaced with empty lines, so that line numbers in errors and warnings still match the whole module.
+	/// </summary>
+	/// <param name="module">Module the entry point belongs to.</param>
+	/// <param name="entry_point">Entry point to build the code for.</param>
+	std::string get_entry_point_hlsl(const module &module, const entry_point &entry_point);
+
+	/// <summary>
+	/// Writes a module to a versioned binary representation, so that it can be stored (e.g. in a cache) and loaded again later without having to compile the effect.
+	/// </summary>
+	/// <param name="module">Module to serialize.</param>
+	/// <param name="data">Target to write the serialized data to.</param>
+	void serialize_module(const module &module, std::string &data);
+	/// <summary>
+	/// Reads a module from data that was written by <see cref="serialize_module"/>.
+	/// </summary>
+	/// <param name="module">Target module, which is only modified if the data could be read successfully.</param>
+	/// <param name="data">Serialized data to read.</param>
+	/// <returns><see langword="true"/> if the data was read successfully, <see langword="false"/> if it is corrupted or was written with a different version of the format.</returns>
+	bool deserialize_module(module &module, const std::string_view &data);
 }
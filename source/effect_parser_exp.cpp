@@ -582,7 +582,7 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 	else if (accept('{'))
 	{
 		bool is_constant = true;
-		std::vector<expression> elements;
+		expression_list elements;
 		type composite_type = { type::t_void, 1, 1 };
 
 		while (!peek('}'))
@@ -693,7 +693,7 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 		// Parse entire argument expression list
 		bool is_constant = true;
 		unsigned int num_components = 0;
-		std::vector<expression> arguments;
+		expression_list arguments;
 
 		while (!peek(')'))
 		{
@@ -798,7 +798,7 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 				return error(location, 3005, "identifier '" + identifier + "' represents a variable, not a function"), false;
 
 			// Parse entire argument expression list
-			std::vector<expression> arguments;
+			expression_list arguments;
 
 			while (!peek(')'))
 			{
@@ -817,10 +817,6 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 			if (!expect(')'))
 				return false;
 
-			// Function calls can only be made from within functions
-			if (!_codegen->is_in_function())
-				return error(location, 3005, "invalid function call outside of a function"), false;
-
 			// Try to resolve the call by searching through both function symbols and intrinsics
 			bool undeclared = !symbol.id, ambiguous = false;
 
@@ -837,91 +833,122 @@ bool reshadefx::parser::parse_expression_unary(expression &exp)
 
 			assert(symbol.function != nullptr);
 
-			std::vector<expression> parameters(arguments.size());
+			// Evaluate calls to intrinsics with only constant arguments at compile time, so that no code has to be generated for them
+			bool is_constant = symbol.op == symbol_type::intrinsic;
+			for (size_t i = 0; i < arguments.size() && is_constant; ++i)
+				is_constant = arguments[i].is_constant;
 
-			// We need to allocate some temporary variables to pass in and load results from pointer parameters
-			for (size_t i = 0; i < arguments.size(); ++i)
+			reshadefx::constant value;
+			if (is_constant)
 			{
-				const auto &param_type = symbol.function->parameter_list[i].type;
+				expression_list constant_arguments(arguments);
+				for (size_t i = 0; i < constant_arguments.size(); ++i)
+					constant_arguments[i].add_cast_operation(symbol.function->parameter_list[i].type);
 
-				if (param_type.has(type::q_out) && (arguments[i].type.has(type::q_const) || !arguments[i].is_lvalue))
-					return error(arguments[i].location, 3025, "l-value specifies const object for an 'out' parameter"), false;
+				is_constant = evaluate_constant_intrinsic(symbol.id, symbol.type, constant_arguments, value);
+			}
 
-				if (arguments[i].type.components() > param_type.components())
-					warning(arguments[i].location, 3206, "implicit truncation of vector type");
+			if (is_constant)
+			{
+				for (size_t i = 0; i < arguments.size(); ++i)
+					if (arguments[i].type.components() > symbol.function->parameter_list[i].type.components())
+						warning(arguments[i].location, 3206, "implicit truncation of vector type");
 
-				if (symbol.op == symbol_type::function || param_type.has(type::q_out))
+				exp.reset_to_rvalue_constant(location, std::move(value), symbol.type);
+			}
+			// Function calls that are not evaluated at compile time can only be made from within functions
+			else if (!_codegen->is_in_function())
+			{
+				return error(location, 3005, "invalid function call outside of a function"), false;
+			}
+			else
+			{
+				expression_list parameters(arguments.size());
+
+				// We need to allocate some temporary variables to pass in and load results from pointer parameters
+				for (size_t i = 0; i < arguments.size(); ++i)
 				{
-					if (param_type.is_sampler() || param_type.is_storage() || param_type.has(type::q_groupshared) /* Special case for atomic intrinsics */)
+					const auto &param_type = symbol.function->parameter_list[i].type;
+
+					if (param_type.has(type::q_out) && (arguments[i].type.has(type::q_const) || !arguments[i].is_lvalue))
+						return error(arguments[i].location, 3025, "l-value specifies const object for an 'out' parameter"), false;
+
+					if (arguments[i].type.components() > param_type.components())
+						warning(arguments[i].location, 3206, "implicit truncation of vector type");
+
+					if (symbol.op == symbol_type::function || param_type.has(type::q_out))
 					{
-						if (arguments[i].type != param_type)
-							return error(location, 3004, "no matching intrinsic overload for '" + identifier + '\''), false;
+						if (param_type.is_sampler() || param_type.is_storage() || param_type.has(type::q_groupshared) /* Special case for atomic intrinsics */)
+						{
+							if (arguments[i].type != param_type)
+								return error(location, 3004, "no matching intrinsic overload for '" + identifier + '\''), false;
 
-						assert(arguments[i].is_lvalue);
+							assert(arguments[i].is_lvalue);
 
-						// Do not shadow object or pointer parameters to function calls
-						size_t chain_index = 0;
-						const auto access_chain = _codegen->emit_access_chain(arguments[i], chain_index);
-						parameters[i].reset_to_lvalue(arguments[i].location, access_chain, param_type);
-						assert(chain_index == arguments[i].chain.size());
+							// Do not shadow object or pointer parameters to function calls
+							size_t chain_index = 0;
+							const auto access_chain = _codegen->emit_access_chain(arguments[i], chain_index);
+							parameters[i].reset_to_lvalue(arguments[i].location, access_chain, param_type);
+							assert(chain_index == arguments[i].chain.size());
 
-						// This is referencing a l-value, but want to avoid copying below
-						parameters[i].is_lvalue = false;
+							// This is referencing a l-value, but want to avoid copying below
+							parameters[i].is_lvalue = false;
+						}
+						else
+						{
+							// All user-defined functions actually accept pointers as arguments, same applies to intrinsics with 'out' parameters
+							const auto temp_variable = _codegen->define_variable(arguments[i].location, param_type);
+							parameters[i].reset_to_lvalue(arguments[i].location, temp_variable, param_type);
+						}
 					}
 					else
 					{
-						// All user-defined functions actually accept pointers as arguments, same applies to intrinsics with 'out' parameters
-						const auto temp_variable = _codegen->define_variable(arguments[i].location, param_type);
-						parameters[i].reset_to_lvalue(arguments[i].location, temp_variable, param_type);
-					}
-				}
-				else
-				{
-					expression arg = arguments[i];
-					arg.add_cast_operation(param_type);
-					parameters[i].reset_to_rvalue(arg.location, _codegen->emit_load(arg), param_type);
+						expression arg = arguments[i];
+						arg.add_cast_operation(param_type);
+						parameters[i].reset_to_rvalue(arg.location, _codegen->emit_load(arg), param_type);
 
-					// Keep track of whether the parameter is a constant for code generation (this makes the expression invalid for all other uses)
-					parameters[i].is_constant = arg.is_constant;
+						// Keep track of whether the parameter is a constant for code generation (this makes the expression invalid for all other uses)
+						parameters[i].is_constant = arg.is_constant;
+					}
 				}
-			}
 
-			// Copy in parameters from the argument access chains to parameter variables
-			for (size_t i = 0; i < arguments.size(); ++i)
-			{
-				// Only do this for pointer parameters as discovered above
-				if (parameters[i].is_lvalue && parameters[i].type.has(type::q_in) && !parameters[i].type.is_sampler() && !parameters[i].type.is_storage())
+				// Copy in parameters from the argument access chains to parameter variables
+				for (size_t i = 0; i < arguments.size(); ++i)
 				{
-					expression arg = arguments[i];
-					arg.add_cast_operation(parameters[i].type);
-					_codegen->emit_store(parameters[i], _codegen->emit_load(arg));
+					// Only do this for pointer parameters as discovered above
+					if (parameters[i].is_lvalue && parameters[i].type.has(type::q_in) && !parameters[i].type.is_sampler() && !parameters[i].type.is_storage())
+					{
+						expression arg = arguments[i];
+						arg.add_cast_operation(parameters[i].type);
+						_codegen->emit_store(parameters[i], _codegen->emit_load(arg));
+					}
 				}
-			}
 
-			// Check if the call resolving found an intrinsic or function and invoke the corresponding code
-			const auto result = symbol.op == symbol_type::function ?
-				_codegen->emit_call(location, symbol.id, symbol.type, parameters) :
-				_codegen->emit_call_intrinsic(location, symbol.id, symbol.type, parameters);
+				// Check if the call resolving found an intrinsic or function and invoke the corresponding code
+				const auto result = symbol.op == symbol_type::function ?
+					_codegen->emit_call(location, symbol.id, symbol.type, parameters) :
+					_codegen->emit_call_intrinsic(location, symbol.id, symbol.type, parameters);
 
-			exp.reset_to_rvalue(location, result, symbol.type);
+				exp.reset_to_rvalue(location, result, symbol.type);
 
-			// Copy out parameters from parameter variables back to the argument access chains
-			for (size_t i = 0; i < arguments.size(); ++i)
-			{
-				// Only do this for pointer parameters as discovered above
-				if (parameters[i].is_lvalue && parameters[i].type.has(type::q_out) && !parameters[i].type.is_sampler() && !parameters[i].type.is_storage())
+				// Copy out parameters from parameter variables back to the argument access chains
+				for (size_t i = 0; i < arguments.size(); ++i)
 				{
-					expression arg = parameters[i];
-					arg.add_cast_operation(arguments[i].type);
-					_codegen->emit_store(arguments[i], _codegen->emit_load(arg));
+					// Only do this for pointer parameters as discovered above
+					if (parameters[i].is_lvalue && parameters[i].type.has(type::q_out) && !parameters[i].type.is_sampler() && !parameters[i].type.is_storage())
+					{
+						expression arg = parameters[i];
+						arg.add_cast_operation(arguments[i].type);
+						_codegen->emit_store(arguments[i], _codegen->emit_load(arg));
+					}
 				}
-			}
 
-			if (_current_function != nullptr)
-			{
-				// Calling a function makes the caller inherit all sampler and storage object references from the callee
-				_current_function->referenced_samplers.insert(symbol.function->referenced_samplers.begin(), symbol.function->referenced_samplers.end());
-				_current_function->referenced_storages.insert(symbol.function->referenced_storages.begin(), symbol.function->referenced_storages.end());
+				if (_current_function != nullptr)
+				{
+					// Calling a function makes the caller inherit all sampler and storage object references from the callee
+					_current_function->referenced_samplers.insert(symbol.function->referenced_samplers.begin(), symbol.function->referenced_samplers.end());
+					_current_function->referenced_storages.insert(symbol.function->referenced_storages.begin(), symbol.function->referenced_storages.end());
+				}
 			}
 		}
 		else if (symbol.op == symbol_type::invalid)
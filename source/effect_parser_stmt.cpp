@@ -7,6 +7,7 @@
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include <cassert>
+#include <limits> // std::numeric_limits
 #include <functional>
 
 struct on_scope_exit
@@ -24,6 +25,9 @@ bool reshadefx::parser::parse(std::string input, codegen *backend)
 	// Set backend for subsequent code-generation
 	_codegen = backend;
 
+	// Allocate expressions created during parsing from the arena of this parser instead of the heap
+	const arena::scope arena_scope(_arena);
+
 	consume();
 
 	bool parse_success = true;
@@ -881,7 +885,7 @@ bool reshadefx::parser::parse_struct()
 	else
 		info.name = "_anonymous_struct_" + std::to_string(location.line) + '_' + std::to_string(location.column);
 
-	info.unique_name = 'S' + current_scope().name + info.name;
+	info.unique_name = 'S' + std::string(current_scope().name) + info.name;
 	std::replace(info.unique_name.begin(), info.unique_name.end(), ':', '_');
 
 	if (!expect('{'))
@@ -999,7 +1003,7 @@ bool reshadefx::parser::parse_function(type type, std::string name)
 
 	function_info info;
 	info.name = name;
-	info.unique_name = 'F' + current_scope().name + name;
+	info.unique_name = 'F' + std::string(current_scope().name) + name;
 	std::replace(info.unique_name.begin(), info.unique_name.end(), ':', '_');
 
 	info.return_type = type;
@@ -1436,7 +1440,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 
 		texture_info.name = name;
 		// Add namespace scope to avoid name clashes
-		texture_info.unique_name = 'V' + current_scope().name + name;
+		texture_info.unique_name = 'V' + std::string(current_scope().name) + name;
 		std::replace(texture_info.unique_name.begin(), texture_info.unique_name.end(), ':', '_');
 
 		texture_info.annotations = std::move(sampler_info.annotations);
@@ -1456,7 +1460,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 
 		sampler_info.name = name;
 		// Add namespace scope to avoid name clashes
-		sampler_info.unique_name = 'V' + current_scope().name + name;
+		sampler_info.unique_name = 'V' + std::string(current_scope().name) + name;
 		std::replace(sampler_info.unique_name.begin(), sampler_info.unique_name.end(), ':', '_');
 
 		symbol = { symbol_type::variable, 0, type };
@@ -1471,7 +1475,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 
 		storage_info.name = name;
 		// Add namespace scope to avoid name clashes
-		storage_info.unique_name = 'V' + current_scope().name + name;
+		storage_info.unique_name = 'V' + std::string(current_scope().name) + name;
 		std::replace(storage_info.unique_name.begin(), storage_info.unique_name.end(), ':', '_');
 
 		storage_info.format = texture_info.format;
@@ -1502,7 +1506,7 @@ bool reshadefx::parser::parse_variable(type type, std::string name, bool global)
 	else
 	{
 		// Update global variable names to contain the namespace scope to avoid name clashes
-		std::string unique_name = global ? 'V' + current_scope().name + name : name;
+		std::string unique_name = global ? 'V' + std::string(current_scope().name) + name : name;
 		std::replace(unique_name.begin(), unique_name.end(), ':', '_');
 
 		symbol = { symbol_type::variable, 0, type };
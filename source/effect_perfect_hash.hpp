@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace reshadefx
+{
+	/// <summary>
+	/// A hash table for a fixed set of unique strings that is built at compile time and is free of collisions, so that a lookup only needs to hash the string and compare it against a single key.
+	/// Keys are first distributed into buckets, and every bucket then gets a seed with which all of its keys map to slots that are not occupied yet (hash and displace).
+	/// Building the table takes roughly linear time in the number of keys, so that it stays well within the step limits compilers impose on constant evaluation. Check <see cref="valid"/> with a "static_assert" after declaring a table.
+	/// </summary>
+	/// <typeparam name="NUM_KEYS">Number of strings in the table.</typeparam>
+	template <size_t NUM_KEYS>
+	class perfect_hash_table
+	{
+		static_assert(NUM_KEYS != 0 && NUM_KEYS < 0xFFFF, "invalid number of keys");
+
+		static constexpr size_t num_buckets = (NUM_KEYS + 1) / 2;
+		static constexpr size_t num_slots = [] {
+			// Keep the table at most half full, so that seeds are found quickly
+			size_t size = 1;
+			while (size < 2 * NUM_KEYS)
+				size *= 2;
+			return size;
+		}();
+
+		using slot_type = std::conditional_t<(NUM_KEYS < 0xFF), uint8_t, uint16_t>;
+
+	public:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		constexpr explicit perfect_hash_table(const std::string_view (&keys)[NUM_KEYS]) : _keys(), _seeds(), _slots()
+		{
+			for (size_t i = 0; i < NUM_KEYS; ++i)
+				_keys[i] = keys[i];
+			build();
+		}
+		template <typename T>
+		constexpr perfect_hash_table(const T (&items)[NUM_KEYS], std::string_view T::*key) : _keys(), _seeds(), _slots()
+		{
+			for (size_t i = 0; i < NUM_KEYS; ++i)
+				_keys[i] = items[i].*key;
+			build();
+		}
+
+		/// <summary>
+		/// Gets a boolean indicating whether the table was built successfully, which fails if the keys contain duplicates.
+		/// </summary>
+		constexpr bool valid() const { return _valid; }
+
+		/// <summary>
+		/// Finds the index of the specified string in the list of keys the table was built from.
+		/// </summary>
+		/// <returns>The index of the matching key, or <see cref="npos"/> if the string is not one of the keys.</returns>
+		constexpr size_t find(const std::string_view &key) const
+		{
+			const uint32_t key_hash = hash(key);
+			const slot_type slot = _slots[mix(key_hash, _seeds[key_hash % num_buckets]) & (num_slots - 1)];
+			if (slot == 0 || _keys[slot - 1] != key)
+				return npos;
+			return slot - 1;
+		}
+
+	private:
+		constexpr void build()
+		{
+			uint32_t hashes[NUM_KEYS] = {};
+			for (size_t i = 0; i < NUM_KEYS; ++i)
+				hashes[i] = hash(_keys[i]);
+
+			// Sort keys by bucket, so that the keys of each bucket are next to each other
+			size_t bucket_offsets[num_buckets + 1] = {};
+			for (size_t i = 0; i < NUM_KEYS; ++i)
+				bucket_offsets[hashes[i] % num_buckets + 1]++;
+			size_t max_bucket_size = 0;
+			for (size_t b = 0; b < num_buckets; ++b)
+			{
+				if (bucket_offsets[b + 1] > max_bucket_size)
+					max_bucket_size = bucket_offsets[b + 1];
+				bucket_offsets[b + 1] += bucket_offsets[b];
+			}
+
+			size_t bucket_keys[NUM_KEYS] = {};
+			size_t bucket_fill[num_buckets] = {};
+			for (size_t i = 0; i < NUM_KEYS; ++i)
+			{
+				const size_t b = hashes[i] % num_buckets;
+				bucket_keys[bucket_offsets[b] + bucket_fill[b]++] = i;
+			}
+
+			// Place the largest buckets first, while most slots are still free (ordered with a counting sort, so that this stays linear in the number of keys)
+			size_t size_offsets[NUM_KEYS + 2] = {};
+			for (size_t b = 0; b < num_buckets; ++b)
+				size_offsets[max_bucket_size - (bucket_offsets[b + 1] - bucket_offsets[b]) + 1]++;
+			for (size_t size = 0; size < max_bucket_size; ++size)
+				size_offsets[size + 1] += size_offsets[size];
+
+			size_t bucket_order[num_buckets] = {};
+			for (size_t b = 0; b < num_buckets; ++b)
+				bucket_order[size_offsets[max_bucket_size - (bucket_offsets[b + 1] - bucket_offsets[b])]++] = b;
+
+			size_t key_slots[NUM_KEYS] = {};
+			for (const size_t b : bucket_order)
+			{
+				const size_t size = bucket_offsets[b + 1] - bucket_offsets[b];
+				if (size == 0)
+					break; // All remaining buckets are empty too
+
+				for (uint32_t seed = 1; _seeds[b] == 0; ++seed)
+				{
+					_seeds[b] = seed;
+
+					for (size_t k = 0; k < size && _seeds[b] != 0; ++k)
+					{
+						const size_t i = bucket_keys[bucket_offsets[b] + k];
+						key_slots[i] = mix(hashes[i], seed) & (num_slots - 1);
+
+						// Slot has to be free and must not be used by another key of the same bucket
+						if (_slots[key_slots[i]] != 0)
+							_seeds[b] = 0;
+						for (size_t j = 0; j < k && _seeds[b] != 0; ++j)
+						{
+							const size_t other = bucket_keys[bucket_offsets[b] + j];
+							if (key_slots[other] != key_slots[i])
+								continue;
+
+							// Identical keys always end up in the same slot, so no seed can ever separate them
+							if (hashes[other] == hashes[i] && _keys[other] == _keys[i])
+							{
+								_valid = false;
+								return;
+							}
+
+							_seeds[b] = 0;
+						}
+					}
+				}
+
+				for (size_t k = 0; k < size; ++k)
+				{
+					const size_t i = bucket_keys[bucket_offsets[b] + k];
+					_slots[key_slots[i]] = static_cast<slot_type>(i + 1);
+				}
+			}
+		}
+
+		static constexpr uint32_t hash(const std::string_view &key)
+		{
+			// FNV-1a
+			uint32_t hash = 2166136261u;
+			for (const char c : key)
+				hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+			return hash;
+		}
+		static constexpr uint32_t mix(uint32_t hash, uint32_t seed)
+		{
+			hash ^= seed * 0x9e3779b9u;
+			hash ^= hash >> 16;
+			hash *= 0x7feb352du;
+			hash ^= hash >> 15;
+			hash *= 0x846ca68bu;
+			hash ^= hash >> 16;
+			return hash;
+		}
+
+		std::string_view _keys[NUM_KEYS];
+		uint32_t _seeds[num_buckets];
+		slot_type _slots[num_slots];
+		bool _valid = true;
+	};
+}
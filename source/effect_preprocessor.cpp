@@ -5,9 +5,10 @@
 
 #include "effect_lexer.hpp"
 #include "effect_preprocessor.hpp"
+#include <mutex>
 #include <cassert>
 #include <fstream>
-#include <algorithm> // std::find_if
+#include <algorithm> // std::find_if, std::sort
 
 #ifndef _WIN32
 	// On Linux systems the native path encoding is UTF-8 already, so no conversion necessary
@@ -97,6 +98,20 @@ static bool read_file(const std::filesystem::path &path, std::string &data)
 	return true;
 }
 
+template <typename T>
+static std::unique_ptr<reshadefx::lexer> create_lexer(T input, const reshadefx::location &start_location)
+{
+	return std::make_unique<reshadefx::lexer>(
+		std::move(input),
+		true  /* ignore_comments */,
+		false /* ignore_whitespace */,
+		false /* ignore_pp_directives */,
+		false /* ignore_line_directives */,
+		true  /* ignore_keywords */,
+		false /* escape_string_literals */,
+		start_location);
+}
+
 static std::string escape_string(std::string s)
 {
 	for (size_t offset = 0; (offset = s.find('\\', offset)) != std::string::npos; offset += 2)
@@ -104,6 +119,94 @@ static std::string escape_string(std::string s)
 	return '\"' + s + '\"';
 }
 
+std::shared_ptr<const reshadefx::include_cache::file> reshadefx::include_cache::get(const std::filesystem::path &path)
+{
+	const std::string path_string = path.u8string();
+
+	std::error_code ec;
+	const std::filesystem::file_time_type modified_time = std::filesystem::last_write_time(path, ec);
+
+	size_t previous_content_hash = 0;
+	std::shared_ptr<const file> previous_file;
+
+	{ const std::shared_lock<std::shared_mutex> lock(_mutex);
+		if (const auto it = _files.find(path_string); it != _files.end())
+		{
+			if (!ec && it->second.modified_time == modified_time)
+				return it->second.lexed_file;
+
+			previous_content_hash = it->second.content_hash;
+			previous_file = it->second.lexed_file;
+		}
+	}
+
+	std::string data;
+	if (!read_file(path, data))
+		return nullptr;
+
+	// Only lex the file again if its contents actually changed (the modification time may change without that, e.g. when a file is saved again without any edits)
+	const size_t content_hash = std::hash<std::string>()(data);
+
+	std::shared_ptr<const file> result = std::move(previous_file);
+	if (result == nullptr || content_hash != previous_content_hash)
+		result = lex_file(std::move(data), path_string);
+
+	// Lexing happens outside the lock, so multiple threads may have done so for the same file at once, in which case the last one wins (they produced identical results anyway)
+	{ const std::unique_lock<std::shared_mutex> lock(_mutex);
+		entry &e = _files[path_string];
+		e.modified_time = ec ? std::filesystem::file_time_type() : modified_time;
+		e.content_hash = content_hash;
+		e.lexed_file = result;
+	}
+
+	return result;
+}
+void reshadefx::include_cache::clear()
+{
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	_files.clear();
+}
+
+std::shared_ptr<const reshadefx::include_cache::file> reshadefx::include_cache::load(const std::filesystem::path &path)
+{
+	std::string data;
+	if (!read_file(path, data))
+		return nullptr;
+
+	return lex_file(std::move(data), path.u8string());
+}
+
+std::shared_ptr<const reshadefx::include_cache::file> reshadefx::include_cache::lex_file(std::string data, const std::string &name)
+{
+	const auto result = std::make_shared<file>();
+	result->source_code = std::move(data);
+
+	// Lex with the same settings and start location as 'preprocessor::push' uses for files, so that replaying the token stream yields the exact same tokens
+	// The lexer shares ownership of the file, so that the source code does not have to be copied
+	const std::unique_ptr<lexer> lexer = create_lexer(std::shared_ptr<const std::string>(result, &result->source_code), location(name, 1));
+
+	do
+		result->tokens.push_back(lexer->lex());
+	while (result->tokens.back() != tokenid::end_of_file);
+
+	return result;
+}
+
+std::string_view reshadefx::preprocessor::input_level::input_string() const
+{
+	return cached_file != nullptr ? cached_file->source_code : lexer->input_string();
+}
+reshadefx::token reshadefx::preprocessor::input_level::lex()
+{
+	if (cached_file == nullptr)
+		return lexer->lex();
+
+	// Keep returning the end of file token once the end of the stream was reached, like the lexer does
+	const size_t index = std::min(next_cached_token++, cached_file->tokens.size() - 1);
+	return cached_file->tokens[index];
+}
+
 reshadefx::preprocessor::preprocessor()
 {
 }
@@ -170,15 +273,21 @@ std::vector<std::pair<std::string, std::string>> reshadefx::preprocessor::used_m
 			defines.push_back({ name, it->second.replacement_list });
 	return defines;
 }
+std::vector<std::string> reshadefx::preprocessor::referenced_macros() const
+{
+	std::vector<std::string> names(_referenced_macros.begin(), _referenced_macros.end());
+	std::sort(names.begin(), names.end());
+	return names;
+}
 
 void reshadefx::preprocessor::error(const location &location, const std::string &message)
 {
-	_errors += location.source + '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')' + ": preprocessor error: " + message + '\n';
+	_errors += std::string(location.source) + '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')' + ": preprocessor error: " + message + '\n';
 	_success = false; // Unset success flag
 }
 void reshadefx::preprocessor::warning(const location &location, const std::string &message)
 {
-	_errors += location.source + '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')' + ": preprocessor warning: " + message + '\n';
+	_errors += std::string(location.source) + '(' + std::to_string(location.line) + ", " + std::to_string(location.column) + ')' + ": preprocessor warning: " + message + '\n';
 }
 
 void reshadefx::preprocessor::push(std::string input, const std::string &name)
@@ -190,15 +299,21 @@ void reshadefx::preprocessor::push(std::string input, const std::string &name)
 		_token.location;
 
 	input_level level = { name };
-	level.lexer.reset(new lexer(
-		std::move(input),
-		true  /* ignore_comments */,
-		false /* ignore_whitespace */,
-		false /* ignore_pp_directives */,
-		false /* ignore_line_directives */,
-		true  /* ignore_keywords */,
-		false /* escape_string_literals */,
-		start_location));
+	level.lexer = create_lexer(std::move(input), start_location);
+
+	push(std::move(level), start_location);
+}
+void reshadefx::preprocessor::push(std::shared_ptr<const include_cache::file> file, const std::string &name)
+{
+	assert(file != nullptr && !file->tokens.empty() && !name.empty());
+
+	input_level level = { name };
+	level.cached_file = std::move(file);
+
+	push(std::move(level), location(name, 1));
+}
+void reshadefx::preprocessor::push(input_level &&level, const location &start_location)
+{
 	level.next_token.id = tokenid::unknown;
 	level.next_token.location = start_location; // This is used in 'consume' to initialize the output location
 
@@ -238,15 +353,15 @@ bool reshadefx::preprocessor::consume()
 	{
 		_output += "#line " + std::to_string(input.next_token.location.line) + " \"" + input.name + "\"\n";
 		_output_location.line = input.next_token.location.line;
-		_output_location.source = input.name;
+		_output_location.source = intern_global_string(input.name);
 	}
 
 	// Set current token
 	_token = std::move(input.next_token);
-	_current_token_raw_data = input.lexer->input_string().substr(_token.offset, _token.length);
+	_current_token_raw_data = input.input_string().substr(_token.offset, _token.length);
 
 	// Get the next token
-	input.next_token = input.lexer->lex();
+	input.next_token = input.lex();
 
 	// Verify string literals (since the lexer cannot throw errors itself)
 	if (_token == tokenid::string_literal && _current_token_raw_data.back() != '\"')
@@ -308,7 +423,7 @@ bool reshadefx::preprocessor::expect(tokenid token)
 			error(actual_token.location, "syntax error: unexpected new line");
 		else
 			error(actual_token.location, "syntax error: unexpected token '" +
-				_input_stack[_next_input_index].lexer->input_string().substr(actual_token.offset, actual_token.length) + '\'');
+				std::string(_input_stack[_next_input_index].input_string().substr(actual_token.offset, actual_token.length)) + '\'');
 
 		return false;
 	}
@@ -440,8 +555,11 @@ void reshadefx::preprocessor::parse_def()
 	const auto macro_name = std::move(_token.literal_as_string);
 	const auto macro_name_end_offset = _token.offset + _token.length;
 
+	// Whether this succeeds depends on whether the macro was defined externally already
+	reference_macro(macro_name);
+
 	// Check input string here directly to ensure the parenthesis follows the macro name without any whitespace between
-	if (_input_stack[_current_input_index].lexer->input_string()[macro_name_end_offset] == '(')
+	if (_input_stack[_current_input_index].input_string()[macro_name_end_offset] == '(')
 	{
 		accept(tokenid::parenthesis_open);
 
@@ -481,6 +599,8 @@ void reshadefx::preprocessor::parse_undef()
 	else if (_token.literal_as_string == "defined")
 		return warning(_token.location, "macro name 'defined' is reserved");
 
+	reference_macro(_token.literal_as_string);
+
 	_macros.erase(_token.literal_as_string);
 }
 
@@ -507,6 +627,8 @@ void reshadefx::preprocessor::parse_ifdef()
 	if (!expect(tokenid::identifier))
 		return;
 
+	reference_macro(_token.literal_as_string);
+
 	level.value = _macros.find(_token.literal_as_string) != _macros.end() ||
 		// Check built-in macros as well
 		_token.literal_as_string == "__LINE__" ||
@@ -530,6 +652,8 @@ void reshadefx::preprocessor::parse_ifndef()
 	if (!expect(tokenid::identifier))
 		return;
 
+	reference_macro(_token.literal_as_string);
+
 	level.value = _macros.find(_token.literal_as_string) == _macros.end() &&
 		_token.literal_as_string != "__LINE__" &&
 		_token.literal_as_string != "__FILE__" &&
@@ -633,8 +757,9 @@ void reshadefx::preprocessor::parse_pragma()
 
 	if (pragma == "once")
 	{
-		if (const auto it = _file_cache.find(_output_location.source); it != _file_cache.end())
-			it->second.clear();
+		// Replace the cached file with an empty one, so that any further includes of it do not add anything
+		if (const auto it = _file_cache.find(std::string(_output_location.source)); it != _file_cache.end())
+			it->second.reset();
 		return;
 	}
 
@@ -687,28 +812,32 @@ void reshadefx::preprocessor::parse_include()
 		return;
 	}
 
-	std::string data;
+	std::shared_ptr<const include_cache::file> file;
 	if (auto it = _file_cache.find(file_path_string);
 		it != _file_cache.end())
 	{
-		data = it->second;
+		file = it->second;
 	}
 	else
 	{
-		if (!read_file(file_path, data))
+		file = _include_cache != nullptr ? _include_cache->get(file_path) : include_cache::load(file_path);
+		if (file == nullptr)
 		{
 			error(keyword_location, "could not open included file '" + file_path_string + '\'');
 			consume_until(tokenid::end_of_line);
 			return;
 		}
 
-		_file_cache.emplace(file_path_string, data);
+		_file_cache.emplace(file_path_string, file);
 	}
 
 	// Clear out input stack before pushing include so that hidden macros do not bleed into the include
 	while (_input_stack.size() > (_next_input_index + 1))
 		_input_stack.pop_back();
-	push(std::move(data), file_path_string);
+	if (file != nullptr)
+		push(std::move(file), file_path_string);
+	else
+		push(std::string(), file_path_string); // File was marked with '#pragma once' and was already included
 }
 
 bool reshadefx::preprocessor::evaluate_expression()
@@ -896,6 +1025,8 @@ bool reshadefx::preprocessor::evaluate_expression()
 				if (has_parentheses && !expect(tokenid::parenthesis_close))
 					return false;
 
+				reference_macro(macro_name);
+
 				rpn[rpn_index++] = { _macros.find(macro_name) != _macros.end() ? 1 : 0, false };
 				continue;
 			}
@@ -1059,7 +1190,7 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 	}
 	if (_token.literal_as_string == "__FILE__")
 	{
-		push(escape_string(_token.location.source));
+		push(escape_string(std::string(_token.location.source)));
 		return true;
 	}
 	if (_token.literal_as_string == "__FILE_STEM__")
@@ -1075,6 +1206,8 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 		return true;
 	}
 
+	reference_macro(_token.literal_as_string);
+
 	const auto it = _macros.find(_token.literal_as_string);
 	if (it == _macros.end())
 		return false;
@@ -1154,6 +1287,12 @@ bool reshadefx::preprocessor::evaluate_identifier_as_macro()
 
 	return true;
 }
+void reshadefx::preprocessor::reference_macro(const std::string &name)
+{
+	// Most identifiers are looked up many times, so avoid constructing a new string for those that were already recorded
+	if (_referenced_macros.find(name) == _referenced_macros.end())
+		_referenced_macros.insert(name);
+}
 
 void reshadefx::preprocessor::expand_macro(const std::string &name, const macro &macro, const std::vector<std::string> &arguments, std::string &out)
 {
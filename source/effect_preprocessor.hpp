@@ -6,13 +6,62 @@
 #pragma once
 
 #include "effect_token.hpp"
-#include <memory> // std::unique_ptr
+#include <memory> // std::unique_ptr, std::shared_ptr
 #include <filesystem>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 
 namespace reshadefx
 {
+	/// <summary>
+	/// A thread-safe cache of lexed include files, which can be shared between multiple preprocessor instances.
+	/// This way a header that is included by many effects only has to be read and lexed once, instead of once per effect.
+	/// </summary>
+	class include_cache
+	{
+	public:
+		/// <summary>
+		/// An immutable token stream of a file.
+		/// </summary>
+		struct file
+		{
+			std::string source_code;
+			std::vector<token> tokens;
+		};
+
+		/// <summary>
+		/// Gets the token stream of the file at the specified <paramref name="path"/>, reading and lexing it only if it is not in the cache yet or was modified since.
+		/// This is safe to call from multiple threads at once.
+		/// </summary>
+		/// <param name="path">Path to the file to get.</param>
+		/// <returns>The token stream of the file, or <see langword="nullptr"/> if it could not be read.</returns>
+		std::shared_ptr<const file> get(const std::filesystem::path &path);
+
+		/// <summary>
+		/// Removes all files from the cache.
+		/// </summary>
+		void clear();
+
+		/// <summary>
+		/// Reads and lexes the file at the specified <paramref name="path"/> without caching it.
+		/// </summary>
+		static std::shared_ptr<const file> load(const std::filesystem::path &path);
+
+	private:
+		static std::shared_ptr<const file> lex_file(std::string data, const std::string &name);
+
+		struct entry
+		{
+			std::filesystem::file_time_type modified_time;
+			size_t content_hash = 0;
+			std::shared_ptr<const include_cache::file> lexed_file;
+		};
+
+		std::shared_mutex _mutex;
+		std::unordered_map<std::string, entry> _files;
+	};
+
 	/// <summary>
 	/// A C-style preprocessor implementation.
 	/// </summary>
@@ -55,6 +104,12 @@ namespace reshadefx
 			return add_macro_definition(name, macro { std::move(value), {} });
 		}
 
+		/// <summary>
+		/// Sets the cache to look up included files in, so that their token streams can be shared with other preprocessor instances.
+		/// </summary>
+		/// <param name="cache">Cache to use, which has to outlive this preprocessor instance, or <see langword="nullptr"/> to lex all included files again.</param>
+		void set_include_cache(include_cache *cache) { _include_cache = cache; }
+
 		/// <summary>
 		/// Opens the specified file, parses its contents and appends them to the output.
 		/// </summary>
@@ -89,6 +144,11 @@ namespace reshadefx
 		/// Gets a list of all defines that were used in #ifdef and #ifndef lines.
 		/// </summary>
 		std::vector<std::pair<std::string, std::string>> used_macro_definitions() const;
+		/// <summary>
+		/// Gets a sorted list of the names of all macros whose definition was looked up during preprocessing, regardless of whether they were defined or not.
+		/// The output only depends on the definitions of these macros, so changing any other definition would produce the same output.
+		/// </summary>
+		std::vector<std::string> referenced_macros() const;
 
 		/// <summary>
 		/// Gets a list of pragmas that occured.
@@ -107,14 +167,21 @@ namespace reshadefx
 		{
 			std::string name;
 			std::unique_ptr<class lexer> lexer;
+			std::shared_ptr<const include_cache::file> cached_file;
+			size_t next_cached_token = 0;
 			token next_token;
 			std::unordered_set<std::string> hidden_macros;
+
+			std::string_view input_string() const;
+			token lex();
 		};
 
 		void error(const location &location, const std::string &message);
 		void warning(const location &location, const std::string &message);
 
 		void push(std::string input, const std::string &name = std::string());
+		void push(std::shared_ptr<const include_cache::file> file, const std::string &name);
+		void push(input_level &&level, const location &start_location);
 
 		bool peek(tokenid token) const;
 		bool consume();
@@ -138,6 +205,7 @@ namespace reshadefx
 
 		bool evaluate_expression();
 		bool evaluate_identifier_as_macro();
+		void reference_macro(const std::string &name);
 
 		void expand_macro(const std::string &name, const macro &macro, const std::vector<std::string> &arguments, std::string &out);
 		void create_macro_replacement_list(macro &macro);
@@ -153,9 +221,11 @@ namespace reshadefx
 		unsigned short _recursion_count = 0;
 		location _output_location;
 		std::unordered_set<std::string> _used_macros;
+		std::unordered_set<std::string> _referenced_macros;
 		std::unordered_map<std::string, macro> _macros;
 		std::vector<std::filesystem::path> _include_paths;
-		std::unordered_map<std::string, std::string> _file_cache;
+		include_cache *_include_cache = nullptr;
+		std::unordered_map<std::string, std::shared_ptr<const include_cache::file>> _file_cache;
 		std::unordered_map<std::string, std::vector<std::string>> _used_pragmas;
 	};
 }
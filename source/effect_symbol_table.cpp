@@ -4,8 +4,11 @@
  */
 
 #include "effect_symbol_table.hpp"
+#include "effect_perfect_hash.hpp"
+#include <cmath> // Used to evaluate intrinsic functions at compile time
 #include <cassert>
 #include <malloc.h> // alloca
+#include <iterator> // std::size
 #include <algorithm> // std::upper_bound, std::sort
 #include <functional> // std::greater
 
@@ -96,16 +99,37 @@ static const intrinsic s_intrinsics[] =
 #undef int2
 #undef int3
 #undef int4
+#undef int2x3
+#undef int2x2
+#undef int2x4
+#undef int3x2
+#undef int3x3
+#undef int3x4
+#undef int4x2
+#undef int4x3
+#undef int4x4
+#undef out_int
+#undef out_int2
+#undef out_int3
+#undef out_int4
+#undef inout_int
 #undef uint
 #undef uint2
 #undef uint3
 #undef uint4
-#undef float1
+#undef inout_uint
+#undef float
 #undef float2
 #undef float3
 #undef float4
+#undef float2x3
 #undef float2x2
+#undef float2x4
+#undef float3x2
 #undef float3x3
+#undef float3x4
+#undef float4x2
+#undef float4x3
 #undef float4x4
 #undef out_float
 #undef out_float2
@@ -114,6 +138,97 @@ static const intrinsic s_intrinsics[] =
 #undef sampler
 #undef storage
 
+// Import names and number of parameters of the intrinsic functions at compile time, in the same order as above
+// The parameter list is only stringized and never expanded, so the type names do not matter here
+struct intrinsic_signature
+{
+	std::string_view name;
+	size_t num_parameters;
+};
+
+static constexpr size_t count_parameters(std::string_view parameter_list)
+{
+	if (parameter_list.empty())
+		return 0;
+
+	size_t num_parameters = 1;
+	for (const char c : parameter_list)
+		if (c == ',') // Type names never contain commas
+			num_parameters++;
+	return num_parameters;
+}
+
+static constexpr intrinsic_signature s_intrinsic_signatures[] =
+{
+#define DEFINE_INTRINSIC(name, i, ret_type, ...) { #name, count_parameters(#__VA_ARGS__) },
+	#include "effect_symbol_table_intrinsics.inl"
+};
+
+static_assert(std::size(s_intrinsic_signatures) == std::size(s_intrinsics));
+
+static constexpr size_t count_intrinsic_names()
+{
+	// Only compare neighbors, since all overloads of an intrinsic are defined next to each other (which is verified when building the lookup table below)
+	size_t num_names = 0;
+	for (size_t i = 0; i < std::size(s_intrinsic_signatures); ++i)
+		if (i == 0 || s_intrinsic_signatures[i].name != s_intrinsic_signatures[i - 1].name)
+			num_names++;
+	return num_names;
+}
+static constexpr size_t count_max_intrinsic_parameters()
+{
+	size_t max_parameters = 0;
+	for (const intrinsic_signature &signature : s_intrinsic_signatures)
+		max_parameters = std::max(max_parameters, signature.num_parameters);
+	return max_parameters;
+}
+
+static constexpr size_t s_num_intrinsic_names = count_intrinsic_names();
+static constexpr size_t s_max_intrinsic_parameters = count_max_intrinsic_parameters();
+
+/// <summary>
+/// Index of all intrinsic overloads grouped by name and then by number of parameters, so that the candidates for a function call can be looked up directly.
+/// </summary>
+struct intrinsic_index
+{
+	constexpr intrinsic_index() : names(), overloads(), first_overload()
+	{
+		size_t name_index = 0, overload_index = 0;
+
+		for (size_t begin = 0, end = 0; begin < std::size(s_intrinsic_signatures); begin = end, ++name_index)
+		{
+			for (end = begin + 1; end < std::size(s_intrinsic_signatures) && s_intrinsic_signatures[end].name == s_intrinsic_signatures[begin].name; ++end)
+				continue;
+
+			names[name_index] = s_intrinsic_signatures[begin].name;
+
+			// Keep the definition order of overloads with the same number of parameters, since the first best match wins during overload resolution
+			for (size_t num_parameters = 0; num_parameters <= s_max_intrinsic_parameters; ++num_parameters)
+			{
+				first_overload[name_index][num_parameters] = static_cast<uint16_t>(overload_index);
+
+				for (size_t i = begin; i < end; ++i)
+					if (s_intrinsic_signatures[i].num_parameters == num_parameters)
+						overloads[overload_index++] = static_cast<uint16_t>(i);
+			}
+
+			first_overload[name_index][s_max_intrinsic_parameters + 1] = static_cast<uint16_t>(overload_index);
+		}
+	}
+
+	std::string_view names[s_num_intrinsic_names];
+	// Indices into 's_intrinsics', sorted by name and then by number of parameters
+	uint16_t overloads[std::size(s_intrinsic_signatures)];
+	// Range in 'overloads' of the overloads with a specific name and number of parameters
+	uint16_t first_overload[s_num_intrinsic_names][s_max_intrinsic_parameters + 2];
+};
+
+static constexpr intrinsic_index s_intrinsic_index;
+static constexpr reshadefx::perfect_hash_table<s_num_intrinsic_names> s_intrinsic_lookup(s_intrinsic_index.names);
+
+// Overloads that are not next to each other would show up as duplicate names
+static_assert(s_intrinsic_lookup.valid(), "overloads of an intrinsic function have to be defined next to each other");
+
 #pragma endregion
 
 unsigned int reshadefx::type::rank(const type &src, const type &dst)
@@ -167,9 +282,12 @@ void reshadefx::symbol_table::enter_scope()
 {
 	_current_scope.level++;
 }
-void reshadefx::symbol_table::enter_namespace(const std::string &name)
+void reshadefx::symbol_table::enter_namespace(const std::string_view &name)
 {
-	_current_scope.name += name + "::";
+	std::string scope_name(_current_scope.name);
+	scope_name += name;
+	scope_name += "::";
+	_current_scope.name = _names.intern(scope_name);
 	_current_scope.level++;
 	_current_scope.namespace_level++;
 }
@@ -202,12 +320,13 @@ void reshadefx::symbol_table::leave_namespace()
 	assert(_current_scope.level > 0);
 	assert(_current_scope.namespace_level > 0);
 
-	_current_scope.name.erase(_current_scope.name.substr(0, _current_scope.name.size() - 2).rfind("::") + 2);
+	// The parent scope name is a prefix of the current one, so a view of that is still pointing to interned memory
+	_current_scope.name = _current_scope.name.substr(0, _current_scope.name.substr(0, _current_scope.name.size() - 2).rfind("::") + 2);
 	_current_scope.level--;
 	_current_scope.namespace_level--;
 }
 
-bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbol &symbol, bool global)
+bool reshadefx::symbol_table::insert_symbol(const std::string_view &name, const symbol &symbol, bool global)
 {
 	assert(symbol.id != 0 || symbol.op == symbol_type::constant);
 
@@ -230,14 +349,15 @@ bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbo
 		scope scope = { "", 0, 0 };
 
 		// Walk scope chain from global scope back to current one
-		for (size_t pos = 0; pos != std::string::npos; pos = _current_scope.name.find("::", pos))
+		for (size_t pos = 0; pos != std::string_view::npos; pos = _current_scope.name.find("::", pos))
 		{
 			// Extract scope name
 			scope.name = _current_scope.name.substr(0, pos += 2);
-			const auto previous_scope_name = _current_scope.name.substr(pos);
+			std::string qualified_name(_current_scope.name.substr(pos));
+			qualified_name += name;
 
 			// Insert symbol into this scope
-			insert_sorted(_symbol_stack[previous_scope_name + name], scoped_symbol { symbol, scope });
+			insert_sorted(_symbol_stack[_names.intern(qualified_name)], scoped_symbol { symbol, scope });
 
 			// Continue walking up the scope chain
 			scope.level = ++scope.namespace_level;
@@ -246,18 +366,18 @@ bool reshadefx::symbol_table::insert_symbol(const std::string &name, const symbo
 	else
 	{
 		// This is a local symbol so it's sufficient to update the symbol stack with just the current scope
-		insert_sorted(_symbol_stack[name], scoped_symbol { symbol, _current_scope });
+		insert_sorted(_symbol_stack[_names.intern(name)], scoped_symbol { symbol, _current_scope });
 	}
 
 	return true;
 }
 
-reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string &name) const
+reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string_view &name) const
 {
 	// Default to start search with current scope and walk back the scope chain
 	return find_symbol(name, _current_scope, false);
 }
-reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string &name, const scope &scope, bool exclusive) const
+reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string_view &name, const scope &scope, bool exclusive) const
 {
 	const auto stack_it = _symbol_stack.find(name);
 
@@ -285,7 +405,7 @@ reshadefx::scoped_symbol reshadefx::symbol_table::find_symbol(const std::string
 	return result;
 }
 
-static int compare_functions(const std::vector<reshadefx::expression> &arguments, const reshadefx::function_info *function1, const reshadefx::function_info *function2)
+static int compare_functions(const reshadefx::expression_list &arguments, const reshadefx::function_info *function1, const reshadefx::function_info *function2)
 {
 	const size_t num_arguments = arguments.size();
 
@@ -334,7 +454,7 @@ static int compare_functions(const std::vector<reshadefx::expression> &arguments
 	return 0; // Both functions are equally viable
 }
 
-bool reshadefx::symbol_table::resolve_function_call(const std::string &name, const std::vector<expression> &arguments, const scope &scope, symbol &out_data, bool &is_ambiguous) const
+bool reshadefx::symbol_table::resolve_function_call(const std::string_view &name, const expression_list &arguments, const scope &scope, symbol &out_data, bool &is_ambiguous) const
 {
 	out_data.op = symbol_type::function;
 
@@ -399,12 +519,17 @@ bool reshadefx::symbol_table::resolve_function_call(const std::string &name, con
 	}
 
 	// Try matching against intrinsic functions if no matching user-defined function was found up to this point
-	if (num_overloads == 0)
+	// Only overloads with the same name and number of parameters can match, so look those up directly instead of going through the whole list
+	if (size_t name_index; num_overloads == 0 && arguments.size() <= s_max_intrinsic_parameters &&
+		(name_index = s_intrinsic_lookup.find(name)) != s_intrinsic_lookup.npos)
 	{
-		for (const intrinsic &intrinsic : s_intrinsics)
+		const size_t first = s_intrinsic_index.first_overload[name_index][arguments.size()];
+		const size_t last = s_intrinsic_index.first_overload[name_index][arguments.size() + 1];
+
+		for (size_t overload_index = first; overload_index < last; ++overload_index)
 		{
-			if (intrinsic.function.name != name || intrinsic.function.parameter_list.size() != arguments.size())
-				continue;
+			const intrinsic &intrinsic = s_intrinsics[s_intrinsic_index.overloads[overload_index]];
+			assert(intrinsic.function.name == name && intrinsic.function.parameter_list.size() == arguments.size());
 
 			// A new possibly-matching intrinsic function was found, compare it against the current result
 			const int comparison = compare_functions(arguments, &intrinsic.function, result);
@@ -429,3 +554,17 @@ bool reshadefx::symbol_table::resolve_function_call(const std::string &name, con
 
 	return num_overloads == 1;
 }
+
+bool reshadefx::symbol_table::evaluate_constant_intrinsic(uint32_t id, const type &res_type, const expression_list &args, constant &result)
+{
+	result = {};
+
+	switch (static_cast<intrinsic_id>(id))
+	{
+	#define IMPLEMENT_INTRINSIC_CONSTANT(name, i, code) case intrinsic_id::name##i: code return true;
+		#include "effect_symbol_table_intrinsics.inl"
+	default:
+		// Intrinsic has side effects or depends on state only known during execution (textures, derivatives, ...)
+		return false;
+	}
+}
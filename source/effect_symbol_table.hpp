@@ -6,6 +6,7 @@
 #pragma once
 
 #include "effect_module.hpp"
+#include "effect_arena.hpp"
 #include <unordered_map> // Used for symbol lookup table
 
 namespace reshadefx
@@ -15,7 +16,8 @@ namespace reshadefx
 	/// </summary>
 	struct scope
 	{
-		std::string name;
+		// Names are interned in the symbol table, so that scopes can be copied around without allocating
+		std::string_view name;
 		uint32_t level, namespace_level;
 	};
 
@@ -63,7 +65,7 @@ namespace reshadefx
 		/// <summary>
 		/// Enters a new namespace as child of the current one.
 		/// </summary>
-		void enter_namespace(const std::string &name);
+		void enter_namespace(const std::string_view &name);
 		/// <summary>
 		/// Leaves the current scope and enter the parent one.
 		/// </summary>
@@ -82,22 +84,34 @@ namespace reshadefx
 		/// Inserts an new symbol in the symbol table.
 		/// Returns <see langword="false"/> if a symbol by that name and type already exists.
 		/// </summary>
-		bool insert_symbol(const std::string &name, const symbol &symbol, bool global = false);
+		bool insert_symbol(const std::string_view &name, const symbol &symbol, bool global = false);
 
 		/// <summary>
 		/// Looks for an existing symbol with the specified <paramref name="name"/>.
 		/// </summary>
-		scoped_symbol find_symbol(const std::string &name) const;
-		scoped_symbol find_symbol(const std::string &name, const scope &scope, bool exclusive) const;
+		scoped_symbol find_symbol(const std::string_view &name) const;
+		scoped_symbol find_symbol(const std::string_view &name, const scope &scope, bool exclusive) const;
 
 		/// <summary>
 		/// Searches for the best function or intrinsic overload matching the argument list.
 		/// </summary>
-		bool resolve_function_call(const std::string &name, const std::vector<expression> &args, const scope &scope, symbol &data, bool &ambiguous) const;
+		bool resolve_function_call(const std::string_view &name, const expression_list &args, const scope &scope, symbol &data, bool &ambiguous) const;
+
+		/// <summary>
+		/// Evaluates a call to the intrinsic function with the specified <paramref name="id"/> at compile time.
+		/// The arguments have to be constants that were already cast to the parameter types of the intrinsic overload.
+		/// </summary>
+		/// <returns><see langword="true"/> if the intrinsic could be evaluated, <see langword="false"/> if it has to be executed at runtime.</returns>
+		static bool evaluate_constant_intrinsic(uint32_t id, const type &res_type, const expression_list &args, constant &result);
+
+	protected:
+		// Memory for everything that only needs to live for the duration of a compilation
+		arena _arena;
 
 	private:
 		scope _current_scope;
-		// Lookup table from name to matching symbols
-		std::unordered_map<std::string, std::vector<scoped_symbol>> _symbol_stack;
+		string_pool _names { _arena };
+		// Lookup table from name to matching symbols (keys are interned in the name pool above)
+		std::unordered_map<std::string_view, std::vector<scoped_symbol>> _symbol_stack;
 	};
 }
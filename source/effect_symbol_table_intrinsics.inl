@@ -15,6 +15,9 @@
 #if defined(__INTELLISENSE__) || !defined(IMPLEMENT_INTRINSIC_SPIRV)
 #define IMPLEMENT_INTRINSIC_SPIRV(name, i, code)
 #endif
+#if defined(__INTELLISENSE__) || !defined(IMPLEMENT_INTRINSIC_CONSTANT)
+#define IMPLEMENT_INTRINSIC_CONSTANT(name, i, code)
+#endif
 
 // ret abs(x)
 DEFINE_INTRINSIC(abs, 0, int, int)
@@ -51,6 +54,14 @@ IMPLEMENT_INTRINSIC_SPIRV(abs, 1, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(abs, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_uint[c] = args[0].constant.as_int[c] < 0 ? 0u - args[0].constant.as_uint[c] : args[0].constant.as_uint[c];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(abs, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::abs(args[0].constant.as_float[c]);
+	})
 
 // ret all(x)
 DEFINE_INTRINSIC(all, 0, bool, bool)
@@ -77,6 +88,16 @@ IMPLEMENT_INTRINSIC_SPIRV(all, 1, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(all, 0, {
+	result.as_uint[0] = true;
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_uint[0] = result.as_uint[0] && args[0].constant.as_uint[c] != 0;
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(all, 1, {
+	result.as_uint[0] = true;
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_uint[0] = result.as_uint[0] && args[0].constant.as_uint[c] != 0;
+	})
 
 // ret any(x)
 DEFINE_INTRINSIC(any, 0, bool, bool)
@@ -103,6 +124,16 @@ IMPLEMENT_INTRINSIC_SPIRV(any, 1, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(any, 0, {
+	result.as_uint[0] = false;
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_uint[0] = result.as_uint[0] || args[0].constant.as_uint[c] != 0;
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(any, 1, {
+	result.as_uint[0] = false;
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_uint[0] = result.as_uint[0] || args[0].constant.as_uint[c] != 0;
+	})
 
 // ret asin(x)
 DEFINE_INTRINSIC(asin, 0, float, float)
@@ -122,6 +153,10 @@ IMPLEMENT_INTRINSIC_SPIRV(asin, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(asin, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::asin(args[0].constant.as_float[c]);
+	})
 
 // ret acos(x)
 DEFINE_INTRINSIC(acos, 0, float, float)
@@ -141,6 +176,10 @@ IMPLEMENT_INTRINSIC_SPIRV(acos, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(acos, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::acos(args[0].constant.as_float[c]);
+	})
 
 // ret atan(x)
 DEFINE_INTRINSIC(atan, 0, float, float)
@@ -160,6 +199,10 @@ IMPLEMENT_INTRINSIC_SPIRV(atan, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(atan, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::atan(args[0].constant.as_float[c]);
+	})
 
 // ret atan2(x, y)
 DEFINE_INTRINSIC(atan2, 0, float, float, float)
@@ -180,6 +223,10 @@ IMPLEMENT_INTRINSIC_SPIRV(atan2, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(atan2, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::atan2(args[0].constant.as_float[c], args[1].constant.as_float[c]);
+	})
 
 // ret sin(x)
 DEFINE_INTRINSIC(sin, 0, float, float)
@@ -199,6 +246,10 @@ IMPLEMENT_INTRINSIC_SPIRV(sin, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(sin, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::sin(args[0].constant.as_float[c]);
+	})
 
 // ret sinh(x)
 DEFINE_INTRINSIC(sinh, 0, float, float)
@@ -218,6 +269,10 @@ IMPLEMENT_INTRINSIC_SPIRV(sinh, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(sinh, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::sinh(args[0].constant.as_float[c]);
+	})
 
 // ret cos(x)
 DEFINE_INTRINSIC(cos, 0, float, float)
@@ -237,6 +292,10 @@ IMPLEMENT_INTRINSIC_SPIRV(cos, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(cos, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::cos(args[0].constant.as_float[c]);
+	})
 
 // ret cosh(x)
 DEFINE_INTRINSIC(cosh, 0, float, float)
@@ -256,6 +315,10 @@ IMPLEMENT_INTRINSIC_SPIRV(cosh, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(cosh, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::cosh(args[0].constant.as_float[c]);
+	})
 
 // ret tan(x)
 DEFINE_INTRINSIC(tan, 0, float, float)
@@ -275,6 +338,10 @@ IMPLEMENT_INTRINSIC_SPIRV(tan, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(tan, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::tan(args[0].constant.as_float[c]);
+	})
 
 // ret tanh(x)
 DEFINE_INTRINSIC(tanh, 0, float, float)
@@ -294,6 +361,10 @@ IMPLEMENT_INTRINSIC_SPIRV(tanh, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(tanh, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::tanh(args[0].constant.as_float[c]);
+	})
 
 // sincos(x, out s, out c)
 DEFINE_INTRINSIC(sincos, 0, void, float, out_float, out_float)
@@ -348,6 +419,10 @@ IMPLEMENT_INTRINSIC_SPIRV(asint, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(asint, 0, {
+	// Reinterpreting the bits does not change the data of the constant
+	result = args[0].constant;
+	})
 
 // ret asuint(x)
 DEFINE_INTRINSIC(asuint, 0, uint, float)
@@ -369,6 +444,10 @@ IMPLEMENT_INTRINSIC_SPIRV(asuint, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(asuint, 0, {
+	// Reinterpreting the bits does not change the data of the constant
+	result = args[0].constant;
+	})
 
 // ret asfloat(x)
 DEFINE_INTRINSIC(asfloat, 0, float, int)
@@ -409,6 +488,14 @@ IMPLEMENT_INTRINSIC_SPIRV(asfloat, 1, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(asfloat, 0, {
+	// Reinterpreting the bits does not change the data of the constant
+	result = args[0].constant;
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(asfloat, 1, {
+	// Reinterpreting the bits does not change the data of the constant
+	result = args[0].constant;
+	})
 
 // ret firstbitlow
 DEFINE_INTRINSIC(firstbitlow, 0, uint, uint)
@@ -428,6 +515,15 @@ IMPLEMENT_INTRINSIC_SPIRV(firstbitlow, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(firstbitlow, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+	{
+		result.as_uint[c] = 0xFFFFFFFF; // Returned if no bit is set
+		for (uint32_t bit = 0; bit < 32 && result.as_uint[c] == 0xFFFFFFFF; ++bit)
+			if ((args[0].constant.as_uint[c] >> bit) & 1)
+				result.as_uint[c] = bit;
+	}
+	})
 
 // ret firstbithigh
 DEFINE_INTRINSIC(firstbithigh, 0, int, int)
@@ -464,6 +560,26 @@ IMPLEMENT_INTRINSIC_SPIRV(firstbithigh, 1, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(firstbithigh, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+	{
+		// Find the first bit that differs from the sign bit for signed integers
+		const uint32_t value = args[0].constant.as_int[c] < 0 ? ~args[0].constant.as_uint[c] : args[0].constant.as_uint[c];
+		result.as_uint[c] = 0xFFFFFFFF;
+		for (uint32_t bit = 32; bit-- > 0 && result.as_uint[c] == 0xFFFFFFFF;)
+			if ((value >> bit) & 1)
+				result.as_uint[c] = bit;
+	}
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(firstbithigh, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+	{
+		result.as_uint[c] = 0xFFFFFFFF;
+		for (uint32_t bit = 32; bit-- > 0 && result.as_uint[c] == 0xFFFFFFFF;)
+			if ((args[0].constant.as_uint[c] >> bit) & 1)
+				result.as_uint[c] = bit;
+	}
+	})
 
 // ret countbits
 DEFINE_INTRINSIC(countbits, 0, uint, uint)
@@ -481,6 +597,11 @@ IMPLEMENT_INTRINSIC_SPIRV(countbits, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(countbits, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		for (uint32_t bit = 0; bit < 32; ++bit)
+			result.as_uint[c] += (args[0].constant.as_uint[c] >> bit) & 1;
+	})
 
 // ret reversebits
 DEFINE_INTRINSIC(reversebits, 0, uint, uint)
@@ -498,6 +619,11 @@ IMPLEMENT_INTRINSIC_SPIRV(reversebits, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(reversebits, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		for (uint32_t bit = 0; bit < 32; ++bit)
+			result.as_uint[c] |= ((args[0].constant.as_uint[c] >> bit) & 1) << (31 - bit);
+	})
 
 // ret ceil(x)
 DEFINE_INTRINSIC(ceil, 0, float, float)
@@ -517,6 +643,10 @@ IMPLEMENT_INTRINSIC_SPIRV(ceil, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(ceil, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::ceil(args[0].constant.as_float[c]);
+	})
 
 // ret floor(x)
 DEFINE_INTRINSIC(floor, 0, float, float)
@@ -539,6 +669,10 @@ IMPLEMENT_INTRINSIC_SPIRV(floor, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(floor, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::floor(args[0].constant.as_float[c]);
+	})
 
 // ret clamp(x, min, max)
 DEFINE_INTRINSIC(clamp, 0, int, int, int, int)
@@ -598,6 +732,18 @@ IMPLEMENT_INTRINSIC_SPIRV(clamp, 2, {
 		.add(args[2].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(clamp, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_int[c] = std::min(std::max(args[0].constant.as_int[c], args[1].constant.as_int[c]), args[2].constant.as_int[c]);
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(clamp, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_uint[c] = std::min(std::max(args[0].constant.as_uint[c], args[1].constant.as_uint[c]), args[2].constant.as_uint[c]);
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(clamp, 2, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::fmin(std::fmax(args[0].constant.as_float[c], args[1].constant.as_float[c]), args[2].constant.as_float[c]);
+	})
 
 // ret saturate(x)
 DEFINE_INTRINSIC(saturate, 0, float, float)
@@ -622,6 +768,10 @@ IMPLEMENT_INTRINSIC_SPIRV(saturate, 0, {
 		.add(constant_one)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(saturate, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::fmin(std::fmax(args[0].constant.as_float[c], 0.0f), 1.0f);
+	})
 
 // ret mad(mvalue, avalue, bvalue)
 DEFINE_INTRINSIC(mad, 0, float, float, float, float)
@@ -646,6 +796,10 @@ IMPLEMENT_INTRINSIC_SPIRV(mad, 0, {
 		.add(args[2].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(mad, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] * args[1].constant.as_float[c] + args[2].constant.as_float[c];
+	})
 
 // ret rcp(x)
 DEFINE_INTRINSIC(rcp, 0, float, float)
@@ -669,6 +823,10 @@ IMPLEMENT_INTRINSIC_SPIRV(rcp, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(rcp, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = 1.0f / args[0].constant.as_float[c];
+	})
 
 // ret pow(x, y)
 DEFINE_INTRINSIC(pow, 0, float, float, float)
@@ -689,6 +847,10 @@ IMPLEMENT_INTRINSIC_SPIRV(pow, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(pow, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::pow(args[0].constant.as_float[c], args[1].constant.as_float[c]);
+	})
 
 // ret exp(x)
 DEFINE_INTRINSIC(exp, 0, float, float)
@@ -708,6 +870,10 @@ IMPLEMENT_INTRINSIC_SPIRV(exp, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(exp, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::exp(args[0].constant.as_float[c]);
+	})
 
 // ret exp2(x)
 DEFINE_INTRINSIC(exp2, 0, float, float)
@@ -727,6 +893,10 @@ IMPLEMENT_INTRINSIC_SPIRV(exp2, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(exp2, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::exp2(args[0].constant.as_float[c]);
+	})
 
 // ret log(x)
 DEFINE_INTRINSIC(log, 0, float, float)
@@ -746,6 +916,10 @@ IMPLEMENT_INTRINSIC_SPIRV(log, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(log, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::log(args[0].constant.as_float[c]);
+	})
 
 // ret log2(x)
 DEFINE_INTRINSIC(log2, 0, float, float)
@@ -765,6 +939,10 @@ IMPLEMENT_INTRINSIC_SPIRV(log2, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(log2, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::log2(args[0].constant.as_float[c]);
+	})
 
 // ret log10(x)
 DEFINE_INTRINSIC(log10, 0, float, float)
@@ -804,6 +982,10 @@ DEFINE_INTRINSIC(sign, 1, float4, float4)
 IMPLEMENT_INTRINSIC_GLSL(sign, 0, {
 	code += "sign(" + id_to_name(args[0].base) + ')';
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(log10, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::log10(args[0].constant.as_float[c]);
+	})
 IMPLEMENT_INTRINSIC_GLSL(sign, 1, {
 	code += "sign(" + id_to_name(args[0].base) + ')';
 	})
@@ -827,6 +1009,14 @@ IMPLEMENT_INTRINSIC_SPIRV(sign, 1, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(sign, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_int[c] = (args[0].constant.as_int[c] > 0) - (args[0].constant.as_int[c] < 0);
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(sign, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = static_cast<float>((args[0].constant.as_float[c] > 0.0f) - (args[0].constant.as_float[c] < 0.0f));
+	})
 
 // ret sqrt(x)
 DEFINE_INTRINSIC(sqrt, 0, float, float)
@@ -846,6 +1036,10 @@ IMPLEMENT_INTRINSIC_SPIRV(sqrt, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(sqrt, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::sqrt(args[0].constant.as_float[c]);
+	})
 
 // ret rsqrt(x)
 DEFINE_INTRINSIC(rsqrt, 0, float, float)
@@ -865,6 +1059,10 @@ IMPLEMENT_INTRINSIC_SPIRV(rsqrt, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(rsqrt, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = 1.0f / std::sqrt(args[0].constant.as_float[c]);
+	})
 
 // ret lerp(x, y, s)
 DEFINE_INTRINSIC(lerp, 0, float, float, float, float)
@@ -886,6 +1084,10 @@ IMPLEMENT_INTRINSIC_SPIRV(lerp, 0, {
 		.add(args[2].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(lerp, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] + args[2].constant.as_float[c] * (args[1].constant.as_float[c] - args[0].constant.as_float[c]);
+	})
 
 // ret step(y, x)
 DEFINE_INTRINSIC(step, 0, float, float, float)
@@ -906,6 +1108,10 @@ IMPLEMENT_INTRINSIC_SPIRV(step, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(step, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[1].constant.as_float[c] >= args[0].constant.as_float[c] ? 1.0f : 0.0f;
+	})
 
 // ret smoothstep(min, max, x)
 DEFINE_INTRINSIC(smoothstep, 0, float, float, float, float)
@@ -927,6 +1133,13 @@ IMPLEMENT_INTRINSIC_SPIRV(smoothstep, 0, {
 		.add(args[2].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(smoothstep, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+	{
+		const float t = std::fmin(std::fmax((args[2].constant.as_float[c] - args[0].constant.as_float[c]) / (args[1].constant.as_float[c] - args[0].constant.as_float[c]), 0.0f), 1.0f);
+		result.as_float[c] = t * t * (3.0f - 2.0f * t);
+	}
+	})
 
 // ret frac(x)
 DEFINE_INTRINSIC(frac, 0, float, float)
@@ -946,6 +1159,10 @@ IMPLEMENT_INTRINSIC_SPIRV(frac, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(frac, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] - std::floor(args[0].constant.as_float[c]);
+	})
 
 // ret ldexp(x, exp)
 DEFINE_INTRINSIC(ldexp, 0, float, float, int)
@@ -966,6 +1183,10 @@ IMPLEMENT_INTRINSIC_SPIRV(ldexp, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(ldexp, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::ldexp(args[0].constant.as_float[c], args[1].constant.as_int[c]);
+	})
 
 // ret modf(x, out ip)
 DEFINE_INTRINSIC(modf, 0, float, float, out_float)
@@ -1025,6 +1246,10 @@ IMPLEMENT_INTRINSIC_SPIRV(trunc, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(trunc, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::trunc(args[0].constant.as_float[c]);
+	})
 
 // ret round(x)
 DEFINE_INTRINSIC(round, 0, float, float)
@@ -1044,6 +1269,11 @@ IMPLEMENT_INTRINSIC_SPIRV(round, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(round, 0, {
+	// Rounds halfway cases to the nearest even value like the hardware does
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::nearbyint(args[0].constant.as_float[c]);
+	})
 
 // ret min(x, y)
 DEFINE_INTRINSIC(min, 0, int, int, int)
@@ -1082,6 +1312,14 @@ IMPLEMENT_INTRINSIC_SPIRV(min, 1, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(min, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_int[c] = std::min(args[0].constant.as_int[c], args[1].constant.as_int[c]);
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(min, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::fmin(args[0].constant.as_float[c], args[1].constant.as_float[c]);
+	})
 
 // ret max(x, y)
 DEFINE_INTRINSIC(max, 0, int, int, int)
@@ -1120,6 +1358,14 @@ IMPLEMENT_INTRINSIC_SPIRV(max, 1, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(max, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_int[c] = std::max(args[0].constant.as_int[c], args[1].constant.as_int[c]);
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(max, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = std::fmax(args[0].constant.as_float[c], args[1].constant.as_float[c]);
+	})
 
 // ret degree(x)
 DEFINE_INTRINSIC(degrees, 0, float, float)
@@ -1139,6 +1385,10 @@ IMPLEMENT_INTRINSIC_SPIRV(degrees, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(degrees, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] * 57.29577951f;
+	})
 
 // ret radians(x)
 DEFINE_INTRINSIC(radians, 0, float, float)
@@ -1158,6 +1408,10 @@ IMPLEMENT_INTRINSIC_SPIRV(radians, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(radians, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] * 0.01745329252f;
+	})
 
 // ret ddx(x)
 DEFINE_INTRINSIC(ddx, 0, float, float)
@@ -1226,6 +1480,10 @@ IMPLEMENT_INTRINSIC_SPIRV(dot, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(dot, 0, {
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_float[0] += args[0].constant.as_float[c] * args[1].constant.as_float[c];
+	})
 
 // ret cross(x, y)
 DEFINE_INTRINSIC(cross, 0, float3, float3, float3)
@@ -1243,6 +1501,13 @@ IMPLEMENT_INTRINSIC_SPIRV(cross, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(cross, 0, {
+	const float *const a = args[0].constant.as_float;
+	const float *const b = args[1].constant.as_float;
+	result.as_float[0] = a[1] * b[2] - a[2] * b[1];
+	result.as_float[1] = a[2] * b[0] - a[0] * b[2];
+	result.as_float[2] = a[0] * b[1] - a[1] * b[0];
+	})
 
 // ret length(x)
 DEFINE_INTRINSIC(length, 0, float, float)
@@ -1262,6 +1527,11 @@ IMPLEMENT_INTRINSIC_SPIRV(length, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(length, 0, {
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_float[0] += args[0].constant.as_float[c] * args[0].constant.as_float[c];
+	result.as_float[0] = std::sqrt(result.as_float[0]);
+	})
 
 // ret distance(x, y)
 DEFINE_INTRINSIC(distance, 0, float, float, float)
@@ -1282,6 +1552,11 @@ IMPLEMENT_INTRINSIC_SPIRV(distance, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(distance, 0, {
+	for (unsigned int c = 0; c < args[0].type.components(); ++c)
+		result.as_float[0] += (args[0].constant.as_float[c] - args[1].constant.as_float[c]) * (args[0].constant.as_float[c] - args[1].constant.as_float[c]);
+	result.as_float[0] = std::sqrt(result.as_float[0]);
+	})
 
 // ret normalize(x)
 DEFINE_INTRINSIC(normalize, 0, float2, float2)
@@ -1300,6 +1575,14 @@ IMPLEMENT_INTRINSIC_SPIRV(normalize, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(normalize, 0, {
+	float length = 0.0f;
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		length += args[0].constant.as_float[c] * args[0].constant.as_float[c];
+	length = std::sqrt(length);
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] / length;
+	})
 
 // ret transpose(x)
 DEFINE_INTRINSIC(transpose, 0, float2x2, float2x2)
@@ -1322,6 +1605,11 @@ IMPLEMENT_INTRINSIC_SPIRV(transpose, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(transpose, 0, {
+	for (unsigned int row = 0; row < args[0].type.rows; ++row)
+		for (unsigned int col = 0; col < args[0].type.cols; ++col)
+			result.as_uint[col * res_type.cols + row] = args[0].constant.as_uint[row * args[0].type.cols + col];
+	})
 
 // ret determinant(m)
 DEFINE_INTRINSIC(determinant, 0, float, float2x2)
@@ -1340,6 +1628,31 @@ IMPLEMENT_INTRINSIC_SPIRV(determinant, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(determinant, 0, {
+	const float *const m = args[0].constant.as_float;
+	switch (args[0].type.rows)
+	{
+	case 2:
+		result.as_float[0] = m[0] * m[3] - m[1] * m[2];
+		break;
+	case 3:
+		result.as_float[0] =
+			m[0] * (m[4] * m[8] - m[5] * m[7]) -
+			m[1] * (m[3] * m[8] - m[5] * m[6]) +
+			m[2] * (m[3] * m[7] - m[4] * m[6]);
+		break;
+	case 4:
+		// Laplace expansion using the 2x2 minors of the first two and last two rows
+		result.as_float[0] =
+			(m[0] * m[5] - m[1] * m[4]) * (m[10] * m[15] - m[11] * m[14]) -
+			(m[0] * m[6] - m[2] * m[4]) * (m[9] * m[15] - m[11] * m[13]) +
+			(m[0] * m[7] - m[3] * m[4]) * (m[9] * m[14] - m[10] * m[13]) +
+			(m[1] * m[6] - m[2] * m[5]) * (m[8] * m[15] - m[11] * m[12]) -
+			(m[1] * m[7] - m[3] * m[5]) * (m[8] * m[14] - m[10] * m[12]) +
+			(m[2] * m[7] - m[3] * m[6]) * (m[8] * m[13] - m[9] * m[12]);
+		break;
+	}
+	})
 
 // ret reflect(i, n)
 DEFINE_INTRINSIC(reflect, 0, float2, float2, float2)
@@ -1359,6 +1672,13 @@ IMPLEMENT_INTRINSIC_SPIRV(reflect, 0, {
 		.add(args[1].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(reflect, 0, {
+	float d = 0.0f;
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		d += args[0].constant.as_float[c] * args[1].constant.as_float[c];
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = args[0].constant.as_float[c] - 2.0f * d * args[1].constant.as_float[c];
+	})
 
 // ret refract(i, n, eta)
 DEFINE_INTRINSIC(refract, 0, float2, float2, float2, float)
@@ -1379,6 +1699,17 @@ IMPLEMENT_INTRINSIC_SPIRV(refract, 0, {
 		.add(args[2].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(refract, 0, {
+	float d = 0.0f;
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		d += args[0].constant.as_float[c] * args[1].constant.as_float[c];
+	const float eta = args[2].constant.as_float[0];
+	const float k = 1.0f - eta * eta * (1.0f - d * d);
+	// Result is zero in case of total internal reflection
+	if (k >= 0.0f)
+		for (unsigned int c = 0; c < res_type.components(); ++c)
+			result.as_float[c] = eta * args[0].constant.as_float[c] - (eta * d + std::sqrt(k)) * args[1].constant.as_float[c];
+	})
 
 // ret faceforward(n, i, ng)
 DEFINE_INTRINSIC(faceforward, 0, float, float, float, float)
@@ -1400,6 +1731,13 @@ IMPLEMENT_INTRINSIC_SPIRV(faceforward, 0, {
 		.add(args[2].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(faceforward, 0, {
+	float d = 0.0f;
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		d += args[2].constant.as_float[c] * args[1].constant.as_float[c];
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_float[c] = d < 0.0f ? args[0].constant.as_float[c] : -args[0].constant.as_float[c];
+	})
 
 // ret mul(x, y)
 DEFINE_INTRINSIC(mul, 0, int2, int, int2)
@@ -1628,6 +1966,61 @@ IMPLEMENT_INTRINSIC_SPIRV(mul, 6, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		if (res_type.is_floating_point())
+			result.as_float[c] = args[0].constant.as_float[0] * args[1].constant.as_float[c];
+		else
+			result.as_uint[c] = args[0].constant.as_uint[0] * args[1].constant.as_uint[c];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 1, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		if (res_type.is_floating_point())
+			result.as_float[c] = args[0].constant.as_float[c] * args[1].constant.as_float[0];
+		else
+			result.as_uint[c] = args[0].constant.as_uint[c] * args[1].constant.as_uint[0];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 2, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		if (res_type.is_floating_point())
+			result.as_float[c] = args[0].constant.as_float[0] * args[1].constant.as_float[c];
+		else
+			result.as_uint[c] = args[0].constant.as_uint[0] * args[1].constant.as_uint[c];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 3, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		if (res_type.is_floating_point())
+			result.as_float[c] = args[0].constant.as_float[c] * args[1].constant.as_float[0];
+		else
+			result.as_uint[c] = args[0].constant.as_uint[c] * args[1].constant.as_uint[0];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 4, {
+	// Row vector times matrix
+	for (unsigned int col = 0; col < args[1].type.cols; ++col)
+		for (unsigned int row = 0; row < args[1].type.rows; ++row)
+			if (res_type.is_floating_point())
+				result.as_float[col] += args[0].constant.as_float[row] * args[1].constant.as_float[row * args[1].type.cols + col];
+			else
+				result.as_uint[col] += args[0].constant.as_uint[row] * args[1].constant.as_uint[row * args[1].type.cols + col];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 5, {
+	// Matrix times column vector
+	for (unsigned int row = 0; row < args[0].type.rows; ++row)
+		for (unsigned int col = 0; col < args[0].type.cols; ++col)
+			if (res_type.is_floating_point())
+				result.as_float[row] += args[0].constant.as_float[row * args[0].type.cols + col] * args[1].constant.as_float[col];
+			else
+				result.as_uint[row] += args[0].constant.as_uint[row * args[0].type.cols + col] * args[1].constant.as_uint[col];
+	})
+IMPLEMENT_INTRINSIC_CONSTANT(mul, 6, {
+	for (unsigned int row = 0; row < res_type.rows; ++row)
+		for (unsigned int col = 0; col < res_type.cols; ++col)
+			for (unsigned int k = 0; k < args[0].type.cols; ++k)
+				if (res_type.is_floating_point())
+					result.as_float[row * res_type.cols + col] += args[0].constant.as_float[row * args[0].type.cols + k] * args[1].constant.as_float[k * args[1].type.cols + col];
+				else
+					result.as_uint[row * res_type.cols + col] += args[0].constant.as_uint[row * args[0].type.cols + k] * args[1].constant.as_uint[k * args[1].type.cols + col];
+	})
 
 // ret isinf(x)
 DEFINE_INTRINSIC(isinf, 0, bool, float)
@@ -1645,6 +2038,10 @@ IMPLEMENT_INTRINSIC_SPIRV(isinf, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(isinf, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_uint[c] = std::isinf(args[0].constant.as_float[c]);
+	})
 
 // ret isnan(x)
 DEFINE_INTRINSIC(isnan, 0, bool, float)
@@ -1662,6 +2059,10 @@ IMPLEMENT_INTRINSIC_SPIRV(isnan, 0, {
 		.add(args[0].base)
 		.result;
 	})
+IMPLEMENT_INTRINSIC_CONSTANT(isnan, 0, {
+	for (unsigned int c = 0; c < res_type.components(); ++c)
+		result.as_uint[c] = std::isnan(args[0].constant.as_float[c]);
+	})
 
 // ret tex2D(s, coords)
 // ret tex2D(s, coords, offset)
@@ -2655,3 +3056,4 @@ IMPLEMENT_INTRINSIC_SPIRV(atomicCompareExchange, 0, {
 #undef IMPLEMENT_INTRINSIC_GLSL
 #undef IMPLEMENT_INTRINSIC_HLSL
 #undef IMPLEMENT_INTRINSIC_SPIRV
+#undef IMPLEMENT_INTRINSIC_CONSTANT
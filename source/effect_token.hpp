@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "effect_arena.hpp"
 #include <string>
 #include <vector>
 
@@ -17,9 +18,10 @@ namespace reshadefx
 	{
 		location() : line(1), column(1) {}
 		explicit location(uint32_t line, uint32_t column = 1) : line(line), column(column) {}
-		explicit location(std::string source, uint32_t line, uint32_t column = 1) : source(std::move(source)), line(line), column(column) {}
+		explicit location(const std::string_view &source, uint32_t line, uint32_t column = 1) : source(intern_global_string(source)), line(line), column(column) {}
 
-		std::string source;
+		// Source file names are interned, so that copying a location (which happens for every token and expression) does not allocate
+		std::string_view source;
 		uint32_t line, column;
 	};
 
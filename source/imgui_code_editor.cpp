@@ -92,16 +92,8 @@ static inline ImVec2 calc_text_size(const char *text, const char *text_end = nul
 	return ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, -1.0f, text, text_end, nullptr);
 }
 
-reshade::imgui::code_editor::code_editor()
-{
-	_lines.emplace_back();
-}
-
 void reshade::imgui::code_editor::render(const char *title, const uint32_t palette[color_palette_max], bool border, ImFont *font)
 {
-	// There should always at least be a single line with a new line character
-	assert(!_lines.empty());
-
 	// Get all the style values here, before they are overwritten via 'ImGui::PushStyleVar'
 	const float button_size = ImGui::GetFrameHeight();
 	const float bottom_height = ImGui::GetFrameHeightWithSpacing() + ImGui::GetStyle().ItemSpacing.y;
@@ -118,7 +110,7 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 	char buf[128] = "", *buf_end = buf;
 
 	// Deduce text start offset by evaluating maximum number of lines plus two spaces as text width
-	snprintf(buf, 16, " %zu ", _lines.size());
+	snprintf(buf, 16, " %zu ", _text.line_count());
 	const float text_start = ImGui::CalcTextSize(buf).x + _left_margin;
 	// The following holds the approximate width and height of a default character for offset calculation
 	const ImVec2 char_advance = ImVec2(calc_text_size(" ").x, ImGui::GetTextLineHeightWithSpacing() * _line_spacing);
@@ -206,13 +198,14 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 
 			text_pos res;
 			res.line = std::max<size_t>(0, static_cast<size_t>(floor(pos.y / char_advance.y)));
-			res.line = std::min<size_t>(res.line, _lines.size() - 1);
+			res.line = std::min<size_t>(res.line, _text.line_count() - 1);
 
 			float column_width = 0.0f;
 			std::string cumulated_string = "";
 			float cumulated_string_width[2] = { 0.0f, 0.0f }; // [0] is the latest, [1] is the previous. I use that trick to check where cursor is exactly (important for tabs).
 
-			const auto &line = _lines[res.line];
+			std::vector<glyph> line;
+			get_line(res.line, line);
 
 			// First we find the hovered column
 			while (text_start + cumulated_string_width[0] < pos.x && res.column < line.size())
@@ -294,40 +287,68 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 	text_pos parenthesis_pos[2];
 	{
 		char parenthesis_c = 0;
-		text_pos search_pos = _cursor_pos;
+		size_t search_offset = to_offset(_cursor_pos);
 
 		// Check if character to the right or left of the cursor is a parenthesis or bracket
-		if (search_pos.column < _lines[search_pos.line].size())
-			parenthesis_c = _lines[search_pos.line][search_pos.column].c;
-		if (search_pos.column > 0 && !get_parenthesis_type(parenthesis_c))
-			parenthesis_c = _lines[search_pos.line][--search_pos.column].c;
+		if (_cursor_pos.column < _text.line_size(_cursor_pos.line))
+			parenthesis_c = _text.char_at(search_offset);
+		if (_cursor_pos.column > 0 && !get_parenthesis_type(parenthesis_c))
+			parenthesis_c = _text.char_at(--search_offset);
 
 		if (const int parenthesis_type = get_parenthesis_type(parenthesis_c))
 		{
-			parenthesis_pos[0] = search_pos;
+			parenthesis_pos[0] = to_text_pos(search_offset);
 
 			const bool backwards = parenthesis_type > 0;
 			int parentheses_level = 1;
-			// These wrap around at zero to 'std::numeric_limits<size_t>::max()' which fail the loop condition and therefore work
-			search_pos.column += (backwards ? -1 : 1);
-			for (; search_pos.line <= (_lines.size() - 1) && parentheses_level != 0; backwards ? --search_pos.line : ++search_pos.line)
+
+			const auto is_matching_parenthesis = [parenthesis_type, backwards, &parentheses_level](char c) {
+				const int next_parenthesis_type = get_parenthesis_type(c);
+				if (std::abs(parenthesis_type) != std::abs(next_parenthesis_type))
+					return false;
+
+				return
+					(next_parenthesis_type < 0 && (backwards ? --parentheses_level : ++parentheses_level) == 0) ||
+					(next_parenthesis_type > 0 && (backwards ? ++parentheses_level : --parentheses_level) == 0);
+			};
+
+			// Search through the text in blocks, rather than looking up every character individually
+			constexpr size_t block_size = 4096;
+
+			if (backwards)
 			{
-				for (; search_pos.column < _lines[search_pos.line].size(); backwards ? --search_pos.column : ++search_pos.column)
+				for (size_t block_end = search_offset; block_end > 0 && parentheses_level != 0;)
 				{
-					const int next_parenthesis_type = get_parenthesis_type(_lines[search_pos.line][search_pos.column].c);
-					if (std::abs(parenthesis_type) != std::abs(next_parenthesis_type))
-						continue;
+					const size_t block_beg = block_end - std::min(block_end, block_size);
+					const std::string block = _text.substr(block_beg, block_end - block_beg);
 
-					if ((next_parenthesis_type < 0 && (backwards ? --parentheses_level : ++parentheses_level) == 0) ||
-						(next_parenthesis_type > 0 && (backwards ? ++parentheses_level : --parentheses_level) == 0))
+					for (size_t i = block.size(); i-- > 0;)
 					{
-						parenthesis_pos[1] = text_pos(search_pos.line, search_pos.column);
-						break;
+						if (is_matching_parenthesis(block[i]))
+						{
+							parenthesis_pos[1] = to_text_pos(block_beg + i);
+							break;
+						}
 					}
+
+					block_end = block_beg;
 				}
+			}
+			else
+			{
+				for (size_t block_beg = search_offset + 1; block_beg < _text.size() && parentheses_level != 0; block_beg += block_size)
+				{
+					const std::string block = _text.substr(block_beg, block_size);
 
-				// Reset search column on new line
-				search_pos.column = backwards && search_pos.line > 0 && !_lines[search_pos.line - 1].empty() ? _lines[search_pos.line - 1].size() - 1 : 0;
+					for (size_t i = 0; i < block.size(); ++i)
+					{
+						if (is_matching_parenthesis(block[i]))
+						{
+							parenthesis_pos[1] = to_text_pos(block_beg + i);
+							break;
+						}
+					}
+				}
 			}
 		}
 	}
@@ -341,12 +362,11 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 	const float space_size = calc_text_size(" ").x;
 
 	size_t line_no = static_cast<size_t>(floor(ImGui::GetScrollY() / char_advance.y));
-	size_t line_max = std::max<size_t>(0, std::min(_lines.size() - 1, line_no + static_cast<size_t>(floor((ImGui::GetScrollY() + ImGui::GetWindowContentRegionMax().y) / char_advance.y))));
+	size_t line_max = std::max<size_t>(0, std::min(_text.line_count() - 1, line_no + static_cast<size_t>(floor((ImGui::GetScrollY() + ImGui::GetWindowContentRegionMax().y) / char_advance.y))));
 
-	const auto calc_text_distance_to_line_begin = [this, space_size](const text_pos &from) {
+	const auto calc_text_distance_to_line_begin = [this, space_size](const std::vector<glyph> &line, size_t column) {
 		float distance = 0.0f;
-		const auto &line = _lines[from.line];
-		for (size_t i = 0u; i < line.size() && i < from.column; ++i)
+		for (size_t i = 0u; i < line.size() && i < column; ++i)
 			if (line[i].c == '\t')
 				distance += _tab_size * space_size;
 			else
@@ -354,9 +374,11 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 		return distance;
 	};
 
+	std::vector<glyph> line;
+
 	for (; line_no <= line_max; ++line_no, buf_end = buf)
 	{
-		const auto &line = _lines[line_no];
+		get_line(line_no, line);
 
 		// Position of the line number
 		const ImVec2 line_screen_pos = ImVec2(ImGui::GetCursorScreenPos().x, ImGui::GetCursorScreenPos().y + line_no * char_advance.y);
@@ -365,15 +387,15 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 
 		const text_pos line_beg_pos(line_no, 0);
 		const text_pos line_end_pos(line_no, line.size());
-		longest_line = std::max(calc_text_distance_to_line_begin(line_end_pos), longest_line);
+		longest_line = std::max(calc_text_distance_to_line_begin(line, line_end_pos.column), longest_line);
 
 		// Calculate selection rectangle
 		float selection_beg = -1.0f;
 		if (_select_beg <= line_end_pos)
-			selection_beg = _select_beg > line_beg_pos ? calc_text_distance_to_line_begin(_select_beg) : 0.0f;
+			selection_beg = _select_beg > line_beg_pos ? calc_text_distance_to_line_begin(line, _select_beg.column) : 0.0f;
 		float selection_end = -1.0f;
 		if (_select_end >  line_beg_pos)
-			selection_end = calc_text_distance_to_line_begin(_select_end < line_end_pos ? _select_end : line_end_pos);
+			selection_end = calc_text_distance_to_line_begin(line, _select_end < line_end_pos ? _select_end.column : line_end_pos.column);
 
 		// Add small overhead rectangle at the end of selected lines
 		if (_select_end.line > line_no)
@@ -395,8 +417,8 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 			{
 				if (parenthesis_pos[i].line == line_no)
 				{
-					const ImVec2 beg = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(parenthesis_pos[i]), text_screen_pos.y);
-					const ImVec2 end = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(text_pos(line_no, parenthesis_pos[i].column + 1)), text_screen_pos.y + char_advance.y);
+					const ImVec2 beg = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(line, parenthesis_pos[i].column), text_screen_pos.y);
+					const ImVec2 end = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(line, parenthesis_pos[i].column + 1), text_screen_pos.y + char_advance.y);
 
 					draw_list->AddRectFilled(beg, end, palette[color_selection]);
 				}
@@ -423,8 +445,8 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 						if ((begin_column == 0 || line[begin_column - 1].col != color_identifier) && (i + 1 == line.size() || line[i + 1].col != color_identifier)) // Make sure this is a whole word and not just part of one
 						{
 							// We found a matching text block
-							const ImVec2 beg = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(text_pos(line_no, begin_column)), text_screen_pos.y);
-							const ImVec2 end = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(text_pos(line_no, i + 1)), text_screen_pos.y + char_advance.y);
+							const ImVec2 beg = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(line, begin_column), text_screen_pos.y);
+							const ImVec2 end = ImVec2(text_screen_pos.x + calc_text_distance_to_line_begin(line, i + 1), text_screen_pos.y + char_advance.y);
 
 							draw_list->AddRectFilled(beg, end, palette[color_selection]);
 						}
@@ -474,7 +496,7 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 			// Draw the cursor animation
 			if (is_focused && io.ConfigInputTextCursorBlink && fmodf(_cursor_anim, 1.0f) <= 0.5f)
 			{
-				const float cx = calc_text_distance_to_line_begin(_cursor_pos);
+				const float cx = calc_text_distance_to_line_begin(line, _cursor_pos.column);
 
 				const ImVec2 beg = ImVec2(text_screen_pos.x + cx, line_screen_pos.y);
 				const ImVec2 end = ImVec2(text_screen_pos.x + cx + (_overwrite ? char_advance.x : 1.0f), line_screen_pos.y + char_advance.y); // Larger cursor while overwriting
@@ -520,11 +542,13 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 	}
 
 	// Create dummy widget so a horizontal scrollbar appears
-	ImGui::Dummy(ImVec2(text_start + longest_line, _lines.size() * char_advance.y));
+	ImGui::Dummy(ImVec2(text_start + longest_line, _text.line_count() * char_advance.y));
 
 	if (_scroll_to_cursor)
 	{
-		const float len = calc_text_distance_to_line_begin(_cursor_pos);
+		get_line(_cursor_pos.line, line);
+
+		const float len = calc_text_distance_to_line_begin(line, _cursor_pos.column);
 		const float extra_space = 8.0f;
 
 		const float max_scroll_width = ImGui::GetWindowWidth() - 16.0f;
@@ -655,10 +679,10 @@ void reshade::imgui::code_editor::render(const char *title, const uint32_t palet
 
 void reshade::imgui::code_editor::select(const text_pos &beg, const text_pos &end, selection_mode mode)
 {
-	assert(beg.line < _lines.size());
-	assert(end.line < _lines.size());
-	assert(beg.column <= _lines[beg.line].size()); // The last column is after the last character in the line
-	assert(end.column <= _lines[end.line].size());
+	assert(beg.line < _text.line_count());
+	assert(end.line < _text.line_count());
+	assert(beg.column <= _text.line_size(beg.line)); // The last column is after the last character in the line
+	assert(end.column <= _text.line_size(end.line));
 
 	if (end > beg)
 		_select_beg = beg,
@@ -668,8 +692,9 @@ void reshade::imgui::code_editor::select(const text_pos &beg, const text_pos &en
 		_select_beg = end;
 
 	const auto select_word = [this](text_pos &beg, text_pos &end) {
-		const auto &beg_line = _lines[beg.line];
-		const auto &end_line = _lines[end.line];
+		std::vector<glyph> beg_line, end_line;
+		get_line(beg.line, beg_line);
+		get_line(end.line, end_line);
 		// Empty lines cannot have any words, so abort
 		if (beg_line.empty() || end_line.empty())
 			return;
@@ -695,7 +720,7 @@ void reshade::imgui::code_editor::select(const text_pos &beg, const text_pos &en
 	text_pos highlight_beg = _select_beg;
 	text_pos highlight_end = _select_end;
 	select_word(highlight_beg, highlight_end);
-	_highlighted = _lines[highlight_beg.line].size() > highlight_beg.column && _lines[highlight_beg.line][highlight_beg.column].col == color_identifier ?
+	_highlighted = _text.line_size(highlight_beg.line) > highlight_beg.column && _text.color_at(to_offset(highlight_beg)) == color_identifier ?
 		get_text(highlight_beg, highlight_end) : std::string();
 
 	switch (mode)
@@ -705,17 +730,14 @@ void reshade::imgui::code_editor::select(const text_pos &beg, const text_pos &en
 		break;
 	case selection_mode::line:
 		_select_beg.column = 0;
-		_select_end.column = _lines[end.line].size();
+		_select_end.column = _text.line_size(end.line);
 		break;
 	}
 }
 void reshade::imgui::code_editor::select_all()
 {
-	if (_lines.empty())
-		return; // Cannot select anything if no text is set
-
 	// Move cursor to end of text
-	_cursor_pos = text_pos(_lines.size() - 1, _lines.back().size());
+	_cursor_pos = to_text_pos(_text.size());
 
 	// Update selection to contain everything
 	_interactive_beg = text_pos(0, 0);
@@ -723,34 +745,31 @@ void reshade::imgui::code_editor::select_all()
 
 	select(_interactive_beg, _interactive_end);
 }
+void reshade::imgui::code_editor::set_cursor_pos(const text_pos &pos)
+{
+	_cursor_pos = pos;
+
+	_interactive_beg = _interactive_end = pos;
+
+	select(pos, pos);
+}
 
 void reshade::imgui::code_editor::set_text(const std::string &text)
 {
-	_lines.clear();
-	_lines.emplace_back();
+	_text.assign(text);
 
 	_undo.clear();
 	_undo_index = 0;
 	_undo_base_index = 0;
 	_errors.clear();
 
-	for (char c : text)
-	{
-		if (c == '\r')
-			continue; // Ignore the carriage return character
-		else if (c == '\n')
-			_lines.emplace_back();
-		else
-			_lines.back().push_back({ c, color_default });
-	}
-
 	// Restrict cursor position to new text bounds
 	_select_beg = _select_end = text_pos();
 	_interactive_beg = _interactive_end = text_pos();
-	_cursor_pos = std::min(_cursor_pos, text_pos(_lines.size() - 1, _lines.back().size()));
+	_cursor_pos = std::min(_cursor_pos, to_text_pos(_text.size()));
 
 	_colorize_line_beg = 0;
-	_colorize_line_end = _lines.size();
+	_colorize_line_end = _text.line_count();
 }
 void reshade::imgui::code_editor::clear_text()
 {
@@ -779,12 +798,12 @@ void reshade::imgui::code_editor::insert_character(char c, bool auto_indent)
 			auto &beg = _select_beg;
 			auto &end = _select_end;
 
-			_colorize_line_beg = std::min(_colorize_line_beg, beg.line - std::min<size_t>(beg.line, 10));
-			_colorize_line_end = std::max(_colorize_line_end, end.line + 10 + 1);
+			_colorize_line_beg = std::min(_colorize_line_beg, beg.line);
+			_colorize_line_end = std::max(_colorize_line_end, end.line + 1);
 
 			beg.column = 0;
 			if (end.column == 0 && end.line > 0)
-				end.column = _lines[--end.line].size();
+				end.column = _text.line_size(--end.line);
 
 			u.removed = get_text(beg, end);
 			u.removed_beg = beg;
@@ -792,33 +811,28 @@ void reshade::imgui::code_editor::insert_character(char c, bool auto_indent)
 
 			for (size_t i = beg.line; i <= end.line; i++)
 			{
-				auto &line = _lines[i];
+				const size_t line_offset = _text.line_offset(i);
 
 				if (ImGui::GetIO().KeyShift)
 				{
-					if (line.empty())
-						continue; // Line is already empty, so there is no indentation to remove
-
-					if (line[0].c == '\t')
-					{
-						line.erase(line.begin());
-						if (i == end.line && end.column > 0)
-							end.column--;
-						if (i == _cursor_pos.line && _cursor_pos.column > 0)
-							_cursor_pos.column--;
-					}
-					else for (size_t j = 0; j < _tab_size && !line.empty() && line[0].c == ' '; j++) // Do the same for spaces
-					{
-						line.erase(line.begin());
-						if (i == end.line && end.column > 0)
-							end.column--;
-						if (i == _cursor_pos.line && _cursor_pos.column > 0)
-							_cursor_pos.column--;
-					}
+					// Remove a tab character or the spaces that make up one from the beginning of the line (if there is any indentation)
+					size_t indentation = 0;
+					if (_text.char_at(line_offset) == '\t')
+						indentation = 1;
+					else while (indentation < _tab_size && _text.char_at(line_offset + indentation) == ' ') // Do the same for spaces
+						indentation++;
+
+					_text.erase(line_offset, indentation);
+					if (i == end.line)
+						end.column -= std::min(end.column, indentation);
+					if (i == _cursor_pos.line)
+						_cursor_pos.column -= std::min(_cursor_pos.column, indentation);
 				}
 				else
 				{
-					line.insert(line.begin(), { '\t', color_background });
+					const uint8_t col = color_background;
+					_text.insert(line_offset, "\t");
+					_text.set_colors(line_offset, 1, &col);
 					if (i == end.line)
 						end.column++;
 					if (i == _cursor_pos.line)
@@ -840,43 +854,34 @@ void reshade::imgui::code_editor::insert_character(char c, bool auto_indent)
 	{
 		if (c == '\t' && auto_indent && ImGui::GetIO().KeyShift)
 		{
-			auto &line = _lines[_cursor_pos.line];
-
-			if (line.empty())
+			if (_text.line_size(_cursor_pos.line) == 0)
 				return; // Line is already empty, so there is no indentation to remove
 
+			const size_t line_offset = _text.line_offset(_cursor_pos.line);
+
+			size_t indentation = 0;
+			if (_text.char_at(line_offset) == '\t')
+				indentation = 1;
+			else while (indentation < _tab_size && _text.char_at(line_offset + indentation) == ' ') // Do the same for spaces
+				indentation++;
+
+			u.removed = _text.substr(line_offset, indentation);
 			u.removed_beg = text_pos(_cursor_pos.line, 0);
-			u.removed_end = u.removed_beg;
+			u.removed_end = text_pos(_cursor_pos.line, indentation);
 
-			if (line[0].c == '\t')
-			{
-				u.removed += line[0].c;
-				u.removed_end.column++;
-				line.erase(line.begin());
-				if (_cursor_pos.column > 0)
-					_cursor_pos.column--;
-			}
-			else for (size_t j = 0; j < _tab_size && !line.empty() && line[0].c == ' '; j++) // Do the same for spaces
-			{
-				u.removed += line[0].c;
-				u.removed_end.column++;
-				line.erase(line.begin());
-				if (_cursor_pos.column > 0)
-					_cursor_pos.column--;
-			}
+			_text.erase(line_offset, indentation);
+			_cursor_pos.column -= std::min(_cursor_pos.column, indentation);
 
 			record_undo(std::move(u));
 			return;
 		}
 	}
 
-	assert(!_lines.empty());
-
 	u.added = c;
 	u.added_beg = _cursor_pos;
 
-	// Colorize additional 10 lines above and below to better catch multi-line constructs
-	_colorize_line_beg = std::min(_colorize_line_beg, _cursor_pos.line - std::min<size_t>(_cursor_pos.line, 10));
+	// Colorize the lines that were changed (multi-line constructs are handled by the lexer state tracked per line)
+	_colorize_line_beg = std::min(_colorize_line_beg, _cursor_pos.line);
 
 	// New line feed requires insertion of a new line
 	if (c == '\n')
@@ -888,29 +893,27 @@ void reshade::imgui::code_editor::insert_character(char c, bool auto_indent)
 			errors.insert({ i.first >= _cursor_pos.line + 1 ? i.first + 1 : i.first, i.second });
 		_errors = std::move(errors);
 
-		auto &new_line = *_lines.emplace(_lines.begin() + _cursor_pos.line + 1);
-		auto &line = _lines[_cursor_pos.line];
-
 		// Auto indentation
-		if (auto_indent && _cursor_pos.column == line.size())
-			for (size_t i = 0; i < line.size() && isblank(line[i].c); ++i)
-				new_line.push_back(line[i]), u.added.push_back(line[i].c);
-		const size_t indentation = new_line.size();
+		if (auto_indent && _cursor_pos.column == _text.line_size(_cursor_pos.line))
+		{
+			const std::string line = _text.substr(_text.line_offset(_cursor_pos.line), _cursor_pos.column);
+			for (size_t i = 0; i < line.size() && isblank(line[i]); ++i)
+				u.added.push_back(line[i]);
+		}
+		const size_t indentation = u.added.size() - 1;
 
-		new_line.insert(new_line.end(), line.begin() + _cursor_pos.column, line.end());
-		line.erase(line.begin() + _cursor_pos.column, line.begin() + line.size());
+		_text.insert(to_offset(_cursor_pos), u.added);
 
 		_cursor_pos.line++;
 		_cursor_pos.column = indentation;
 	}
 	else if (c != '\r') // Ignore carriage return
 	{
-		auto &line = _lines[_cursor_pos.line];
+		const size_t offset = to_offset(_cursor_pos);
 
-		if (_overwrite && _cursor_pos.column < line.size())
-			line[_cursor_pos.column] = { c, color_default };
-		else
-			line.insert(line.begin() + _cursor_pos.column, { c, color_default });
+		if (_overwrite && _cursor_pos.column < _text.line_size(_cursor_pos.line))
+			_text.erase(offset, 1);
+		_text.insert(offset, std::string_view(&c, 1));
 
 		_cursor_pos.column++;
 	}
@@ -923,45 +926,19 @@ void reshade::imgui::code_editor::insert_character(char c, bool auto_indent)
 
 	_scroll_to_cursor = true;
 
-	_colorize_line_end = std::max(_colorize_line_end, _cursor_pos.line + 10 + 1);
+	_colorize_line_end = std::max(_colorize_line_end, _cursor_pos.line + 1);
 }
 
 std::string reshade::imgui::code_editor::get_text() const
 {
-	return get_text(0, _lines.size());
+	return _text.substr(0, _text.size());
 }
 std::string reshade::imgui::code_editor::get_text(const text_pos &beg, const text_pos &end) const
 {
-	// Calculate length of text to pre-allocate memory before building the string
-	size_t length = 0;
-	for (auto it = beg; it < end; it.line++)
-		length += _lines[it.line].size() + 1;
+	const size_t beg_offset = to_offset(beg);
+	const size_t end_offset = to_offset(end);
 
-	std::string result;
-	result.reserve(length);
-
-	for (auto it = beg; it < end;)
-	{
-		const auto &line = _lines[it.line];
-
-		if (it.column < line.size())
-		{
-			result.push_back(line[it.column].c);
-
-			it.column++;
-		}
-		else
-		{
-			it.line++;
-			it.column = 0;
-
-			if (it.line < _lines.size())
-				// Reached end of line, so append a new line feed
-				result.push_back('\n');
-		}
-	}
-
-	return result;
+	return end_offset > beg_offset ? _text.substr(beg_offset, end_offset - beg_offset) : std::string();
 }
 std::string reshade::imgui::code_editor::get_selected_text() const
 {
@@ -1054,45 +1031,33 @@ void reshade::imgui::code_editor::delete_next()
 		return;
 	}
 
-	assert(!_lines.empty());
-
-	auto &line = _lines[_cursor_pos.line];
-
 	undo_record u;
 	u.removed_beg = _cursor_pos;
 	u.removed_end = _cursor_pos;
 
-	// If at end of line, move next line into the current one
-	if (_cursor_pos.column == line.size())
+	// If at end of line, move next line into the current one by removing the line feed
+	if (_cursor_pos.column == _text.line_size(_cursor_pos.line))
 	{
-		if (_cursor_pos.line == _lines.size() - 1)
+		if (_cursor_pos.line == _text.line_count() - 1)
 			return; // This already is the last line
 
-		const auto &next_line = _lines[_cursor_pos.line + 1];
-
 		u.removed = '\n';
 		u.removed_end.line++;
 		u.removed_end.column = 0;
-
-		// Copy next line into current line
-		line.insert(line.end(), next_line.begin(), next_line.end());
-
-		// Remove the line
-		delete_lines(_cursor_pos.line + 1, _cursor_pos.line + 1);
 	}
 	else
 	{
-		u.removed = line[_cursor_pos.column].c;
-		u.removed_end.column++;
-
 		// Otherwise just remove the character at the cursor position
-		line.erase(line.begin() + _cursor_pos.column);
+		u.removed = _text.char_at(to_offset(_cursor_pos));
+		u.removed_end.column++;
 	}
 
+	erase_text(u.removed_beg, u.removed_end);
+
 	record_undo(std::move(u));
 
-	_colorize_line_beg = std::min(_colorize_line_beg, _cursor_pos.line - std::min<size_t>(_cursor_pos.line, 10));
-	_colorize_line_end = std::max(_colorize_line_end, _cursor_pos.line + 10 + 1);
+	_colorize_line_beg = std::min(_colorize_line_beg, _cursor_pos.line);
+	_colorize_line_end = std::max(_colorize_line_end, _cursor_pos.line + 1);
 }
 void reshade::imgui::code_editor::delete_previous()
 {
@@ -1105,48 +1070,38 @@ void reshade::imgui::code_editor::delete_previous()
 		return;
 	}
 
-	assert(!_lines.empty());
-
-	auto &line = _lines[_cursor_pos.line];
-
 	undo_record u;
 	u.removed_end = _cursor_pos;
 
-	// If at beginning of line, move previous line into the current one
+	// If at beginning of line, move current line into the previous one by removing the line feed
 	if (_cursor_pos.column == 0)
 	{
 		if (_cursor_pos.line == 0)
 			return; // This already is the first line
 
-		auto &prev_line = _lines[_cursor_pos.line - 1];
 		_cursor_pos.line--;
-		_cursor_pos.column = prev_line.size();
+		_cursor_pos.column = _text.line_size(_cursor_pos.line);
 
 		u.removed = '\n';
-
-		// Copy current line into previous line
-		prev_line.insert(prev_line.end(), line.begin(), line.end());
-
-		// Remove the line
-		delete_lines(_cursor_pos.line + 1, _cursor_pos.line + 1);
 	}
 	else
 	{
+		// Otherwise remove the character next to the cursor position
 		_cursor_pos.column--;
 
-		u.removed = line[_cursor_pos.column].c;
-
-		// Otherwise remove the character next to the cursor position
-		line.erase(line.begin() + _cursor_pos.column);
+		u.removed = _text.char_at(to_offset(_cursor_pos));
 	}
 
 	u.removed_beg = _cursor_pos;
+
+	erase_text(u.removed_beg, u.removed_end);
+
 	record_undo(std::move(u));
 
 	_scroll_to_cursor = true;
 
-	_colorize_line_beg = std::min(_colorize_line_beg, _cursor_pos.line - std::min<size_t>(_cursor_pos.line, 10));
-	_colorize_line_end = std::max(_colorize_line_end, _cursor_pos.line + 10 + 1);
+	_colorize_line_beg = std::min(_colorize_line_beg, _cursor_pos.line);
+	_colorize_line_end = std::max(_colorize_line_end, _cursor_pos.line + 1);
 }
 void reshade::imgui::code_editor::delete_selection()
 {
@@ -1156,62 +1111,42 @@ void reshade::imgui::code_editor::delete_selection()
 	if (!has_selection())
 		return;
 
-	assert(!_lines.empty());
-
 	undo_record u;
 	u.removed = get_selected_text();
 	u.removed_beg = _select_beg;
 	u.removed_end = _select_end;
 	record_undo(std::move(u));
 
-	if (_select_beg.line == _select_end.line)
-	{
-		auto &line = _lines[_select_beg.line];
+	erase_text(_select_beg, _select_end);
 
-		if (_select_end.column >= line.size())
-			line.erase(line.begin() + _select_beg.column, line.end());
-		else
-			line.erase(line.begin() + _select_beg.column, line.begin() + _select_end.column);
-	}
-	else
-	{
-		auto &beg_line = _lines[_select_beg.line];
-		auto &end_line = _lines[_select_end.line];
-
-		beg_line.erase(beg_line.begin() + _select_beg.column, beg_line.end());
-		end_line.erase(end_line.begin(), end_line.begin() + _select_end.column);
-
-		if (_select_beg.line < _select_end.line)
-		{
-			beg_line.insert(beg_line.end(), end_line.begin(), end_line.end());
-
-			delete_lines(_select_beg.line + 1, _select_end.line);
-		}
-
-		assert(!_lines.empty());
-	}
-
-	_colorize_line_beg = std::min(_colorize_line_beg, _select_beg.line - std::min<size_t>(_cursor_pos.line, 10));
-	_colorize_line_end = std::max(_colorize_line_end, _select_end.line + 10 + 1);
+	// All selected lines were merged into the first one
+	_colorize_line_beg = std::min(_colorize_line_beg, _select_beg.line);
+	_colorize_line_end = std::max(_colorize_line_end, _select_beg.line + 1);
 
 	// Reset selection
 	_cursor_pos = _select_beg;
 	select(_cursor_pos, _cursor_pos);
 }
-void reshade::imgui::code_editor::delete_lines(size_t first_line, size_t last_line)
+void reshade::imgui::code_editor::erase_text(const text_pos &beg, const text_pos &end)
 {
 	if (_readonly)
 		return;
 
-	// Move all error markers after the deleted lines down
-	std::unordered_map<size_t, std::pair<std::string, bool>> errors;
-	errors.reserve(_errors.size());
-	for (auto &i : _errors)
-		if (i.first < first_line && i.first > last_line)
-			errors.insert({ i.first > last_line ? i.first - (last_line - first_line) : i.first, i.second });
-	_errors = std::move(errors);
+	if (end.line > beg.line)
+	{
+		// Remove error markers on the lines that are merged into the first one and move all error markers after them up (error markers are using one-based line numbers)
+		std::unordered_map<size_t, std::pair<std::string, bool>> errors;
+		errors.reserve(_errors.size());
+		for (auto &i : _errors)
+			if (i.first <= beg.line + 1 || i.first > end.line + 1)
+				errors.insert({ i.first > end.line + 1 ? i.first - (end.line - beg.line) : i.first, i.second });
+		_errors = std::move(errors);
+	}
 
-	_lines.erase(_lines.begin() + first_line, _lines.begin() + last_line + 1);
+	const size_t beg_offset = to_offset(beg);
+	const size_t end_offset = to_offset(end);
+	if (end_offset > beg_offset)
+		_text.erase(beg_offset, end_offset - beg_offset);
 }
 
 void reshade::imgui::code_editor::clipboard_copy()
@@ -1223,12 +1158,9 @@ void reshade::imgui::code_editor::clipboard_copy()
 	{
 		ImGui::SetClipboardText(get_selected_text().c_str());
 	}
-	else if (!_lines.empty()) // Copy current line if there is no selection
+	else // Copy current line if there is no selection
 	{
-		std::string line_text;
-		line_text.reserve(_lines[_cursor_pos.line].size());
-		for (const glyph &glyph : _lines[_cursor_pos.line])
-			line_text.push_back(glyph.c);
+		std::string line_text = _text.substr(_text.line_offset(_cursor_pos.line), _text.line_size(_cursor_pos.line));
 		// Include new line character
 		line_text += '\n';
 
@@ -1295,13 +1227,11 @@ void reshade::imgui::code_editor::clipboard_paste()
 
 void reshade::imgui::code_editor::move_up(size_t amount, bool selection)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
 	_cursor_pos.line = std::max<intptr_t>(0, _cursor_pos.line - amount);
 
 	// The line before could be shorter, so adjust column
-	_cursor_pos.column = std::min<intptr_t>(_cursor_pos.column, _lines[_cursor_pos.line].size());
+	_cursor_pos.column = std::min<intptr_t>(_cursor_pos.column, _text.line_size(_cursor_pos.line));
 
 	if (prev_pos == _cursor_pos)
 		return;
@@ -1327,13 +1257,11 @@ void reshade::imgui::code_editor::move_up(size_t amount, bool selection)
 }
 void reshade::imgui::code_editor::move_down(size_t amount, bool selection)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
-	_cursor_pos.line = std::min<intptr_t>(_cursor_pos.line + amount, _lines.size() - 1);
+	_cursor_pos.line = std::min<intptr_t>(_cursor_pos.line + amount, _text.line_count() - 1);
 
 	// The line after could be shorter, so adjust column
-	_cursor_pos.column = std::min<intptr_t>(_cursor_pos.column, _lines[_cursor_pos.line].size());
+	_cursor_pos.column = std::min<intptr_t>(_cursor_pos.column, _text.line_size(_cursor_pos.line));
 
 	if (prev_pos == _cursor_pos)
 		return;
@@ -1359,8 +1287,6 @@ void reshade::imgui::code_editor::move_down(size_t amount, bool selection)
 }
 void reshade::imgui::code_editor::move_left(size_t amount, bool selection, bool word_mode)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
 
 	// Move cursor to selection start when moving left and no longer selecting
@@ -1379,12 +1305,15 @@ void reshade::imgui::code_editor::move_left(size_t amount, bool selection, bool
 					break;
 
 				_cursor_pos.line--;
-				_cursor_pos.column = _lines[_cursor_pos.line].size();
+				_cursor_pos.column = _text.line_size(_cursor_pos.line);
 			}
 			else if (word_mode)
 			{
-				for (const auto word_color = _lines[_cursor_pos.line][_cursor_pos.column - 1].col; _cursor_pos.column > 0; --_cursor_pos.column)
-					if (_lines[_cursor_pos.line][_cursor_pos.column - 1].col != word_color)
+				std::vector<glyph> line;
+				get_line(_cursor_pos.line, line);
+
+				for (const auto word_color = line[_cursor_pos.column - 1].col; _cursor_pos.column > 0; --_cursor_pos.column)
+					if (line[_cursor_pos.column - 1].col != word_color)
 						break;
 			}
 			else
@@ -1415,17 +1344,13 @@ void reshade::imgui::code_editor::move_left(size_t amount, bool selection, bool
 }
 void reshade::imgui::code_editor::move_right(size_t amount, bool selection, bool word_mode)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
 
 	while (amount-- > 0)
 	{
-		auto &line = _lines[_cursor_pos.line];
-
-		if (_cursor_pos.column >= line.size()) // At the end of the current line, so move on to next
+		if (_cursor_pos.column >= _text.line_size(_cursor_pos.line)) // At the end of the current line, so move on to next
 		{
-			if (_cursor_pos.line >= _lines.size() - 1)
+			if (_cursor_pos.line >= _text.line_count() - 1)
 				break; // Reached end of input
 
 			_cursor_pos.line++;
@@ -1433,8 +1358,11 @@ void reshade::imgui::code_editor::move_right(size_t amount, bool selection, bool
 		}
 		else if (word_mode)
 		{
-			for (const auto word_color = _lines[_cursor_pos.line][_cursor_pos.column].col; _cursor_pos.column < _lines[_cursor_pos.line].size(); ++_cursor_pos.column)
-				if (_lines[_cursor_pos.line][_cursor_pos.column].col != word_color)
+			std::vector<glyph> line;
+			get_line(_cursor_pos.line, line);
+
+			for (const auto word_color = line[_cursor_pos.column].col; _cursor_pos.column < line.size(); ++_cursor_pos.column)
+				if (line[_cursor_pos.column].col != word_color)
 					break;
 		}
 		else
@@ -1463,8 +1391,6 @@ void reshade::imgui::code_editor::move_right(size_t amount, bool selection, bool
 }
 void reshade::imgui::code_editor::move_top(bool selection)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
 	_cursor_pos = text_pos(0, 0);
 
@@ -1492,10 +1418,8 @@ void reshade::imgui::code_editor::move_top(bool selection)
 }
 void reshade::imgui::code_editor::move_bottom(bool selection)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
-	_cursor_pos = text_pos(_lines.size() - 1, 0);
+	_cursor_pos = text_pos(_text.line_count() - 1, 0);
 
 	if (prev_pos == _cursor_pos)
 		return;
@@ -1520,8 +1444,6 @@ void reshade::imgui::code_editor::move_bottom(bool selection)
 }
 void reshade::imgui::code_editor::move_home(bool selection)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
 	_cursor_pos.column = 0;
 
@@ -1549,10 +1471,8 @@ void reshade::imgui::code_editor::move_home(bool selection)
 }
 void reshade::imgui::code_editor::move_end(bool selection)
 {
-	assert(!_lines.empty());
-
 	const auto prev_pos = _cursor_pos;
-	_cursor_pos.column = _lines[_cursor_pos.line].size();
+	_cursor_pos.column = _text.line_size(_cursor_pos.line);
 
 	if (prev_pos == _cursor_pos &&
 		_interactive_beg == _interactive_end) // This ensures that deselection works even when cursor is already at end
@@ -1581,24 +1501,38 @@ void reshade::imgui::code_editor::move_lines_up()
 	if (_select_beg.line == 0 || _readonly)
 		return;
 
-	for (size_t line = _select_beg.line; line <= _select_end.line; ++line)
-		std::swap(_lines[line], _lines[line - 1]);
+	// Move the line above the selected lines to below them
+	const size_t prev_line_offset = _text.line_offset(_select_beg.line - 1);
+	const std::string prev_line = _text.substr(prev_line_offset, _text.line_size(_select_beg.line - 1));
+	_text.erase(prev_line_offset, prev_line.size() + 1);
 
 	_select_beg.line--;
 	_select_end.line--;
 	_cursor_pos.line--;
+
+	_text.insert(_text.line_offset(_select_end.line) + _text.line_size(_select_end.line), '\n' + prev_line);
+
+	_colorize_line_beg = std::min(_colorize_line_beg, _select_beg.line);
+	_colorize_line_end = std::max(_colorize_line_end, _select_end.line + 2);
 }
 void reshade::imgui::code_editor::move_lines_down()
 {
-	if (_select_end.line + 1 >= _lines.size() || _readonly)
+	if (_select_end.line + 1 >= _text.line_count() || _readonly)
 		return;
 
-	for (size_t line = _select_end.line; line >= _select_beg.line && line < _lines.size(); --line)
-		std::swap(_lines[line], _lines[line + 1]);
+	// Move the line below the selected lines to above them
+	const size_t next_line_offset = _text.line_offset(_select_end.line + 1);
+	const std::string next_line = _text.substr(next_line_offset, _text.line_size(_select_end.line + 1));
+	_text.erase(next_line_offset - 1, next_line.size() + 1);
+
+	_text.insert(_text.line_offset(_select_beg.line), next_line + '\n');
 
 	_select_beg.line++;
 	_select_end.line++;
 	_cursor_pos.line++;
+
+	_colorize_line_beg = std::min(_colorize_line_beg, _select_beg.line - 1);
+	_colorize_line_end = std::max(_colorize_line_end, _select_end.line + 1);
 }
 
 bool reshade::imgui::code_editor::find_and_scroll_to_text(const std::string &text, bool backwards, bool with_selection)
@@ -1611,119 +1545,40 @@ bool reshade::imgui::code_editor::find_and_scroll_to_text(const std::string &tex
 	};
 
 	// Start search at the cursor position
-	text_pos match_pos_beg, search_pos = backwards != with_selection ? _select_beg : _select_end;
+	const text_pos search_pos = backwards != with_selection ? _select_beg : _select_end;
+	const size_t search_offset = to_offset(search_pos);
+
+	size_t match_offset = 0;
 
 	if (backwards)
 	{
-		// Start searching at the character before the current cursor position
-		if (search_pos.column != 0)
-		{
-			search_pos.column -= 1;
-		}
-		else if (search_pos.line != 0)
-		{
-			search_pos.line -= 1;
-			search_pos.column = _lines[search_pos.line].size();
-		}
+		// Search for the last match that ends before the cursor position
+		const std::string search_text = _text.substr(0, search_offset);
 
-		const size_t match_last = text.size() - 1;
-		size_t match_offset = match_last;
+		const auto it = std::find_end(search_text.begin(), search_text.end(), text.begin(), text.end(), compare_c);
+		if (it == search_text.end())
+			return false; // No match found
 
-		while (true)
-		{
-			if (!_lines[search_pos.line].empty())
-			{
-				// Trim column index to the last character in the line (rather than the actual end)
-				search_pos.column = std::min(search_pos.column, _lines[search_pos.line].size() - 1);
-
-				while (true)
-				{
-					if (compare_c(_lines[search_pos.line][search_pos.column].c, text[match_offset]))
-					{
-						if (match_offset == match_last) // Keep track of end of the match
-							match_pos_beg = search_pos;
-
-						// All characters matching means the text was found, so select it and return
-						if (match_offset == 0)
-						{
-							_select_beg = search_pos;
-							_select_end = text_pos(match_pos_beg.line, match_pos_beg.column + 1);
-							_cursor_pos = _select_beg;
-							_scroll_to_cursor = true;
-							return true;
-						}
-						else
-						{
-							match_offset--;
-						}
-					}
-					else
-					{
-						// A character mismatched, so start from the end again
-						match_offset = match_last;
-					}
-
-					if (search_pos.column == 0)
-						break; // Reached the first column and cannot go further back, so break and go up the next line
-					else
-						search_pos.column -= 1;
-				}
-			}
-
-			if (search_pos.line == 0)
-				break; // Reached the first line and cannot go further back, so abort
-			else
-				search_pos.line -= 1;
-
-			if (match_offset != match_last && text[match_offset--] != '\n')
-				match_offset  = match_last; // Check for line feed in search text between lines
-
-			search_pos.column = _lines[search_pos.line].size(); // Continue at end of previous line
-		}
+		match_offset = it - search_text.begin();
 	}
 	else
 	{
-		size_t match_offset = 0;
-
-		while (search_pos.line < _lines.size())
-		{
-			if (match_offset != 0 && text[match_offset++] != '\n')
-				match_offset  = 0; // Check for line feed in search text between lines
-
-			while (search_pos.column < _lines[search_pos.line].size())
-			{
-				if (compare_c(_lines[search_pos.line][search_pos.column].c, text[match_offset]))
-				{
-					if (match_offset == 0) // Keep track of beginning of the match
-						match_pos_beg = search_pos;
-
-					match_offset++;
-
-					// All characters matching means the text was found, so select it and return
-					if (match_offset == text.size())
-					{
-						_select_beg = match_pos_beg;
-						_select_end = text_pos(search_pos.line, search_pos.column + 1);
-						_cursor_pos = _select_end;
-						_scroll_to_cursor = true;
-						return true;
-					}
-				}
-				else
-				{
-					// A character mismatched, so start from the beginning again
-					match_offset = 0;
-				}
+		// Search for the first match that begins after the cursor position
+		const std::string search_text = _text.substr(search_offset, _text.size() - search_offset);
 
-				search_pos.column += 1;
-			}
+		const auto it = std::search(search_text.begin(), search_text.end(), text.begin(), text.end(), compare_c);
+		if (it == search_text.end())
+			return false; // No match found
 
-			search_pos.line += 1;
-			search_pos.column = 0;
-		}
+		match_offset = search_offset + (it - search_text.begin());
 	}
 
-	return false; // No match found
+	// Select the text that was found
+	_select_beg = to_text_pos(match_offset);
+	_select_end = to_text_pos(match_offset + text.size());
+	_cursor_pos = backwards ? _select_beg : _select_end;
+	_scroll_to_cursor = true;
+	return true;
 }
 
 void reshade::imgui::code_editor::colorize()
@@ -1731,27 +1586,73 @@ void reshade::imgui::code_editor::colorize()
 	if (_colorize_line_beg >= _colorize_line_end)
 		return;
 
+	const size_t line_count = _text.line_count();
+	if (_colorize_line_end > line_count)
+		_colorize_line_end = line_count;
+
 	// Step through code incrementally rather than coloring everything at once
-	const size_t from = _colorize_line_beg, to = std::min(from + 1000, _colorize_line_end);
-	_colorize_line_beg = to;
+	// Lines are lexed in blocks that grow in size, so that typing only lexes the changed lines, while changes affecting many lines (like opening a multi-line comment) still progress quickly
+	for (size_t from = _colorize_line_beg, num_lines = std::max<size_t>(_colorize_line_end - from, 16), lines_left = 1000; from < line_count; from += num_lines, lines_left -= num_lines, num_lines *= 2)
+	{
+		if (lines_left == 0)
+		{
+			_colorize_line_beg = from;
+			_colorize_line_end = std::max(_colorize_line_end, from + 1);
+			return;
+		}
+
+		num_lines = std::min(num_lines, lines_left);
 
-	// Reset coloring range if we have finished coloring it after this iteration
-	if (_colorize_line_end > _lines.size())
-		_colorize_line_end = _lines.size();
-	if (_colorize_line_beg == _colorize_line_end)
+		if (colorize(from, std::min(from + num_lines, line_count)))
+			break;
+	}
+
+	// Reset coloring range, since everything that changed has been colored now
+	_colorize_line_beg = std::numeric_limits<size_t>::max();
+	_colorize_line_end = 0;
+}
+bool reshade::imgui::code_editor::colorize(size_t from, size_t to)
+{
+	const size_t from_offset = _text.line_offset(from);
+	const size_t to_offset = _text.line_offset(to);
+
+	// Continue any multi-line construct the first line starts in by prepending its beginning to the input
+	std::string input_string;
+	switch (from != 0 ? static_cast<line_state>(_text.color_at(from_offset - 1)) : line_state::normal)
 	{
-		_colorize_line_beg = std::numeric_limits<size_t>::max();
-		_colorize_line_end = 0;
+	case line_state::multi_line_comment:
+		input_string = "/* "; // Include a space so that a '/' at the beginning of the line cannot close the comment
+		break;
+	case line_state::string_literal:
+		input_string = "\"";
+		break;
+	case line_state::preprocessor_directive:
+	{
+		// Prepend the lines the directive spans so far, starting with the one containing its '#'
+		size_t directive_line = from - 1;
+		while (directive_line != 0 && static_cast<line_state>(_text.color_at(_text.line_offset(directive_line) - 1)) == line_state::preprocessor_directive)
+			directive_line--;
+		const size_t directive_offset = _text.line_offset(directive_line);
+		input_string = _text.substr(directive_offset, from_offset - directive_offset);
+		break;
+	}
+	case line_state::unknown:
+	case line_state::normal:
+		break;
 	}
 
+	const size_t prefix_size = input_string.size();
+
 	// Copy lines into string for consumption by the lexer
-	std::string input_string;
-	for (size_t l = from; l < to && l < _lines.size(); ++l, input_string.push_back('\n'))
-		for (size_t k = 0; k < _lines[l].size(); ++k)
-			input_string.push_back(_lines[l][k].c);
+	input_string += _text.substr(from_offset, to_offset - from_offset);
+
+	// Update the colors of the lines all at once after lexing them
+	std::vector<uint8_t> colors(input_string.size() - prefix_size, static_cast<uint8_t>(color_default));
+	std::vector<uint8_t> prev_colors(colors.size());
+	_text.get_colors(from_offset, prev_colors.size(), prev_colors.data());
 
 	reshadefx::lexer lexer(
-		input_string,
+		std::move(input_string),
 		false /* ignore_comments */,
 		true  /* ignore_whitespace */,
 		false /* ignore_pp_directives */,
@@ -1958,19 +1859,64 @@ void reshade::imgui::code_editor::colorize()
 		}
 
 		// Update character range matching the current the token
-		size_t line = from + tok.location.line - 1;
-		size_t column = tok.location.column - 1;
+		const size_t tok_beg = std::max(tok.offset, prefix_size) - prefix_size;
+		const size_t tok_end = std::min(tok.offset + tok.length, lexer.input_string().size()) - prefix_size;
+		if (tok_end > tok_beg)
+			std::fill(colors.begin() + tok_beg, colors.begin() + tok_end, static_cast<uint8_t>(col));
+	}
 
-		for (size_t k = 0; k < tok.length; ++k)
-		{
-			if (column >= _lines[line].size())
-			{
-				line++;
-				column = 0;
-				continue;
-			}
+	// Store the lexer state at the beginning of each line in the color of the line feed before it (which is never rendered)
+	// Lines after the changed ones only need to be colored again if the state they begin in changed
+	for (size_t i = 0, line = from + 1; i < colors.size(); ++i)
+	{
+		if (lexer.input_string()[prefix_size + i] != '\n')
+			continue;
+
+		line_state state = line_state::normal;
+		if (colors[i] == color_multiline_comment)
+			state = line_state::multi_line_comment;
+		else if (colors[i] == color_string_literal)
+			state = line_state::string_literal;
+		else if (colors[i] == color_preprocessor)
+			state = line_state::preprocessor_directive;
 
-			_lines[line][column++].col = col;
+		colors[i] = static_cast<uint8_t>(state);
+
+		if (line++ >= _colorize_line_end && colors[i] == prev_colors[i])
+		{
+			_text.set_colors(from_offset, i + 1, colors.data());
+			return true;
 		}
 	}
+
+	_text.set_colors(from_offset, colors.size(), colors.data());
+	return to == _text.line_count();
+}
+
+void reshade::imgui::code_editor::get_line(size_t line, std::vector<glyph> &glyphs) const
+{
+	const size_t offset = _text.line_offset(line);
+	const std::string text = _text.substr(offset, _text.line_size(line));
+
+	std::vector<uint8_t> colors(text.size());
+	_text.get_colors(offset, colors.size(), colors.data());
+
+	glyphs.resize(text.size());
+	for (size_t i = 0; i < text.size(); ++i)
+		glyphs[i] = { text[i], static_cast<color>(colors[i]) };
+}
+
+size_t reshade::imgui::code_editor::to_offset(const text_pos &pos) const
+{
+	if (pos.line >= _text.line_count())
+		return _text.size();
+
+	// Columns past the end of a line refer to the end of that line
+	return _text.line_offset(pos.line) + std::min(pos.column, _text.line_size(pos.line));
+}
+reshade::imgui::code_editor::text_pos reshade::imgui::code_editor::to_text_pos(size_t offset) const
+{
+	const size_t line = _text.line_at(offset);
+
+	return text_pos(line, offset - _text.line_offset(line));
 }
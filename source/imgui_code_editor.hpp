@@ -6,8 +6,7 @@
 
 #pragma once
 
-#include <string>
-#include <vector>
+#include "imgui_text_buffer.hpp"
 #include <unordered_map>
 
 struct ImFont;
@@ -75,8 +74,6 @@ namespace reshade::imgui
 
 		static const char *get_palette_color_name(unsigned int index);
 
-		code_editor();
-
 		/// <summary>
 		/// Performs all input logic and renders this text editor to the current ImGui window.
 		/// </summary>
@@ -86,6 +83,16 @@ namespace reshade::imgui
 		/// <param name="font">Font used for rendering the text (<see langword="nullptr"/> to use the default).</param>
 		void render(const char *title, const uint32_t palette[color_palette_max], bool border = false, ImFont *font = nullptr);
 
+		/// <summary>
+		/// Updates syntax highlighting of the next block of lines that changed since the last call.
+		/// This is done once per frame in <see cref="render"/>, but can also be called directly to color text without rendering it.
+		/// </summary>
+		void colorize();
+		/// <summary>
+		/// Returns whether there are changed lines left that syntax highlighting was not updated for yet.
+		/// </summary>
+		bool is_colorizing() const { return _colorize_line_beg < _colorize_line_end; }
+
 		/// <summary>
 		/// Sets the selection to be between the specified <paramref name="beg"/>in and <paramref name="end"/> positions.
 		/// </summary>
@@ -98,6 +105,10 @@ namespace reshade::imgui
 		/// </summary>
 		void select_all();
 		/// <summary>
+		/// Moves the cursor to the specified position and clears the selection.
+		/// </summary>
+		void set_cursor_pos(const text_pos &pos);
+		/// <summary>
 		/// Returns whether a selection is currently active.
 		/// </summary>
 		bool has_selection() const { return _select_end > _select_beg; }
@@ -203,6 +214,23 @@ namespace reshade::imgui
 			color col = color_default;
 		};
 
+		/// <summary>
+		/// State of the lexer at the beginning of a line, which is stored in the color of the line feed character ending the previous line.
+		/// </summary>
+		enum class line_state : uint8_t
+		{
+			unknown, // Line feed was inserted and not colored yet
+			normal,
+			multi_line_comment,
+			string_literal,
+			preprocessor_directive,
+		};
+
+		void get_line(size_t line, std::vector<glyph> &glyphs) const;
+
+		size_t to_offset(const text_pos &pos) const;
+		text_pos to_text_pos(size_t offset) const;
+
 		struct undo_record
 		{
 			text_pos added_beg;
@@ -220,7 +248,7 @@ namespace reshade::imgui
 		void delete_next();
 		void delete_previous();
 		void delete_selection();
-		void delete_lines(size_t first_line, size_t last_line);
+		void erase_text(const text_pos &beg, const text_pos &end);
 
 		void clipboard_copy();
 		void clipboard_cut();
@@ -237,10 +265,10 @@ namespace reshade::imgui
 		void move_lines_up();
 		void move_lines_down();
 
-		void colorize();
+		bool colorize(size_t from, size_t to);
 
-		// Holds the entire text split up into individual character glyphs
-		std::vector<std::vector<glyph>> _lines;
+		// Holds the entire text and the color of each character
+		text_buffer _text;
 
 		bool _readonly = false;
 		bool _overwrite = false;
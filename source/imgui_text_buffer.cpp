@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "imgui_text_buffer.hpp"
+#include <cassert>
+#include <cstring> // std::memset
+
+using namespace reshade::imgui;
+
+void text_buffer::assign(const std::string_view &text)
+{
+	for (std::string &buffer : _buffers)
+		buffer.clear();
+	for (std::vector<size_t> &line_feed_offsets : _line_feed_offsets)
+		line_feed_offsets.clear();
+
+	_pieces.clear();
+	_colors.clear();
+
+	_buffers[0].reserve(text.size());
+	for (const char c : text)
+	{
+		if (c == '\r')
+			continue; // Ignore the carriage return character
+		if (c == '\n')
+			_line_feed_offsets[0].push_back(_buffers[0].size());
+		_buffers[0].push_back(c);
+	}
+
+	if (_buffers[0].empty())
+		return;
+
+	_pieces.insert(0, piece { 0, 0, _buffers[0].size(), _line_feed_offsets[0].size() }, [this](const piece &value, size_t offset) { return split_piece(value, offset); });
+	_colors.insert(0, color_run { 0, _buffers[0].size() }, split_color_run);
+}
+
+void text_buffer::insert(size_t offset, const std::string_view &text)
+{
+	if (text.empty())
+		return;
+
+	assert(offset <= size());
+
+	const size_t start = _buffers[1].size();
+	const size_t length = text.size();
+
+	size_t line_feeds = 0;
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (text[i] == '\n')
+		{
+			_line_feed_offsets[1].push_back(start + i);
+			line_feeds++;
+		}
+	}
+
+	_buffers[1].append(text);
+
+	// Text inserted right after the previous insertion (like when typing) can just extend the piece that references it
+	if (!_pieces.grow(offset, length, line_feeds, [start, length, line_feeds](piece &value) {
+			if (value.buffer != 1 || value.start + value.length != start)
+				return false;
+			value.length += length;
+			value.line_feeds += line_feeds;
+			return true;
+		}))
+		_pieces.insert(offset, piece { 1, start, length, line_feeds }, [this](const piece &value, size_t offset) { return split_piece(value, offset); });
+
+	if (!_colors.grow(offset, length, 0, [length](color_run &value) {
+			if (value.color != 0)
+				return false;
+			value.length += length;
+			return true;
+		}))
+		_colors.insert(offset, color_run { 0, length }, split_color_run);
+}
+
+void text_buffer::erase(size_t offset, size_t length)
+{
+	if (length == 0)
+		return;
+
+	assert(offset + length <= size());
+
+	_pieces.erase(offset, length, [this](const piece &value, size_t offset) { return split_piece(value, offset); });
+	_colors.erase(offset, length, split_color_run);
+}
+
+size_t text_buffer::line_offset(size_t line) const
+{
+	if (line == 0)
+		return 0;
+
+	// The line begins after the line feed that ends the previous line
+	size_t span_offset, span_line_feeds;
+	const piece *const p = _pieces.find_line_feed(line - 1, span_offset, span_line_feeds);
+	if (p == nullptr)
+		return size();
+
+	const std::vector<size_t> &line_feed_offsets = _line_feed_offsets[p->buffer];
+	const size_t line_feed_offset = *(std::lower_bound(line_feed_offsets.begin(), line_feed_offsets.end(), p->start) + (line - 1 - span_line_feeds));
+
+	return span_offset + (line_feed_offset - p->start) + 1;
+}
+
+size_t text_buffer::line_size(size_t line) const
+{
+	const size_t beg = line_offset(line);
+	const size_t end = line + 1 < line_count() ? line_offset(line + 1) - 1 : size();
+	return end - beg;
+}
+
+size_t text_buffer::line_at(size_t offset) const
+{
+	size_t span_offset, span_line_feeds;
+	const piece *const p = _pieces.find_offset(offset, span_offset, span_line_feeds);
+	if (p == nullptr)
+		return line_count() - 1;
+
+	return span_line_feeds + count_line_feeds(p->buffer, p->start, p->start + (offset - span_offset));
+}
+
+char text_buffer::char_at(size_t offset) const
+{
+	size_t span_offset, span_line_feeds;
+	const piece *const p = _pieces.find_offset(offset, span_offset, span_line_feeds);
+	if (p == nullptr)
+		return '\0';
+
+	return _buffers[p->buffer][p->start + (offset - span_offset)];
+}
+
+std::string text_buffer::substr(size_t offset, size_t length) const
+{
+	offset = std::min(offset, size());
+	length = std::min(length, size() - offset);
+
+	std::string result;
+	result.reserve(length);
+
+	_pieces.for_each(offset, length, [this, &result](const piece &value, size_t local_offset, size_t local_length) {
+		result.append(_buffers[value.buffer], value.start + local_offset, local_length);
+	});
+
+	return result;
+}
+
+uint8_t text_buffer::color_at(size_t offset) const
+{
+	size_t span_offset, span_line_feeds;
+	const color_run *const run = _colors.find_offset(offset, span_offset, span_line_feeds);
+	if (run == nullptr)
+		return 0;
+
+	return run->color;
+}
+
+void text_buffer::get_colors(size_t offset, size_t length, uint8_t *colors) const
+{
+	_colors.for_each(offset, length, [&colors](const color_run &value, size_t, size_t local_length) {
+		std::memset(colors, value.color, local_length);
+		colors += local_length;
+	});
+}
+
+void text_buffer::set_colors(size_t offset, size_t length, const uint8_t *colors)
+{
+	if (length == 0)
+		return;
+
+	assert(offset + length <= size());
+
+	// Compress the colors into runs before replacing the existing ones
+	std::vector<color_run> runs;
+	for (size_t i = 0; i < length; ++i)
+	{
+		if (runs.empty() || runs.back().color != colors[i])
+			runs.push_back({ colors[i], 1 });
+		else
+			runs.back().length++;
+	}
+
+	_colors.erase(offset, length, split_color_run);
+	_colors.insert(offset, runs, split_color_run);
+}
+
+size_t text_buffer::count_line_feeds(uint32_t buffer, size_t beg, size_t end) const
+{
+	const std::vector<size_t> &line_feed_offsets = _line_feed_offsets[buffer];
+	return std::lower_bound(line_feed_offsets.begin(), line_feed_offsets.end(), end) - std::lower_bound(line_feed_offsets.begin(), line_feed_offsets.end(), beg);
+}
+
+std::pair<text_buffer::piece, text_buffer::piece> text_buffer::split_piece(const piece &value, size_t offset) const
+{
+	const size_t line_feeds = count_line_feeds(value.buffer, value.start, value.start + offset);
+
+	return { { value.buffer, value.start, offset, line_feeds }, { value.buffer, value.start + offset, value.length - offset, value.line_feeds - line_feeds } };
+}
+
+std::pair<text_buffer::color_run, text_buffer::color_run> text_buffer::split_color_run(const color_run &value, size_t offset)
+{
+	return { { value.color, offset }, { value.color, value.length - offset } };
+}
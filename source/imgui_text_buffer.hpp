@@ -0,0 +1,479 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <algorithm> // std::min
+
+namespace reshade::imgui
+{
+	/// <summary>
+	/// A sequence of spans (like pieces of text or runs of a color), stored in a balanced binary tree (a treap) that is ordered by position.
+	/// Every node keeps track of the total length and number of line feeds in its subtree, so that finding, inserting and removing spans at any offset or line is O(log n).
+	/// </summary>
+	/// <typeparam name="T">Type of a span, which has to have a <c>length</c> and a <c>line_feeds</c> member.</typeparam>
+	template <typename T>
+	class span_tree
+	{
+	public:
+		span_tree() : _nodes(1) {}
+
+		/// <summary>
+		/// Removes all spans.
+		/// </summary>
+		void clear()
+		{
+			_nodes.resize(1);
+			_free_list.clear();
+			_root = 0;
+		}
+
+		/// <summary>
+		/// Gets the total length of all spans.
+		/// </summary>
+		size_t length() const { return _nodes[_root].total_length; }
+		/// <summary>
+		/// Gets the total number of line feeds in all spans.
+		/// </summary>
+		size_t line_feeds() const { return _nodes[_root].total_line_feeds; }
+
+		/// <summary>
+		/// Finds the span that contains the specified <paramref name="offset"/>.
+		/// </summary>
+		/// <param name="offset">Offset to look up.</param>
+		/// <param name="span_offset">Set to the offset at which the returned span begins.</param>
+		/// <param name="span_line_feeds">Set to the number of line feeds before the returned span.</param>
+		/// <returns>A pointer to the span, or <see langword="nullptr"/> if the offset is past the end.</returns>
+		const T *find_offset(size_t offset, size_t &span_offset, size_t &span_line_feeds) const
+		{
+			span_offset = span_line_feeds = 0;
+
+			for (uint32_t x = _root; x != 0;)
+			{
+				const node &n = _nodes[x];
+				const node &l = _nodes[n.left];
+
+				if (offset < l.total_length)
+				{
+					x = n.left;
+					continue;
+				}
+
+				offset -= l.total_length;
+				span_offset += l.total_length;
+				span_line_feeds += l.total_line_feeds;
+
+				if (offset < n.value.length)
+					return &n.value;
+
+				offset -= n.value.length;
+				span_offset += n.value.length;
+				span_line_feeds += n.value.line_feeds;
+				x = n.right;
+			}
+
+			return nullptr;
+		}
+		/// <summary>
+		/// Finds the span that contains the line feed with the specified <paramref name="index"/>.
+		/// </summary>
+		/// <param name="index">Zero-based index of the line feed to look up.</param>
+		/// <param name="span_offset">Set to the offset at which the returned span begins.</param>
+		/// <param name="span_line_feeds">Set to the number of line feeds before the returned span.</param>
+		/// <returns>A pointer to the span, or <see langword="nullptr"/> if there are not that many line feeds.</returns>
+		const T *find_line_feed(size_t index, size_t &span_offset, size_t &span_line_feeds) const
+		{
+			span_offset = span_line_feeds = 0;
+
+			for (uint32_t x = _root; x != 0;)
+			{
+				const node &n = _nodes[x];
+				const node &l = _nodes[n.left];
+
+				if (index < l.total_line_feeds)
+				{
+					x = n.left;
+					continue;
+				}
+
+				index -= l.total_line_feeds;
+				span_offset += l.total_length;
+				span_line_feeds += l.total_line_feeds;
+
+				if (index < n.value.line_feeds)
+					return &n.value;
+
+				index -= n.value.line_feeds;
+				span_offset += n.value.length;
+				span_line_feeds += n.value.line_feeds;
+				x = n.right;
+			}
+
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Calls the specified function for every span that overlaps the range between <paramref name="offset"/> and <paramref name="offset"/> + <paramref name="length"/>, in order.
+		/// </summary>
+		/// <param name="func">Function that is called with a span, the first offset in it that is part of the range and the number of elements in it that are part of the range.</param>
+		template <typename F>
+		void for_each(size_t offset, size_t length, F &&func) const
+		{
+			for_each(_root, offset, offset + length, func);
+		}
+
+		/// <summary>
+		/// Inserts a new span at the specified <paramref name="offset"/>.
+		/// </summary>
+		/// <param name="split_func">Function that splits a span into two at a local offset, in case the offset falls into the middle of an existing span.</param>
+		template <typename S>
+		void insert(size_t offset, const T &value, S &&split_func)
+		{
+			const auto [l, r] = split(_root, offset, split_func);
+			_root = merge(merge(l, create_node(value)), r);
+		}
+		/// <summary>
+		/// Inserts a sequence of new spans at the specified <paramref name="offset"/>.
+		/// </summary>
+		/// <param name="split_func">Function that splits a span into two at a local offset, in case the offset falls into the middle of an existing span.</param>
+		template <typename S>
+		void insert(size_t offset, const std::vector<T> &values, S &&split_func)
+		{
+			const auto [l, r] = split(_root, offset, split_func);
+			_root = merge(merge(l, build(values)), r);
+		}
+		/// <summary>
+		/// Removes the range between <paramref name="offset"/> and <paramref name="offset"/> + <paramref name="length"/>, splitting spans at the boundaries as necessary.
+		/// </summary>
+		/// <param name="split_func">Function that splits a span into two at a local offset, in case a boundary falls into the middle of an existing span.</param>
+		template <typename S>
+		void erase(size_t offset, size_t length, S &&split_func)
+		{
+			const auto [l, mr] = split(_root, offset, split_func);
+			const auto [m, r] = split(mr, length, split_func);
+			destroy(m);
+			_root = merge(l, r);
+		}
+
+		/// <summary>
+		/// Grows the span that ends exactly at the specified <paramref name="offset"/> in place, instead of inserting a new one.
+		/// This avoids creating a new span for every character when text is typed in one character at a time.
+		/// </summary>
+		/// <param name="length">Length that is added to the span.</param>
+		/// <param name="line_feeds">Number of line feeds that are added to the span.</param>
+		/// <param name="grow_func">Function that grows the span that ends at the offset and returns <see langword="true"/>, or returns <see langword="false"/> if it cannot be grown.</param>
+		/// <returns><see langword="true"/> if a span was grown, <see langword="false"/> if a new span has to be inserted instead.</returns>
+		template <typename G>
+		bool grow(size_t offset, size_t length, size_t line_feeds, G &&grow_func)
+		{
+			return offset != 0 && grow(_root, offset, length, line_feeds, grow_func);
+		}
+
+	private:
+		struct node
+		{
+			T value = {};
+			uint32_t left = 0, right = 0;
+			uint32_t priority = 0;
+			size_t total_length = 0;
+			size_t total_line_feeds = 0;
+		};
+
+		uint32_t create_node(const T &value)
+		{
+			uint32_t x;
+			if (!_free_list.empty())
+			{
+				x = _free_list.back();
+				_free_list.pop_back();
+			}
+			else
+			{
+				x = static_cast<uint32_t>(_nodes.size());
+				_nodes.emplace_back();
+			}
+
+			// Simple xorshift random number generator for the node priorities, which keep the tree balanced
+			_seed ^= _seed << 13;
+			_seed ^= _seed >> 17;
+			_seed ^= _seed << 5;
+
+			node &n = _nodes[x];
+			n.value = value;
+			n.left = n.right = 0;
+			n.priority = _seed;
+			n.total_length = value.length;
+			n.total_line_feeds = value.line_feeds;
+			return x;
+		}
+		void destroy(uint32_t x)
+		{
+			if (x == 0)
+				return;
+			destroy(_nodes[x].left);
+			destroy(_nodes[x].right);
+			_free_list.push_back(x);
+		}
+
+		void update(uint32_t x)
+		{
+			node &n = _nodes[x];
+			n.total_length = _nodes[n.left].total_length + n.value.length + _nodes[n.right].total_length;
+			n.total_line_feeds = _nodes[n.left].total_line_feeds + n.value.line_feeds + _nodes[n.right].total_line_feeds;
+		}
+
+		uint32_t merge(uint32_t l, uint32_t r)
+		{
+			if (l == 0 || r == 0)
+				return l != 0 ? l : r;
+
+			if (_nodes[l].priority > _nodes[r].priority)
+			{
+				const uint32_t right = merge(_nodes[l].right, r);
+				_nodes[l].right = right;
+				update(l);
+				return l;
+			}
+			else
+			{
+				const uint32_t left = merge(l, _nodes[r].left);
+				_nodes[r].left = left;
+				update(r);
+				return r;
+			}
+		}
+		template <typename S>
+		std::pair<uint32_t, uint32_t> split(uint32_t x, size_t offset, S &split_func)
+		{
+			if (x == 0)
+				return { 0, 0 };
+
+			const size_t left_length = _nodes[_nodes[x].left].total_length;
+
+			if (offset <= left_length)
+			{
+				const auto [l, r] = split(_nodes[x].left, offset, split_func);
+				_nodes[x].left = r;
+				update(x);
+				return { l, x };
+			}
+
+			offset -= left_length;
+
+			if (offset >= _nodes[x].value.length)
+			{
+				const auto [l, r] = split(_nodes[x].right, offset - _nodes[x].value.length, split_func);
+				_nodes[x].right = l;
+				update(x);
+				return { x, r };
+			}
+
+			// The offset falls into the middle of this span, so split it into two
+			const auto [first, second] = split_func(_nodes[x].value, offset);
+			_nodes[x].value = first;
+			const uint32_t right = _nodes[x].right;
+			_nodes[x].right = 0;
+			update(x);
+			const uint32_t second_node = create_node(second);
+			return { x, merge(second_node, right) };
+		}
+
+		uint32_t build(const std::vector<T> &values)
+		{
+			if (values.empty())
+				return 0;
+
+			// Build a treap from an ordered sequence in linear time by keeping track of its right spine (see https://en.wikipedia.org/wiki/Cartesian_tree)
+			std::vector<uint32_t> spine;
+			for (const T &value : values)
+			{
+				const uint32_t x = create_node(value);
+
+				uint32_t last = 0;
+				while (!spine.empty() && _nodes[spine.back()].priority < _nodes[x].priority)
+				{
+					last = spine.back();
+					spine.pop_back();
+				}
+
+				_nodes[x].left = last;
+				if (!spine.empty())
+					_nodes[spine.back()].right = x;
+
+				spine.push_back(x);
+			}
+
+			update_all(spine.front());
+			return spine.front();
+		}
+		void update_all(uint32_t x)
+		{
+			if (x == 0)
+				return;
+			update_all(_nodes[x].left);
+			update_all(_nodes[x].right);
+			update(x);
+		}
+
+		template <typename G>
+		bool grow(uint32_t x, size_t offset, size_t length, size_t line_feeds, G &grow_func)
+		{
+			if (x == 0)
+				return false;
+
+			node &n = _nodes[x];
+			const size_t left_length = _nodes[n.left].total_length;
+
+			if (offset <= left_length)
+			{
+				if (!grow(n.left, offset, length, line_feeds, grow_func))
+					return false;
+			}
+			else if (offset - left_length == n.value.length)
+			{
+				if (!grow_func(n.value))
+					return false;
+			}
+			else if (offset - left_length > n.value.length)
+			{
+				if (!grow(n.right, offset - left_length - n.value.length, length, line_feeds, grow_func))
+					return false;
+			}
+			else
+			{
+				return false; // The offset falls into the middle of this span
+			}
+
+			n.total_length += length;
+			n.total_line_feeds += line_feeds;
+			return true;
+		}
+
+		template <typename F>
+		void for_each(uint32_t x, size_t beg, size_t end, F &func) const
+		{
+			if (x == 0 || beg >= end)
+				return;
+
+			const node &n = _nodes[x];
+			const size_t left_length = _nodes[n.left].total_length;
+
+			if (beg < left_length)
+				for_each(n.left, beg, std::min(end, left_length), func);
+
+			const size_t value_beg = left_length, value_end = left_length + n.value.length;
+			if (beg < value_end && end > value_beg)
+			{
+				const size_t local_beg = beg > value_beg ? beg - value_beg : 0;
+				func(n.value, local_beg, std::min(end, value_end) - value_beg - local_beg);
+			}
+
+			if (end > value_end)
+				for_each(n.right, beg > value_end ? beg - value_end : 0, end - value_end, func);
+		}
+
+		// Index zero is a sentinel node with no length, which is used in place of a null pointer
+		std::vector<node> _nodes;
+		std::vector<uint32_t> _free_list;
+		uint32_t _root = 0;
+		uint32_t _seed = 0x9E3779B9;
+	};
+
+	/// <summary>
+	/// Text storage for the code editor, based on a piece table: The original text and all text inserted later are kept in two buffers that are never modified other than appending to the second.
+	/// The text is then described by a sequence of pieces referencing parts of those buffers, so that inserting or removing text only needs to change a few pieces, instead of moving the text after it.
+	/// Each character is also assigned a color, which are kept separately as a sequence of runs of the same color.
+	/// </summary>
+	class text_buffer
+	{
+	public:
+		/// <summary>
+		/// Replaces the entire text with the specified string. Any carriage return characters are removed.
+		/// </summary>
+		void assign(const std::string_view &text);
+
+		/// <summary>
+		/// Inserts the specified <paramref name="text"/> at an offset. The inserted text has color zero.
+		/// </summary>
+		void insert(size_t offset, const std::string_view &text);
+		/// <summary>
+		/// Removes the text between <paramref name="offset"/> and <paramref name="offset"/> + <paramref name="length"/>.
+		/// </summary>
+		void erase(size_t offset, size_t length);
+
+		/// <summary>
+		/// Gets the total number of characters in the text, including line feeds.
+		/// </summary>
+		size_t size() const { return _pieces.length(); }
+		/// <summary>
+		/// Gets the number of lines in the text, which is always at least one.
+		/// </summary>
+		size_t line_count() const { return _pieces.line_feeds() + 1; }
+		/// <summary>
+		/// Gets the offset of the first character in the specified <paramref name="line"/>, or the total size of the text if the line does not exist.
+		/// </summary>
+		size_t line_offset(size_t line) const;
+		/// <summary>
+		/// Gets the number of characters in the specified <paramref name="line"/>, not including the line feed at its end.
+		/// </summary>
+		size_t line_size(size_t line) const;
+		/// <summary>
+		/// Gets the line that contains the character at the specified <paramref name="offset"/>.
+		/// </summary>
+		size_t line_at(size_t offset) const;
+
+		/// <summary>
+		/// Gets the character at the specified <paramref name="offset"/>.
+		/// </summary>
+		char char_at(size_t offset) const;
+		/// <summary>
+		/// Gets the text between <paramref name="offset"/> and <paramref name="offset"/> + <paramref name="length"/>.
+		/// </summary>
+		std::string substr(size_t offset, size_t length) const;
+
+		/// <summary>
+		/// Gets the color of the character at the specified <paramref name="offset"/>.
+		/// </summary>
+		uint8_t color_at(size_t offset) const;
+		/// <summary>
+		/// Gets the colors of all characters between <paramref name="offset"/> and <paramref name="offset"/> + <paramref name="length"/>.
+		/// </summary>
+		void get_colors(size_t offset, size_t length, uint8_t *colors) const;
+		/// <summary>
+		/// Changes the colors of all characters between <paramref name="offset"/> and <paramref name="offset"/> + <paramref name="length"/>.
+		/// </summary>
+		void set_colors(size_t offset, size_t length, const uint8_t *colors);
+
+	private:
+		struct piece
+		{
+			uint32_t buffer;
+			size_t start;
+			size_t length;
+			size_t line_feeds;
+		};
+		struct color_run
+		{
+			uint8_t color;
+			size_t length;
+			static constexpr size_t line_feeds = 0;
+		};
+
+		size_t count_line_feeds(uint32_t buffer, size_t beg, size_t end) const;
+		std::pair<piece, piece> split_piece(const piece &value, size_t offset) const;
+		static std::pair<color_run, color_run> split_color_run(const color_run &value, size_t offset);
+
+		// The original text is in the first buffer, any text added afterwards is appended to the second one
+		std::string _buffers[2];
+		// Offsets of all line feed characters in each buffer, to be able to look up lines without scanning the text
+		std::vector<size_t> _line_feed_offsets[2];
+		span_tree<piece> _pieces;
+		span_tree<color_run> _colors;
+	};
+}
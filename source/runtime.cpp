@@ -10,6 +10,7 @@
 #include "addon_manager.hpp"
 #include "runtime.hpp"
 #include "runtime_objects.hpp"
+#include "runtime_shader_compiler.hpp"
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
@@ -19,12 +20,11 @@
 #include "process_utils.hpp"
 #include <set>
 #include <thread>
+#include <unordered_set>
 #include <cstring>
 #include <fstream>
 #include <algorithm>
 #include <fpng.h>
-#include <stb_image.h>
-#include <stb_image_dds.h>
 #include <stb_image_write.h>
 #include <stb_image_resize.h>
 #include <malloc.h>
@@ -222,7 +222,11 @@ reshade::runtime::runtime(api::device *device, api::command_queue *graphics_queu
 }
 reshade::runtime::~runtime()
 {
-	assert(_worker_threads.empty());
+#if RESHADE_FX
+	// Writing the effect cache to disk runs in the background and is not waited on during reloads and resets, so finish it now
+	_worker_tasks.wait(_effect_cache_tasks);
+#endif
+	assert(_worker_tasks.is_idle());
 #if RESHADE_FX
 	assert(!_is_initialized && _techniques.empty());
 #endif
@@ -523,10 +527,7 @@ void reshade::runtime::on_reset()
 	_device->destroy_resource_view(_effect_stencil_dsv);
 	_effect_stencil_dsv = {};
 #else
-	for (std::thread &thread : _worker_threads)
-		if (thread.joinable())
-			thread.join();
-	_worker_threads.clear();
+	_worker_tasks.wait_idle();
 #endif
 
 	_device->destroy_pipeline(_copy_pipeline);
@@ -620,6 +621,11 @@ void reshade::runtime::on_present()
 	const auto current_time = std::chrono::high_resolution_clock::now();
 	_last_frame_duration = current_time - _last_present_time; _last_present_time = current_time;
 
+#if RESHADE_FX
+	_last_uniform_data_uploaded = _uniform_data_uploaded;
+	_uniform_data_uploaded = 0;
+#endif
+
 #ifdef NDEBUG
 	// Lock input so it cannot be modified by other threads while we are reading it here
 	const std::shared_lock<std::shared_mutex> input_lock = (_input != nullptr) ?
@@ -968,13 +974,91 @@ void reshade::runtime::load_current_preset()
 	// Recompile effects if preprocessor definitions have changed or running in performance mode (in which case all preset values are compile-time constants)
 	if (_reload_remaining_effects != 0) // ... unless this is the 'load_current_preset' call in 'update_effects'
 	{
-		if (_performance_mode || preset_preprocessor_definitions != _preset_preprocessor_definitions)
+		if (_performance_mode || (preset_preprocessor_definitions != _preset_preprocessor_definitions && _reload_remaining_effects != std::numeric_limits<size_t>::max())) // Start over if effects are still being loaded
 		{
 			_preset_preprocessor_definitions = std::move(preset_preprocessor_definitions);
 			reload_effects();
 			return; // Preset values are loaded in 'update_effects' during effect loading
 		}
 
+		if (preset_preprocessor_definitions != _preset_preprocessor_definitions)
+		{
+			const auto effective_definitions = [this](const std::vector<std::string> &preset_definitions) {
+				std::unordered_map<std::string_view, std::string_view> definitions;
+				const auto add_definitions = [&definitions](const std::vector<std::string> &list) {
+					for (const std::string_view definition : list)
+					{
+						if (definition.empty() || definition == "=")
+							continue; // Skip invalid definitions
+
+						// Only the first definition of a macro is used, see 'add_macro_definition'
+						const size_t equals_index = definition.find('=');
+						definitions.emplace(definition.substr(0, equals_index), equals_index != std::string_view::npos ? definition.substr(equals_index + 1) : std::string_view("1"));
+					}
+				};
+				add_definitions(preset_definitions);
+				add_definitions(_global_preprocessor_definitions);
+				return definitions;
+			};
+
+			const auto old_definitions = effective_definitions(_preset_preprocessor_definitions);
+			const auto new_definitions = effective_definitions(preset_preprocessor_definitions);
+
+			std::vector<std::string_view> changed_macros;
+			for (const auto &[name, value] : old_definitions)
+				if (const auto it = new_definitions.find(name); it == new_definitions.end() || it->second != value)
+					changed_macros.push_back(name);
+			for (const auto &[name, value] : new_definitions)
+				if (old_definitions.find(name) == old_definitions.end())
+					changed_macros.push_back(name);
+
+			// Only reload effects that reference any of the changed macros, since all others would compile to the same result
+			std::vector<size_t> effects_to_reload;
+			size_t num_loaded_effects = 0;
+			for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
+			{
+				const effect &effect = _effects[effect_index];
+				if (effect.skipped)
+					continue;
+
+				num_loaded_effects++;
+
+				if (effect.referenced_macros.empty() || std::find_if(changed_macros.begin(), changed_macros.end(),
+						[&effect](const std::string_view &name) { return std::binary_search(effect.referenced_macros.begin(), effect.referenced_macros.end(), name); }) != changed_macros.end())
+					effects_to_reload.push_back(effect_index);
+			}
+
+			_preset_preprocessor_definitions = std::move(preset_preprocessor_definitions);
+
+			if (!effects_to_reload.empty() && effects_to_reload.size() == num_loaded_effects)
+			{
+				reload_effects(); // Load all effects in parallel if they have to be reloaded anyway
+				return;
+			}
+			if (!effects_to_reload.empty())
+			{
+				// Reload effects even if none of their techniques are in the new preset (the check below reloads everything if any skipped effects are needed)
+				_load_option_disable_skipping = true;
+
+#if RESHADE_GUI
+				_show_splash = false; // Hide splash bar when only some effects are reloaded
+#endif
+				// Destroy the affected effects on the render thread, then compile them again in parallel like 'load_effects' does
+				for (const size_t effect_index : effects_to_reload)
+					destroy_effect(effect_index);
+
+				_reload_remaining_effects = effects_to_reload.size();
+
+				for (const size_t effect_index : effects_to_reload)
+					_worker_tasks.submit([this, source_file = _effects[effect_index].source_file, effect_index, &preset]() {
+						// Abort loading when initialization state changes (indicating that 'on_reset' was called in the meantime)
+						if (_is_initialized)
+							load_effect(source_file, preset, effect_index);
+					});
+				return; // Preset values are loaded in 'update_effects' after the effects were reloaded
+			}
+		}
+
 		if (std::find_if(technique_list.begin(), technique_list.end(), [this](const std::string_view &technique_name) {
 				if (const size_t at_pos = technique_name.find('@'); at_pos == std::string::npos)
 					return true;
@@ -1267,6 +1351,316 @@ bool reshade::runtime::switch_to_next_preset(std::filesystem::path filter_path,
 	return true;
 }
 
+class reshade::runtime::effect_shader_compiler final : public shader_compiler
+{
+public:
+	effect_shader_compiler(runtime &runtime, const effect &effect, const std::string &pragma_warnings, bool skip_optimization) :
+		_runtime(runtime), _effect(effect), _pragma_warnings(pragma_warnings), _skip_optimization(skip_optimization) {}
+
+	bool compile(const reshadefx::module &module, const reshadefx::entry_point &entry_point, std::string &cso, std::string &cso_text, std::string &errors) override
+	{
+		if (entry_point.type == reshadefx::shader_type::cs && !_runtime._device->check_capability(api::device_caps::compute_shader))
+		{
+			errors += "error: " + entry_point.name + ": compute shaders are not supported in D3D9/D3D10\n";
+			return false;
+		}
+
+		if ((_runtime._renderer_id & 0xF0000) == 0)
+		{
+			assert(_runtime._d3d_compiler_module != nullptr);
+
+			std::string texture_pixel_sizes;
+			if (_runtime._renderer_id == 0x9000)
+			{
+				texture_pixel_sizes = "#define COLOR_PIXEL_SIZE 1.0 / " + std::to_string(_runtime._width) + ", 1.0 / " + std::to_string(_runtime._height) + '\n';
+
+				uint32_t semantic_index = 0;
+				for (const reshadefx::texture_info &tex : module.textures)
+				{
+					if (tex.semantic.empty() || tex.semantic == "COLOR")
+						continue;
+
+					semantic_index++;
+					assert((_effect.uniform_data_storage.size() / 16) < (255 - semantic_index));
+
+					texture_pixel_sizes += "uniform float2 " + tex.semantic + "_PIXEL_SIZE : register(c" + std::to_string(255 - semantic_index) + ");\n";
+				}
+			}
+
+			// Add specialization constant defines to source code
+			// Only compile the code this entry point actually uses, if the code generator provided it, rather than the whole module
+			const std::string hlsl =
+				_pragma_warnings +
+				texture_pixel_sizes +
+				"#line 1\n" + // Reset line number, so it matches what is shown when viewing the generated code
+				reshadefx::get_entry_point_hlsl(module, entry_point);
+
+			// Overwrite position semantic in pixel shaders
+			const D3D_SHADER_MACRO ps_defines[] = {
+				{ "POSITION", "VPOS" }, { nullptr, nullptr }
+			};
+
+			std::string profile;
+			switch (entry_point.type)
+			{
+			case reshadefx::shader_type::vs:
+				profile = "vs";
+				break;
+			case reshadefx::shader_type::ps:
+				profile = "ps";
+				break;
+			case reshadefx::shader_type::cs:
+				profile = "cs";
+				break;
+			}
+
+			switch (_runtime._renderer_id)
+			{
+			default:
+			case D3D_FEATURE_LEVEL_11_0:
+				profile += "_5_0";
+				break;
+			case D3D_FEATURE_LEVEL_10_1:
+				profile += "_4_1";
+				break;
+			case D3D_FEATURE_LEVEL_10_0:
+				profile += "_4_0";
+				break;
+			case D3D_FEATURE_LEVEL_9_1:
+			case D3D_FEATURE_LEVEL_9_2:
+				profile += "_4_0_level_9_1";
+				break;
+			case D3D_FEATURE_LEVEL_9_3:
+				profile += "_4_0_level_9_3";
+				break;
+			case 0x9000:
+				profile += "_3_0";
+				break;
+			}
+
+			UINT compile_flags = 0;
+			if (_skip_optimization)
+				compile_flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
+			else if (_runtime._performance_mode)
+				compile_flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
+			if (_runtime._renderer_id >= D3D_FEATURE_LEVEL_10_0)
+				compile_flags |= D3DCOMPILE_ENABLE_STRICTNESS;
+#ifndef NDEBUG
+			compile_flags |= D3DCOMPILE_DEBUG;
+#endif
+
+			std::string hlsl_attributes;
+			hlsl_attributes += "entrypoint=" + entry_point.name + ';';
+			hlsl_attributes += "profile=" + profile + ';';
+			hlsl_attributes += "flags=" + std::to_string(compile_flags) + ';';
+
+			// Unused declarations were replaced with empty lines to keep line numbers intact, but those should not change the cache key when only the line count of some unused code changed
+			std::string hlsl_key = hlsl;
+			hlsl_key.erase(std::unique(hlsl_key.begin(), hlsl_key.end(), [](char lhs, char rhs) { return lhs == '\n' && rhs == '\n'; }), hlsl_key.end());
+
+			const std::string cache_id =
+				_effect.source_file.stem().u8string() + '-' + entry_point.name + '-' + std::to_string(_runtime._renderer_id) + '-' +
+				std::to_string(effect_cache::hash(hlsl_attributes) ^ effect_cache::hash(hlsl_key));
+
+			if (!_runtime.load_effect_cache(cache_id, "cso", cso))
+			{
+				const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(static_cast<HMODULE>(_runtime._d3d_compiler_module), "D3DCompile"));
+				assert(D3DCompile != nullptr);
+
+				com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
+				const HRESULT hr = D3DCompile(
+					hlsl.data(), hlsl.size(),
+					nullptr, entry_point.type == reshadefx::shader_type::ps ? ps_defines : nullptr, nullptr,
+					entry_point.name.c_str(),
+					profile.c_str(),
+					compile_flags, 0,
+					&d3d_compiled, &d3d_errors);
+
+				std::string d3d_errors_string;
+				if (d3d_errors != nullptr) // Append warnings to the output error string as well
+					d3d_errors_string.assign(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
+
+				// De-duplicate error lines (D3DCompiler sometimes repeats the same error multiple times)
+				for (size_t line_offset = 0, next_line_offset; (next_line_offset = d3d_errors_string.find('\n', line_offset)) != std::string::npos; line_offset = next_line_offset + 1)
+				{
+					const std::string_view cur_line(d3d_errors_string.c_str() + line_offset, next_line_offset - line_offset);
+
+					if (const size_t end_offset = d3d_errors_string.find('\n', next_line_offset + 1);
+						end_offset != std::string::npos)
+					{
+						const std::string_view next_line(d3d_errors_string.c_str() + next_line_offset + 1, end_offset - next_line_offset - 1);
+						if (cur_line == next_line)
+						{
+							d3d_errors_string.erase(next_line_offset, end_offset - next_line_offset);
+							next_line_offset = line_offset - 1;
+						}
+					}
+
+					// Also remove D3DCompiler warnings about 'groupshared' specifier used in VS/PS modules
+					if (cur_line.find("X3579") != std::string_view::npos)
+					{
+						d3d_errors_string.erase(line_offset, next_line_offset + 1 - line_offset);
+						next_line_offset = line_offset - 1;
+					}
+				}
+
+				if (FAILED(hr))
+				{
+					// Add a prefix with the offending entry point name for generic error messages like an out of memory notification
+					if (d3d_errors_string.find("error") == std::string::npos)
+						errors += "error: " + entry_point.name + ": ";
+
+					errors += d3d_errors_string;
+					return false;
+				}
+				else
+				{
+					// Append warnings
+					errors += d3d_errors_string;
+				}
+
+				cso.resize(d3d_compiled->GetBufferSize());
+				std::memcpy(cso.data(), d3d_compiled->GetBufferPointer(), cso.size());
+
+				_runtime.save_effect_cache(cache_id, "cso", cso);
+			}
+
+			if (!_runtime.load_effect_cache(cache_id, "asm", cso_text))
+			{
+				const auto D3DDisassemble = reinterpret_cast<pD3DDisassemble>(GetProcAddress(static_cast<HMODULE>(_runtime._d3d_compiler_module), "D3DDisassemble"));
+				assert(D3DDisassemble != nullptr);
+
+				if (com_ptr<ID3DBlob> d3d_disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &d3d_disassembled)))
+					cso_text.assign(static_cast<const char *>(d3d_disassembled->GetBufferPointer()), d3d_disassembled->GetBufferSize() - 1);
+
+				_runtime.save_effect_cache(cache_id, "asm", cso_text);
+			}
+		}
+		else if (module.spirv.empty())
+		{
+			cso = "#version 430\n#define ENTRY_POINT_" + entry_point.name + " 1\n";
+
+			if (entry_point.type != reshadefx::shader_type::ps)
+			{
+				// OpenGL does not allow using 'discard' in the vertex shader profile
+				cso += "#define discard\n";
+				// 'dFdx', 'dFdx' and 'fwidth' too are only available in fragment shaders
+				cso += "#define dFdx(x) x\n";
+				cso += "#define dFdy(y) y\n";
+				cso += "#define fwidth(p) p\n";
+			}
+			if (entry_point.type != reshadefx::shader_type::cs)
+			{
+				// OpenGL does not allow using 'shared' in vertex/fragment shader profile
+				cso += "#define shared\n";
+				cso += "#define atomicAdd(a, b) a\n";
+				cso += "#define atomicAnd(a, b) a\n";
+				cso += "#define atomicOr(a, b) a\n";
+				cso += "#define atomicXor(a, b) a\n";
+				cso += "#define atomicMin(a, b) a\n";
+				cso += "#define atomicMax(a, b) a\n";
+				cso += "#define atomicExchange(a, b) a\n";
+				cso += "#define atomicCompSwap(a, b, c) a\n";
+				// Barrier intrinsics are only available in compute shaders
+				cso += "#define barrier()\n";
+				cso += "#define memoryBarrier()\n";
+				cso += "#define groupMemoryBarrier()\n";
+			}
+
+			cso += "#line 1 0\n"; // Reset line number, so it matches what is shown when viewing the generated code
+			cso += module.hlsl;
+
+			cso_text = cso;
+		}
+		else
+		{
+			assert(_runtime._renderer_id >= 0x14600); // Core since OpenGL 4.6 (see https://www.khronos.org/opengl/wiki/SPIR-V)
+
+			// There are various issues with SPIR-V modules that have multiple entry points on all major GPU vendors.
+			// On AMD for instance creating a graphics pipeline just fails with a generic 'VK_ERROR_OUT_OF_HOST_MEMORY'. On NVIDIA artifacts occur on some driver versions.
+			// To work around these problems, create a separate shader module for every entry point and rewrite the SPIR-V module for each to remove all but a single entry point (and associated functions/variables).
+			uint32_t current_function = 0, current_function_offset = 0;
+			std::vector<uint32_t> spirv = module.spirv; // Copy SPIR-V, so that all but the current entry point are only removed from that copy
+			std::vector<uint32_t> functions_to_remove, variables_to_remove;
+
+			for (uint32_t inst = 5 /* Skip SPIR-V header information */; inst < spirv.size();)
+			{
+				const uint32_t op = spirv[inst] & 0xFFFF;
+				const uint32_t len = (spirv[inst] >> 16) & 0xFFFF;
+				assert(len != 0);
+
+				switch (op)
+				{
+				case 15 /* OpEntryPoint */:
+					// Look for any non-matching entry points
+					if (entry_point.name != reinterpret_cast<const char *>(&spirv[inst + 3]))
+					{
+						functions_to_remove.push_back(spirv[inst + 2]);
+
+						// Get interface variables
+						for (uint32_t k = inst + 3 + static_cast<uint32_t>((std::strlen(reinterpret_cast<const char *>(&spirv[inst + 3])) + 4) / 4); k < inst + len; ++k)
+							variables_to_remove.push_back(spirv[k]);
+
+						// Remove this entry point from the module
+						spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+						continue;
+					}
+					break;
+				case 16 /* OpExecutionMode */:
+					if (std::find(functions_to_remove.begin(), functions_to_remove.end(), spirv[inst + 1]) != functions_to_remove.end())
+					{
+						spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+						continue;
+					}
+					break;
+				case 59 /* OpVariable */:
+					// Remove all declarations of the interface variables for non-matching entry points
+					if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 2]) != variables_to_remove.end())
+					{
+						spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+						continue;
+					}
+					break;
+				case 71 /* OpDecorate */:
+					// Remove all decorations targeting any of the interface variables for non-matching entry points
+					if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 1]) != variables_to_remove.end())
+					{
+						spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
+						continue;
+					}
+					break;
+				case 54 /* OpFunction */:
+					current_function = spirv[inst + 2];
+					current_function_offset = inst;
+					break;
+				case 56 /* OpFunctionEnd */:
+					// Remove all function definitions for non-matching entry points
+					if (std::find(functions_to_remove.begin(), functions_to_remove.end(), current_function) != functions_to_remove.end())
+					{
+						spirv.erase(spirv.begin() + current_function_offset, spirv.begin() + inst + len);
+						inst = current_function_offset;
+						continue;
+					}
+					break;
+				}
+
+				inst += len;
+			}
+
+			cso.resize(spirv.size() * sizeof(uint32_t));
+			std::memcpy(cso.data(), spirv.data(), cso.size());
+		}
+
+		return true;
+	}
+
+private:
+	runtime &_runtime;
+	const effect &_effect;
+	const std::string &_pragma_warnings;
+	const bool _skip_optimization;
+};
+
 bool reshade::runtime::load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, bool preprocess_required)
 {
 	const std::chrono::high_resolution_clock::time_point time_load_started = std::chrono::high_resolution_clock::now();
@@ -1306,6 +1700,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		}
 	}
 
+	// Identify the effect and the headers it may include by the hash of their contents instead of their modification time, so that touching a file without changing it (or restoring an earlier version of it) does not invalidate the cache
 	for (const std::filesystem::path &include_path : include_paths)
 	{
 		attributes += include_path.u8string();
@@ -1317,7 +1712,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				attributes += ',';
 				attributes += filename.u8string();
 				attributes += '?';
-				attributes += std::to_string(entry.last_write_time(ec).time_since_epoch().count());
+				attributes += std::to_string(effect_cache::hash_file(entry.path()));
 			}
 		}
 		attributes += ';';
@@ -1326,10 +1721,57 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	std::vector<std::string> preprocessor_definitions = _global_preprocessor_definitions;
 	// Insert preset preprocessor definitions before global ones, so that if there are duplicates, the preset ones are used (since 'add_macro_definition' succeeds only for the first occurance)
 	preprocessor_definitions.insert(preprocessor_definitions.begin(), _preset_preprocessor_definitions.begin(), _preset_preprocessor_definitions.end());
-	for (const std::string &definition : preprocessor_definitions)
-		attributes += definition + ';';
 
-	const size_t source_hash = std::hash<std::string>()(attributes);
+	// The preprocessed source only depends on the definitions of macros the effect references, so only those are part of its hash
+	// This way changing an unrelated definition (or switching to a preset that only differs in those) does not cause the effect to be compiled again
+	// The list of referenced macros is stored in the cache under a key that does not include any definitions, since it is only known after preprocessing
+	const std::string cache_id_prefix = source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-';
+	const std::string macros_cache_id = cache_id_prefix + std::to_string(effect_cache::hash(attributes));
+
+	const auto compute_source_hash = [&attributes, &preprocessor_definitions](const std::vector<std::string> *referenced_macros) {
+		std::string key = attributes;
+		if (referenced_macros != nullptr)
+		{
+			// Include the list itself, so that cache entries are only reused if they were created with the same list, which guarantees that all definitions they depend on match
+			for (const std::string &name : *referenced_macros)
+				key += name + ',';
+			key += ';';
+		}
+
+		std::unordered_set<std::string_view> defined_names;
+		for (const std::string &definition : preprocessor_definitions)
+		{
+			if (referenced_macros == nullptr)
+			{
+				key += definition + ';';
+				continue;
+			}
+
+			if (definition.empty() || definition == "=")
+				continue; // Skip invalid definitions
+
+			// Only the first definition of a macro is used, see 'add_macro_definition'
+			const std::string_view name = std::string_view(definition).substr(0, definition.find('='));
+			if (!defined_names.insert(name).second)
+				continue;
+
+			if (std::binary_search(referenced_macros->begin(), referenced_macros->end(), name))
+				key += definition + ';';
+		}
+
+		return effect_cache::hash(key);
+	};
+
+	std::string referenced_macros_data;
+	std::vector<std::string> referenced_macros;
+	const bool referenced_macros_cached = load_effect_cache(macros_cache_id, "macros", referenced_macros_data);
+	if (referenced_macros_cached)
+	{
+		for (size_t offset = 0, next; (next = referenced_macros_data.find('\n', offset)) != std::string::npos; offset = next + 1)
+			referenced_macros.push_back(referenced_macros_data.substr(offset, next - offset));
+	}
+
+	uint64_t source_hash = compute_source_hash(referenced_macros_cached ? &referenced_macros : nullptr);
 
 	effect &effect = _effects[effect_index];
 	const std::string effect_name = source_file.filename().u8string();
@@ -1341,7 +1783,7 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 		effect.source_hash = source_hash;
 	}
 
-	if (_effect_load_skipping && !_load_option_disable_skipping && !_worker_threads.empty()) // Only skip during 'load_effects'
+	if (_effect_load_skipping && !_load_option_disable_skipping && _reload_remaining_effects != std::numeric_limits<size_t>::max()) // Only skip during 'load_effects'
 	{
 		if (std::vector<std::string> techniques;
 			preset.get({}, "Techniques", techniques))
@@ -1362,10 +1804,32 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 	bool skip_optimization = false;
 	std::string pragma_warnings;
 
-	bool source_cached = false; std::string source;
-	if (!effect.preprocessed && (preprocess_required || (source_cached = load_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source)) == false))
+	// Compiling the preprocessed source only depends on the debug information setting in addition to what is already part of the source hash
+	const auto get_module_cache_id = [&]() {
+		return cache_id_prefix + std::to_string(source_hash) + (_no_debug_info ? "" : "-debug");
+	};
+
+	// Skip preprocessing and compiling altogether if the module compiled from the same source is still in the cache
+	bool module_cached = false;
+	if (!effect.preprocessed && !effect.compiled && !preprocess_required)
+	{
+		if (std::string module_data;
+			load_effect_cache(get_module_cache_id(), "module", module_data) && reshadefx::deserialize_module(effect.module, module_data))
+		{
+			module_cached = true;
+
+			// Restore any warnings that were reported when the module was compiled
+			if (std::string log; load_effect_cache(get_module_cache_id(), "log", log))
+				effect.errors += log;
+		}
+	}
+
+	bool source_cached = module_cached; std::string source;
+	if (!effect.preprocessed && !module_cached && (preprocess_required || (source_cached = load_effect_cache(cache_id_prefix + std::to_string(source_hash), "i", source)) == false))
 	{
 		reshadefx::preprocessor pp;
+		// Share lexed include files between all effects, so that common headers are only lexed once per reload instead of once per effect
+		pp.set_include_cache(&_effect_include_cache);
 		pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
 		pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", _performance_mode ? "1" : "0");
 		pp.add_macro_definition("__VENDOR__", std::to_string(_vendor_id));
@@ -1437,9 +1901,20 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				}
 			}
 
+			// Now that it is known which macros the effect references, update the hash to only include the definitions of those
+			effect.referenced_macros = referenced_macros = pp.referenced_macros();
+
+			std::string new_referenced_macros_data;
+			for (const std::string &name : referenced_macros)
+				new_referenced_macros_data += name + '\n';
+			if (new_referenced_macros_data != referenced_macros_data)
+				save_effect_cache(macros_cache_id, "macros", new_referenced_macros_data);
+
+			effect.source_hash = source_hash = compute_source_hash(&referenced_macros);
+
 			// Do not cache if any pragma commands were used, to ensure they are read again next time
 			if (pp.used_pragmas().empty())
-				source_cached = save_effect_cache(source_file.stem().u8string() + '-' + std::to_string(_renderer_id) + '-' + std::to_string(source_hash), "i", source);
+				source_cached = save_effect_cache(cache_id_prefix + std::to_string(source_hash), "i", source);
 
 			// Keep track of used preprocessor definitions (so they can be displayed in the overlay)
 			effect.definitions.clear();
@@ -1458,39 +1933,61 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 			std::sort(effect.included_files.begin(), effect.included_files.end()); // Sort file names alphabetically
 		}
 	}
+	else if (source_cached)
+	{
+		// The source was created with the macros from the cache, so keep track of those (so that changing other definitions later does not reload this effect)
+		effect.referenced_macros = std::move(referenced_macros);
+	}
 
-	if (!effect.compiled && !source.empty())
+	if (!effect.compiled && (module_cached || !source.empty()))
 	{
-		unsigned shader_model;
-		if (_renderer_id == 0x9000)
-			shader_model = 30; // D3D9
-		else if (_renderer_id < 0xa100)
-			shader_model = 40; // D3D10 (including feature level 9)
-		else if (_renderer_id < 0xb000)
-			shader_model = 41; // D3D10.1
-		else if (_renderer_id < 0xc000)
-			shader_model = 50; // D3D11
+		if (module_cached)
+		{
+			effect.compiled = true;
+		}
 		else
-			shader_model = 51; // D3D12
+		{
+			unsigned shader_model;
+			if (_renderer_id == 0x9000)
+				shader_model = 30; // D3D9
+			else if (_renderer_id < 0xa100)
+				shader_model = 40; // D3D10 (including feature level 9)
+			else if (_renderer_id < 0xb000)
+				shader_model = 41; // D3D10.1
+			else if (_renderer_id < 0xc000)
+				shader_model = 50; // D3D11
+			else
+				shader_model = 51; // D3D12
 
-		std::unique_ptr<reshadefx::codegen> codegen;
-		if ((_renderer_id & 0xF0000) == 0)
-			codegen.reset(reshadefx::create_codegen_hlsl(shader_model, !_no_debug_info, _performance_mode));
-		else if (_renderer_id < 0x20000)
-			codegen.reset(reshadefx::create_codegen_glsl(false, !_no_debug_info, _performance_mode, false, true));
-		else // Vulkan uses SPIR-V input
-			codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, _performance_mode, false, false));
+			std::unique_ptr<reshadefx::codegen> codegen;
+			if ((_renderer_id & 0xF0000) == 0)
+				codegen.reset(reshadefx::create_codegen_hlsl(shader_model, !_no_debug_info, _performance_mode));
+			else if (_renderer_id < 0x20000)
+				codegen.reset(reshadefx::create_codegen_glsl(false, !_no_debug_info, _performance_mode, false, true));
+			else // Vulkan uses SPIR-V input
+				codegen.reset(reshadefx::create_codegen_spirv(true, !_no_debug_info, _performance_mode, false, false));
+
+			reshadefx::parser parser;
 
-		reshadefx::parser parser;
+			// Compile the pre-processed source code (try the compile even if the preprocessor step failed to get additional error information)
+			effect.compiled = parser.parse(std::move(source), codegen.get());
 
-		// Compile the pre-processed source code (try the compile even if the preprocessor step failed to get additional error information)
-		effect.compiled = parser.parse(std::move(source), codegen.get());
+			// Append parser errors to the error list
+			effect.errors  += parser.errors();
 
-		// Append parser errors to the error list
-		effect.errors  += parser.errors();
+			// Write result to effect module
+			codegen->write_result(effect.module);
 
-		// Write result to effect module
-		codegen->write_result(effect.module);
+			// Store the module before it is modified below (with values from the current preset), so that the next load of the same source can skip compiling it
+			// This is only done if the preprocessed source was cacheable as well, since otherwise it may depend on pragma commands that are not part of the cache key
+			if (effect.compiled && source_cached)
+			{
+				std::string module_data;
+				reshadefx::serialize_module(effect.module, module_data);
+				save_effect_cache(get_module_cache_id(), "module", std::move(module_data));
+				save_effect_cache(get_module_cache_id(), "log", effect.errors);
+			}
+		}
 
 		if (effect.compiled)
 		{
@@ -1506,41 +2003,8 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				// Copy initial data into uniform storage area
 				reset_uniform_value(variable);
 
-				const std::string_view special = variable.annotation_as_string("source");
-				if (special.empty()) /* Ignore if annotation is missing */
-					variable.special = special_uniform::none;
-				else if (special == "frametime")
-					variable.special = special_uniform::frame_time;
-				else if (special == "framecount")
-					variable.special = special_uniform::frame_count;
-				else if (special == "random")
-					variable.special = special_uniform::random;
-				else if (special == "pingpong")
-					variable.special = special_uniform::ping_pong;
-				else if (special == "date")
-					variable.special = special_uniform::date;
-				else if (special == "timer")
-					variable.special = special_uniform::timer;
-				else if (special == "key")
-					variable.special = special_uniform::key;
-				else if (special == "mousepoint")
-					variable.special = special_uniform::mouse_point;
-				else if (special == "mousedelta")
-					variable.special = special_uniform::mouse_delta;
-				else if (special == "mousebutton")
-					variable.special = special_uniform::mouse_button;
-				else if (special == "mousewheel")
-					variable.special = special_uniform::mouse_wheel;
-				else if (special == "ui_open" || special == "overlay_open")
-					variable.special = special_uniform::overlay_open;
-				else if (special == "ui_active" || special == "overlay_active")
-					variable.special = special_uniform::overlay_active;
-				else if (special == "ui_hovered" || special == "overlay_hovered")
-					variable.special = special_uniform::overlay_hovered;
-				else if (special == "screenshot")
-					variable.special = special_uniform::screenshot;
-				else
-					variable.special = special_uniform::unknown;
+				// Figure out whether this is a special uniform that is updated every frame and parse the annotations controlling that once here
+				variable.parse_special_annotations();
 
 				effect.uniforms.push_back(std::move(variable));
 			}
@@ -1601,312 +2065,44 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 				}
 
 				effect.module.hlsl = preamble + effect.module.hlsl;
+
+				// Move the code ranges of entry points behind the preamble, which they all need
+				const uint32_t preamble_size = static_cast<uint32_t>(preamble.size());
+				for (reshadefx::entry_point &entry_point : effect.module.entry_points)
+				{
+					if (entry_point.hlsl_ranges.empty())
+						continue;
+
+					for (std::pair<uint32_t, uint32_t> &range : entry_point.hlsl_ranges)
+						range.first += preamble_size,
+						range.second += preamble_size;
+					entry_point.hlsl_ranges.insert(entry_point.hlsl_ranges.begin(), { 0, preamble_size });
+				}
 			}
 		}
 	}
 
 	if ( effect.compiled && (effect.preprocessed || source_cached))
 	{
-		// Compile shader modules
-		for (const reshadefx::entry_point &entry_point : effect.module.entry_points)
+		// Start decoding the image files referenced by textures already, so that this happens in parallel to shader compilation (and 'load_textures' later only has to pick up the results)
+		for (const reshadefx::texture_info &info : effect.module.textures)
 		{
-			if (entry_point.type == reshadefx::shader_type::cs && !_device->check_capability(api::device_caps::compute_shader))
-			{
-				effect.errors += "error: " + entry_point.name + ": compute shaders are not supported in D3D9/D3D10\n";
-				effect.compiled = false;
-				break;
-			}
-
-			auto &assembly = effect.assembly[entry_point.name];
-			std::string &cso = assembly.first;
-			std::string &cso_text = assembly.second;
-
-			if ((_renderer_id & 0xF0000) == 0)
-			{
-				assert(_d3d_compiler_module != nullptr);
-
-				std::string texture_pixel_sizes;
-				if (_renderer_id == 0x9000)
-				{
-					texture_pixel_sizes = "#define COLOR_PIXEL_SIZE 1.0 / " + std::to_string(_width) + ", 1.0 / " + std::to_string(_height) + '\n';
-
-					uint32_t semantic_index = 0;
-					for (const reshadefx::texture_info &tex : effect.module.textures)
-					{
-						if (tex.semantic.empty() || tex.semantic == "COLOR")
-							continue;
-
-						semantic_index++;
-						assert((effect.uniform_data_storage.size() / 16) < (255 - semantic_index));
-
-						texture_pixel_sizes += "uniform float2 " + tex.semantic + "_PIXEL_SIZE : register(c" + std::to_string(255 - semantic_index) + ");\n";
-					}
-				}
-
-				// Add specialization constant defines to source code
-				const std::string hlsl =
-					pragma_warnings +
-					texture_pixel_sizes +
-					"#line 1\n" + // Reset line number, so it matches what is shown when viewing the generated code
-					effect.module.hlsl;
-
-				// Overwrite position semantic in pixel shaders
-				const D3D_SHADER_MACRO ps_defines[] = {
-					{ "POSITION", "VPOS" }, { nullptr, nullptr }
-				};
-
-				std::string profile;
-				switch (entry_point.type)
-				{
-				case reshadefx::shader_type::vs:
-					profile = "vs";
-					break;
-				case reshadefx::shader_type::ps:
-					profile = "ps";
-					break;
-				case reshadefx::shader_type::cs:
-					profile = "cs";
-					break;
-				}
-
-				switch (_renderer_id)
-				{
-				default:
-				case D3D_FEATURE_LEVEL_11_0:
-					profile += "_5_0";
-					break;
-				case D3D_FEATURE_LEVEL_10_1:
-					profile += "_4_1";
-					break;
-				case D3D_FEATURE_LEVEL_10_0:
-					profile += "_4_0";
-					break;
-				case D3D_FEATURE_LEVEL_9_1:
-				case D3D_FEATURE_LEVEL_9_2:
-					profile += "_4_0_level_9_1";
-					break;
-				case D3D_FEATURE_LEVEL_9_3:
-					profile += "_4_0_level_9_3";
-					break;
-				case 0x9000:
-					profile += "_3_0";
-					break;
-				}
-
-				UINT compile_flags = 0;
-				if (skip_optimization)
-					compile_flags |= D3DCOMPILE_SKIP_OPTIMIZATION;
-				else if (_performance_mode)
-					compile_flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
-				if (_renderer_id >= D3D_FEATURE_LEVEL_10_0)
-					compile_flags |= D3DCOMPILE_ENABLE_STRICTNESS;
-#ifndef NDEBUG
-				compile_flags |= D3DCOMPILE_DEBUG;
-#endif
-
-				std::string hlsl_attributes;
-				hlsl_attributes += "entrypoint=" + entry_point.name + ';';
-				hlsl_attributes += "profile=" + profile + ';';
-				hlsl_attributes += "flags=" + std::to_string(compile_flags) + ';';
-
-				const std::string cache_id =
-					effect.source_file.stem().u8string() + '-' + entry_point.name + '-' + std::to_string(_renderer_id) + '-' +
-					std::to_string(std::hash<std::string_view>()(hlsl_attributes) ^ std::hash<std::string_view>()(hlsl));
-
-				if (!load_effect_cache(cache_id, "cso", cso))
-				{
-					const auto D3DCompile = reinterpret_cast<pD3DCompile>(GetProcAddress(static_cast<HMODULE>(_d3d_compiler_module), "D3DCompile"));
-					assert(D3DCompile != nullptr);
-
-					com_ptr<ID3DBlob> d3d_compiled, d3d_errors;
-					const HRESULT hr = D3DCompile(
-						hlsl.data(), hlsl.size(),
-						nullptr, entry_point.type == reshadefx::shader_type::ps ? ps_defines : nullptr, nullptr,
-						entry_point.name.c_str(),
-						profile.c_str(),
-						compile_flags, 0,
-						&d3d_compiled, &d3d_errors);
-
-					std::string d3d_errors_string;
-					if (d3d_errors != nullptr) // Append warnings to the output error string as well
-						d3d_errors_string.assign(static_cast<const char *>(d3d_errors->GetBufferPointer()), d3d_errors->GetBufferSize() - 1); // Subtracting one to not append the null-terminator as well
-
-					// De-duplicate error lines (D3DCompiler sometimes repeats the same error multiple times)
-					for (size_t line_offset = 0, next_line_offset; (next_line_offset = d3d_errors_string.find('\n', line_offset)) != std::string::npos; line_offset = next_line_offset + 1)
-					{
-						const std::string_view cur_line(d3d_errors_string.c_str() + line_offset, next_line_offset - line_offset);
-
-						if (const size_t end_offset = d3d_errors_string.find('\n', next_line_offset + 1);
-							end_offset != std::string::npos)
-						{
-							const std::string_view next_line(d3d_errors_string.c_str() + next_line_offset + 1, end_offset - next_line_offset - 1);
-							if (cur_line == next_line)
-							{
-								d3d_errors_string.erase(next_line_offset, end_offset - next_line_offset);
-								next_line_offset = line_offset - 1;
-							}
-						}
-
-						// Also remove D3DCompiler warnings about 'groupshared' specifier used in VS/PS modules
-						if (cur_line.find("X3579") != std::string_view::npos)
-						{
-							d3d_errors_string.erase(line_offset, next_line_offset + 1 - line_offset);
-							next_line_offset = line_offset - 1;
-						}
-					}
-
-					if (FAILED(hr))
-					{
-						// Add a prefix with the offending entry point name for generic error messages like an out of memory notification
-						if (d3d_errors_string.find("error") == std::string::npos)
-							effect.errors += "error: " + entry_point.name + ": ";
-
-						effect.errors += d3d_errors_string;
-						effect.compiled = false;
-
-						d3d_errors.reset();
-						d3d_compiled.reset();
-						break;
-					}
-					else
-					{
-						// Append warnings
-						effect.errors += d3d_errors_string;
-					}
-
-					cso.resize(d3d_compiled->GetBufferSize());
-					std::memcpy(cso.data(), d3d_compiled->GetBufferPointer(), cso.size());
-
-					save_effect_cache(cache_id, "cso", cso);
-				}
-
-				if (!load_effect_cache(cache_id, "asm", cso_text))
-				{
-					const auto D3DDisassemble = reinterpret_cast<pD3DDisassemble>(GetProcAddress(static_cast<HMODULE>(_d3d_compiler_module), "D3DDisassemble"));
-					assert(D3DDisassemble != nullptr);
-
-					if (com_ptr<ID3DBlob> d3d_disassembled; SUCCEEDED(D3DDisassemble(cso.data(), cso.size(), 0, nullptr, &d3d_disassembled)))
-						cso_text.assign(static_cast<const char *>(d3d_disassembled->GetBufferPointer()), d3d_disassembled->GetBufferSize() - 1);
-
-					save_effect_cache(cache_id, "asm", cso_text);
-				}
-			}
-			else if (effect.module.spirv.empty())
-			{
-				cso = "#version 430\n#define ENTRY_POINT_" + entry_point.name + " 1\n";
-
-				if (entry_point.type != reshadefx::shader_type::ps)
-				{
-					// OpenGL does not allow using 'discard' in the vertex shader profile
-					cso += "#define discard\n";
-					// 'dFdx', 'dFdx' and 'fwidth' too are only available in fragment shaders
-					cso += "#define dFdx(x) x\n";
-					cso += "#define dFdy(y) y\n";
-					cso += "#define fwidth(p) p\n";
-				}
-				if (entry_point.type != reshadefx::shader_type::cs)
-				{
-					// OpenGL does not allow using 'shared' in vertex/fragment shader profile
-					cso += "#define shared\n";
-					cso += "#define atomicAdd(a, b) a\n";
-					cso += "#define atomicAnd(a, b) a\n";
-					cso += "#define atomicOr(a, b) a\n";
-					cso += "#define atomicXor(a, b) a\n";
-					cso += "#define atomicMin(a, b) a\n";
-					cso += "#define atomicMax(a, b) a\n";
-					cso += "#define atomicExchange(a, b) a\n";
-					cso += "#define atomicCompSwap(a, b, c) a\n";
-					// Barrier intrinsics are only available in compute shaders
-					cso += "#define barrier()\n";
-					cso += "#define memoryBarrier()\n";
-					cso += "#define groupMemoryBarrier()\n";
-				}
-
-				cso += "#line 1 0\n"; // Reset line number, so it matches what is shown when viewing the generated code
-				cso += effect.module.hlsl;
-
-				cso_text = cso;
-			}
-			else
-			{
-				assert(_renderer_id >= 0x14600); // Core since OpenGL 4.6 (see https://www.khronos.org/opengl/wiki/SPIR-V)
-
-				// There are various issues with SPIR-V modules that have multiple entry points on all major GPU vendors.
-				// On AMD for instance creating a graphics pipeline just fails with a generic 'VK_ERROR_OUT_OF_HOST_MEMORY'. On NVIDIA artifacts occur on some driver versions.
-				// To work around these problems, create a separate shader module for every entry point and rewrite the SPIR-V module for each to remove all but a single entry point (and associated functions/variables).
-				uint32_t current_function = 0, current_function_offset = 0;
-				std::vector<uint32_t> spirv = effect.module.spirv; // Copy SPIR-V, so that all but the current entry point are only removed from that copy
-				std::vector<uint32_t> functions_to_remove, variables_to_remove;
-
-				for (uint32_t inst = 5 /* Skip SPIR-V header information */; inst < spirv.size();)
-				{
-					const uint32_t op = spirv[inst] & 0xFFFF;
-					const uint32_t len = (spirv[inst] >> 16) & 0xFFFF;
-					assert(len != 0);
-
-					switch (op)
-					{
-					case 15 /* OpEntryPoint */:
-						// Look for any non-matching entry points
-						if (entry_point.name != reinterpret_cast<const char *>(&spirv[inst + 3]))
-						{
-							functions_to_remove.push_back(spirv[inst + 2]);
-
-							// Get interface variables
-							for (uint32_t k = inst + 3 + static_cast<uint32_t>((std::strlen(reinterpret_cast<const char *>(&spirv[inst + 3])) + 4) / 4); k < inst + len; ++k)
-								variables_to_remove.push_back(spirv[k]);
-
-							// Remove this entry point from the module
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 16 /* OpExecutionMode */:
-						if (std::find(functions_to_remove.begin(), functions_to_remove.end(), spirv[inst + 1]) != functions_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 59 /* OpVariable */:
-						// Remove all declarations of the interface variables for non-matching entry points
-						if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 2]) != variables_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 71 /* OpDecorate */:
-						// Remove all decorations targeting any of the interface variables for non-matching entry points
-						if (std::find(variables_to_remove.begin(), variables_to_remove.end(), spirv[inst + 1]) != variables_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + inst, spirv.begin() + inst + len);
-							continue;
-						}
-						break;
-					case 54 /* OpFunction */:
-						current_function = spirv[inst + 2];
-						current_function_offset = inst;
-						break;
-					case 56 /* OpFunctionEnd */:
-						// Remove all function definitions for non-matching entry points
-						if (std::find(functions_to_remove.begin(), functions_to_remove.end(), current_function) != functions_to_remove.end())
-						{
-							spirv.erase(spirv.begin() + current_function_offset, spirv.begin() + inst + len);
-							inst = current_function_offset;
-							continue;
-						}
-						break;
-					}
-
-					inst += len;
-				}
+			const auto source = std::find_if(info.annotations.begin(), info.annotations.end(),
+				[](const reshadefx::annotation &annotation) { return annotation.name == "source"; });
+			if (!info.semantic.empty() || source == info.annotations.end() || source->value.string_data.empty())
+				continue;
 
-				cso.resize(spirv.size() * sizeof(uint32_t));
-				std::memcpy(cso.data(), spirv.data(), cso.size());
-			}
+			_worker_tasks.submit(_texture_tasks, [this, source_path = std::filesystem::u8path(source->value.string_data)]() mutable {
+				if (find_file(_texture_search_paths, source_path))
+					_texture_cache.load(source_path);
+			});
 		}
 
+		// Compile shader modules for all entry points in parallel, so that a single large effect does not keep only one thread busy
+		effect_shader_compiler compiler(*this, effect, pragma_warnings, skip_optimization);
+		if (!compile_entry_points(_worker_tasks, compiler, effect.module, effect.assembly, effect.errors))
+			effect.compiled = false;
+
 		const std::unique_lock<std::shared_mutex> lock(_reload_mutex);
 
 		for (texture new_texture : effect.module.textures)
@@ -2031,6 +2227,8 @@ bool reshade::runtime::load_effect(const std::filesystem::path &source_file, con
 
 	const std::chrono::high_resolution_clock::time_point time_load_finished = std::chrono::high_resolution_clock::now();
 
+	effect.load_duration = time_load_finished - time_load_started;
+
 	if (_reload_remaining_effects != 0 && _reload_remaining_effects != std::numeric_limits<size_t>::max())
 		_reload_remaining_effects--;
 	else
@@ -2182,6 +2380,9 @@ bool reshade::runtime::create_effect(size_t effect_index)
 
 		_device->set_resource_name(effect.cb, "ReShade constant buffer");
 
+		// Upload all uniform data before it is used the first time
+		effect.mark_uniform_data_dirty(0, effect.uniform_data_storage.size());
+
 		if (!_device->allocate_descriptor_set(effect.layout, 0, &effect.cb_set))
 		{
 			effect.compiled = false;
@@ -2982,26 +3183,42 @@ void reshade::runtime::load_effects()
 		}
 	}
 
+	// Open the packed cache file, so that all effects can look up their intermediate results in it
+	if (!_no_effect_cache)
+		_effect_cache.open(g_reshade_base_path / _intermediate_cache_path / L"ReShade.cache");
+
+	// Drop decoded images that were not used by any effect since the last reload, so that the texture cache does not keep growing
+	_texture_cache.evict_unused();
+
 	// Allocate space for effects which are placed in this array during the 'load_effect' call
 	const size_t offset = _effects.size();
 	_effects.resize(offset + effect_files.size());
 	_reload_remaining_effects = effect_files.size();
+	_reload_start_time = std::chrono::high_resolution_clock::now();
 
 	// Now that we have a list of files, load them in parallel
-	// Split workload into batches instead of launching a thread for every file to avoid launch overhead and stutters due to too many threads being in flight
-	const size_t num_splits = std::min<size_t>(effect_files.size(), std::max<size_t>(std::thread::hardware_concurrency(), 2u) - 1);
-
-	// Keep track of the spawned threads, so the runtime cannot be destroyed while they are still running
-	for (size_t n = 0; n < num_splits; ++n)
-		_worker_threads.emplace_back([this, effect_files, offset, num_splits, n, &preset]() {
+	// Every file is a separate task, so that workers which are done with their files can pick up the remaining ones, instead of waiting on a single slow effect
+	// The scheduler keeps track of the submitted tasks, so the runtime cannot be destroyed while they are still running
+	for (size_t i = 0; i < effect_files.size(); ++i)
+		_worker_tasks.submit([this, source_file = effect_files[i], effect_index = offset + i, &preset]() {
 			// Abort loading when initialization state changes (indicating that 'on_reset' was called in the meantime)
-			for (size_t i = 0; i < effect_files.size() && _is_initialized; ++i)
-				if (i * num_splits / effect_files.size() == n)
-					load_effect(effect_files[i], preset, offset + i);
+			if (_is_initialized)
+				load_effect(source_file, preset, effect_index);
 		});
 }
 void reshade::runtime::load_textures()
 {
+	struct texture_source
+	{
+		texture *tex = nullptr;
+		std::filesystem::path path;
+		std::shared_ptr<const decoded_image> image;
+		std::vector<uint8_t> data;
+		uint32_t levels = 0;
+	};
+
+	std::vector<texture_source> sources;
+
 	for (texture &tex : _textures)
 	{
 		if (tex.resource == 0 || !tex.semantic.empty())
@@ -3022,45 +3239,62 @@ void reshade::runtime::load_textures()
 			continue;
 		}
 
-		std::error_code ec;
-		const uintmax_t file_size = std::filesystem::file_size(source_path, ec);
-		if (ec)
-		{
-			if (_effects[tex.effect_index].errors.find(source_path.u8string()) == std::string::npos)
-				_effects[tex.effect_index].errors += "warning: " + tex.unique_name + ": source \"" + source_path.u8string() + "\" could not be loaded.\n";
+		// Mipmaps are generated on the GPU after upload wherever the texture supports it, so only compute them on the CPU if it does not
+		const bool generate_mipmaps_on_cpu = tex.levels > 1 && (_device->get_resource_desc(tex.resource).flags & api::resource_flags::generate_mipmaps) == 0;
 
-			LOG(ERROR) << "Failed to load " << source_path << " for texture '" << tex.unique_name << "' with error code " << ec.value() << '!';
-			continue;
-		}
+		sources.push_back({ &tex, std::move(source_path), nullptr, {}, generate_mipmaps_on_cpu ? tex.levels : 1 });
+	}
+
+	// Decoding, resizing and generating mipmaps is independent for every texture, so do it in parallel
+	// Most images were already decoded in the background while effects were compiling, in which case this just picks them up from the texture cache
+	for (texture_source &source : sources)
+	{
+		_worker_tasks.submit(_texture_tasks, [this, &source]() {
+			source.image = _texture_cache.load(source.path);
+			if (source.image == nullptr)
+				return;
 
-		stbi_uc *pixels = nullptr;
-		int width = 0, height = 0, channels = 0;
+			const texture &tex = *source.tex;
 
-		if (auto file = std::ifstream(source_path, std::ios::binary))
-		{
-			// Read texture data into memory in one go since that is faster than reading chunk by chunk
-			std::vector<stbi_uc> file_data(static_cast<size_t>(file_size));
-			file.read(reinterpret_cast<char *>(file_data.data()), file_data.size());
-			file.close();
+			std::vector<uint8_t> resized;
+			const uint8_t *pixels = source.image->pixels.data();
+			// Need to potentially resize image data to the texture dimensions
+			if (tex.width != source.image->width || tex.height != source.image->height)
+			{
+				resized.resize(static_cast<size_t>(tex.width) * static_cast<size_t>(tex.height) * 4);
+				stbir_resize_uint8(pixels, source.image->width, source.image->height, 0, resized.data(), tex.width, tex.height, 0, 4);
+				pixels = resized.data();
+			}
 
-			if (stbi_dds_test_memory(file_data.data(), static_cast<int>(file_data.size())))
-				pixels = stbi_dds_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
-			else
-				pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
-		}
+			source.data.resize(mipmap_chain_size(tex.width, tex.height, source.levels));
+			generate_mipmap_chain(pixels, tex.width, tex.height, source.levels, source.data.data());
+		});
+	}
+
+	// Wait for all the above tasks (and any decoding that is still in progress from 'load_effect'), with the render thread helping to execute them
+	_worker_tasks.wait(_texture_tasks);
 
-		if (pixels == nullptr)
+	for (texture_source &source : sources)
+	{
+		texture &tex = *source.tex;
+
+		if (source.image == nullptr)
 		{
-			if (_effects[tex.effect_index].errors.find(source_path.u8string()) == std::string::npos)
-				_effects[tex.effect_index].errors += "warning: " + tex.unique_name + ": source \"" + source_path.u8string() + "\" could not be loaded.\n";
+			if (_effects[tex.effect_index].errors.find(source.path.u8string()) == std::string::npos)
+				_effects[tex.effect_index].errors += "warning: " + tex.unique_name + ": source \"" + source.path.u8string() + "\" could not be loaded.\n";
 
-			LOG(ERROR) << "Failed to load " << source_path << " for texture '" << tex.unique_name << "'! Make sure it is of a compatible file format.";
+			LOG(ERROR) << "Failed to load " << source.path << " for texture '" << tex.unique_name << "'! Make sure it exists and is of a compatible file format.";
 			continue;
 		}
 
-		update_texture(tex, width, height, pixels);
+		if (tex.width != source.image->width || tex.height != source.image->height)
+			LOG(INFO) << "Resizing image data for texture '" << tex.unique_name << "' from " << source.image->width << "x" << source.image->height << " to " << tex.width << "x" << tex.height << '.';
 
-		stbi_image_free(pixels);
+		upload_texture(tex, source.data.data(), source.levels);
+
+		// Release the pixel data right after the upload, the texture cache keeps its own reference to the decoded image as long as it fits
+		source.image.reset();
+		source.data = {};
 
 		tex.loaded = true;
 	}
@@ -3092,11 +3326,8 @@ void reshade::runtime::reload_effects()
 }
 void reshade::runtime::destroy_effects()
 {
-	// Make sure no threads are still accessing effect data
-	for (std::thread &thread : _worker_threads)
-		if (thread.joinable())
-			thread.join();
-	_worker_threads.clear();
+	// Make sure no tasks are still accessing effect data
+	_worker_tasks.wait_idle();
 
 	for (size_t effect_index = 0; effect_index < _effects.size(); ++effect_index)
 		destroy_effect(effect_index);
@@ -3128,42 +3359,23 @@ bool reshade::runtime::load_effect_cache(const std::string &id, const std::strin
 	if (_no_effect_cache)
 		return false;
 
-	std::filesystem::path path = g_reshade_base_path / _intermediate_cache_path;
-	path /= std::filesystem::u8path("reshade-" + id + '.' + type);
-
-	std::ifstream file(path, std::ios::binary);
-	if (!file)
-		return false;
-
-	std::error_code ec;
-	const uintmax_t file_size = std::filesystem::file_size(path, ec);
-	if (ec)
-		return false;
-
-	data.resize(static_cast<size_t>(file_size), '\0');
-	file.read(data.data(), data.size());
-	return !file.fail();
+	return _effect_cache.load("reshade-" + id + '.' + type, data);
 }
-bool reshade::runtime::save_effect_cache(const std::string &id, const std::string &type, const std::string &data) const
+bool reshade::runtime::save_effect_cache(const std::string &id, const std::string &type, const std::string &data)
 {
 	if (_no_effect_cache)
 		return false;
 
-	std::filesystem::path path = g_reshade_base_path / _intermediate_cache_path;
-	path /= std::filesystem::u8path("reshade-" + id + '.' + type);
-
-	std::ofstream file(path, std::ios::binary | std::ios::trunc);
-	if (!file)
-		return false;
-
-	file.write(data.data(), data.size());
-	return !file.fail();
+	return _effect_cache.save("reshade-" + id + '.' + type, data);
 }
 void reshade::runtime::clear_effect_cache()
 {
+	_effect_cache.clear();
+	_effect_include_cache.clear();
+
 	std::error_code ec;
 
-	// Find all cached effect files and delete them
+	// Find all loose cache files written by older versions and delete them too
 	for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(g_reshade_base_path / _intermediate_cache_path, std::filesystem::directory_options::skip_permission_denied, ec))
 	{
 		if (entry.is_directory(ec))
@@ -3269,11 +3481,19 @@ void reshade::runtime::update_effects()
 
 	if (_reload_remaining_effects == 0)
 	{
-		// Clear the thread list now that they all have finished
-		for (std::thread &thread : _worker_threads)
-			if (thread.joinable())
-				thread.join(); // Threads have exited, but still need to join them prior to destruction
-		_worker_threads.clear();
+		// Report timing of the entire reload (but not when only a single effect was reloaded)
+		if (const auto slowest_effect = std::max_element(_effects.begin(), _effects.end(),
+				[](const effect &lhs, const effect &rhs) { return lhs.load_duration < rhs.load_duration; });
+			slowest_effect != _effects.end() && _reload_start_time != std::chrono::high_resolution_clock::time_point())
+		{
+			LOG(INFO) << "Finished loading " << _effects.size() << " effects in " << (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - _reload_start_time).count() * 1e-3f) << " s using " << _worker_tasks.num_threads() << " worker threads (slowest was " << slowest_effect->source_file.filename() << " with " << (std::chrono::duration_cast<std::chrono::milliseconds>(slowest_effect->load_duration).count() * 1e-3f) << " s).";
+		}
+
+		_reload_start_time = std::chrono::high_resolution_clock::time_point();
+
+		// Write all new intermediate results to disk in one go, on a worker thread, since rewriting the cache file can take a while
+		// This is a background task, so that resets and reloads do not have to wait for it to finish
+		_worker_tasks.submit(_effect_cache_tasks, [this]() { _effect_cache.flush(); });
 
 		// Finished loading effects, so apply preset to figure out which ones need compiling
 		load_current_preset();
@@ -3437,19 +3657,19 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 				}
 				case special_uniform::random:
 				{
-					const int min = variable.annotation_as_int("min", 0, 0);
-					const int max = variable.annotation_as_int("max", 0, RAND_MAX);
+					const int min = variable.special_params.min_int;
+					const int max = variable.special_params.max_int;
 					set_uniform_value(variable, min + (std::rand() % (std::abs(max - min) + 1)));
 					break;
 				}
 				case special_uniform::ping_pong:
 				{
-					const float min = variable.annotation_as_float("min", 0, 0.0f);
-					const float max = variable.annotation_as_float("max", 0, 1.0f);
-					const float step_min = variable.annotation_as_float("step", 0);
-					const float step_max = variable.annotation_as_float("step", 1);
+					const float min = variable.special_params.min;
+					const float max = variable.special_params.max;
+					const float step_min = variable.special_params.step[0];
+					const float step_max = variable.special_params.step[1];
 					float increment = step_max == 0 ? step_min : (step_min + std::fmodf(static_cast<float>(std::rand()), step_max - step_min + 1));
-					const float smoothing = variable.annotation_as_float("smoothing");
+					const float smoothing = variable.special_params.smoothing;
 
 					float value[2] = { 0, 0 };
 					get_uniform_value(variable, value, 2);
@@ -3497,18 +3717,18 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 					if (_input == nullptr)
 						break;
 
-					if (const int keycode = variable.annotation_as_int("keycode");
+					if (const int keycode = variable.special_params.keycode;
 						keycode > 7 && keycode < 256)
 					{
-						if (const std::string_view mode = variable.annotation_as_string("mode");
-							mode == "toggle" || variable.annotation_as_int("toggle"))
+						if (const special_uniform_params::key_mode mode = variable.special_params.mode;
+							mode == special_uniform_params::key_mode::toggle)
 						{
 							bool current_value = false;
 							get_uniform_value(variable, &current_value);
 							if (_input->is_key_pressed(keycode))
 								set_uniform_value(variable, !current_value);
 						}
-						else if (mode == "press")
+						else if (mode == special_uniform_params::key_mode::press)
 							set_uniform_value(variable, _input->is_key_pressed(keycode));
 						else
 							set_uniform_value(variable, _input->is_key_down(keycode));
@@ -3536,18 +3756,18 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 					if (_input == nullptr)
 						break;
 
-					if (const int keycode = variable.annotation_as_int("keycode");
+					if (const int keycode = variable.special_params.keycode;
 						keycode >= 0 && keycode < 5)
 					{
-						if (const std::string_view mode = variable.annotation_as_string("mode");
-							mode == "toggle" || variable.annotation_as_int("toggle"))
+						if (const special_uniform_params::key_mode mode = variable.special_params.mode;
+							mode == special_uniform_params::key_mode::toggle)
 						{
 							bool current_value = false;
 							get_uniform_value(variable, &current_value);
 							if (_input->is_mouse_button_pressed(keycode))
 								set_uniform_value(variable, !current_value);
 						}
-						else if (mode == "press")
+						else if (mode == special_uniform_params::key_mode::press)
 							set_uniform_value(variable, _input->is_mouse_button_pressed(keycode));
 						else
 							set_uniform_value(variable, _input->is_mouse_button_down(keycode));
@@ -3559,11 +3779,9 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 					if (_input == nullptr)
 						break;
 
-					const float min = variable.annotation_as_float("min");
-					const float max = variable.annotation_as_float("max");
-					float step = variable.annotation_as_float("step");
-					if (step == 0.0f)
-						step  = 1.0f;
+					const float min = variable.special_params.min;
+					const float max = variable.special_params.max;
+					const float step = variable.special_params.step[0];
 
 					float value[2] = { 0, 0 };
 					get_uniform_value(variable, value, 2);
@@ -3647,7 +3865,7 @@ void reshade::runtime::render_effects(api::command_list *cmd_list, api::resource
 }
 void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_list, api::resource back_buffer_resource, api::resource_view back_buffer_rtv, api::resource_view back_buffer_rtv_srgb)
 {
-	const effect &effect = _effects[tech.effect_index];
+	effect &effect = _effects[tech.effect_index];
 
 #if RESHADE_GUI
 	if (_gather_gpu_statistics && effect.query_pool != 0)
@@ -3668,16 +3886,36 @@ void reshade::runtime::render_technique(technique &tech, api::command_list *cmd_
 	cmd_list->begin_debug_event(tech.name.c_str(), debug_event_col);
 #endif
 
-	// Update shader constants
-	if (void *mapped_uniform_data;
-		effect.cb != 0 && _device->map_buffer_region(effect.cb, 0, std::numeric_limits<uint64_t>::max(), api::map_access::write_discard, &mapped_uniform_data))
+	// Update shader constants (the constant buffer keeps its contents, so only need to do this when any of them changed, which also means techniques of the same effect share a single upload)
+	if (effect.cb != 0)
 	{
-		std::memcpy(mapped_uniform_data, effect.uniform_data_storage.data(), effect.uniform_data_storage.size());
-		_device->unmap_buffer_region(effect.cb);
+		if (effect.uniform_data_dirty_beg < effect.uniform_data_dirty_end)
+		{
+			// Buffers in D3D12 and Vulkan are backed by a single allocation, so can just overwrite the part that changed, whereas other APIs need to discard and write the entire buffer
+			const bool partial_update = _device->get_api() == api::device_api::d3d12 || _device->get_api() == api::device_api::vulkan;
+
+			const size_t offset = partial_update ? effect.uniform_data_dirty_beg : 0;
+			const size_t size = partial_update ? effect.uniform_data_dirty_end - offset : effect.uniform_data_storage.size();
+
+			if (void *mapped_uniform_data;
+				_device->map_buffer_region(effect.cb, offset, size, partial_update ? api::map_access::write_only : api::map_access::write_discard, &mapped_uniform_data))
+			{
+				std::memcpy(mapped_uniform_data, effect.uniform_data_storage.data() + offset, size);
+				_device->unmap_buffer_region(effect.cb);
+
+				_uniform_data_uploaded += size;
+
+				effect.uniform_data_dirty_beg = std::numeric_limits<size_t>::max();
+				effect.uniform_data_dirty_end = 0;
+			}
+		}
 	}
 	else if (_renderer_id == 0x9000)
 	{
+		// Constants in D3D9 are global state that is shared with the application and other effects, so have to be set again every time
 		cmd_list->push_constants(api::shader_stage::all, effect.layout, 0, 0, static_cast<uint32_t>(effect.uniform_data_storage.size() / 4), effect.uniform_data_storage.data());
+
+		_uniform_data_uploaded += effect.uniform_data_storage.size();
 	}
 
 	const bool sampler_with_resource_view = _device->check_capability(api::device_caps::sampler_with_resource_view);
@@ -3911,7 +4149,7 @@ void reshade::runtime::save_texture(const texture &tex)
 	if (std::vector<uint8_t> pixels(static_cast<size_t>(tex.width) * static_cast<size_t>(tex.height) * 4);
 		get_texture_data(tex.resource, api::resource_usage::shader_resource, pixels.data()))
 	{
-		_worker_threads.emplace_back([this, screenshot_path, pixels = std::move(pixels), width = tex.width, height = tex.height]() mutable {
+		_worker_tasks.submit([this, screenshot_path, pixels = std::move(pixels), width = tex.width, height = tex.height]() mutable {
 			// Default to a save failure unless it is reported to succeed below
 			bool save_success = false;
 
@@ -3970,22 +4208,15 @@ void reshade::runtime::update_texture(texture &tex, const uint32_t width, const
 		std::memcpy(resized.data(), pixels, resized.size());
 	}
 
-	// Collapse data to the correct number of components per pixel based on the texture format
-	uint32_t row_pitch = tex.width;
+	upload_texture(tex, resized.data(), 1);
+}
+void reshade::runtime::upload_texture(texture &tex, uint8_t *data, uint32_t levels)
+{
 	switch (tex.format)
 	{
 	case reshadefx::texture_format::r8:
-		for (size_t i = 4, k = 1; i < resized.size(); i += 4, k += 1)
-			resized[k] = resized[i];
-		break;
 	case reshadefx::texture_format::rg8:
-		for (size_t i = 4, k = 2; i < resized.size(); i += 4, k += 2)
-			resized[k + 0] = resized[i + 0],
-			resized[k + 1] = resized[i + 1];
-		row_pitch *= 2;
-		break;
 	case reshadefx::texture_format::rgba8:
-		row_pitch *= 4;
 		break;
 	default:
 		LOG(ERROR) << "Texture upload is not supported for format " << static_cast<int>(tex.format) << " of texture '" << tex.unique_name << "'!";
@@ -3994,10 +4225,40 @@ void reshade::runtime::update_texture(texture &tex, const uint32_t width, const
 
 	api::command_list *const cmd_list = _graphics_queue->get_immediate_command_list();
 	cmd_list->barrier(tex.resource, api::resource_usage::shader_resource, api::resource_usage::copy_dest);
-	_device->update_texture_region({ resized.data(), row_pitch, row_pitch * tex.height }, tex.resource, 0);
+
+	// The data contains the specified number of levels one after another, each tightly packed with four components per pixel
+	for (uint32_t level = 0, width = tex.width, height = tex.height; level < levels; ++level, width = std::max(1u, width / 2), height = std::max(1u, height / 2))
+	{
+		const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+
+		// Collapse data to the correct number of components per pixel based on the texture format
+		uint32_t row_pitch = width;
+		switch (tex.format)
+		{
+		case reshadefx::texture_format::r8:
+			for (size_t i = 4, k = 1; i < size; i += 4, k += 1)
+				data[k] = data[i];
+			break;
+		case reshadefx::texture_format::rg8:
+			for (size_t i = 4, k = 2; i < size; i += 4, k += 2)
+				data[k + 0] = data[i + 0],
+				data[k + 1] = data[i + 1];
+			row_pitch *= 2;
+			break;
+		case reshadefx::texture_format::rgba8:
+			row_pitch *= 4;
+			break;
+		}
+
+		_device->update_texture_region({ data, row_pitch, row_pitch * height }, tex.resource, level);
+
+		data += size;
+	}
+
 	cmd_list->barrier(tex.resource, api::resource_usage::copy_dest, api::resource_usage::shader_resource);
 
-	if (tex.levels > 1)
+	// Fall back to generating mipmaps on the GPU for any levels that were not provided
+	if (tex.levels > levels)
 		cmd_list->generate_mipmaps(tex.srv[0]);
 }
 
@@ -4006,6 +4267,7 @@ void reshade::runtime::reset_uniform_value(uniform &variable)
 	if (!variable.has_initializer_value)
 	{
 		std::memset(_effects[variable.effect_index].uniform_data_storage.data() + variable.offset, 0, variable.size);
+		_effects[variable.effect_index].mark_uniform_data_dirty(variable.offset, variable.size);
 		return;
 	}
 
@@ -4145,9 +4407,18 @@ void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *
 	size = std::min(size, static_cast<size_t>(variable.size));
 	assert(data != nullptr && (size % 4) == 0);
 
-	auto &data_storage = _effects[variable.effect_index].uniform_data_storage;
+	effect &effect = _effects[variable.effect_index];
+	auto &data_storage = effect.uniform_data_storage;
 	assert(variable.offset + size <= data_storage.size());
 
+	// Only mark values that actually changed as dirty, so that setting the same value every frame does not cause the constant buffer to be uploaded again
+	const auto update_data = [&effect, &data_storage](size_t offset, const uint8_t *value, size_t value_size) {
+		if (std::memcmp(data_storage.data() + offset, value, value_size) == 0)
+			return;
+		std::memcpy(data_storage.data() + offset, value, value_size);
+		effect.mark_uniform_data_dirty(offset, value_size);
+	};
+
 	const size_t array_length = (variable.type.is_array() ? variable.type.array_length : 1);
 	if (assert(base_index < array_length); base_index >= array_length)
 		return;
@@ -4158,8 +4429,8 @@ void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *
 			// Each row of a matrix is 16-byte aligned, so needs special handling
 			for (size_t row = 0; row < variable.type.rows; ++row)
 				for (size_t col = 0; i < (size / 4) && col < variable.type.cols; ++col, ++i)
-					std::memcpy(
-						data_storage.data() + variable.offset + (a * variable.type.rows * 4 + (row * 4 + col)) * 4,
+					update_data(
+						variable.offset + (a * variable.type.rows * 4 + (row * 4 + col)) * 4,
 						data + ((a - base_index) * variable.type.components() + (row * variable.type.cols + col)) * 4, 4);
 	}
 	else if (array_length > 1)
@@ -4167,13 +4438,13 @@ void reshade::runtime::set_uniform_value_data(uniform &variable, const uint8_t *
 		for (size_t a = base_index, i = 0; a < array_length; ++a)
 			// Each element in the array is 16-byte aligned, so needs special handling
 			for (size_t row = 0; i < (size / 4) && row < variable.type.rows; ++row, ++i)
-				std::memcpy(
-					data_storage.data() + variable.offset + (a * 4 + row) * 4,
+				update_data(
+					variable.offset + (a * 4 + row) * 4,
 					data + ((a - base_index) * variable.type.components() + row) * 4, 4);
 	}
 	else
 	{
-		std::memcpy(data_storage.data() + variable.offset, data, size);
+		update_data(variable.offset, data, size);
 	}
 }
 
@@ -4375,7 +4646,7 @@ void reshade::runtime::save_screenshot(const std::string &postfix)
 		const bool include_preset = false;
 #endif
 
-		_worker_threads.emplace_back([this, screenshot_path, pixels = std::move(pixels), include_preset]() mutable {
+		_worker_tasks.submit([this, screenshot_path, pixels = std::move(pixels), include_preset]() mutable {
 			// Remove alpha channel
 			int comp = 4;
 			if (_screenshot_clear_alpha)
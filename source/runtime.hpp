@@ -14,6 +14,10 @@
 #include <vector>
 #include <unordered_map>
 #include "reshade_api.hpp"
+#include "task_scheduler.hpp"
+#include "runtime_effect_cache.hpp"
+#include "runtime_texture_cache.hpp"
+#include "effect_preprocessor.hpp"
 #if RESHADE_GUI
 #include "imgui_code_editor.hpp"
 #endif
@@ -197,6 +201,8 @@ namespace reshade
 
 		bool switch_to_next_preset(std::filesystem::path filter_path, bool reversed = false);
 
+		class effect_shader_compiler;
+
 		bool load_effect(const std::filesystem::path &source_file, const ini_file &preset, size_t effect_index, bool preprocess_required = false);
 		bool create_effect(size_t effect_index);
 		bool create_effect_sampler_state(const api::sampler_desc &desc, api::sampler &sampler);
@@ -215,7 +221,7 @@ namespace reshade
 		void destroy_effects();
 
 		bool load_effect_cache(const std::string &id, const std::string &type, std::string &data) const;
-		bool save_effect_cache(const std::string &id, const std::string &type, const std::string &data) const;
+		bool save_effect_cache(const std::string &id, const std::string &type, const std::string &data);
 		void clear_effect_cache();
 
 		bool update_effect_color_tex(api::format format);
@@ -226,6 +232,7 @@ namespace reshade
 
 		void save_texture(const texture &texture);
 		void update_texture(texture &texture, const uint32_t width, const uint32_t height, const uint8_t *pixels);
+		void upload_texture(texture &texture, uint8_t *data, uint32_t levels);
 
 		void reset_uniform_value(uniform &variable);
 
@@ -268,6 +275,8 @@ namespace reshade
 		bool _effects_enabled = true;
 		bool _effects_rendered_this_frame = false;
 		unsigned int _effects_key_data[4] = {};
+		size_t _uniform_data_uploaded = 0;
+		size_t _last_uniform_data_uploaded = 0;
 #endif
 
 		std::chrono::high_resolution_clock::duration _last_frame_duration;
@@ -290,6 +299,8 @@ namespace reshade
 		std::vector<std::string> _global_preprocessor_definitions;
 		std::vector<std::string> _preset_preprocessor_definitions;
 		std::filesystem::path _intermediate_cache_path;
+		effect_cache _effect_cache;
+		reshadefx::include_cache _effect_include_cache;
 		std::vector<std::filesystem::path> _effect_search_paths;
 		std::vector<std::filesystem::path> _texture_search_paths;
 
@@ -303,8 +314,13 @@ namespace reshade
 		std::vector<effect> _effects;
 		std::vector<texture> _textures;
 		std::vector<technique> _techniques;
+
+		texture_cache _texture_cache;
+		task_scheduler::task_group _texture_tasks;
+		task_scheduler::task_group _effect_cache_tasks { true };
 #endif
-		std::vector<std::thread> _worker_threads;
+		task_scheduler _worker_tasks;
+		std::chrono::high_resolution_clock::time_point _reload_start_time;
 		std::chrono::high_resolution_clock::time_point _last_reload_time;
 		#pragma endregion
 
@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "dll_log.hpp"
+#include "runtime_effect_cache.hpp"
+#include <mutex>
+#include <vector>
+#include <limits>
+#include <cassert>
+#include <fstream>
+#include <algorithm>
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+#include <Windows.h>
+
+static constexpr uint32_t CACHE_FILE_MAGIC = 0x58465352; // "RSFX"
+static constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+struct cache_file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t num_entries;
+	uint64_t access_counter;
+	uint64_t index_checksum;
+};
+struct cache_file_index_entry
+{
+	uint64_t key;
+	uint64_t offset;
+	uint64_t last_access;
+	uint32_t size;
+	uint32_t checksum;
+};
+
+static inline uint32_t compute_checksum(const void *data, size_t size)
+{
+	return static_cast<uint32_t>(XXH3_64bits(data, size));
+}
+
+reshade::effect_cache::~effect_cache()
+{
+	close();
+}
+
+bool reshade::effect_cache::open(const std::filesystem::path &path, uint64_t max_size)
+{
+	if (path == _path)
+	{
+		_max_size = max_size;
+		return true;
+	}
+
+	close();
+
+	const std::unique_lock<std::mutex> flush_lock(_flush_mutex);
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	_path = path;
+	_max_size = max_size;
+
+	if (!map_file())
+		return true; // Cache file does not exist yet, so start out empty
+
+	// Validate file and read the index into memory
+	const auto header = reinterpret_cast<const cache_file_header *>(_file_view);
+	const auto index = reinterpret_cast<const cache_file_index_entry *>(_file_view + sizeof(cache_file_header));
+
+	if (_file_size < sizeof(cache_file_header) ||
+		header->magic != CACHE_FILE_MAGIC ||
+		header->version != CACHE_FILE_VERSION ||
+		header->num_entries > (_file_size - sizeof(cache_file_header)) / sizeof(cache_file_index_entry) ||
+		header->index_checksum != XXH3_64bits(index, static_cast<size_t>(header->num_entries) * sizeof(cache_file_index_entry)))
+	{
+		LOG(WARN) << "Effect cache file " << _path << " is corrupted or was written by a different version and will be rebuilt.";
+
+		unmap_file();
+		return true;
+	}
+
+	_access_counter = header->access_counter;
+
+	for (size_t i = 0; i < header->num_entries; ++i)
+	{
+		if (index[i].offset > _file_size || index[i].size > _file_size - index[i].offset)
+			continue; // Skip entries that point outside the file
+
+		entry &e = _entries[index[i].key];
+		e.offset = index[i].offset;
+		e.size = index[i].size;
+		e.checksum = index[i].checksum;
+		e.last_access = index[i].last_access;
+	}
+
+	return true;
+}
+void reshade::effect_cache::close()
+{
+	flush();
+
+	const std::unique_lock<std::mutex> flush_lock(_flush_mutex);
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	unmap_file();
+
+	_path.clear();
+	_entries.clear();
+	_dirty = false;
+}
+
+bool reshade::effect_cache::load(const std::string_view &key, std::string &data) const
+{
+	const std::shared_lock<std::shared_mutex> lock(_mutex);
+
+	const auto it = _entries.find(hash(key));
+	if (it == _entries.end())
+		return false;
+
+	const entry &e = it->second;
+
+	if (e.pending_data != nullptr)
+	{
+		data = *e.pending_data;
+	}
+	else
+	{
+		// Entry may be out of bounds if another process replaced the file in the meantime
+		if (_file_view == nullptr || e.offset > _file_size || e.size > _file_size - e.offset)
+			return false;
+
+		data.assign(reinterpret_cast<const char *>(_file_view + e.offset), e.size);
+
+		if (compute_checksum(data.data(), data.size()) != e.checksum)
+			return false;
+	}
+
+	e.last_access = ++_access_counter;
+	return true;
+}
+bool reshade::effect_cache::save(const std::string_view &key, std::string data)
+{
+	if (data.size() > std::numeric_limits<uint32_t>::max())
+		return false;
+
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	if (_path.empty())
+		return false;
+
+	entry &e = _entries[hash(key)];
+	e.size = static_cast<uint32_t>(data.size());
+	e.checksum = compute_checksum(data.data(), data.size());
+	e.last_access = ++_access_counter;
+	e.pending_data = std::make_shared<const std::string>(std::move(data));
+
+	_dirty = true;
+	return true;
+}
+
+bool reshade::effect_cache::flush()
+{
+	const std::unique_lock<std::mutex> flush_lock(_flush_mutex);
+
+	// Take a snapshot of all entries, so that the file can be written without blocking other threads
+	// Pending data is shared with the snapshot and the file mapping is only replaced while holding the flush lock, so both remain valid while writing
+	std::vector<flush_entry> entries, evicted_entries;
+	uint64_t access_counter = 0;
+	{ const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+		if (!_dirty || _path.empty())
+			return true;
+
+		entries.reserve(_entries.size());
+		for (const auto &[key, e] : _entries)
+		{
+			flush_entry &snapshot = entries.emplace_back();
+			snapshot.key = key;
+			snapshot.offset = e.offset;
+			snapshot.last_access = e.last_access;
+			snapshot.size = e.size;
+			snapshot.checksum = e.checksum;
+			snapshot.pending_data = e.pending_data;
+
+			// Drop entries whose data is no longer available because another process replaced the file in the meantime
+			if (snapshot.pending_data == nullptr && (_file_view == nullptr || snapshot.offset > _file_size || snapshot.size > _file_size - snapshot.offset))
+			{
+				evicted_entries.push_back(std::move(snapshot));
+				entries.pop_back();
+			}
+		}
+
+		access_counter = _access_counter;
+
+		// Any entry saved from here on marks the cache dirty again, so that it is written by the next flush
+		_dirty = false;
+	}
+
+	// Sort entries so that the most recently used ones come first
+	std::sort(entries.begin(), entries.end(),
+		[](const flush_entry &lhs, const flush_entry &rhs) { return lhs.last_access > rhs.last_access; });
+
+	// Evict least recently used entries that exceed the size limit
+	size_t num_entries = 0;
+	for (uint64_t total_size = 0; num_entries < entries.size(); ++num_entries)
+	{
+		total_size += entries[num_entries].size;
+		if (total_size > _max_size && num_entries != 0)
+			break;
+	}
+
+	evicted_entries.insert(evicted_entries.end(), std::make_move_iterator(entries.begin() + num_entries), std::make_move_iterator(entries.end()));
+	entries.resize(num_entries);
+
+	// Write to a temporary file first and then replace the existing one with it, so that other processes never see a partially written cache file
+	std::filesystem::path temp_path = _path;
+	temp_path += L'.' + std::to_wstring(GetCurrentProcessId()) + L".tmp";
+
+	std::vector<uint64_t> offsets(entries.size());
+	if (!write_file(temp_path, entries, access_counter, offsets.data()))
+	{
+		DeleteFileW(temp_path.c_str());
+
+		{ const std::unique_lock<std::shared_mutex> lock(_mutex);
+			_dirty = true; // Retry on the next flush
+		}
+
+		LOG(ERROR) << "Failed to write effect cache file " << temp_path << '!';
+		return false;
+	}
+
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	unmap_file();
+
+	if (!MoveFileExW(temp_path.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		const DWORD error_code = GetLastError();
+
+		DeleteFileW(temp_path.c_str());
+
+		// Keep all entries in memory, so that writing them can be retried on the next flush
+		map_file();
+		_dirty = true;
+
+		LOG(ERROR) << "Failed to replace effect cache file " << _path << " with error code " << error_code << '!';
+		return false;
+	}
+
+	map_file();
+
+	// Only update entries that were not saved again while the file was written, since those still need their new data written on the next flush
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const auto it = _entries.find(entries[i].key);
+		if (it == _entries.end() || it->second.pending_data != entries[i].pending_data)
+			continue;
+
+		it->second.offset = offsets[i];
+		it->second.pending_data.reset();
+	}
+
+	for (const flush_entry &evicted_entry : evicted_entries)
+	{
+		const auto it = _entries.find(evicted_entry.key);
+		if (it != _entries.end() && it->second.pending_data == evicted_entry.pending_data)
+			_entries.erase(it);
+	}
+
+	return true;
+}
+void reshade::effect_cache::clear()
+{
+	const std::unique_lock<std::mutex> flush_lock(_flush_mutex);
+	const std::unique_lock<std::shared_mutex> lock(_mutex);
+
+	unmap_file();
+
+	_entries.clear();
+	_dirty = false;
+
+	if (!_path.empty())
+		DeleteFileW(_path.c_str());
+}
+
+uint64_t reshade::effect_cache::hash(const std::string_view &key)
+{
+	return XXH3_64bits(key.data(), key.size());
+}
+uint64_t reshade::effect_cache::hash_file(const std::filesystem::path &path)
+{
+	struct file_hash
+	{
+		std::filesystem::file_time_type last_write_time;
+		uintmax_t size;
+		uint64_t hash;
+	};
+
+	static std::mutex s_mutex;
+	static std::unordered_map<std::filesystem::path::string_type, file_hash> s_file_hashes;
+
+	std::error_code ec;
+	const std::filesystem::file_time_type last_write_time = std::filesystem::last_write_time(path, ec);
+	if (ec)
+		return 0;
+	const uintmax_t size = std::filesystem::file_size(path, ec);
+	if (ec)
+		return 0;
+
+	{ const std::unique_lock<std::mutex> lock(s_mutex);
+		if (const auto it = s_file_hashes.find(path.native());
+			it != s_file_hashes.end() && it->second.last_write_time == last_write_time && it->second.size == size)
+			return it->second.hash;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return 0;
+
+	std::string data(static_cast<size_t>(size), '\0');
+	file.read(data.data(), data.size());
+	data.resize(static_cast<size_t>(file.gcount()));
+
+	const uint64_t hash = XXH3_64bits(data.data(), data.size());
+
+	{ const std::unique_lock<std::mutex> lock(s_mutex);
+		s_file_hashes[path.native()] = { last_write_time, size, hash };
+	}
+
+	return hash;
+}
+
+bool reshade::effect_cache::map_file()
+{
+	assert(_file == nullptr && _file_view == nullptr);
+
+	// Allow other processes to replace the file while it is mapped here
+	const HANDLE file = CreateFileW(_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size = {};
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(cache_file_header)))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const HANDLE file_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (file_mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void *const file_view = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (file_view == nullptr)
+	{
+		CloseHandle(file_mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_file_mapping = file_mapping;
+	_file_view = static_cast<const uint8_t *>(file_view);
+	_file_size = static_cast<uint64_t>(file_size.QuadPart);
+
+	return true;
+}
+void reshade::effect_cache::unmap_file()
+{
+	if (_file_view != nullptr)
+		UnmapViewOfFile(_file_view);
+	if (_file_mapping != nullptr)
+		CloseHandle(_file_mapping);
+	if (_file != nullptr)
+		CloseHandle(_file);
+
+	_file = nullptr;
+	_file_mapping = nullptr;
+	_file_view = nullptr;
+	_file_size = 0;
+}
+
+bool reshade::effect_cache::write_file(const std::filesystem::path &path, const std::vector<flush_entry> &entries, uint64_t access_counter, uint64_t *offsets) const
+{
+	std::vector<cache_file_index_entry> index(entries.size());
+
+	// Data of all entries is stored right after the index
+	uint64_t offset = sizeof(cache_file_header) + index.size() * sizeof(cache_file_index_entry);
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const flush_entry &e = entries[i];
+
+		index[i].key = e.key;
+		index[i].offset = offset;
+		index[i].last_access = e.last_access;
+		index[i].size = e.size;
+		index[i].checksum = e.checksum;
+
+		offsets[i] = offset;
+		offset += e.size;
+	}
+
+	cache_file_header header = {};
+	header.magic = CACHE_FILE_MAGIC;
+	header.version = CACHE_FILE_VERSION;
+	header.num_entries = index.size();
+	header.access_counter = access_counter;
+	header.index_checksum = XXH3_64bits(index.data(), index.size() * sizeof(cache_file_index_entry));
+
+	const HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	const auto write = [file](const void *data, size_t size) {
+		while (size != 0)
+		{
+			DWORD size_written = 0;
+			if (!WriteFile(file, data, static_cast<DWORD>(std::min<size_t>(size, 0x40000000)), &size_written, nullptr) || size_written == 0)
+				return false;
+			data = static_cast<const uint8_t *>(data) + size_written;
+			size -= size_written;
+		}
+		return true;
+	};
+
+	bool result = write(&header, sizeof(header)) && write(index.data(), index.size() * sizeof(cache_file_index_entry));
+
+	for (size_t i = 0; i < entries.size() && result; ++i)
+	{
+		const flush_entry &e = entries[i];
+		if (e.pending_data != nullptr)
+			result = write(e.pending_data->data(), e.pending_data->size());
+		else
+			result = write(_file_view + e.offset, e.size);
+	}
+
+	// Make sure the data actually reached the disk before the file replaces the existing one, so that a crash cannot leave a truncated file behind under the final name
+	result = result && FlushFileBuffers(file);
+
+	CloseHandle(file);
+
+	return result;
+}
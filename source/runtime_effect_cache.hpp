@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <filesystem>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// A persistent store for intermediate effect compilation results (pre-processed source code, compiled shader objects, ...).
+	/// All entries are packed into a single file on disk, which starts with an index of 64-bit hash keys and is memory mapped for reading, so that many threads can look up entries at once without opening any files.
+	/// New entries are kept in memory until <see cref="flush"/> is called, which rewrites the file atomically and evicts the least recently used entries if the size limit is exceeded.
+	/// The file is written without holding the lock that guards look ups, so flushing may happen on a background thread while other threads keep loading and saving entries.
+	/// </summary>
+	class effect_cache
+	{
+	public:
+		/// <summary>
+		/// Default upper bound for the total size of all entries in a cache file.
+		/// </summary>
+		static constexpr uint64_t default_max_size = 256 * 1024 * 1024;
+
+		effect_cache() = default;
+		~effect_cache();
+
+		effect_cache(const effect_cache &) = delete;
+		effect_cache &operator=(const effect_cache &) = delete;
+
+		/// <summary>
+		/// Opens the cache file at the specified <paramref name="path"/>, or creates an empty cache if it does not exist yet.
+		/// Any previously opened cache file is flushed and closed first, unless it is the same one.
+		/// </summary>
+		bool open(const std::filesystem::path &path, uint64_t max_size = default_max_size);
+		/// <summary>
+		/// Flushes and closes the cache file.
+		/// </summary>
+		void close();
+
+		/// <summary>
+		/// Gets a boolean indicating whether a cache file is currently open.
+		/// </summary>
+		bool is_open() const { return !_path.empty(); }
+
+		/// <summary>
+		/// Looks up the entry with the specified <paramref name="key"/> and copies its data.
+		/// This is safe to call from multiple threads at once.
+		/// </summary>
+		/// <returns><see langword="true"/> if the entry was found and its checksum matched, <see langword="false"/> otherwise.</returns>
+		bool load(const std::string_view &key, std::string &data) const;
+		/// <summary>
+		/// Adds or replaces the entry with the specified <paramref name="key"/>.
+		/// The data is only written to disk on the next call to <see cref="flush"/>.
+		/// </summary>
+		bool save(const std::string_view &key, std::string data);
+
+		/// <summary>
+		/// Writes all new entries to disk, evicting the least recently used ones if the size limit is exceeded.
+		/// This is safe to call from any thread, concurrently with look ups and saves. Entries saved while the file is written are kept in memory until the next flush.
+		/// </summary>
+		bool flush();
+		/// <summary>
+		/// Removes all entries from the cache and deletes the cache file.
+		/// </summary>
+		void clear();
+
+		/// <summary>
+		/// Computes the 64-bit key used to identify an entry.
+		/// </summary>
+		static uint64_t hash(const std::string_view &key);
+		/// <summary>
+		/// Computes a hash of the contents of the file at the specified <paramref name="path"/>, so that keys can be derived from the actual source rather than its modification time.
+		/// The result is remembered until the modification time or size of the file changes, to avoid reading unchanged files again.
+		/// </summary>
+		/// <returns>The hash of the file contents, or zero if the file could not be read.</returns>
+		static uint64_t hash_file(const std::filesystem::path &path);
+
+	private:
+		struct entry
+		{
+			uint64_t offset = 0;
+			uint32_t size = 0;
+			uint32_t checksum = 0;
+			mutable std::atomic<uint64_t> last_access = 0;
+			std::shared_ptr<const std::string> pending_data; // Data that was not yet written to the cache file (shared with a flush that is currently writing it)
+		};
+		struct flush_entry
+		{
+			uint64_t key;
+			uint64_t offset;
+			uint64_t last_access;
+			uint32_t size;
+			uint32_t checksum;
+			std::shared_ptr<const std::string> pending_data;
+		};
+
+		bool map_file();
+		void unmap_file();
+		bool write_file(const std::filesystem::path &path, const std::vector<flush_entry> &entries, uint64_t access_counter, uint64_t *offsets) const;
+
+		// Serializes flushes with each other and with anything else that replaces the file mapping, so that a flush can read from it without holding the main lock
+		std::mutex _flush_mutex;
+		mutable std::shared_mutex _mutex;
+		std::filesystem::path _path;
+		uint64_t _max_size = default_max_size;
+		std::unordered_map<uint64_t, entry> _entries;
+		mutable std::atomic<uint64_t> _access_counter = 0;
+		bool _dirty = false;
+
+		void *_file = nullptr;
+		void *_file_mapping = nullptr;
+		const uint8_t *_file_view = nullptr;
+		uint64_t _file_size = 0;
+	};
+}
@@ -2003,6 +2003,7 @@ void reshade::runtime::draw_gui_statistics()
 		ImGui::Text("Frame %llu:", _framecount + 1);
 #if RESHADE_FX
 		ImGui::TextUnformatted("Post-Processing:");
+		ImGui::TextUnformatted("Uniform Uploads:");
 #endif
 
 		ImGui::EndGroup();
@@ -2042,6 +2043,7 @@ void reshade::runtime::draw_gui_statistics()
 		ImGui::Text("%.2f fps", _imgui_context->IO.Framerate);
 #if RESHADE_FX
 		ImGui::Text("%*.3f ms CPU", cpu_digits + 4, post_processing_time_cpu * 1e-6f);
+		ImGui::Text("%zu bytes per frame", _last_uniform_data_uploaded);
 #endif
 
 		ImGui::EndGroup();
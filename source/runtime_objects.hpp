@@ -6,6 +6,11 @@
 #pragma once
 
 #include "effect_module.hpp"
+#include <limits>
+#include <cstdlib> // RAND_MAX
+#include <algorithm> // std::find_if
+#include <filesystem>
+#include <unordered_map>
 
 namespace reshade
 {
@@ -119,6 +124,25 @@ namespace reshade
 		std::vector<api::resource_view> uav;
 	};
 
+	struct special_uniform_params
+	{
+		enum class key_mode
+		{
+			down,
+			press,
+			toggle
+		};
+
+		int min_int = 0;
+		int max_int = 0;
+		float min = 0.0f;
+		float max = 0.0f;
+		float step[2] = {};
+		float smoothing = 0.0f;
+		int keycode = 0;
+		key_mode mode = key_mode::down;
+	};
+
 	struct uniform final : reshadefx::uniform_info
 	{
 		uniform(const reshadefx::uniform_info &init) : uniform_info(init) {}
@@ -172,8 +196,86 @@ namespace reshade
 			return ui_type == "list" || ui_type == "combo" || ui_type == "radio";
 		}
 
+		/// <summary>
+		/// Looks up the "source" annotation to figure out whether this is a special uniform (which is updated every frame), and parses the annotations that control how it is updated.
+		/// This is done once when the effect is loaded, so that the update does not have to search through the annotations every frame.
+		/// </summary>
+		void parse_special_annotations()
+		{
+			const std::string_view source = annotation_as_string("source");
+			if (source.empty()) /* Ignore if annotation is missing */
+				special = special_uniform::none;
+			else if (source == "frametime")
+				special = special_uniform::frame_time;
+			else if (source == "framecount")
+				special = special_uniform::frame_count;
+			else if (source == "random")
+				special = special_uniform::random;
+			else if (source == "pingpong")
+				special = special_uniform::ping_pong;
+			else if (source == "date")
+				special = special_uniform::date;
+			else if (source == "timer")
+				special = special_uniform::timer;
+			else if (source == "key")
+				special = special_uniform::key;
+			else if (source == "mousepoint")
+				special = special_uniform::mouse_point;
+			else if (source == "mousedelta")
+				special = special_uniform::mouse_delta;
+			else if (source == "mousebutton")
+				special = special_uniform::mouse_button;
+			else if (source == "mousewheel")
+				special = special_uniform::mouse_wheel;
+			else if (source == "ui_open" || source == "overlay_open")
+				special = special_uniform::overlay_open;
+			else if (source == "ui_active" || source == "overlay_active")
+				special = special_uniform::overlay_active;
+			else if (source == "ui_hovered" || source == "overlay_hovered")
+				special = special_uniform::overlay_hovered;
+			else if (source == "screenshot")
+				special = special_uniform::screenshot;
+			else
+				special = special_uniform::unknown;
+
+			switch (special)
+			{
+			case special_uniform::random:
+				special_params.min_int = annotation_as_int("min", 0, 0);
+				special_params.max_int = annotation_as_int("max", 0, RAND_MAX);
+				break;
+			case special_uniform::ping_pong:
+				special_params.min = annotation_as_float("min", 0, 0.0f);
+				special_params.max = annotation_as_float("max", 0, 1.0f);
+				special_params.step[0] = annotation_as_float("step", 0);
+				special_params.step[1] = annotation_as_float("step", 1);
+				special_params.smoothing = annotation_as_float("smoothing");
+				break;
+			case special_uniform::key:
+			case special_uniform::mouse_button:
+				special_params.keycode = annotation_as_int("keycode");
+				if (const std::string_view mode = annotation_as_string("mode");
+					mode == "toggle" || annotation_as_int("toggle"))
+					special_params.mode = special_uniform_params::key_mode::toggle;
+				else if (mode == "press")
+					special_params.mode = special_uniform_params::key_mode::press;
+				else
+					special_params.mode = special_uniform_params::key_mode::down;
+				break;
+			case special_uniform::mouse_wheel:
+				special_params.min = annotation_as_float("min");
+				special_params.max = annotation_as_float("max");
+				special_params.step[0] = annotation_as_float("step");
+				if (special_params.step[0] == 0.0f)
+					special_params.step[0] = 1.0f;
+				break;
+			}
+		}
+
 		size_t effect_index = std::numeric_limits<size_t>::max();
 		special_uniform special = special_uniform::none;
+		// Annotations that control how the special uniform is updated, see 'parse_special_annotations'
+		special_uniform_params special_params;
 		unsigned int toggle_key_data[4] = {};
 	};
 
@@ -251,13 +353,24 @@ namespace reshade
 		bool preprocessed = false;
 		std::string errors;
 		reshadefx::module module;
-		size_t source_hash = 0;
+		uint64_t source_hash = 0;
 		std::filesystem::path source_file;
+		std::chrono::high_resolution_clock::duration load_duration = {};
 		std::vector<std::filesystem::path> included_files;
 		std::vector<std::pair<std::string, std::string>> definitions;
+		std::vector<std::string> referenced_macros;
 		std::unordered_map<std::string, std::pair<std::string, std::string>> assembly;
 		std::vector<uniform> uniforms;
 		std::vector<uint8_t> uniform_data_storage;
+		// Range of the uniform data that changed since it was last uploaded to the constant buffer
+		size_t uniform_data_dirty_beg = std::numeric_limits<size_t>::max();
+		size_t uniform_data_dirty_end = 0;
+
+		void mark_uniform_data_dirty(size_t offset, size_t size)
+		{
+			uniform_data_dirty_beg = std::min(uniform_data_dirty_beg, offset);
+			uniform_data_dirty_end = std::max(uniform_data_dirty_end, offset + size);
+		}
 
 		struct binding_data
 		{
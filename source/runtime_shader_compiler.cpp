@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "runtime_shader_compiler.hpp"
+
+bool reshade::compile_entry_points(task_scheduler &scheduler, shader_compiler &compiler, const reshadefx::module &module, std::unordered_map<std::string, std::pair<std::string, std::string>> &assembly, std::string &errors)
+{
+	struct result
+	{
+		bool success = false;
+		std::string cso, cso_text, errors;
+	};
+
+	std::vector<result> results(module.entry_points.size());
+
+	// Only worth the scheduling overhead if there is more than one entry point
+	if (results.size() == 1)
+	{
+		results[0].success = compiler.compile(module, module.entry_points[0], results[0].cso, results[0].cso_text, results[0].errors);
+	}
+	else
+	{
+		task_scheduler::task_group group;
+
+		for (size_t i = 0; i < results.size(); ++i)
+			scheduler.submit(group, [&compiler, &module, &results, i]() {
+				result &result = results[i];
+				result.success = compiler.compile(module, module.entry_points[i], result.cso, result.cso_text, result.errors);
+			});
+
+		scheduler.wait(group);
+	}
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		result &result = results[i];
+
+		errors += result.errors;
+
+		if (!result.success)
+			return false;
+
+		assembly[module.entry_points[i].name] = { std::move(result.cso), std::move(result.cso_text) };
+	}
+
+	return true;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include "effect_module.hpp"
+#include "task_scheduler.hpp"
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// The backend step of loading an effect, which turns the code for a single entry point into a shader object that can be passed to the graphics API.
+	/// </summary>
+	class shader_compiler
+	{
+	public:
+		virtual ~shader_compiler() {}
+
+		/// <summary>
+		/// Compiles the specified entry point of a module.
+		/// This is called from multiple threads at once (for different entry points of the same module), so implementations have to be thread-safe.
+		/// </summary>
+		/// <param name="module">Module the entry point belongs to.</param>
+		/// <param name="entry_point">Entry point to compile.</param>
+		/// <param name="cso">Compiled shader object.</param>
+		/// <param name="cso_text">Human-readable representation of the compiled shader object (like its disassembly), which is shown in the overlay.</param>
+		/// <param name="errors">Error and warning messages that occured during compilation.</param>
+		/// <returns><see langword="true"/> if compilation was successful, <see langword="false"/> otherwise.</returns>
+		virtual bool compile(const reshadefx::module &module, const reshadefx::entry_point &entry_point, std::string &cso, std::string &cso_text, std::string &errors) = 0;
+	};
+
+	/// <summary>
+	/// Compiles all entry points of a module in parallel, with a separate task for each on the specified scheduler, and waits for them to finish.
+	/// The calling thread helps executing those tasks, so this may be called from within a task of the same scheduler.
+	/// </summary>
+	/// <param name="scheduler">Scheduler to execute compilation tasks on.</param>
+	/// <param name="compiler">Compiler to use for every entry point.</param>
+	/// <param name="module">Module with the entry points to compile.</param>
+	/// <param name="assembly">Map of entry point names to their compiled shader object and its human-readable representation, which results are added to.</param>
+	/// <param name="errors">String to append error and warning messages to. These are appended in entry point order (up to the first one that failed to compile), independent of the order in which the tasks finished, so that the result is the same as if all entry points were compiled one after another.</param>
+	/// <returns><see langword="true"/> if all entry points compiled successfully, <see langword="false"/> otherwise.</returns>
+	bool compile_entry_points(task_scheduler &scheduler, shader_compiler &compiler, const reshadefx::module &module, std::unordered_map<std::string, std::pair<std::string, std::string>> &assembly, std::string &errors);
+}
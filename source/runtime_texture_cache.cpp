@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "runtime_texture_cache.hpp"
+#include <limits>
+#include <cstring> // std::memcpy
+#include <fstream>
+#include <algorithm>
+#include <stb_image.h>
+#include <stb_image_dds.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RESHADE_MIPMAP_SSE2 1
+#endif
+
+static std::shared_ptr<const reshade::decoded_image> decode_image(const std::filesystem::path &path)
+{
+	std::error_code ec;
+	const uintmax_t file_size = std::filesystem::file_size(path, ec);
+	if (ec || file_size > static_cast<uintmax_t>(std::numeric_limits<int>::max()))
+		return nullptr;
+
+	std::vector<stbi_uc> file_data(static_cast<size_t>(file_size));
+	if (auto file = std::ifstream(path, std::ios::binary))
+	{
+		// Read image data into memory in one go since that is faster than reading chunk by chunk
+		if (!file.read(reinterpret_cast<char *>(file_data.data()), file_data.size()))
+			return nullptr;
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	stbi_uc *pixels = nullptr;
+	int width = 0, height = 0, channels = 0;
+
+	if (stbi_dds_test_memory(file_data.data(), static_cast<int>(file_data.size())))
+		pixels = stbi_dds_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+	else
+		pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, STBI_rgb_alpha);
+
+	if (pixels == nullptr)
+		return nullptr;
+
+	const auto image = std::make_shared<reshade::decoded_image>();
+	image->width = static_cast<uint32_t>(width);
+	image->height = static_cast<uint32_t>(height);
+	image->pixels.assign(pixels, pixels + static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+	stbi_image_free(pixels);
+
+	return image;
+}
+
+std::shared_ptr<const reshade::decoded_image> reshade::texture_cache::load(const std::filesystem::path &path)
+{
+	std::error_code ec;
+	const std::filesystem::file_time_type last_write_time = std::filesystem::last_write_time(path, ec);
+	if (ec)
+		return nullptr;
+
+	std::promise<std::shared_ptr<const decoded_image>> promise;
+	std::shared_future<std::shared_ptr<const decoded_image>> image;
+	uint64_t decode_index = 0;
+
+	{ const std::unique_lock<std::mutex> lock(_mutex);
+		entry &entry = _entries[path.native()];
+		entry.used = true;
+		entry.last_access = ++_access_count;
+
+		if (!entry.image.valid() || entry.last_write_time != last_write_time)
+		{
+			_size -= entry.size;
+
+			entry.size = 0;
+			entry.last_write_time = last_write_time;
+			entry.image = promise.get_future().share();
+			entry.decode_index = decode_index = ++_decode_count;
+		}
+
+		image = entry.image;
+	}
+
+	// Decode outside the lock, so that other images can be decoded in parallel
+	if (decode_index != 0)
+	{
+		std::shared_ptr<const decoded_image> result = decode_image(path);
+
+		{ const std::unique_lock<std::mutex> lock(_mutex);
+			// Only account for the decoded image if the entry was not evicted or replaced by a newer version of the file in the meantime
+			if (const auto it = _entries.find(path.native()); it != _entries.end() && it->second.decode_index == decode_index && result != nullptr)
+			{
+				it->second.size = result->pixels.size();
+				_size += it->second.size;
+
+				evict_to_max_size(&it->second);
+			}
+		}
+
+		promise.set_value(std::move(result));
+	}
+
+	return image.get();
+}
+
+void reshade::texture_cache::evict_unused()
+{
+	const std::unique_lock<std::mutex> lock(_mutex);
+
+	for (auto it = _entries.begin(); it != _entries.end();)
+	{
+		if (!it->second.used)
+		{
+			_size -= it->second.size;
+			it = _entries.erase(it);
+			continue;
+		}
+
+		it->second.used = false;
+		++it;
+	}
+}
+
+void reshade::texture_cache::evict_to_max_size(const entry *keep)
+{
+	while (_size > _max_size)
+	{
+		// Find the least recently used entry (this is a linear search, but the number of images effects reference is small)
+		// Entries that are still being decoded have no size yet and are skipped, as are entries that were just added
+		auto lru_it = _entries.end();
+		for (auto it = _entries.begin(); it != _entries.end(); ++it)
+			if (it->second.size != 0 && &it->second != keep && (lru_it == _entries.end() || it->second.last_access < lru_it->second.last_access))
+				lru_it = it;
+
+		if (lru_it == _entries.end())
+			break; // Keep the image that was just decoded even if it alone exceeds the limit
+
+		// Any users of the image still hold a reference to it, so this only drops the one of the cache
+		_size -= lru_it->second.size;
+		_entries.erase(lru_it);
+	}
+}
+
+size_t reshade::mipmap_chain_size(uint32_t width, uint32_t height, uint32_t levels)
+{
+	size_t size = 0;
+	for (uint32_t level = 0; level < levels; ++level, width = std::max(1u, width / 2), height = std::max(1u, height / 2))
+		size += static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+	return size;
+}
+
+static void downsample(const uint8_t *src, uint32_t src_width, uint32_t src_height, uint8_t *dst)
+{
+	const uint32_t dst_width = std::max(1u, src_width / 2);
+	const uint32_t dst_height = std::max(1u, src_height / 2);
+
+	for (uint32_t y = 0; y < dst_height; ++y)
+	{
+		// Clamp to the last row/column when the source is only one pixel high/wide
+		const uint8_t *const row0 = src + static_cast<size_t>(std::min(y * 2 + 0, src_height - 1)) * src_width * 4;
+		const uint8_t *const row1 = src + static_cast<size_t>(std::min(y * 2 + 1, src_height - 1)) * src_width * 4;
+		uint8_t *const dst_row = dst + static_cast<size_t>(y) * dst_width * 4;
+
+		uint32_t x = 0;
+#if RESHADE_MIPMAP_SSE2
+		// Every destination pixel has two source pixels in each row here if the source is wider than one pixel, so can process four destination pixels (eight source pixels) at once
+		if (src_width > 1)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i round = _mm_set1_epi16(2);
+
+			for (; x + 4 <= dst_width; x += 4)
+			{
+				const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 0));
+				const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 16));
+				const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 0));
+				const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 16));
+
+				// Add vertical pairs, with each register holding the two columns of one destination pixel as 16-bit values
+				__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+				__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+				__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+				__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+				// Add horizontal pairs, which leaves the sum of all four source pixels in the lower half of each register
+				s0 = _mm_add_epi16(s0, _mm_srli_si128(s0, 8));
+				s1 = _mm_add_epi16(s1, _mm_srli_si128(s1, 8));
+				s2 = _mm_add_epi16(s2, _mm_srli_si128(s2, 8));
+				s3 = _mm_add_epi16(s3, _mm_srli_si128(s3, 8));
+
+				const __m128i s01 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s0, s1), round), 2);
+				const __m128i s23 = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s2, s3), round), 2);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(dst_row + x * 4), _mm_packus_epi16(s01, s23));
+			}
+		}
+#endif
+		for (; x < dst_width; ++x)
+		{
+			const uint32_t x0 = std::min(x * 2 + 0, src_width - 1);
+			const uint32_t x1 = std::min(x * 2 + 1, src_width - 1);
+
+			for (uint32_t c = 0; c < 4; ++c)
+				dst_row[x * 4 + c] = static_cast<uint8_t>((row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c] + 2) / 4);
+		}
+	}
+}
+
+void reshade::generate_mipmap_chain(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t levels, uint8_t *data)
+{
+	if (levels == 0)
+		return;
+
+	std::memcpy(data, pixels, static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+
+	for (uint32_t level = 1; level < levels; ++level)
+	{
+		uint8_t *const next_data = data + static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+
+		downsample(data, width, height, next_data);
+
+		data = next_data;
+		width = std::max(1u, width / 2);
+		height = std::max(1u, height / 2);
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <mutex>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+namespace reshade
+{
+	/// <summary>
+	/// Pixel data of an image file, decoded to 8-bit RGBA.
+	/// </summary>
+	struct decoded_image
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	/// <summary>
+	/// An in-memory cache of decoded image files, so that reloading effects does not have to decode the same images again.
+	/// Entries are keyed by file path and last modification time, so that images which were changed on disk are decoded again.
+	/// The total size of the decoded images is capped, with the least recently used entries being evicted when it is exceeded.
+	/// </summary>
+	class texture_cache
+	{
+	public:
+		/// <summary>
+		/// Constructs a cache that holds at most <paramref name="max_size"/> bytes of decoded image data.
+		/// </summary>
+		explicit texture_cache(size_t max_size = 256 * 1024 * 1024) : _max_size(max_size) {}
+
+		/// <summary>
+		/// Gets the decoded image of the file at the specified <paramref name="path"/>, decoding it first if it is not in the cache yet or was modified since.
+		/// This is safe to call from multiple threads at once. Concurrent calls for the same file only decode it once, with the other calls waiting for that to finish.
+		/// </summary>
+		/// <param name="path">Absolute path to a DDS image file or any file format supported by stb_image.</param>
+		/// <returns>The decoded image, or <see langword="nullptr"/> if the file could not be read or decoded.</returns>
+		std::shared_ptr<const decoded_image> load(const std::filesystem::path &path);
+
+		/// <summary>
+		/// Removes all entries that were not accessed via <see cref="load"/> since the last call to this, to free the memory of images no effect references anymore.
+		/// </summary>
+		void evict_unused();
+
+		/// <summary>
+		/// Gets the total size in bytes of the decoded images currently held in the cache.
+		/// </summary>
+		size_t size() const { const std::unique_lock<std::mutex> lock(_mutex); return _size; }
+
+	private:
+		struct entry
+		{
+			std::filesystem::file_time_type last_write_time;
+			std::shared_future<std::shared_ptr<const decoded_image>> image;
+			uint64_t decode_index = 0;
+			uint64_t last_access = 0;
+			size_t size = 0;
+			bool used = false;
+		};
+
+		void evict_to_max_size(const entry *keep);
+
+		mutable std::mutex _mutex;
+		std::unordered_map<std::filesystem::path::string_type, entry> _entries;
+		size_t _size = 0;
+		const size_t _max_size;
+		uint64_t _access_count = 0;
+		uint64_t _decode_count = 0;
+	};
+
+	/// <summary>
+	/// Computes the number of bytes required to store all the specified mipmap <paramref name="levels"/> of an 8-bit RGBA image.
+	/// </summary>
+	size_t mipmap_chain_size(uint32_t width, uint32_t height, uint32_t levels);
+
+	/// <summary>
+	/// Generates the mipmap chain of an 8-bit RGBA image on the CPU, by repeatedly downsampling it with a 2x2 box filter (using SSE2 where available).
+	/// The result contains all levels one after another, starting with a copy of the image itself, each tightly packed and half the size of the previous one (rounded down, but at least one pixel).
+	/// </summary>
+	/// <param name="pixels">Pixel data of the base level.</param>
+	/// <param name="width">Width of the base level.</param>
+	/// <param name="height">Height of the base level.</param>
+	/// <param name="levels">Number of levels to generate, including the base level.</param>
+	/// <param name="data">Buffer of at least <see cref="mipmap_chain_size"/> bytes that receives the pixel data of all levels.</param>
+	void generate_mipmap_chain(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t levels, uint8_t *data);
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include "task_scheduler.hpp"
+#include <cassert>
+#include <algorithm>
+
+// Keep track of the scheduler and worker index the current thread belongs to, so that tasks submitted from within a task end up in the queue of the same worker
+static thread_local const reshade::task_scheduler *s_current_scheduler = nullptr;
+static thread_local size_t s_current_worker_index = 0;
+
+reshade::task_scheduler::task_scheduler(size_t num_threads) :
+	_num_threads(num_threads != 0 ? num_threads : std::max<size_t>(std::thread::hardware_concurrency(), 2u) - 1)
+{
+}
+reshade::task_scheduler::~task_scheduler()
+{
+	{ const std::unique_lock<std::mutex> lock(_signal_mutex);
+		_shutdown = true;
+	}
+
+	_work_available.notify_all();
+
+	// Workers drain all remaining tasks before they exit
+	for (const std::unique_ptr<worker> &worker : _workers)
+		if (worker->thread.joinable())
+			worker->thread.join();
+}
+
+void reshade::task_scheduler::submit(std::function<void()> task)
+{
+	submit(queued_task { std::move(task) });
+}
+void reshade::task_scheduler::submit(task_group &group, std::function<void()> task)
+{
+	// Count task before it is queued, so that it cannot be popped before (which would underflow the counts)
+	group._num_pending++;
+	group._num_queued++;
+
+	submit(queued_task { std::move(task), &group });
+
+	// Wake up any thread waiting on the group, so that it can help executing the new task
+	_work_finished.notify_all();
+}
+void reshade::task_scheduler::submit(queued_task &&task)
+{
+	std::call_once(_start_flag, &task_scheduler::start, this);
+
+	if (task.group == nullptr || !task.group->_background)
+		_num_pending++;
+
+	// Increment queue count before the task is queued, since a worker may pop and execute it right away (which decrements the count again)
+	// This is done under the signal lock, so that a worker cannot miss the notification between checking the count and going to sleep
+	{ const std::unique_lock<std::mutex> lock(_signal_mutex);
+		_num_queued++;
+	}
+
+	const size_t index = (s_current_scheduler == this) ? s_current_worker_index : _next_worker++ % _workers.size();
+	{ const std::unique_lock<std::mutex> lock(_workers[index]->mutex);
+		_workers[index]->tasks.push_back(std::move(task));
+	}
+
+	_work_available.notify_one();
+}
+
+void reshade::task_scheduler::wait(task_group &group)
+{
+	queued_task task;
+
+	while (group._num_pending != 0)
+	{
+		// Help executing the tasks of the group, rather than just blocking
+		if (pop_group_task(group, task))
+		{
+			execute(task);
+			continue;
+		}
+
+		// All remaining tasks of the group are currently executing on other threads, so wait for those to finish (or new ones to be queued)
+		std::unique_lock<std::mutex> lock(_signal_mutex);
+		_work_finished.wait(lock, [&group]() { return group._num_pending == 0 || group._num_queued != 0; });
+	}
+}
+void reshade::task_scheduler::wait_idle()
+{
+	assert(s_current_scheduler != this);
+
+	std::unique_lock<std::mutex> lock(_signal_mutex);
+	_work_finished.wait(lock, [this]() { return _num_pending == 0; });
+}
+
+void reshade::task_scheduler::start()
+{
+	_workers.reserve(_num_threads);
+	for (size_t i = 0; i < _num_threads; ++i)
+		_workers.push_back(std::make_unique<worker>());
+
+	// Only launch threads after all workers were created, since they may try to steal from each other immediately
+	for (size_t i = 0; i < _num_threads; ++i)
+		_workers[i]->thread = std::thread(&task_scheduler::worker_main, this, i);
+}
+
+void reshade::task_scheduler::worker_main(size_t index)
+{
+	s_current_scheduler = this;
+	s_current_worker_index = index;
+
+	queued_task task;
+
+	while (true)
+	{
+		if (pop_task(index, task))
+		{
+			execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_signal_mutex);
+		_work_available.wait(lock, [this]() { return _shutdown || _num_queued != 0; });
+
+		if (_shutdown && _num_queued == 0)
+			break;
+	}
+
+	s_current_scheduler = nullptr;
+}
+
+bool reshade::task_scheduler::pop_task(size_t index, queued_task &task)
+{
+	// Take the most recently added task from the own queue first, since its data is most likely still in cache
+	{ worker &self = *_workers[index];
+		const std::unique_lock<std::mutex> lock(self.mutex);
+		if (!self.tasks.empty())
+		{
+			task = std::move(self.tasks.back());
+			self.tasks.pop_back();
+			if (task.group != nullptr)
+				task.group->_num_queued--;
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest task from another worker
+	for (size_t offset = 1; offset < _workers.size(); ++offset)
+	{
+		worker &victim = *_workers[(index + offset) % _workers.size()];
+
+		const std::unique_lock<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			if (task.group != nullptr)
+				task.group->_num_queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+bool reshade::task_scheduler::pop_group_task(task_group &group, queued_task &task)
+{
+	if (group._num_queued == 0 || _workers.empty())
+		return false;
+
+	// Start with the queue of the calling worker, since that is where tasks submitted from within a task end up
+	const size_t start_index = (s_current_scheduler == this) ? s_current_worker_index : 0;
+
+	for (size_t offset = 0; offset < _workers.size(); ++offset)
+	{
+		worker &target = *_workers[(start_index + offset) % _workers.size()];
+
+		const std::unique_lock<std::mutex> lock(target.mutex);
+		for (auto it = target.tasks.rbegin(); it != target.tasks.rend(); ++it)
+		{
+			if (it->group != &group)
+				continue;
+
+			task = std::move(*it);
+			target.tasks.erase(std::next(it).base());
+			group._num_queued--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void reshade::task_scheduler::execute(queued_task &task)
+{
+	_num_queued--;
+
+	task.function();
+	task.function = nullptr; // Destroy any captured state before reporting the task as finished
+
+	const bool counted = task.group == nullptr || !task.group->_background;
+	const bool group_finished = task.group != nullptr && --task.group->_num_pending == 0;
+	task.group = nullptr;
+
+	if ((counted && --_num_pending == 0) || group_finished)
+	{
+		{ const std::unique_lock<std::mutex> lock(_signal_mutex); }
+		_work_finished.notify_all();
+	}
+}
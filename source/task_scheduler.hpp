@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#pragma once
+
+#include <deque>
+#include <cassert>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace reshade
+{
+	/// <summary>
+	/// A pool of worker threads that execute submitted tasks.
+	/// Every worker has its own task queue and idle workers steal tasks from the queues of busy ones, so that a single long running task does not hold up the tasks queued behind it.
+	/// </summary>
+	class task_scheduler
+	{
+	public:
+		/// <summary>
+		/// A set of tasks that can be waited on independently of all other tasks in the scheduler.
+		/// </summary>
+		class task_group
+		{
+		public:
+			/// <summary>
+			/// Creates a new task group.
+			/// </summary>
+			/// <param name="background">Set to <see langword="true"/> to keep tasks of this group out of <see cref="task_scheduler::wait_idle"/> and <see cref="task_scheduler::is_idle"/>, so that only <see cref="task_scheduler::wait"/> on the group itself blocks on them.</param>
+			explicit task_group(bool background = false) : _background(background) {}
+			~task_group() { assert(_num_pending == 0); }
+
+			task_group(const task_group &) = delete;
+			task_group &operator=(const task_group &) = delete;
+
+		private:
+			friend class task_scheduler;
+
+			const bool _background;
+			std::atomic<size_t> _num_queued = 0;
+			std::atomic<size_t> _num_pending = 0;
+		};
+
+		/// <summary>
+		/// Creates a new scheduler. Worker threads are only spawned once the first task is submitted.
+		/// </summary>
+		/// <param name="num_threads">Number of worker threads to use, or zero to use one less than the number of hardware threads (leaving one for the render thread).</param>
+		explicit task_scheduler(size_t num_threads = 0);
+		~task_scheduler();
+
+		task_scheduler(const task_scheduler &) = delete;
+		task_scheduler &operator=(const task_scheduler &) = delete;
+
+		/// <summary>
+		/// Gets the number of worker threads used by this scheduler.
+		/// </summary>
+		size_t num_threads() const { return _num_threads; }
+
+		/// <summary>
+		/// Gets a boolean indicating whether all submitted tasks (except for those of background groups) have finished executing.
+		/// </summary>
+		bool is_idle() const { return _num_pending == 0; }
+
+		/// <summary>
+		/// Queues a task for execution on one of the worker threads.
+		/// When called from within a task, the new task is added to the queue of the calling worker.
+		/// </summary>
+		void submit(std::function<void()> task);
+		/// <summary>
+		/// Queues a task that belongs to the specified <paramref name="group"/> for execution on one of the worker threads.
+		/// </summary>
+		void submit(task_group &group, std::function<void()> task);
+
+		/// <summary>
+		/// Blocks until all tasks of the specified <paramref name="group"/> have finished executing.
+		/// The calling thread executes queued tasks of the group itself while waiting, so this may be called from within a task without blocking a worker thread (or dead-locking if there is only one).
+		/// </summary>
+		void wait(task_group &group);
+
+		/// <summary>
+		/// Blocks until all submitted tasks (except for those of background groups) have finished executing.
+		/// Must not be called from within a task.
+		/// </summary>
+		void wait_idle();
+
+	private:
+		struct queued_task
+		{
+			std::function<void()> function;
+			task_group *group = nullptr;
+		};
+		struct worker
+		{
+			std::mutex mutex;
+			std::deque<queued_task> tasks;
+			std::thread thread;
+		};
+
+		void submit(queued_task &&task);
+
+		void start();
+		void worker_main(size_t index);
+		bool pop_task(size_t index, queued_task &task);
+		bool pop_group_task(task_group &group, queued_task &task);
+		void execute(queued_task &task);
+
+		const size_t _num_threads;
+		std::vector<std::unique_ptr<worker>> _workers;
+		std::once_flag _start_flag;
+		std::atomic<size_t> _next_worker = 0;
+		std::atomic<size_t> _num_queued = 0;
+		std::atomic<size_t> _num_pending = 0;
+		std::mutex _signal_mutex;
+		std::condition_variable _work_available;
+		std::condition_variable _work_finished;
+		bool _shutdown = false;
+	};
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+/// <summary>
+/// A two-level segregated fit (TLSF) allocator of contiguous ranges in an index space (like a range of descriptors in a descriptor heap), with constant time allocation and freeing.
+/// Free ranges are kept in lists segregated by size class (a power of two, subdivided into 16 linear steps), with bitmaps to find a non-empty list that is guaranteed to satisfy a request in constant time.
+/// Adjacent free ranges are merged immediately when freeing, using boundary tags stored at the first and last index of each free range.
+/// This is not thread-safe, so the caller has to synchronize access.
+/// </summary>
+class tlsf_allocator
+{
+	static constexpr uint32_t SL_LOG2 = 4;
+	static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+	static constexpr uint32_t FL_COUNT = 32 - SL_LOG2 + 1;
+	static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+public:
+	explicit tlsf_allocator(uint32_t capacity = 0)
+	{
+		reset(capacity);
+	}
+
+	/// <summary>
+	/// Frees all allocations and changes the size of the index space to the specified <paramref name="capacity"/>.
+	/// </summary>
+	void reset(uint32_t capacity)
+	{
+		_capacity = capacity;
+		_free_size = 0;
+
+		_fl_bitmap = 0;
+		for (uint32_t fl = 0; fl < FL_COUNT; ++fl)
+		{
+			_sl_bitmap[fl] = 0;
+			for (uint32_t sl = 0; sl < SL_COUNT; ++sl)
+				_heads[fl][sl] = NONE;
+		}
+
+		_size_at_beg.assign(capacity, 0);
+		_beg_at_end.assign(capacity, NONE);
+		_next.assign(capacity, NONE);
+		_prev.assign(capacity, NONE);
+
+		if (capacity != 0)
+			insert_free_range(0, capacity);
+	}
+
+	/// <summary>
+	/// Allocates a contiguous range of the specified number of indices.
+	/// </summary>
+	/// <param name="count">Number of indices to allocate.</param>
+	/// <param name="offset">Set to the first index of the allocated range.</param>
+	/// <returns><see langword="true"/> if the range was allocated, or <see langword="false"/> if there is no free range large enough.</returns>
+	bool allocate(uint32_t count, uint32_t &offset)
+	{
+		if (count == 0 || count > _free_size)
+			return false;
+
+		uint32_t beg = NONE;
+
+		// Round up to the next size class, so that every range in the first non-empty list at or above it is large enough
+		if (uint32_t fl, sl; mapping_search(count, fl, sl) && find_non_empty_list(fl, sl))
+		{
+			beg = _heads[fl][sl];
+		}
+		else
+		{
+			// Rounding up may have skipped a range in the size class of the request that is large enough, so look through that list before giving up (this only happens when close to full)
+			mapping_insert(count, fl, sl);
+			for (uint32_t it = _heads[fl][sl]; it != NONE; it = _next[it])
+			{
+				if (_size_at_beg[it] >= count)
+				{
+					beg = it;
+					break;
+				}
+			}
+		}
+
+		if (beg == NONE)
+			return false;
+
+		const uint32_t size = _size_at_beg[beg];
+		assert(size >= count);
+
+		remove_free_range(beg);
+		// Return the remainder to the free lists
+		if (size > count)
+			insert_free_range(beg + count, size - count);
+
+		offset = beg;
+		return true;
+	}
+
+	/// <summary>
+	/// Frees a range of indices that was previously allocated via <see cref="allocate"/>.
+	/// </summary>
+	/// <param name="offset">First index of the range.</param>
+	/// <param name="count">Number of indices in the range (has to match what was passed to <see cref="allocate"/>).</param>
+	void free(uint32_t offset, uint32_t count)
+	{
+		if (count == 0)
+			return;
+
+		assert(offset < _capacity && count <= _capacity - offset);
+		assert(_size_at_beg[offset] == 0); // Range was not allocated
+
+		uint32_t beg = offset;
+		uint32_t end = offset + count;
+
+		// Merge with the free ranges directly before and after
+		if (beg != 0 && _beg_at_end[beg - 1] != NONE)
+		{
+			const uint32_t prev_beg = _beg_at_end[beg - 1];
+			remove_free_range(prev_beg);
+			beg = prev_beg;
+		}
+		if (end != _capacity && _size_at_beg[end] != 0)
+		{
+			const uint32_t next_size = _size_at_beg[end];
+			remove_free_range(end);
+			end += next_size;
+		}
+
+		insert_free_range(beg, end - beg);
+	}
+
+	/// <summary>
+	/// Gets the total number of indices this allocator manages.
+	/// </summary>
+	uint32_t capacity() const { return _capacity; }
+	/// <summary>
+	/// Gets the total number of indices that are currently not allocated.
+	/// </summary>
+	uint32_t free_size() const { return _free_size; }
+
+	/// <summary>
+	/// Gets the size of the largest free range, which is the largest allocation that can currently succeed.
+	/// This walks the list of the largest non-empty size class, so is meant for statistics rather than to be called on every allocation.
+	/// </summary>
+	uint32_t largest_free_range() const
+	{
+		if (_fl_bitmap == 0)
+			return 0;
+
+		const uint32_t fl = index_of_highest_bit(_fl_bitmap);
+		const uint32_t sl = index_of_highest_bit(_sl_bitmap[fl]);
+
+		uint32_t largest = 0;
+		for (uint32_t it = _heads[fl][sl]; it != NONE; it = _next[it])
+			if (_size_at_beg[it] > largest)
+				largest = _size_at_beg[it];
+		return largest;
+	}
+	/// <summary>
+	/// Gets the fraction of free indices that are not part of the largest free range, from 0 (all free indices are contiguous) to 1 (heavily fragmented).
+	/// </summary>
+	float fragmentation() const
+	{
+		if (_free_size == 0)
+			return 0.0f;
+
+		return 1.0f - static_cast<float>(largest_free_range()) / static_cast<float>(_free_size);
+	}
+
+private:
+	static inline uint32_t index_of_lowest_bit(uint32_t mask)
+	{
+		assert(mask != 0);
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+	static inline uint32_t index_of_highest_bit(uint32_t mask)
+	{
+		assert(mask != 0);
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, mask);
+		return index;
+#else
+		return 31 - __builtin_clz(mask);
+#endif
+	}
+
+	static void mapping_insert(uint32_t size, uint32_t &fl, uint32_t &sl)
+	{
+		if (size < SL_COUNT)
+		{
+			// Small sizes map linearly into the first row
+			fl = 0;
+			sl = size;
+		}
+		else
+		{
+			const uint32_t msb = index_of_highest_bit(size);
+			fl = msb - SL_LOG2 + 1;
+			sl = (size >> (msb - SL_LOG2)) ^ SL_COUNT;
+		}
+	}
+	static bool mapping_search(uint32_t size, uint32_t &fl, uint32_t &sl)
+	{
+		if (size >= SL_COUNT)
+		{
+			const uint32_t round = (1u << (index_of_highest_bit(size) - SL_LOG2)) - 1;
+			if (size > 0xFFFFFFFF - round)
+				return false;
+			size += round;
+		}
+
+		mapping_insert(size, fl, sl);
+		return true;
+	}
+
+	bool find_non_empty_list(uint32_t &fl, uint32_t &sl) const
+	{
+		uint32_t sl_map = _sl_bitmap[fl] & (~0u << sl);
+		if (sl_map == 0)
+		{
+			const uint32_t fl_map = (fl + 1 < 32) ? _fl_bitmap & (~0u << (fl + 1)) : 0;
+			if (fl_map == 0)
+				return false;
+
+			fl = index_of_lowest_bit(fl_map);
+			sl_map = _sl_bitmap[fl];
+		}
+
+		sl = index_of_lowest_bit(sl_map);
+		return true;
+	}
+
+	void insert_free_range(uint32_t beg, uint32_t size)
+	{
+		assert(size != 0);
+
+		_size_at_beg[beg] = size;
+		_beg_at_end[beg + size - 1] = beg;
+		_free_size += size;
+
+		uint32_t fl, sl;
+		mapping_insert(size, fl, sl);
+
+		_prev[beg] = NONE;
+		_next[beg] = _heads[fl][sl];
+		if (_next[beg] != NONE)
+			_prev[_next[beg]] = beg;
+		_heads[fl][sl] = beg;
+
+		_fl_bitmap |= 1u << fl;
+		_sl_bitmap[fl] |= 1u << sl;
+	}
+	void remove_free_range(uint32_t beg)
+	{
+		const uint32_t size = _size_at_beg[beg];
+		assert(size != 0);
+
+		uint32_t fl, sl;
+		mapping_insert(size, fl, sl);
+
+		if (_prev[beg] != NONE)
+			_next[_prev[beg]] = _next[beg];
+		else
+			_heads[fl][sl] = _next[beg];
+		if (_next[beg] != NONE)
+			_prev[_next[beg]] = _prev[beg];
+
+		if (_heads[fl][sl] == NONE)
+		{
+			_sl_bitmap[fl] &= ~(1u << sl);
+			if (_sl_bitmap[fl] == 0)
+				_fl_bitmap &= ~(1u << fl);
+		}
+
+		// Clear boundary tags, so that the indices are no longer recognized as part of a free range
+		_size_at_beg[beg] = 0;
+		_beg_at_end[beg + size - 1] = NONE;
+		_free_size -= size;
+	}
+
+	uint32_t _capacity = 0;
+	uint32_t _free_size = 0;
+	uint32_t _fl_bitmap = 0;
+	uint32_t _sl_bitmap[FL_COUNT] = {};
+	uint32_t _heads[FL_COUNT][SL_COUNT] = {};
+	// Boundary tags of free ranges and links between free ranges in the same list, all indexed by the first (or last) index of a free range
+	std::vector<uint32_t> _size_at_beg;
+	std::vector<uint32_t> _beg_at_end;
+	std::vector<uint32_t> _next;
+	std::vector<uint32_t> _prev;
+};
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Looks up GPU virtual addresses in an index of buffer ranges, the way "device_impl::resolve_gpu_address" does, both for addresses inside buffers and ones that are not.
+// One large buffer is registered first, since that used to make every look up that misses walk all ranges after it.
+// Usage: address_range_map_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include "address_range_map.hpp"
+#include <random>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_ranges = quick ? 1000 : 100000;
+	const size_t num_lookups = quick ? 100000 : 1000000;
+
+	std::mt19937_64 rng(1);
+	address_range_map<size_t> map;
+
+	std::vector<std::pair<uint64_t, uint64_t>> ranges;
+	uint64_t address = 0x100000000;
+
+	// A large buffer at the start, followed by many small ones with gaps between them
+	ranges.emplace_back(address, 256 * 1024 * 1024);
+	address += ranges.back().second + 65536;
+	for (size_t i = 1; i < num_ranges; ++i)
+	{
+		ranges.emplace_back(address, ((rng() % 4096) + 1) * 256);
+		address += ranges.back().second + 65536;
+	}
+
+	reshade::test::timer timer;
+	for (size_t i = 0; i < ranges.size(); ++i)
+		map.insert(ranges[i].first, ranges[i].second, i);
+	const double insert_ms = timer.elapsed_ms();
+
+	std::vector<uint64_t> hits(num_lookups), misses(num_lookups);
+	for (size_t i = 0; i < num_lookups; ++i)
+	{
+		const auto &range = ranges[rng() % ranges.size()];
+		hits[i] = range.first + rng() % range.second;
+		misses[i] = range.first + range.second + rng() % 65536;
+	}
+
+	size_t num_found = 0;
+	size_t value = 0;
+	uint64_t offset = 0;
+
+	timer.reset();
+	for (const uint64_t hit : hits)
+		num_found += map.find(hit, &value, &offset);
+	const double hit_ms = timer.elapsed_ms();
+
+	CHECK(num_found == num_lookups);
+
+	num_found = 0;
+	timer.reset();
+	for (const uint64_t miss : misses)
+		num_found += map.find(miss, &value, &offset);
+	const double miss_ms = timer.elapsed_ms();
+
+	CHECK(num_found == 0);
+
+	timer.reset();
+	for (size_t i = 0; i < ranges.size(); ++i)
+		map.erase(ranges[i].first, i);
+	const double erase_ms = timer.elapsed_ms();
+
+	CHECK(map.size() == 0);
+
+	std::printf("%zu ranges: inserting %.2f ms, %zu look ups inside a range %.1f ms (%.0f ns each), outside %.1f ms (%.0f ns each), erasing %.2f ms\n",
+		num_ranges, insert_ms, num_lookups, hit_ms, hit_ms * 1e6 / num_lookups, miss_ms, miss_ms * 1e6 / num_lookups, erase_ms);
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test_utils.hpp"
+#include "address_range_map.hpp"
+#include <random>
+#include <vector>
+
+struct reference_range
+{
+	uint64_t start;
+	uint64_t size;
+	int value;
+};
+
+/// <summary>
+/// Finds the range containing an address by checking every range, picking the one with the highest start address (and the last inserted one of those) like <see cref="address_range_map::find"/>.
+/// </summary>
+static const reference_range *find_reference(const std::vector<reference_range> &ranges, uint64_t address)
+{
+	const reference_range *result = nullptr;
+	for (const reference_range &range : ranges)
+		if (address >= range.start && address - range.start < range.size && (result == nullptr || range.start >= result->start))
+			result = &range;
+	return result;
+}
+
+static void test_basic()
+{
+	address_range_map<int> map;
+
+	int value = 0;
+	uint64_t offset = 0, size = 0;
+	CHECK(!map.find(0x1000, &value, &offset));
+
+	map.insert(0x1000, 0x100, 1);
+	map.insert(0x2000, 0x200, 2);
+	CHECK(map.size() == 2);
+
+	CHECK(map.find(0x1000, &value, &offset, &size) && value == 1 && offset == 0 && size == 0x100);
+	CHECK(map.find(0x10FF, &value, &offset) && value == 1 && offset == 0xFF);
+	CHECK(!map.find(0x1100, &value, &offset));
+	CHECK(!map.find(0x0FFF, &value, &offset));
+	CHECK(map.find(0x2100, &value, &offset) && value == 2 && offset == 0x100);
+
+	CHECK(!map.erase(0x1000, 2));
+	CHECK(map.erase(0x1000, 1));
+	CHECK(!map.erase(0x1000, 1));
+	CHECK(!map.find(0x1000, &value, &offset));
+	CHECK(map.size() == 1);
+}
+
+static void test_large_range_removed()
+{
+	address_range_map<int> map;
+
+	// A large range covering many small ones
+	map.insert(0x0, 0x100000, 0);
+	for (int i = 1; i <= 100; ++i)
+		map.insert(i * 0x1000, 0x100, i);
+
+	int value = 0;
+	uint64_t offset = 0;
+	CHECK(map.find(0x5050, &value, &offset) && value == 5 && offset == 0x50);
+	CHECK(map.find(0x5800, &value, &offset) && value == 0 && offset == 0x5800);
+
+	// Once it is gone, addresses between the small ranges are not contained in anything anymore
+	CHECK(map.erase(0x0, 0));
+	CHECK(!map.find(0x5800, &value, &offset));
+	CHECK(map.find(0x5050, &value, &offset) && value == 5);
+}
+
+static void test_against_reference()
+{
+	std::mt19937_64 rng(42);
+	address_range_map<int> map;
+	std::vector<reference_range> ranges;
+
+	size_t num_mismatches = 0;
+	for (int i = 0; i < 20000; ++i)
+	{
+		switch (rng() % 4)
+		{
+		case 0:
+		{
+			// Mostly small ranges, with the occasional large one overlapping many others
+			const uint64_t start = (rng() % 4096) * 16;
+			const uint64_t size = (rng() % 32 == 0) ? (rng() % 16384) + 1 : (rng() % 256) + 1;
+			map.insert(start, size, i);
+			ranges.push_back({ start, size, i });
+			break;
+		}
+		case 1:
+			if (!ranges.empty())
+			{
+				const size_t index = rng() % ranges.size();
+				if (!map.erase(ranges[index].start, ranges[index].value))
+					num_mismatches++;
+				ranges.erase(ranges.begin() + index);
+			}
+			break;
+		default:
+		{
+			const uint64_t address = rng() % (4096 * 16 + 16384);
+
+			int value = -1;
+			uint64_t offset = 0, size = 0;
+			const bool found = map.find(address, &value, &offset, &size);
+
+			// Ranges with the same start address may be returned in any order, so only compare the start of the found range
+			const reference_range *const expected = find_reference(ranges, address);
+			if (found != (expected != nullptr) || (found && (address - offset != expected->start || offset >= size)))
+				num_mismatches++;
+			break;
+		}
+		}
+	}
+
+	CHECK(num_mismatches == 0);
+	CHECK(map.size() == ranges.size());
+}
+
+int main()
+{
+	test_basic();
+	test_large_range_removed();
+	test_against_reference();
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Allocates and frees slots of "bitmap_allocator" from multiple threads at once, while pools are added on demand the way "descriptor_heap_cpu" does, and checks that no slot is ever handed out twice.
+
+#include "test_utils.hpp"
+#include "bitmap_allocator.hpp"
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t pool_size = 64;
+
+static void test_single_threaded()
+{
+	bitmap_allocator<pool_size> allocator;
+
+	uint32_t pool = 0, index = 0;
+	CHECK(allocator.num_pools() == 0 && !allocator.allocate(pool, index));
+
+	// Add enough pools to span several chunks of the pool table
+	for (uint32_t i = 0; i < 100; ++i)
+		CHECK(allocator.add_pool(1000 + i) == i);
+	CHECK(allocator.num_pools() == 100);
+
+	size_t num_errors = 0;
+
+	std::vector<bool> used(100 * pool_size);
+	for (size_t i = 0; i < used.size(); ++i)
+	{
+		if (!allocator.allocate(pool, index) || pool >= 100 || index >= pool_size || used[pool * pool_size + index])
+			num_errors++;
+		else
+			used[pool * pool_size + index] = true;
+	}
+
+	CHECK(num_errors == 0);
+	CHECK(!allocator.allocate(pool, index));
+
+	for (uint32_t i = 0; i < 100; ++i)
+		if (allocator.get_user_data(i) != 1000 + i)
+			num_errors++;
+
+	CHECK(num_errors == 0);
+
+	// Freed slots have to be allocated again, no matter in which pool they are
+	allocator.free(3, 17);
+	allocator.free(99, 63);
+	CHECK(allocator.allocate(pool, index) && pool == 99 && index == 63);
+	CHECK(allocator.allocate(pool, index) && pool == 3 && index == 17);
+	CHECK(!allocator.allocate(pool, index));
+}
+
+static void test_multi_threaded()
+{
+	const uint32_t max_pools = 300;
+	const uint32_t num_threads = 4;
+
+	bitmap_allocator<pool_size> allocator;
+	std::mutex pool_mutex;
+
+	// Owner of every slot (zero if free), to find slots that are handed out to more than one thread
+	std::vector<std::atomic<uint32_t>> owners(max_pools * pool_size);
+	for (std::atomic<uint32_t> &owner : owners)
+		owner.store(0, std::memory_order_relaxed);
+
+	std::atomic<size_t> num_duplicates = 0, num_bad_slots = 0, num_failed_allocations = 0;
+
+	std::vector<std::thread> threads;
+	for (uint32_t t = 1; t <= num_threads; ++t)
+	{
+		threads.emplace_back([&, t]() {
+			std::mt19937 rng(t);
+			std::vector<uint32_t> allocated;
+
+			for (uint32_t i = 0; i < 200000; ++i)
+			{
+				// Grow while allocating, so that the number of live slots keeps exceeding the pools that exist
+				if (rng() % 100 < (i < 100000 ? 60u : 40u) || allocated.empty())
+				{
+					uint32_t pool = 0, index = 0;
+					bool full = false;
+					for (uint32_t num_pools = allocator.num_pools(); !full && !allocator.allocate(pool, index); num_pools = allocator.num_pools())
+					{
+						// Add a pool while the other threads keep allocating from the existing ones (unless another thread already added one)
+						const std::unique_lock<std::mutex> lock(pool_mutex);
+
+						if (num_pools >= max_pools)
+							full = true;
+						else if (allocator.num_pools() == num_pools)
+							allocator.add_pool(num_pools);
+					}
+
+					if (full)
+						continue;
+
+					if (pool >= allocator.num_pools() || index >= pool_size || allocator.get_user_data(pool) != pool)
+					{
+						num_failed_allocations++;
+						continue;
+					}
+
+					const uint32_t slot = pool * pool_size + index;
+					if (uint32_t expected = 0; !owners[slot].compare_exchange_strong(expected, t))
+					{
+						num_duplicates++;
+						continue;
+					}
+
+					allocated.push_back(slot);
+				}
+				else
+				{
+					const size_t k = rng() % allocated.size();
+					const uint32_t slot = allocated[k];
+					allocated[k] = allocated.back();
+					allocated.pop_back();
+
+					if (owners[slot].exchange(0) != t)
+						num_bad_slots++;
+
+					allocator.free(slot / pool_size, slot % pool_size);
+				}
+			}
+
+			for (const uint32_t slot : allocated)
+			{
+				owners[slot] = 0;
+				allocator.free(slot / pool_size, slot % pool_size);
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	CHECK(num_duplicates == 0);
+	CHECK(num_bad_slots == 0);
+	CHECK(num_failed_allocations == 0);
+	CHECK(allocator.num_pools() > 1 && allocator.num_pools() <= max_pools);
+
+	// Every slot was freed again, so all of them have to be allocatable once more
+	const uint32_t num_slots = allocator.num_pools() * pool_size;
+	std::vector<bool> used(num_slots);
+	size_t num_errors = 0;
+	for (uint32_t i = 0; i < num_slots; ++i)
+	{
+		uint32_t pool = 0, index = 0;
+		if (!allocator.allocate(pool, index) || used[pool * pool_size + index])
+			num_errors++;
+		else
+			used[pool * pool_size + index] = true;
+	}
+
+	CHECK(num_errors == 0);
+
+	std::printf("%u threads allocated and freed concurrently across %u pools\n", num_threads, allocator.num_pools());
+}
+
+int main()
+{
+	test_single_threaded();
+	test_multi_threaded();
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Looks up and updates resource view information from multiple threads at once, the way the D3D12 device does for every descriptor an application creates, copies or binds.
+// Compares "concurrent_flat_map" with a hash map guarded by a shared mutex, which is what the device used before.
+// Usage: concurrent_flat_map_benchmark [--quick] [<number of threads>]
+
+#include "test_utils.hpp"
+#include "concurrent_flat_map.hpp"
+#include <random>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <shared_mutex>
+#include <unordered_map>
+
+/// <summary>
+/// Stands in for "device_impl::view_info", which is a resource handle and a resource view description.
+/// </summary>
+struct view_info
+{
+	uint64_t resource;
+	uint32_t type, format;
+	uint64_t first_level, levels, first_layer;
+	uint32_t layers;
+};
+
+class locked_map
+{
+public:
+	bool find(uint64_t key, view_info &value) const
+	{
+		const std::shared_lock<std::shared_mutex> lock(_mutex);
+		const auto it = _map.find(key);
+		if (it == _map.end())
+			return false;
+		value = it->second;
+		return true;
+	}
+
+	void insert_or_assign(uint64_t key, const view_info &value)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_mutex);
+		_map.insert_or_assign(key, value);
+	}
+
+	bool erase(uint64_t key)
+	{
+		const std::unique_lock<std::shared_mutex> lock(_mutex);
+		return _map.erase(key) != 0;
+	}
+
+private:
+	mutable std::shared_mutex _mutex;
+	std::unordered_map<uint64_t, view_info> _map;
+};
+
+static view_info make_view_info(uint64_t index)
+{
+	return { index + 1, 1, 28, index, 1, 0, 1 };
+}
+
+/// <summary>
+/// Runs a mix of 90% look ups and 10% updates (half of which remove a view, like "destroy_resource_view") on the specified number of threads.
+/// </summary>
+template <typename TMap>
+static double run(size_t num_threads, size_t num_ops_per_thread, size_t num_views, size_t &num_inconsistent)
+{
+	TMap map;
+	for (uint64_t i = 0; i < num_views; ++i)
+		map.insert_or_assign(0x100000 + i * 32, make_view_info(i));
+
+	std::atomic<size_t> inconsistent = 0;
+
+	reshade::test::timer timer;
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([&map, &inconsistent, t, num_ops_per_thread, num_views]() {
+			std::mt19937_64 rng(t);
+			for (size_t i = 0; i < num_ops_per_thread; ++i)
+			{
+				// Descriptor handles are addresses with a fixed stride
+				const uint64_t index = rng() % (num_views * 2);
+				const uint64_t key = 0x100000 + index * 32;
+
+				if (i % 20 == 0)
+					map.insert_or_assign(key, make_view_info(index));
+				else if (i % 20 == 10)
+					map.erase(key);
+				else if (view_info info; map.find(key, info) && (info.resource != index + 1 || info.first_level != index))
+					inconsistent++;
+			}
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+
+	num_inconsistent = inconsistent;
+	return timer.elapsed_ms();
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_views = quick ? 10000 : 200000;
+	const size_t num_ops_per_thread = quick ? 100000 : 2000000;
+
+	size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+	if (argc > 1 && argv[argc - 1][0] != '-')
+		max_threads = std::stoul(argv[argc - 1]);
+
+	for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+	{
+		size_t locked_inconsistent = 0, concurrent_inconsistent = 0;
+		const double locked_ms = run<locked_map>(num_threads, num_ops_per_thread, num_views, locked_inconsistent);
+		const double concurrent_ms = run<concurrent_flat_map<uint64_t, view_info>>(num_threads, num_ops_per_thread, num_views, concurrent_inconsistent);
+
+		CHECK(locked_inconsistent == 0);
+		CHECK(concurrent_inconsistent == 0);
+
+		const double num_ops = static_cast<double>(num_threads * num_ops_per_thread);
+		std::printf("%zu thread(s), %zu operations each: shared mutex %.1f ms (%.0f ns per operation), concurrent flat map %.1f ms (%.0f ns per operation)\n",
+			num_threads, num_ops_per_thread, locked_ms, locked_ms * 1e6 / num_ops, concurrent_ms, concurrent_ms * 1e6 / num_ops);
+	}
+
+	return reshade::test::finish();
+}
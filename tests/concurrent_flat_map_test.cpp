@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test_utils.hpp"
+#include "concurrent_flat_map.hpp"
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+
+/// <summary>
+/// A value larger than a single word (like the view information the D3D12 device keeps per descriptor), which stores its key so that readers can tell whether they got the value of a different key.
+/// </summary>
+struct test_value
+{
+	uint64_t key;
+	uint64_t data[4];
+};
+
+static test_value make_value(uint64_t key, uint64_t version)
+{
+	return { key, { version, key * 3, version ^ key, ~key } };
+}
+static bool is_consistent(const test_value &value, uint64_t key)
+{
+	return value.key == key && value.data[1] == key * 3 && value.data[2] == (value.data[0] ^ key) && value.data[3] == ~key;
+}
+
+static void test_against_reference()
+{
+	std::mt19937_64 rng(1);
+	concurrent_flat_map<uint64_t, test_value> map;
+	std::unordered_map<uint64_t, test_value> reference;
+
+	size_t num_mismatches = 0;
+	for (uint64_t i = 0; i < 1000000; ++i)
+	{
+		const uint64_t key = 0x10000 + (rng() % 50000) * 32;
+
+		switch (rng() % 10)
+		{
+		case 0:
+		case 1:
+		case 2:
+		case 3:
+			map.insert_or_assign(key, make_value(key, i));
+			reference[key] = make_value(key, i);
+			break;
+		case 4:
+		case 5:
+		{
+			test_value value = {};
+			const bool erased = map.erase(key, value);
+			const auto it = reference.find(key);
+			if (erased != (it != reference.end()) || (erased && value.data[0] != it->second.data[0]))
+				num_mismatches++;
+			if (it != reference.end())
+				reference.erase(it);
+			break;
+		}
+		default:
+		{
+			test_value value = {};
+			const bool found = map.find(key, value);
+			const auto it = reference.find(key);
+			if (found != (it != reference.end()) || (found && value.data[0] != it->second.data[0]))
+				num_mismatches++;
+			break;
+		}
+		}
+	}
+
+	CHECK(num_mismatches == 0);
+}
+
+static void test_churn()
+{
+	concurrent_flat_map<uint64_t, test_value> map;
+
+	// Keep adding new keys and removing old ones, so that the number of live keys stays the same while removed entries pile up and have to be reused or dropped
+	size_t num_mismatches = 0;
+	for (uint64_t key = 1; key <= 2000000; ++key)
+	{
+		map.insert_or_assign(key * 64, make_value(key * 64, key));
+		if (key > 1000 && !map.erase((key - 1000) * 64))
+			num_mismatches++;
+	}
+
+	test_value value = {};
+	for (uint64_t key = 2000000 - 999; key <= 2000000; ++key)
+		if (!map.find(key * 64, value) || !is_consistent(value, key * 64))
+			num_mismatches++;
+	CHECK(!map.find(64, value));
+
+	CHECK(num_mismatches == 0);
+}
+
+static void test_concurrent_reuse()
+{
+	concurrent_flat_map<uint64_t, test_value> map;
+
+	const uint64_t num_keys = 4096;
+	std::atomic<bool> stop = false;
+	std::atomic<size_t> num_inconsistent = 0;
+
+	// Readers look up keys while writers remove and add keys, so that entries of removed keys are reused for other keys and tables are replaced
+	std::vector<std::thread> readers;
+	for (uint32_t t = 0; t < 3; ++t)
+	{
+		readers.emplace_back([&map, &stop, &num_inconsistent, t]() {
+			std::mt19937_64 rng(t);
+			while (!stop.load(std::memory_order_relaxed))
+			{
+				const uint64_t key = 32 + (rng() % (num_keys * 4)) * 32;
+				if (test_value value; map.find(key, value) && !is_consistent(value, key))
+					num_inconsistent++;
+			}
+		});
+	}
+
+	std::thread writer([&map, &stop]() {
+		std::mt19937_64 rng(42);
+		for (uint64_t i = 0; i < 2000000; ++i)
+		{
+			const uint64_t key = 32 + (rng() % (num_keys * 4)) * 32;
+			if (rng() % 2)
+				map.insert_or_assign(key, make_value(key, i));
+			else
+				map.erase(key);
+		}
+		stop = true;
+	});
+
+	writer.join();
+	for (std::thread &thread : readers)
+		thread.join();
+
+	CHECK(num_inconsistent == 0);
+}
+
+int main()
+{
+	test_against_reference();
+	test_churn();
+	test_concurrent_reuse();
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Converts GPU descriptor handles back to the descriptor heap containing them, the way "device_impl::convert_to_descriptor_set" does for every descriptor table bound.
+// Compares walking all heaps (which is what it did before) with looking them up in the address range index it uses now.
+// Usage: descriptor_heap_lookup_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include "address_range_map.hpp"
+#include <memory>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+/// <summary>
+/// Stands in for a shader visible "ID3D12DescriptorHeap".
+/// </summary>
+struct descriptor_heap
+{
+	descriptor_heap(uint64_t base_gpu_handle, uint32_t num_descriptors) : base_gpu_handle(base_gpu_handle), num_descriptors(num_descriptors) {}
+	virtual ~descriptor_heap() {}
+
+	uint64_t base_gpu_handle;
+	uint32_t num_descriptors;
+
+	// Querying the heap description goes through a COM call, which cannot be inlined
+	virtual uint32_t get_num_descriptors() const { return num_descriptors; }
+};
+
+static const uint32_t descriptor_handle_size = 32;
+
+static const descriptor_heap *find_heap_linear(const std::vector<descriptor_heap *> &heaps, uint64_t handle, uint64_t &offset)
+{
+	for (const descriptor_heap *heap : heaps)
+	{
+		if (handle >= heap->base_gpu_handle && handle < heap->base_gpu_handle + static_cast<uint64_t>(heap->get_num_descriptors()) * descriptor_handle_size)
+		{
+			offset = handle - heap->base_gpu_handle;
+			return heap;
+		}
+	}
+	return nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_heaps = quick ? 100 : 500;
+	const size_t num_conversions = quick ? 100000 : 1000000;
+
+	std::mt19937_64 rng(1);
+
+	// Applications mostly create a few large heaps and many small ones, with the driver placing them at arbitrary addresses
+	std::vector<std::unique_ptr<descriptor_heap>> storage;
+	std::vector<descriptor_heap *> heaps;
+	uint64_t address = 0x200000000;
+	for (size_t i = 0; i < num_heaps; ++i)
+	{
+		const uint32_t num_descriptors = (i % 50 == 0) ? 1000000 : static_cast<uint32_t>(rng() % 2048) + 16;
+		storage.push_back(std::make_unique<descriptor_heap>(address, num_descriptors));
+		address += static_cast<uint64_t>(num_descriptors) * descriptor_handle_size + (rng() % 16 + 1) * 65536;
+	}
+	// Heaps are registered in creation order, which is not the order of their addresses
+	for (const std::unique_ptr<descriptor_heap> &heap : storage)
+		heaps.push_back(heap.get());
+	std::shuffle(heaps.begin(), heaps.end(), rng);
+
+	address_range_map<const descriptor_heap *> heap_ranges;
+	for (const descriptor_heap *heap : heaps)
+		heap_ranges.insert(heap->base_gpu_handle, static_cast<uint64_t>(heap->num_descriptors) * descriptor_handle_size, heap);
+
+	// Descriptor tables are bound at random offsets into random heaps
+	std::vector<uint64_t> handles(num_conversions);
+	for (uint64_t &handle : handles)
+	{
+		const descriptor_heap *const heap = heaps[rng() % heaps.size()];
+		handle = heap->base_gpu_handle + (rng() % heap->num_descriptors) * descriptor_handle_size;
+	}
+
+	std::vector<std::pair<const descriptor_heap *, uint64_t>> linear_results(num_conversions), indexed_results(num_conversions);
+
+	reshade::test::timer timer;
+	for (size_t i = 0; i < num_conversions; ++i)
+		linear_results[i].first = find_heap_linear(heaps, handles[i], linear_results[i].second);
+	const double linear_ms = timer.elapsed_ms();
+
+	timer.reset();
+	for (size_t i = 0; i < num_conversions; ++i)
+		heap_ranges.find(handles[i], &indexed_results[i].first, &indexed_results[i].second);
+	const double indexed_ms = timer.elapsed_ms();
+
+	size_t num_mismatches = 0;
+	for (size_t i = 0; i < num_conversions; ++i)
+		if (linear_results[i].first == nullptr || linear_results[i] != indexed_results[i])
+			num_mismatches++;
+	CHECK(num_mismatches == 0);
+
+	std::printf("%zu handle conversions over %zu heaps: walking all heaps %.1f ms (%.0f ns each), address range index %.1f ms (%.0f ns each)\n",
+		num_conversions, num_heaps, linear_ms, linear_ms * 1e6 / num_conversions, indexed_ms, indexed_ms * 1e6 / num_conversions);
+
+	return reshade::test::finish();
+}
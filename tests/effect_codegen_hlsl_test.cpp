@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Checks that the HLSL code built for an entry point only contains the declarations it uses, while every line of it is still at the same line as in the whole module.
+
+#include "test_utils.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Two pixel shaders share a helper function (and the structure it uses), while another function, structure and sampler are not referenced by any entry point
+static const char s_effect_source[] = R"(
+struct Unused { float4 a; };
+struct Used { float4 b; };
+texture TexA { Width = 4; Height = 4; };
+texture TexB { Width = 4; Height = 4; };
+sampler SamplerA { Texture = TexA; };
+sampler SamplerB { Texture = TexB; };
+float4 Shared(float4 v) { Used u; u.b = v; return u.b * 2; }
+float4 NotReferenced(float4 v) { Unused u; u.a = tex2D(SamplerB, v.xy); return u.a; }
+void VS(uint id : SV_VertexID, out float4 pos : SV_Position) { pos = float4(id, 0, 0, 1); }
+float4 PS1(float4 pos : SV_Position) : SV_Target { return Shared(tex2D(SamplerA, pos.xy)); }
+float4 PS2(float4 pos : SV_Position) : SV_Target { return Shared(pos); }
+technique T { pass { VertexShader = VS; PixelShader = PS1; } pass { VertexShader = VS; PixelShader = PS2; } }
+)";
+
+static bool compile(bool debug_info, reshadefx::module &module)
+{
+	const std::unique_ptr<reshadefx::codegen> backend(reshadefx::create_codegen_hlsl(50, debug_info, false));
+
+	reshadefx::parser parser;
+	if (!parser.parse(s_effect_source, backend.get()))
+		return std::fprintf(stderr, "%s", parser.errors().c_str()), false;
+
+	backend->write_result(module);
+	return true;
+}
+
+static std::vector<std::string> split_lines(const std::string &code)
+{
+	std::vector<std::string> lines(1);
+	for (const char c : code)
+		if (c == '\n')
+			lines.emplace_back();
+		else
+			lines.back() += c;
+	return lines;
+}
+
+static const reshadefx::entry_point *find_entry_point(const reshadefx::module &module, const std::string &name)
+{
+	for (const reshadefx::entry_point &entry_point : module.entry_points)
+		if (entry_point.name == name)
+			return &entry_point;
+	return nullptr;
+}
+
+/// <summary>
+/// Checks that the code of every entry point has the same number of lines as the module and that each line in it is either empty or the same line of the module.
+/// </summary>
+static void test_line_numbers(bool debug_info)
+{
+	reshadefx::module module;
+	const bool success = compile(debug_info, module);
+	CHECK(success);
+	if (!success)
+		return;
+
+	CHECK(module.entry_points.size() == 3);
+
+	const std::vector<std::string> module_lines = split_lines(module.hlsl);
+
+	size_t num_mismatches = 0;
+
+	for (const reshadefx::entry_point &entry_point : module.entry_points)
+	{
+		// Every entry point leaves out at least one declaration
+		CHECK(!entry_point.hlsl_ranges.empty());
+
+		const std::string code = reshadefx::get_entry_point_hlsl(module, entry_point);
+		CHECK(code.size() < module.hlsl.size());
+
+		const std::vector<std::string> lines = split_lines(code);
+		if (lines.size() != module_lines.size())
+		{
+			num_mismatches++;
+			continue;
+		}
+
+		for (size_t i = 0; i < lines.size(); ++i)
+			if (!lines[i].empty() && lines[i] != module_lines[i])
+				num_mismatches++;
+	}
+
+	CHECK(num_mismatches == 0);
+}
+
+/// <summary>
+/// Checks which declarations end up in the code of each entry point (using debug names, so that they can be found in the code).
+/// </summary>
+static void test_stripped_declarations()
+{
+	reshadefx::module module;
+	const bool success = compile(true, module);
+	CHECK(success);
+	if (!success)
+		return;
+
+	const reshadefx::entry_point *const ps1 = find_entry_point(module, "F__PS1");
+	const reshadefx::entry_point *const ps2 = find_entry_point(module, "F__PS2");
+	CHECK(ps1 != nullptr && ps2 != nullptr);
+	if (ps1 == nullptr || ps2 == nullptr)
+		return;
+
+	const std::string ps1_code = reshadefx::get_entry_point_hlsl(module, *ps1);
+	const std::string ps2_code = reshadefx::get_entry_point_hlsl(module, *ps2);
+
+	const auto contains = [](const std::string &code, const char *name) {
+		return code.find(name) != std::string::npos;
+	};
+
+	// The whole module has everything
+	CHECK(contains(module.hlsl, "F__NotReferenced") && contains(module.hlsl, "S__Unused") && contains(module.hlsl, "V__SamplerB"));
+
+	// Both pixel shaders keep the helper they share and the structure it uses
+	CHECK(contains(ps1_code, "float4 F__Shared(") && contains(ps1_code, "struct S__Used"));
+	CHECK(contains(ps2_code, "float4 F__Shared(") && contains(ps2_code, "struct S__Used"));
+
+	// Neither has the unreferenced function, structure or sampler (or its texture)
+	for (const std::string *code : { &ps1_code, &ps2_code })
+	{
+		CHECK(!contains(*code, "F__NotReferenced"));
+		CHECK(!contains(*code, "S__Unused"));
+		CHECK(!contains(*code, "V__SamplerB"));
+		CHECK(!contains(*code, "__V__TexB"));
+	}
+
+	// Only the first pixel shader samples a texture, and neither has the other one
+	CHECK(contains(ps1_code, "V__SamplerA") && !contains(ps2_code, "V__SamplerA"));
+	CHECK(!contains(ps1_code, "F__PS2") && !contains(ps2_code, "F__PS1"));
+}
+
+int main()
+{
+	test_line_numbers(true);
+	test_line_numbers(false);
+	test_stripped_declarations();
+
+	return reshade::test::finish();
+}
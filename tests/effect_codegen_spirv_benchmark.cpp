@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Generates SPIR-V for synthetic effects of increasing size, which use many distinct constants, types and function signatures, to show how code generation time scales with the number of expressions.
+// Usage: effect_codegen_spirv_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <memory>
+#include <string>
+#include <iterator>
+
+static std::string generate_effect(size_t num_expressions)
+{
+	static const char *const parameter_types[] = { "float", "float2", "float3", "float4", "int", "int2", "uint3", "bool4" };
+	const size_t num_statements_per_function = 50;
+
+	std::string source = "texture BackBufferTex : COLOR;\nsampler BackBuffer { Texture = BackBufferTex; };\n\n";
+
+	size_t num_functions = 0;
+	for (size_t e = 0; e < num_expressions; ++num_functions)
+	{
+		const std::string n = std::to_string(num_functions);
+		const char *const parameter_type = parameter_types[num_functions % std::size(parameter_types)];
+
+		// Every function takes an array of a different size, so that they all have distinct signatures and types
+		source += "float4 Function" + n + "(float4 a, " + parameter_type + " b, float c[" + std::to_string(num_functions % 64 + 1) + "])\n{\n";
+		for (size_t s = 0; s < num_statements_per_function && e < num_expressions; ++s, ++e)
+		{
+			// Every expression uses a few new constants
+			const std::string x = std::to_string(e) + ".25", y = std::to_string(e % 1000) + ".5";
+			source += "\ta = a * float4(" + x + ", " + y + ", c[0], 1.0) + float4(b.x, " + std::to_string(e) + ", " + std::to_string(e) + "u, 0.0);\n";
+		}
+		source += "\treturn a;\n}\n\n";
+	}
+
+	source += "float4 MainPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target\n{\n\tfloat4 color = tex2D(BackBuffer, uv);\n";
+	for (size_t f = 0; f < num_functions; ++f)
+	{
+		const char *const parameter_type = parameter_types[f % std::size(parameter_types)];
+		source += "\t{ float c[" + std::to_string(f % 64 + 1) + "]; c[0] = uv.y; color = Function" + std::to_string(f) + "(color, (" + parameter_type + ")uv.x, c); }\n";
+	}
+	source += "\treturn color;\n}\n\n";
+
+	source += "void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)\n{\n";
+	source += "\ttexcoord.x = (id == 2) ? 2.0 : 0.0;\n\ttexcoord.y = (id == 1) ? 2.0 : 0.0;\n\tposition = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);\n}\n\n";
+	source += "technique Generated\n{\n\tpass\n\t{\n\t\tVertexShader = PostProcessVS;\n\t\tPixelShader = MainPS;\n\t}\n}\n";
+	return source;
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+
+	double first_ms_per_expression = 0.0;
+
+	for (const size_t num_expressions : quick ? std::vector<size_t> { 200, 400 } : std::vector<size_t> { 2000, 4000, 8000, 10000 })
+	{
+		const std::string source = generate_effect(num_expressions);
+
+		reshade::test::timer timer;
+
+		const std::unique_ptr<reshadefx::codegen> backend(reshadefx::create_codegen_spirv(true, false, false));
+
+		reshadefx::parser parser;
+		const bool success = parser.parse(source, backend.get());
+		CHECK(success);
+		if (!success)
+			std::fprintf(stderr, "%s", parser.errors().c_str());
+
+		reshadefx::module module;
+		backend->write_result(module);
+		CHECK(module.spirv.size() > num_expressions);
+
+		const double elapsed_ms = timer.elapsed_ms();
+		const double ms_per_expression = elapsed_ms / num_expressions;
+		if (first_ms_per_expression == 0.0)
+			first_ms_per_expression = ms_per_expression;
+
+		// Linear scaling means that the time per expression stays about the same as the effect grows
+		std::printf("%5zu expressions: %7.1f ms (%.4f ms per expression, %.2fx that of the smallest effect), %zu bytes of SPIR-V\n",
+			num_expressions, elapsed_ms, ms_per_expression, ms_per_expression / first_ms_per_expression, module.spirv.size() * sizeof(uint32_t));
+	}
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Checks that calls to intrinsics with constant arguments are evaluated at compile time and produce the right values.
+// Every call is used as the initializer of a uniform variable, whose initializer value ends up in the module only if it is a constant.
+
+#include "test_utils.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct folding_case
+{
+	const char *type;
+	const char *expression;
+	std::vector<double> expected; // Matrices in row-major order, booleans as 0 or 1, integers as their value (or two's complement bit pattern)
+};
+
+static const double pi = 3.14159265358979323846;
+
+static const folding_case s_cases[] = {
+	{ "int", "abs(-3)", { 3 } },
+	{ "float2", "abs(float2(-1.5, 2))", { 1.5, 2 } },
+	{ "bool", "all(bool3(true, false, true))", { 0 } },
+	{ "bool", "all(bool2(true, true))", { 1 } },
+	{ "bool", "any(bool3(false, false, true))", { 1 } },
+	{ "bool", "any(false)", { 0 } },
+	{ "float", "asin(0.5)", { pi / 6 } },
+	{ "float", "acos(0.5)", { pi / 3 } },
+	{ "float", "atan(1.0)", { pi / 4 } },
+	{ "float", "atan2(1.0, -1.0)", { 3 * pi / 4 } },
+	{ "float", "sin(1.0)", { 0.8414709848078965 } },
+	{ "float", "sinh(1.0)", { 1.1752011936438014 } },
+	{ "float", "cos(1.0)", { 0.5403023058681398 } },
+	{ "float", "cosh(1.0)", { 1.5430806348152437 } },
+	{ "float", "tan(1.0)", { 1.5574077246549023 } },
+	{ "float", "tanh(1.0)", { 0.7615941559557649 } },
+	{ "int", "asint(1.0)", { 0x3f800000 } },
+	{ "uint", "asuint(-2.0)", { 0xc0000000 } },
+	{ "float", "asfloat(0x40400000)", { 3 } },
+	{ "float", "asfloat(int(0x3f000000))", { 0.5 } },
+	{ "uint", "firstbitlow(12u)", { 2 } },
+	{ "uint", "firstbitlow(0u)", { 0xFFFFFFFF } },
+	{ "uint", "firstbithigh(12u)", { 3 } },
+	{ "int", "firstbithigh(-1)", { -1 } },
+	{ "int", "firstbithigh(-8)", { 2 } },
+	{ "int", "firstbithigh(5)", { 2 } },
+	{ "uint", "countbits(0xF0F0u)", { 8 } },
+	{ "uint", "reversebits(1u)", { 0x80000000 } },
+	{ "float", "ceil(1.2)", { 2 } },
+	{ "float", "floor(-1.2)", { -2 } },
+	{ "int", "clamp(7, 0, 4)", { 4 } },
+	{ "uint", "clamp(2u, 3u, 5u)", { 3 } },
+	{ "float2", "clamp(float2(-1, 0.5), 0.0, 1.0)", { 0, 0.5 } },
+	{ "float3", "saturate(float3(-1, 0.25, 3))", { 0, 0.25, 1 } },
+	{ "float", "mad(2.0, 3.0, 1.0)", { 7 } },
+	{ "float", "rcp(4.0)", { 0.25 } },
+	{ "float", "pow(2.0, 10.0)", { 1024 } },
+	{ "float", "exp(1.0)", { 2.718281828459045 } },
+	{ "float", "exp2(3.5)", { 11.313708498984761 } },
+	{ "float", "log(10.0)", { 2.302585092994046 } },
+	{ "float", "log2(8.0)", { 3 } },
+	{ "float", "log10(1000.0)", { 3 } },
+	{ "int", "sign(-5)", { -1 } },
+	{ "float3", "sign(float3(-2, 0, 3))", { -1, 0, 1 } },
+	{ "float", "sqrt(2.0)", { 1.4142135623730951 } },
+	{ "float", "rsqrt(4.0)", { 0.5 } },
+	{ "float", "lerp(2.0, 4.0, 0.25)", { 2.5 } },
+	{ "float2", "step(0.5, float2(0.4, 0.6))", { 0, 1 } },
+	{ "float", "smoothstep(0.0, 2.0, 0.5)", { 0.15625 } },
+	{ "float", "frac(-1.25)", { 0.75 } },
+	{ "float", "ldexp(1.5, 3)", { 12 } },
+	{ "float", "trunc(-1.7)", { -1 } },
+	{ "float4", "round(float4(0.5, 1.5, 2.5, -0.5))", { 0, 2, 2, 0 } },
+	{ "int", "min(3, -2)", { -2 } },
+	{ "float", "min(1.5, 2.5)", { 1.5 } },
+	{ "int", "max(3, -2)", { 3 } },
+	{ "float2", "max(float2(1, 5), float2(2, 4))", { 2, 5 } },
+	{ "float", "degrees(3.14159265)", { 180 } },
+	{ "float", "radians(180.0)", { pi } },
+	{ "float", "dot(float3(1, 2, 3), float3(4, 5, 6))", { 32 } },
+	{ "float3", "cross(float3(1, 0, 0), float3(0, 1, 0))", { 0, 0, 1 } },
+	{ "float", "length(float2(3, 4))", { 5 } },
+	{ "float", "distance(float3(1, 1, 1), float3(2, 3, 3))", { 3 } },
+	{ "float2", "normalize(float2(3, 4))", { 0.6, 0.8 } },
+	{ "float3x2", "transpose(float2x3(1, 2, 3, 4, 5, 6))", { 1, 4, 2, 5, 3, 6 } },
+	{ "float", "determinant(float2x2(1, 2, 3, 4))", { -2 } },
+	{ "float", "determinant(float3x3(2, 0, 1, 1, 3, 2, 1, 1, 1))", { 0 } },
+	{ "float", "determinant(float4x4(1, 0, 2, -1, 3, 0, 0, 5, 2, 1, 4, -3, 1, 0, 5, 0))", { 30 } },
+	{ "float2", "reflect(float2(1, -1), float2(0, 1))", { 1, 1 } },
+	{ "float2", "refract(float2(0.6, -0.8), float2(0, 1), 0.5)", { 0.3, -0.9539392014169456 } },
+	{ "float2", "refract(float2(0.707107, -0.707107), float2(0, 1), 2.0)", { 0, 0 } },
+	{ "float2", "faceforward(float2(0, 1), float2(0, -1), float2(0, 1))", { 0, 1 } },
+	{ "float2", "faceforward(float2(0, 1), float2(0, 1), float2(0, 1))", { 0, -1 } },
+	{ "float2", "mul(2.0, float2(1, 2))", { 2, 4 } },
+	{ "int3", "mul(int3(1, 2, 3), 3)", { 3, 6, 9 } },
+	{ "int2x2", "mul(2, int2x2(1, 2, 3, 4))", { 2, 4, 6, 8 } },
+	{ "float2x2", "mul(float2x2(1, 2, 3, 4), 0.5)", { 0.5, 1, 1.5, 2 } },
+	{ "float3", "mul(float2(1, 2), float2x3(1, 2, 3, 4, 5, 6))", { 9, 12, 15 } },
+	{ "float2", "mul(float2x3(1, 2, 3, 4, 5, 6), float3(1, 0, -1))", { -2, -2 } },
+	{ "float2x2", "mul(float2x2(1, 2, 3, 4), float2x2(5, 6, 7, 8))", { 19, 22, 43, 50 } },
+	{ "int2x2", "mul(int2x3(1, 2, 3, 4, 5, 6), int3x2(1, 0, 0, 1, 1, 1))", { 4, 5, 10, 11 } },
+	{ "bool2", "isinf(float2(1.0 / 0.0, 1.0))", { 1, 0 } },
+	{ "bool2", "isnan(float2(0.0 / 0.0, 1.0))", { 1, 0 } },
+};
+
+static bool parse(const std::string &source, reshadefx::module &module, std::string &errors)
+{
+	const std::unique_ptr<reshadefx::codegen> backend(reshadefx::create_codegen_hlsl(50, false, false));
+
+	reshadefx::parser parser;
+	const bool success = parser.parse(source, backend.get());
+	errors = parser.errors();
+	if (success)
+		backend->write_result(module);
+	return success;
+}
+
+static bool matches(const reshadefx::uniform_info &uniform, const std::vector<double> &expected)
+{
+	if (!uniform.has_initializer_value || uniform.type.components() != expected.size())
+		return false;
+
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		const reshadefx::constant &value = uniform.initializer_value;
+
+		switch (uniform.type.base)
+		{
+		case reshadefx::type::t_bool:
+			if ((value.as_uint[i] != 0) != (expected[i] != 0))
+				return false;
+			break;
+		case reshadefx::type::t_int:
+		case reshadefx::type::t_uint:
+			// Compare bit patterns, so that the same reference works for signed and unsigned results
+			if (value.as_uint[i] != static_cast<uint32_t>(static_cast<int64_t>(expected[i])))
+				return false;
+			break;
+		default:
+			if (std::abs(value.as_float[i] - expected[i]) > 1e-5 * std::max(1.0, std::abs(expected[i])))
+				return false;
+			break;
+		}
+	}
+
+	return true;
+}
+
+static void test_reference_values()
+{
+	std::string source;
+	for (size_t i = 0; i < std::size(s_cases); ++i)
+		source += std::string("uniform ") + s_cases[i].type + " Case" + std::to_string(i) + " = " + s_cases[i].expression + ";\n";
+
+	reshadefx::module module;
+	std::string errors;
+	CHECK(parse(source, module, errors));
+	CHECK(module.uniforms.size() == std::size(s_cases));
+
+	for (size_t i = 0; i < std::size(s_cases) && i < module.uniforms.size(); ++i)
+	{
+		const reshadefx::uniform_info &uniform = module.uniforms[i];
+		CHECK(uniform.name == "Case" + std::to_string(i));
+
+		if (!matches(uniform, s_cases[i].expected))
+		{
+			std::fprintf(stderr, "%s: %s = {", s_cases[i].expression, uniform.has_initializer_value ? "" : " (not constant)");
+			for (unsigned int k = 0; k < uniform.type.components(); ++k)
+				std::fprintf(stderr, " %g (0x%08x)", uniform.initializer_value.as_float[k], uniform.initializer_value.as_uint[k]);
+			std::fprintf(stderr, " }\n");
+			++reshade::test::num_failures;
+		}
+	}
+}
+
+static void test_folding_in_functions()
+{
+	// Folded calls do not generate any code, so the generated HLSL only contains the resulting constant
+	const std::string source =
+		"float4 PS(float4 pos : SV_Position) : SV_Target { return float4(sqrt(4.0), dot(float2(1, 2), float2(3, 4)), 0, 1); }\n"
+		"technique T { pass { VertexShader = PS; PixelShader = PS; } }\n";
+
+	reshadefx::module module;
+	std::string errors;
+	CHECK(parse(source, module, errors));
+	CHECK(module.hlsl.find("sqrt") == std::string::npos);
+	CHECK(module.hlsl.find("dot") == std::string::npos);
+}
+
+static void test_non_constant_calls_outside_functions()
+{
+	// Calls that cannot be evaluated at compile time are still only allowed inside functions
+	reshadefx::module module;
+	std::string errors;
+	CHECK(!parse("uniform float u;\nstatic const float x = sin(u);\n", module, errors));
+	CHECK(errors.find("X3005") != std::string::npos);
+
+	CHECK(!parse("float2 f() { return 1.0; }\nstatic const float2 x = f();\n", module, errors));
+	CHECK(errors.find("X3005") != std::string::npos);
+}
+
+int main()
+{
+	test_reference_values();
+	test_folding_in_functions();
+	test_non_constant_calls_outside_functions();
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Lexes effect sources with the SIMD code path of the lexer and with the scalar one, checks that both produce identical tokens and compares their speed.
+// Usage: effect_lexer_benchmark [--quick] [<directory with .fx and .fxh files>]
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_lexer.hpp"
+#include "effect_lexer_dump.hpp"
+#include <random>
+
+std::string lex_and_dump_scalar(const std::string &source, bool ignore_comments, bool ignore_whitespace);
+size_t lex_and_count_scalar(const std::string &source);
+
+static bool compare(const std::string &source, bool ignore_comments, bool ignore_whitespace)
+{
+	return reshade::test::lex_and_dump<reshadefx::lexer>(source, ignore_comments, ignore_whitespace) == lex_and_dump_scalar(source, ignore_comments, ignore_whitespace);
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+
+	std::vector<std::string> sources;
+	if (argc > 1 && argv[argc - 1][0] != '-')
+	{
+		for (const std::filesystem::directory_entry &entry : std::filesystem::recursive_directory_iterator(argv[argc - 1]))
+		{
+			if (entry.path().extension() != ".fx" && entry.path().extension() != ".fxh")
+				continue;
+
+			std::ifstream file(entry.path(), std::ios::binary);
+			sources.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+	}
+	else
+	{
+		sources.push_back(reshade::test::sample_header());
+		for (size_t i = 0; i < (quick ? 4 : 40); ++i)
+			sources.push_back(reshade::test::sample_effect(i, 8, 40));
+	}
+
+	// Check real sources and random inputs made up of the characters the fast paths look for, including runs that cross block boundaries
+	size_t num_mismatches = 0;
+	for (const std::string &source : sources)
+		for (int flags = 0; flags < 4; ++flags)
+			if (!compare(source, (flags & 1) != 0, (flags & 2) != 0))
+				num_mismatches++;
+
+	std::mt19937 random(42);
+	const char alphabet[] = "ab_Z09 \t\r\n\v\f/*#\".;x";
+	for (size_t i = 0; i < (quick ? 2000 : 20000); ++i)
+	{
+		std::string source;
+		for (size_t k = 0, length = random() % 100; k < length; ++k)
+			source += alphabet[random() % (sizeof(alphabet) - 1)];
+
+		for (int flags = 0; flags < 4; ++flags)
+			if (!compare(source, (flags & 1) != 0, (flags & 2) != 0))
+				num_mismatches++;
+	}
+
+	CHECK(num_mismatches == 0);
+
+	// Lex everything a couple of times the way the preprocessor does (keeping whitespace, skipping comments)
+	const size_t num_iterations = quick ? 1 : 20;
+	size_t num_tokens = 0, num_bytes = 0;
+
+	reshade::test::timer timer;
+	for (size_t i = 0; i < num_iterations; ++i)
+		for (const std::string &source : sources)
+			num_tokens += reshade::test::lex_and_count<reshadefx::lexer>(source), num_bytes += source.size();
+	const double simd_ms = timer.elapsed_ms();
+
+	timer.reset();
+	for (size_t i = 0; i < num_iterations; ++i)
+		for (const std::string &source : sources)
+			lex_and_count_scalar(source);
+	const double scalar_ms = timer.elapsed_ms();
+
+	std::printf("%zu tokens in %zu bytes: SIMD %.1f ms, scalar %.1f ms\n", num_tokens, num_bytes, simd_ms, scalar_ms);
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <cstring>
+
+namespace reshade::test
+{
+	/// <summary>
+	/// Writes all attributes of the specified <paramref name="token"/> (identifier, location, offset, length and literal) into a line of text.
+	/// </summary>
+	template <typename TToken>
+	std::string dump_token(const TToken &token)
+	{
+		unsigned long long literal = 0;
+		if (token.id == reshadefx::tokenid::double_literal)
+			std::memcpy(&literal, &token.literal_as_double, sizeof(double));
+		else if (token.id == reshadefx::tokenid::int_literal || token.id == reshadefx::tokenid::uint_literal || token.id == reshadefx::tokenid::float_literal)
+			literal = token.literal_as_uint;
+
+		return std::to_string(static_cast<int>(token.id)) + ' ' + std::to_string(token.location.line) + ':' + std::to_string(token.location.column) + ' ' +
+			std::to_string(token.offset) + '+' + std::to_string(token.length) + ' ' + std::to_string(literal) + " [" + token.literal_as_string + "]\n";
+	}
+
+	/// <summary>
+	/// Lexes the remaining input of the specified <paramref name="lexer"/> and writes all tokens into a string, so that the output of different lexers can be compared.
+	/// </summary>
+	template <typename TLexer>
+	std::string dump_tokens(TLexer &lexer)
+	{
+		std::string result;
+		while (true)
+		{
+			const auto token = lexer.lex();
+
+			result += dump_token(token);
+
+			if (token.id == reshadefx::tokenid::end_of_file)
+				return result;
+		}
+	}
+
+	/// <summary>
+	/// Lexes the specified <paramref name="source"/> and writes all token attributes into a string, so that the output of different lexer builds can be compared.
+	/// </summary>
+	template <typename TLexer>
+	std::string lex_and_dump(const std::string &source, bool ignore_comments, bool ignore_whitespace)
+	{
+		TLexer lexer(source, ignore_comments, ignore_whitespace, false, false, false, false);
+		return dump_tokens(lexer);
+	}
+
+	/// <summary>
+	/// Lexes the specified <paramref name="source"/> the way the preprocessor does and returns the number of tokens.
+	/// </summary>
+	template <typename TLexer>
+	size_t lex_and_count(const std::string &source)
+	{
+		size_t num_tokens = 1;
+		TLexer lexer(source, true, false, false, false, false, false);
+		while (lexer.lex().id != reshadefx::tokenid::end_of_file)
+			num_tokens++;
+		return num_tokens;
+	}
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Builds the lexer a second time with only the scalar code path, so that "effect_lexer_benchmark" can compare it against the SIMD code path in the same executable.
+// The lexer and token classes are renamed, so that their definitions do not collide with those of the regular build.
+
+#define RESHADEFX_LEXER_NO_SIMD
+#define lexer scalar_lexer
+#define token scalar_token
+#include "effect_lexer.cpp"
+#include "effect_lexer_dump.hpp"
+
+std::string lex_and_dump_scalar(const std::string &source, bool ignore_comments, bool ignore_whitespace)
+{
+	return reshade::test::lex_and_dump<reshadefx::scalar_lexer>(source, ignore_comments, ignore_whitespace);
+}
+size_t lex_and_count_scalar(const std::string &source)
+{
+	return reshade::test::lex_and_count<reshadefx::scalar_lexer>(source);
+}
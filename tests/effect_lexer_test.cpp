@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Checks that a lexer produces the same tokens whether it owns its input string, shares an input buffer or is a copy of another lexer (including one copied in the middle of the input).
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_lexer.hpp"
+#include "effect_lexer_dump.hpp"
+#include <memory>
+#include <algorithm>
+
+/// <summary>
+/// Lexer constructed from a shared input buffer instead of an owned string.
+/// </summary>
+class shared_input_lexer : public reshadefx::lexer
+{
+public:
+	shared_input_lexer(const std::string &source, bool ignore_comments, bool ignore_whitespace, bool ignore_pp_directives, bool ignore_line_directives, bool ignore_keywords, bool escape_string_literals) :
+		lexer(std::make_shared<const std::string>(source), ignore_comments, ignore_whitespace, ignore_pp_directives, ignore_line_directives, ignore_keywords, escape_string_literals) {}
+};
+
+/// <summary>
+/// Lexer copied from another one, which is destroyed right after, so that any input still referenced in it would be freed memory.
+/// </summary>
+template <typename TLexer>
+class copied_lexer : public reshadefx::lexer
+{
+public:
+	copied_lexer(const std::string &source, bool ignore_comments, bool ignore_whitespace, bool ignore_pp_directives, bool ignore_line_directives, bool ignore_keywords, bool escape_string_literals) :
+		lexer(*std::make_unique<TLexer>(source, ignore_comments, ignore_whitespace, ignore_pp_directives, ignore_line_directives, ignore_keywords, escape_string_literals)) {}
+};
+
+/// <summary>
+/// Lexes the first half of the tokens, then copies the lexer and checks that both the copy and the original continue with the same tokens as a lexer that went through all of them.
+/// </summary>
+template <typename TLexer>
+static bool compare_copied_midway(const std::string &source, const std::string &expected)
+{
+	TLexer original(source, false, false, false, false, false, false);
+
+	std::string result;
+	for (size_t i = 0, num_tokens = std::count(expected.begin(), expected.end(), '\n'); i < num_tokens / 2; ++i)
+		result += reshade::test::dump_token(original.lex());
+
+	reshadefx::lexer copy = original;
+
+	return result + reshade::test::dump_tokens(copy) == expected && result + reshade::test::dump_tokens(original) == expected;
+}
+
+int main()
+{
+	std::vector<std::string> sources;
+	sources.push_back(reshade::test::sample_header());
+	for (size_t i = 0; i < 8; ++i)
+		sources.push_back(reshade::test::sample_effect(i, 8, 40));
+
+	size_t num_mismatches = 0;
+
+	for (const std::string &source : sources)
+	{
+		for (const bool ignore_comments : { false, true })
+		{
+			for (const bool ignore_whitespace : { false, true })
+			{
+				const std::string expected = reshade::test::lex_and_dump<reshadefx::lexer>(source, ignore_comments, ignore_whitespace);
+
+				if (reshade::test::lex_and_dump<shared_input_lexer>(source, ignore_comments, ignore_whitespace) != expected)
+					num_mismatches++;
+				if (reshade::test::lex_and_dump<copied_lexer<reshadefx::lexer>>(source, ignore_comments, ignore_whitespace) != expected)
+					num_mismatches++;
+				if (reshade::test::lex_and_dump<copied_lexer<shared_input_lexer>>(source, ignore_comments, ignore_whitespace) != expected)
+					num_mismatches++;
+			}
+		}
+
+		const std::string expected = reshade::test::lex_and_dump<reshadefx::lexer>(source, false, false);
+
+		if (!compare_copied_midway<reshadefx::lexer>(source, expected))
+			num_mismatches++;
+		if (!compare_copied_midway<shared_input_lexer>(source, expected))
+			num_mismatches++;
+	}
+
+	CHECK(num_mismatches == 0);
+
+	return reshade::test::finish();
+}
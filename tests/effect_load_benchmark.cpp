@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Loads a directory of effects through the preprocessor and parser, like "runtime::load_effects" does, once split into fixed contiguous slices per thread and once through the work-stealing task scheduler.
+// Usage: effect_load_benchmark [--quick] [<directory with .fx files>]
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include "task_scheduler.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+static bool load_effect(const std::filesystem::path &path)
+{
+	reshadefx::preprocessor pp;
+	pp.add_include_path(path.parent_path());
+	pp.add_macro_definition("__RESHADE__", "50000");
+	pp.add_macro_definition("BUFFER_WIDTH", "1920");
+	pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	if (!pp.append_file(path))
+		return false;
+
+	const std::unique_ptr<reshadefx::codegen> backend(reshadefx::create_codegen_hlsl(50, false, false));
+
+	reshadefx::parser parser;
+	return parser.parse(pp.output(), backend.get());
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 2u) - 1;
+
+	std::vector<std::filesystem::path> effect_files;
+	if (argc > 1 && argv[argc - 1][0] != '-')
+		effect_files = reshade::test::find_effects(argv[argc - 1]);
+	else
+		effect_files = reshade::test::write_sample_effects(std::filesystem::temp_directory_path() / "reshade_effect_load_benchmark", quick ? 16 : 200, 4, quick ? 10 : 60);
+
+	std::atomic<size_t> num_failed = 0;
+
+	// Fixed contiguous slices of the effect list per thread, as the runtime did before the task scheduler
+	reshade::test::timer timer;
+	{
+		std::vector<std::thread> threads;
+		for (size_t n = 0; n < num_threads; ++n)
+		{
+			threads.emplace_back([&, n]() {
+				for (size_t i = 0; i < effect_files.size(); ++i)
+					if (i * num_threads / effect_files.size() == n && !load_effect(effect_files[i]))
+						num_failed++;
+			});
+		}
+		for (std::thread &thread : threads)
+			thread.join();
+	}
+	const double static_split_ms = timer.elapsed_ms();
+
+	// One task per effect with work stealing
+	timer.reset();
+	{
+		reshade::task_scheduler scheduler(num_threads);
+		for (const std::filesystem::path &path : effect_files)
+			scheduler.submit([&]() {
+				if (!load_effect(path))
+					num_failed++;
+			});
+		scheduler.wait_idle();
+	}
+	const double task_scheduler_ms = timer.elapsed_ms();
+
+	std::printf("%zu effects on %zu threads: static split %.1f ms, task scheduler %.1f ms\n", effect_files.size(), num_threads, static_split_ms, task_scheduler_ms);
+
+	CHECK(num_failed == 0);
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Compares loading a set of effects from source (preprocessing, parsing and code generation) with loading the modules serialized by "reshadefx::serialize_module", as done on a hit in the effect cache.
+// Usage: effect_module_benchmark [--quick] [<directory with .fx files>]
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_module.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include <memory>
+
+static bool compile(const std::filesystem::path &path, bool spirv, reshadefx::module &module)
+{
+	reshadefx::preprocessor pp;
+	pp.add_include_path(path.parent_path());
+	pp.add_macro_definition("__RESHADE__", "50000");
+	pp.add_macro_definition("BUFFER_WIDTH", "1920");
+	pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	if (!pp.append_file(path))
+		return false;
+
+	const std::unique_ptr<reshadefx::codegen> backend(spirv ?
+		reshadefx::create_codegen_spirv(true, false, false) :
+		reshadefx::create_codegen_hlsl(50, false, false));
+
+	reshadefx::parser parser;
+	if (!parser.parse(pp.output(), backend.get()))
+		return false;
+
+	backend->write_result(module);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+
+	std::filesystem::path directory;
+	std::vector<std::filesystem::path> paths;
+	if (argc > 1 && argv[argc - 1][0] != '-')
+	{
+		paths = reshade::test::find_effects(argv[argc - 1]);
+	}
+	else
+	{
+		directory = std::filesystem::temp_directory_path() / "reshade_effect_module_benchmark";
+		std::filesystem::remove_all(directory);
+		paths = reshade::test::write_sample_effects(directory, quick ? 8 : 100, 4, quick ? 10 : 40);
+	}
+
+	for (const bool spirv : { false, true })
+	{
+		std::vector<std::string> serialized(paths.size());
+
+		reshade::test::timer timer;
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			reshadefx::module module;
+			if (compile(paths[i], spirv, module))
+				reshadefx::serialize_module(module, serialized[i]);
+		}
+		const double compile_ms = timer.elapsed_ms();
+
+		size_t num_loaded = 0, num_bytes = 0;
+
+		timer.reset();
+		for (const std::string &data : serialized)
+		{
+			reshadefx::module module;
+			if (!data.empty() && reshadefx::deserialize_module(module, data))
+				num_loaded++;
+			num_bytes += data.size();
+		}
+		const double deserialize_ms = timer.elapsed_ms();
+
+		CHECK(num_loaded != 0);
+		CHECK(directory.empty() || num_loaded == paths.size());
+
+		std::printf("%zu effects with %s code generator: compiling from source %.1f ms, deserializing %zu bytes %.1f ms (%.0fx faster)\n",
+			num_loaded, spirv ? "SPIR-V" : "HLSL", compile_ms, num_bytes, deserialize_ms, compile_ms / std::max(deserialize_ms, 0.001));
+	}
+
+	if (!directory.empty())
+		std::filesystem::remove_all(directory);
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Checks that "reshadefx::serialize_module" and "reshadefx::deserialize_module" reproduce a module exactly, for the output of every code generator, and that truncated or corrupted data is rejected.
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_module.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include <memory>
+#include <cstring>
+#include <iterator>
+
+// Effect which uses every kind of object and most pass states, so that all parts of the module are populated
+static const char s_effect_source[] = R"(
+#include "ReShade.fxh"
+
+uniform float Strength < ui_type = "slider"; ui_min = 0.0; ui_max = 1.0; ui_label = "Strength"; > = 0.25;
+uniform int Mode < ui_type = "combo"; ui_items = "First\0Second\0"; > = 1;
+uniform bool Enabled = true;
+uniform float4x4 Transform = float4x4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+uniform float Timer < source = "timer"; >;
+
+texture NoiseTex < source = "noise.png"; > { Width = 64; Height = 32; Format = R8; };
+texture IntermediateTex { Width = BUFFER_WIDTH / 2; Height = BUFFER_HEIGHT / 2; MipLevels = 4; Format = RGBA16F; };
+texture StorageTex { Width = 128; Height = 128; Format = RGBA8; };
+
+sampler NoiseSampler { Texture = NoiseTex; AddressU = WRAP; AddressV = MIRROR; MinFilter = POINT; MagFilter = POINT; MipLODBias = 1.0; };
+sampler IntermediateSampler { Texture = IntermediateTex; MinLOD = 1.0; MaxLOD = 3.0; };
+sampler StorageSampler { Texture = StorageTex; SRGBTexture = true; };
+storage StorageWrite { Texture = StorageTex; };
+
+struct Output
+{
+	float4 color : SV_Target0;
+	float4 extra : SV_Target1;
+};
+
+float4 FirstPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target
+{
+	float4 color = tex2D(ReShade::BackBuffer, uv) * Strength;
+	if (Enabled && Mode == 1)
+		color = mul(Transform, color);
+	return color + tex2D(NoiseSampler, uv * sin(Timer)).x;
+}
+Output SecondPS(float4 pos : SV_Position, float2 uv : TEXCOORD)
+{
+	Output output;
+	output.color = tex2D(IntermediateSampler, uv) + tex2D(StorageSampler, uv);
+	output.extra = ReShade::GetLinearizedDepth(uv);
+	return output;
+}
+void FillCS(uint3 id : SV_DispatchThreadID)
+{
+	tex2Dstore(StorageWrite, id.xy, float4(id.xy / 128.0, 0.0, 1.0));
+}
+
+technique First < ui_tooltip = "First technique"; enabled = true; >
+{
+	pass Fill
+	{
+		ComputeShader = FillCS<8, 8>;
+		DispatchSizeX = 16;
+		DispatchSizeY = 16;
+	}
+	pass Draw
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = FirstPS;
+		RenderTarget = IntermediateTex;
+		ClearRenderTargets = true;
+		GenerateMipMaps = false;
+	}
+}
+technique Second
+{
+	pass
+	{
+		VertexShader = PostProcessVS;
+		PixelShader = SecondPS;
+		SRGBWriteEnable = true;
+		BlendEnable = true;
+		SrcBlend = SRCALPHA;
+		DestBlend = INVSRCALPHA;
+		StencilEnable = true;
+		StencilRef = 7;
+		StencilFunc = EQUAL;
+		StencilPass = REPLACE;
+		PrimitiveTopology = TRIANGLESTRIP;
+		VertexCount = 4;
+	}
+}
+)";
+
+static bool compile(const std::string &source, const std::filesystem::path &include_path, reshadefx::codegen *backend, reshadefx::module &module)
+{
+	reshadefx::preprocessor pp;
+	pp.add_include_path(include_path);
+	pp.add_macro_definition("__RESHADE__", "50000");
+	pp.add_macro_definition("BUFFER_WIDTH", "1920");
+	pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	if (!pp.append_string(source, include_path / "Test.fx"))
+		return std::fprintf(stderr, "%s", pp.errors().c_str()), false;
+
+	reshadefx::parser parser;
+	if (!parser.parse(pp.output(), backend))
+		return std::fprintf(stderr, "%s", parser.errors().c_str()), false;
+
+	backend->write_result(module);
+	return true;
+}
+
+static bool equal(const std::vector<reshadefx::annotation> &lhs, const std::vector<reshadefx::annotation> &rhs)
+{
+	if (lhs.size() != rhs.size())
+		return false;
+
+	for (size_t i = 0; i < lhs.size(); ++i)
+		if (lhs[i].type != rhs[i].type || lhs[i].name != rhs[i].name || lhs[i].value.string_data != rhs[i].value.string_data ||
+			std::memcmp(lhs[i].value.as_uint, rhs[i].value.as_uint, sizeof(lhs[i].value.as_uint)) != 0)
+			return false;
+	return true;
+}
+
+static bool equal(const reshadefx::sampler_info &lhs, const reshadefx::sampler_info &rhs)
+{
+	return lhs.id == rhs.id && lhs.binding == rhs.binding && lhs.texture_binding == rhs.texture_binding && lhs.name == rhs.name && lhs.unique_name == rhs.unique_name && lhs.texture_name == rhs.texture_name && equal(lhs.annotations, rhs.annotations) &&
+		lhs.filter == rhs.filter && lhs.address_u == rhs.address_u && lhs.address_v == rhs.address_v && lhs.address_w == rhs.address_w && lhs.min_lod == rhs.min_lod && lhs.max_lod == rhs.max_lod && lhs.lod_bias == rhs.lod_bias && lhs.srgb == rhs.srgb;
+}
+static bool equal(const reshadefx::storage_info &lhs, const reshadefx::storage_info &rhs)
+{
+	return lhs.id == rhs.id && lhs.binding == rhs.binding && lhs.name == rhs.name && lhs.unique_name == rhs.unique_name && lhs.texture_name == rhs.texture_name && lhs.format == rhs.format && lhs.level == rhs.level;
+}
+static bool equal(const reshadefx::uniform_info &lhs, const reshadefx::uniform_info &rhs)
+{
+	return lhs.name == rhs.name && lhs.type == rhs.type && lhs.size == rhs.size && lhs.offset == rhs.offset && equal(lhs.annotations, rhs.annotations) && lhs.has_initializer_value == rhs.has_initializer_value &&
+		std::memcmp(lhs.initializer_value.as_uint, rhs.initializer_value.as_uint, sizeof(lhs.initializer_value.as_uint)) == 0;
+}
+
+template <typename T>
+static bool equal(const std::vector<T> &lhs, const std::vector<T> &rhs)
+{
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const T &a, const T &b) { return equal(a, b); });
+}
+
+static bool equal(const reshadefx::module &lhs, const reshadefx::module &rhs)
+{
+	if (lhs.hlsl != rhs.hlsl || lhs.spirv != rhs.spirv ||
+		lhs.total_uniform_size != rhs.total_uniform_size || lhs.num_texture_bindings != rhs.num_texture_bindings || lhs.num_sampler_bindings != rhs.num_sampler_bindings || lhs.num_storage_bindings != rhs.num_storage_bindings)
+		return false;
+
+	if (lhs.entry_points.size() != rhs.entry_points.size())
+		return false;
+	for (size_t i = 0; i < lhs.entry_points.size(); ++i)
+		if (lhs.entry_points[i].name != rhs.entry_points[i].name || lhs.entry_points[i].type != rhs.entry_points[i].type || lhs.entry_points[i].hlsl_ranges != rhs.entry_points[i].hlsl_ranges)
+			return false;
+
+	if (lhs.textures.size() != rhs.textures.size())
+		return false;
+	for (size_t i = 0; i < lhs.textures.size(); ++i)
+	{
+		const reshadefx::texture_info &a = lhs.textures[i], &b = rhs.textures[i];
+		if (a.id != b.id || a.binding != b.binding || a.name != b.name || a.semantic != b.semantic || a.unique_name != b.unique_name || !equal(a.annotations, b.annotations) ||
+			a.width != b.width || a.height != b.height || a.levels != b.levels || a.format != b.format || a.render_target != b.render_target || a.storage_access != b.storage_access)
+			return false;
+	}
+
+	if (!equal(lhs.samplers, rhs.samplers) || !equal(lhs.storages, rhs.storages) || !equal(lhs.uniforms, rhs.uniforms) || !equal(lhs.spec_constants, rhs.spec_constants))
+		return false;
+
+	if (lhs.techniques.size() != rhs.techniques.size())
+		return false;
+	for (size_t i = 0; i < lhs.techniques.size(); ++i)
+	{
+		const reshadefx::technique_info &a = lhs.techniques[i], &b = rhs.techniques[i];
+		if (a.name != b.name || !equal(a.annotations, b.annotations) || a.passes.size() != b.passes.size())
+			return false;
+
+		for (size_t k = 0; k < a.passes.size(); ++k)
+		{
+			const reshadefx::pass_info &pa = a.passes[k], &pb = b.passes[k];
+			if (pa.name != pb.name || pa.vs_entry_point != pb.vs_entry_point || pa.ps_entry_point != pb.ps_entry_point || pa.cs_entry_point != pb.cs_entry_point ||
+				!std::equal(std::begin(pa.render_target_names), std::end(pa.render_target_names), std::begin(pb.render_target_names)) ||
+				pa.generate_mipmaps != pb.generate_mipmaps || pa.clear_render_targets != pb.clear_render_targets || pa.srgb_write_enable != pb.srgb_write_enable ||
+				std::memcmp(pa.blend_enable, pb.blend_enable, sizeof(pa.blend_enable)) != 0 || std::memcmp(pa.color_write_mask, pb.color_write_mask, sizeof(pa.color_write_mask)) != 0 ||
+				!std::equal(std::begin(pa.src_blend), std::end(pa.src_blend), std::begin(pb.src_blend)) || !std::equal(std::begin(pa.dest_blend), std::end(pa.dest_blend), std::begin(pb.dest_blend)) ||
+				pa.stencil_enable != pb.stencil_enable || pa.stencil_reference_value != pb.stencil_reference_value || pa.stencil_comparison_func != pb.stencil_comparison_func || pa.stencil_op_pass != pb.stencil_op_pass ||
+				pa.num_vertices != pb.num_vertices || pa.topology != pb.topology ||
+				pa.viewport_width != pb.viewport_width || pa.viewport_height != pb.viewport_height || pa.viewport_dispatch_z != pb.viewport_dispatch_z ||
+				!equal(pa.samplers, pb.samplers) || !equal(pa.storages, pb.storages))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static void test_round_trip(const reshadefx::module &module, const char *name)
+{
+	std::string data;
+	reshadefx::serialize_module(module, data);
+
+	reshadefx::module loaded;
+	const bool success = reshadefx::deserialize_module(loaded, data);
+	CHECK(success);
+	if (!success)
+		return;
+
+	if (!equal(module, loaded))
+	{
+		std::fprintf(stderr, "%s: deserialized module does not match the original\n", name);
+		++reshade::test::num_failures;
+	}
+
+	// Writing the loaded module again has to produce the same data
+	std::string data_again;
+	reshadefx::serialize_module(loaded, data_again);
+	CHECK(data_again == data);
+
+	// Truncated data has to be rejected and leave the target module untouched
+	size_t num_truncated_accepted = 0;
+	for (size_t size = 0; size < data.size(); size += 1 + data.size() / 500)
+	{
+		reshadefx::module truncated;
+		truncated.hlsl = "untouched";
+		if (reshadefx::deserialize_module(truncated, std::string_view(data.data(), size)) || truncated.hlsl != "untouched")
+			num_truncated_accepted++;
+	}
+	CHECK(num_truncated_accepted == 0);
+
+	// Data with a different magic number or version has to be rejected
+	for (size_t i = 0; i < 8 && i < data.size(); ++i)
+	{
+		std::string corrupted = data;
+		corrupted[i] ^= 0x5A;
+		reshadefx::module ignored;
+		CHECK(!reshadefx::deserialize_module(ignored, corrupted));
+	}
+
+	// Corruption further in must not crash (it may or may not be detected, depending on whether it hit a size or just some content)
+	for (size_t offset = 8; offset < data.size(); offset += 1 + data.size() / 200)
+	{
+		std::string corrupted = data;
+		for (size_t i = offset; i < corrupted.size(); i += 97)
+			corrupted[i] ^= 0x5A;
+		reshadefx::module ignored;
+		reshadefx::deserialize_module(ignored, corrupted);
+	}
+}
+
+int main()
+{
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reshade_effect_module_test";
+	std::filesystem::create_directories(directory);
+	std::ofstream(directory / "ReShade.fxh", std::ios::binary) << reshade::test::sample_header();
+
+	const struct {
+		const char *name;
+		std::unique_ptr<reshadefx::codegen> backend;
+	} backends[] = {
+		{ "HLSL", std::unique_ptr<reshadefx::codegen>(reshadefx::create_codegen_hlsl(50, true, false)) },
+		{ "HLSL (spec constants)", std::unique_ptr<reshadefx::codegen>(reshadefx::create_codegen_hlsl(50, false, true)) },
+		{ "GLSL", std::unique_ptr<reshadefx::codegen>(reshadefx::create_codegen_glsl(true, true, false)) },
+		{ "SPIR-V", std::unique_ptr<reshadefx::codegen>(reshadefx::create_codegen_spirv(true, true, false)) },
+		{ "SPIR-V (spec constants)", std::unique_ptr<reshadefx::codegen>(reshadefx::create_codegen_spirv(true, false, true)) },
+	};
+
+	for (const auto &backend : backends)
+	{
+		reshadefx::module module;
+		const bool success = compile(s_effect_source, directory, backend.backend.get(), module);
+		CHECK(success);
+		if (!success)
+			continue;
+
+		CHECK(module.techniques.size() == 2 && module.textures.size() >= 3 && module.samplers.size() >= 2 && !module.storages.empty() && !(module.uniforms.empty() && module.spec_constants.empty()));
+
+		test_round_trip(module, backend.name);
+	}
+
+	// An empty module has to survive a round trip too
+	test_round_trip(reshadefx::module(), "empty");
+
+	// Code ranges outside the code or out of order have to be rejected
+	for (const std::vector<std::pair<uint32_t, uint32_t>> &ranges : { std::vector<std::pair<uint32_t, uint32_t>> { { 0, 20 } }, { { 2, 1 } }, { { 2, 3 }, { 0, 1 } } })
+	{
+		reshadefx::module module;
+		module.hlsl = "void main() {}";
+		module.entry_points.push_back({ "main", reshadefx::shader_type::ps, ranges });
+
+		std::string data;
+		reshadefx::serialize_module(module, data);
+		reshadefx::module ignored;
+		CHECK(!reshadefx::deserialize_module(ignored, data));
+	}
+
+	std::filesystem::remove_all(directory);
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Parses a large effect with the HLSL and the SPIR-V code generator and counts the heap allocations made during parsing, next to the wall time.
+// Usage: effect_parser_benchmark [--quick] [<effect file>]
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_parser.hpp"
+#include "effect_codegen.hpp"
+#include "effect_preprocessor.hpp"
+#include <new>
+#include <memory>
+#include <cstdlib>
+
+static bool s_count_allocations = false;
+static size_t s_num_allocations = 0;
+static size_t s_num_allocated_bytes = 0;
+
+void *operator new(size_t size)
+{
+	if (s_count_allocations)
+	{
+		s_num_allocations++;
+		s_num_allocated_bytes += size;
+	}
+
+	if (void *const p = std::malloc(size != 0 ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+void operator delete(void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_iterations = quick ? 1 : 5;
+
+	std::filesystem::path path;
+	if (argc > 1 && argv[argc - 1][0] != '-')
+	{
+		path = argv[argc - 1];
+	}
+	else
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reshade_effect_parser_benchmark";
+		std::filesystem::create_directories(directory);
+		std::ofstream(directory / "ReShade.fxh", std::ios::binary) << reshade::test::sample_header();
+		std::ofstream(path = directory / "Large.fx", std::ios::binary) << reshade::test::sample_effect(0, quick ? 8 : 64, quick ? 20 : 100);
+	}
+
+	reshadefx::preprocessor pp;
+	pp.add_include_path(path.parent_path());
+	pp.add_macro_definition("__RESHADE__", "50000");
+	pp.add_macro_definition("BUFFER_WIDTH", "1920");
+	pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	if (!pp.append_file(path))
+	{
+		std::fprintf(stderr, "%s", pp.errors().c_str());
+		return 1;
+	}
+
+	const std::string source = pp.output();
+
+	for (const bool spirv : { false, true })
+	{
+		double best_ms = 0.0;
+		size_t num_allocations = 0, num_allocated_bytes = 0;
+
+		for (size_t i = 0; i < num_iterations; ++i)
+		{
+			const std::unique_ptr<reshadefx::codegen> backend(spirv ?
+				reshadefx::create_codegen_spirv(true, false, false) :
+				reshadefx::create_codegen_hlsl(50, false, false));
+
+			reshadefx::parser parser;
+
+			s_num_allocations = 0;
+			s_num_allocated_bytes = 0;
+			s_count_allocations = true;
+
+			reshade::test::timer timer;
+			const bool success = parser.parse(source, backend.get());
+			const double elapsed_ms = timer.elapsed_ms();
+
+			s_count_allocations = false;
+
+			CHECK(success);
+			if (!success)
+				std::fprintf(stderr, "%s", parser.errors().c_str());
+
+			if (i == 0 || elapsed_ms < best_ms)
+				best_ms = elapsed_ms;
+			num_allocations = s_num_allocations;
+			num_allocated_bytes = s_num_allocated_bytes;
+		}
+
+		std::printf("%s (%zu bytes of source) with %s code generator: %.1f ms, %zu allocations (%zu bytes)\n",
+			path.filename().u8string().c_str(), source.size(), spirv ? "SPIR-V" : "HLSL", best_ms, num_allocations, num_allocated_bytes);
+	}
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Preprocesses many small effects that include the same large headers, once lexing every header for every effect (as without an include cache) and once sharing a single "reshadefx::include_cache" between all of them.
+// Usage: effect_preprocessor_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include "effect_samples.hpp"
+#include "effect_preprocessor.hpp"
+#include "task_scheduler.hpp"
+
+static bool preprocess(const std::filesystem::path &path, reshadefx::include_cache *cache, std::string &output)
+{
+	reshadefx::preprocessor pp;
+	pp.set_include_cache(cache);
+	pp.add_include_path(path.parent_path());
+	pp.add_macro_definition("__RESHADE__", "50000");
+	pp.add_macro_definition("BUFFER_WIDTH", "1920");
+	pp.add_macro_definition("BUFFER_HEIGHT", "1080");
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+	if (!pp.append_file(path))
+		return false;
+
+	output = pp.output();
+	return true;
+}
+
+static double preprocess_all(const std::vector<std::filesystem::path> &paths, reshadefx::include_cache *cache, std::vector<std::string> &outputs)
+{
+	outputs.assign(paths.size(), std::string());
+
+	reshade::test::timer timer;
+	{
+		reshade::task_scheduler scheduler;
+		for (size_t i = 0; i < paths.size(); ++i)
+			scheduler.submit([&, i]() {
+				if (!preprocess(paths[i], cache, outputs[i]))
+					outputs[i].clear();
+			});
+		scheduler.wait_idle();
+	}
+	return timer.elapsed_ms();
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_effects = quick ? 16 : 300;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reshade_effect_preprocessor_benchmark";
+	std::filesystem::remove_all(directory);
+
+	// Effects are small, but all include "ReShade.fxh" and a large shared header, like the UI and utility headers most effect collections come with
+	std::vector<std::filesystem::path> paths = reshade::test::write_sample_effects(directory, num_effects, 1, 4);
+	for (const std::filesystem::path &path : paths)
+	{
+		std::string source = reshade::test::sample_effect(0, 0, 0);
+		source.insert(source.find('\n') + 1, "#include \"Shared.fxh\"\n");
+		std::ofstream(path, std::ios::binary) << source;
+	}
+
+	std::string shared_header = "#pragma once\n";
+	{
+		const std::string functions = reshade::test::sample_effect(0, quick ? 8 : 40, 20);
+		shared_header += functions.substr(functions.find('\n') + 1, functions.find("float4 MainPS") - functions.find('\n') - 1);
+	}
+	std::ofstream(directory / "Shared.fxh", std::ios::binary) << shared_header;
+
+	std::vector<std::string> uncached_outputs, cached_outputs;
+
+	const double uncached_ms = preprocess_all(paths, nullptr, uncached_outputs);
+
+	reshadefx::include_cache cache;
+	const double cached_cold_ms = preprocess_all(paths, &cache, cached_outputs);
+	CHECK(cached_outputs == uncached_outputs);
+	const double cached_warm_ms = preprocess_all(paths, &cache, cached_outputs);
+	CHECK(cached_outputs == uncached_outputs);
+
+	for (const std::string &output : uncached_outputs)
+		CHECK(!output.empty());
+
+	std::printf("%zu effects including a %zu byte header: without include cache %.1f ms, with include cache %.1f ms (%.1f ms when all files are cached already)\n",
+		paths.size(), shared_header.size(), uncached_ms, cached_cold_ms, cached_warm_ms);
+
+	// Changing a header has to be picked up by the cache (the modification time is moved forward explicitly, since file systems may only store it at a coarse granularity)
+	const std::filesystem::file_time_type modified_time = std::filesystem::last_write_time(directory / "Shared.fxh");
+	std::ofstream(directory / "Shared.fxh", std::ios::binary) << shared_header << "#define SHARED_HEADER_CHANGED 1\nstatic const float changed = SHARED_HEADER_CHANGED;\n";
+	std::filesystem::last_write_time(directory / "Shared.fxh", modified_time + std::chrono::seconds(2));
+
+	std::string changed_output;
+	CHECK(preprocess(paths[0], &cache, changed_output) && changed_output.find("SHARED_HEADER_CHANGED") == std::string::npos && changed_output.find("changed =  1") != std::string::npos);
+
+	std::filesystem::remove_all(directory);
+
+	return reshade::test::finish();
+}
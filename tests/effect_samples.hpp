@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+namespace reshade::test
+{
+	/// <summary>
+	/// Gets the source code of a stripped down "ReShade.fxh", which all generated effects include.
+	/// </summary>
+	inline std::string sample_header()
+	{
+		return R"(#pragma once
+/*
+ * Stripped down version of the common ReShade header, so that generated effects look like real ones.
+ */
+#define BUFFER_PIXEL_SIZE float2(BUFFER_RCP_WIDTH, BUFFER_RCP_HEIGHT)
+#define BUFFER_SCREEN_SIZE float2(BUFFER_WIDTH, BUFFER_HEIGHT)
+#define BUFFER_ASPECT_RATIO (BUFFER_WIDTH * BUFFER_RCP_HEIGHT)
+
+#ifndef RESHADE_DEPTH_INPUT_IS_REVERSED
+	#define RESHADE_DEPTH_INPUT_IS_REVERSED 1
+#endif
+
+namespace ReShade
+{
+	texture BackBufferTex : COLOR;
+	texture DepthBufferTex : DEPTH;
+	sampler BackBuffer { Texture = BackBufferTex; };
+	sampler DepthBuffer { Texture = DepthBufferTex; };
+
+	// Helper function to linearize the depth buffer value
+	float GetLinearizedDepth(float2 texcoord)
+	{
+		float depth = tex2Dlod(DepthBuffer, float4(texcoord, 0, 0)).x;
+#if RESHADE_DEPTH_INPUT_IS_REVERSED
+		depth = 1.0 - depth;
+#endif
+		const float N = 1.0;
+		depth /= 1000.0 - depth * (1000.0 - N);
+		return depth;
+	}
+}
+
+// Vertex shader generating a triangle covering the entire screen
+void PostProcessVS(in uint id : SV_VertexID, out float4 position : SV_Position, out float2 texcoord : TEXCOORD)
+{
+	texcoord.x = (id == 2) ? 2.0 : 0.0;
+	texcoord.y = (id == 1) ? 2.0 : 0.0;
+	position = float4(texcoord * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+}
+)";
+	}
+
+	/// <summary>
+	/// Generates the source code of an effect, made up of a comment block, a uniform and a function of <paramref name="num_statements"/> vector expressions for each of the <paramref name="num_functions"/> functions, plus a pixel shader calling all of them.
+	/// </summary>
+	inline std::string sample_effect(size_t index, size_t num_functions, size_t num_statements)
+	{
+		std::string source = "#include \"ReShade.fxh\"\n\n";
+		source += "/*\n * Generated effect " + std::to_string(index) + "\n *\n";
+		for (size_t i = 0; i < 8; ++i)
+			source += " * Long license or description text, as found at the top of most effect files, which the lexer has to skip.\n";
+		source += " */\n\n";
+
+		for (size_t f = 0; f < num_functions; ++f)
+		{
+			const std::string n = std::to_string(f);
+			source += "// Function " + n + " combines the input color with a set of constants\n";
+			source += "uniform float Strength" + n + " < ui_type = \"slider\"; ui_min = 0.0; ui_max = 1.0; ui_label = \"Strength " + n + "\"; > = 0.5;\n";
+			source += "float4 Function" + n + "(float2 uv, float4 color)\n{\n\tfloat4 r = color;\n";
+			for (size_t s = 0; s < num_statements; ++s)
+			{
+				const std::string a = std::to_string(s % 100) + '.' + std::to_string(s % 7), b = std::to_string((s * 3 + f) % 50) + ".25";
+				source += "\tr = r * float4(" + a + ", 0.5, " + b + ", 1.0) + float4(uv * BUFFER_PIXEL_SIZE, 0.0, Strength" + n + ") * " + std::to_string(s % 8 + 1) + ".0; // Step " + std::to_string(s) + "\n";
+			}
+			source += "\treturn saturate(r);\n}\n\n";
+		}
+
+		source += "float4 MainPS(float4 pos : SV_Position, float2 uv : TEXCOORD) : SV_Target\n{\n\tfloat4 color = tex2D(ReShade::BackBuffer, uv);\n";
+		for (size_t f = 0; f < num_functions; ++f)
+			source += "\tcolor = Function" + std::to_string(f) + "(uv, color);\n";
+		source += "\treturn lerp(color, ReShade::GetLinearizedDepth(uv), 0.5);\n}\n\n";
+
+		source += "technique Generated" + std::to_string(index) + "\n{\n\tpass\n\t{\n\t\tVertexShader = PostProcessVS;\n\t\tPixelShader = MainPS;\n\t}\n}\n";
+		return source;
+	}
+
+	/// <summary>
+	/// Writes "ReShade.fxh" and <paramref name="num_effects"/> generated effects into the specified directory.
+	/// Every eighth effect is made eight times larger than the others, to model the few heavy effects (like depth of field or global illumination) found in typical installations.
+	/// </summary>
+	/// <returns>Paths to all written effect files.</returns>
+	inline std::vector<std::filesystem::path> write_sample_effects(const std::filesystem::path &directory, size_t num_effects, size_t num_functions, size_t num_statements)
+	{
+		std::filesystem::create_directories(directory);
+		std::ofstream(directory / "ReShade.fxh", std::ios::binary) << sample_header();
+
+		std::vector<std::filesystem::path> paths;
+		for (size_t i = 0; i < num_effects; ++i)
+		{
+			const size_t scale = (i % 8) == 0 ? 8 : 1;
+
+			paths.push_back(directory / ("Generated" + std::to_string(i) + ".fx"));
+			std::ofstream(paths.back(), std::ios::binary) << sample_effect(i, num_functions * scale, num_statements);
+		}
+		return paths;
+	}
+
+	/// <summary>
+	/// Finds all effect files in the specified directory (not recursive).
+	/// </summary>
+	inline std::vector<std::filesystem::path> find_effects(const std::filesystem::path &directory)
+	{
+		std::vector<std::filesystem::path> paths;
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory))
+			if (entry.path().extension() == ".fx")
+				paths.push_back(entry.path());
+		std::sort(paths.begin(), paths.end());
+		return paths;
+	}
+}
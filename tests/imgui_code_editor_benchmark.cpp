@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Edits a large file in the code editor, measuring the time every edit and the syntax highlighting update after it take, as they would happen during a frame.
+// Usage: imgui_code_editor_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include "imgui_code_editor.hpp"
+#include <string>
+#include <algorithm>
+
+using namespace reshade::imgui;
+
+static std::string generate_text(size_t num_lines)
+{
+	std::string text;
+	for (size_t i = 0; i < num_lines; ++i)
+	{
+		if (i % 500 == 0)
+			text += "/* Comment spanning\n * two lines */ float4 x" + std::to_string(i) + " = 1.0;\n", ++i;
+		else
+			text += "float4 Function" + std::to_string(i) + "(float2 uv : TEXCOORD) : SV_Target { return tex2D(s, uv) * 0.5; } // Comment\n";
+	}
+	return text;
+}
+
+/// <summary>
+/// Calls <see cref="code_editor::colorize"/> once per frame until all changed lines were colored.
+/// </summary>
+/// <returns>Number of frames it took.</returns>
+static size_t colorize_all(code_editor &editor, double &max_frame_ms)
+{
+	size_t num_frames = 0;
+	max_frame_ms = 0.0;
+
+	while (editor.is_colorizing())
+	{
+		reshade::test::timer timer;
+		editor.colorize();
+		max_frame_ms = std::max(max_frame_ms, timer.elapsed_ms());
+		num_frames++;
+	}
+
+	return num_frames;
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_lines = quick ? 2000 : 20000;
+	const size_t num_keystrokes = quick ? 200 : 2000;
+
+	code_editor editor;
+	double max_frame_ms = 0.0;
+
+	reshade::test::timer timer;
+	editor.set_text(generate_text(num_lines));
+	const size_t initial_frames = colorize_all(editor, max_frame_ms);
+	std::printf("Opening a %zu line file: %.1f ms (colored over %zu frames, at most %.2f ms per frame)\n", num_lines, timer.elapsed_ms(), initial_frames, max_frame_ms);
+
+	CHECK(initial_frames != 0);
+
+	// Type into the middle of the file, coloring after every keystroke like the editor does once per frame
+	double total_ms = 0.0, max_ms = 0.0;
+	size_t num_unfinished = 0;
+	for (size_t i = 0; i < num_keystrokes; ++i)
+	{
+		editor.set_cursor_pos(code_editor::text_pos(num_lines / 2 + 2 + (i % 50) * 3, 6));
+
+		timer.reset();
+		editor.insert_text(i % 8 == 7 ? " " : "a");
+		editor.colorize();
+		const double elapsed_ms = timer.elapsed_ms();
+
+		total_ms += elapsed_ms;
+		max_ms = std::max(max_ms, elapsed_ms);
+
+		// Typing a letter or space does not change the lexer state at the end of the line, so coloring has to finish within the same frame
+		if (editor.is_colorizing())
+			num_unfinished++;
+	}
+	std::printf("Typing %zu characters into the middle: %.4f ms per keystroke on average, %.4f ms at most\n", num_keystrokes, total_ms / num_keystrokes, max_ms);
+
+	CHECK(num_unfinished == 0);
+
+	// Open a multi-line comment near the top, which changes the color of everything up to the next comment end
+	const std::string text_before = editor.get_text();
+
+	timer.reset();
+	editor.set_cursor_pos(code_editor::text_pos(3, 0));
+	editor.insert_text("/*");
+	const size_t open_frames = colorize_all(editor, max_frame_ms);
+	std::printf("Opening a comment at the top: %.1f ms (colored over %zu frames, at most %.2f ms per frame)\n", timer.elapsed_ms(), open_frames, max_frame_ms);
+
+	timer.reset();
+	editor.undo(2); // Every inserted character is a separate undo record
+	const size_t close_frames = colorize_all(editor, max_frame_ms);
+	std::printf("Removing it again: %.1f ms (colored over %zu frames, at most %.2f ms per frame)\n", timer.elapsed_ms(), close_frames, max_frame_ms);
+
+	CHECK(open_frames != 0 && close_frames != 0);
+	CHECK(editor.get_text() == text_before);
+
+	// Paste a large block into the middle
+	const std::string block = generate_text(1000);
+	timer.reset();
+	editor.set_cursor_pos(code_editor::text_pos(num_lines / 3, 0));
+	editor.insert_text(block);
+	const double paste_ms = timer.elapsed_ms();
+	const size_t paste_frames = colorize_all(editor, max_frame_ms);
+	std::printf("Pasting 1000 lines: %.1f ms, colored over %zu frames (at most %.2f ms per frame)\n", paste_ms, paste_frames, max_frame_ms);
+
+	CHECK(editor.get_text().size() == text_before.size() + block.size());
+
+	return reshade::test::finish();
+}
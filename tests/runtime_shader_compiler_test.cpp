@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Checks that "reshade::compile_entry_points" compiles entry points in parallel, yet reports results as if they were compiled one after another.
+
+#include "test_utils.hpp"
+#include "runtime_shader_compiler.hpp"
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace reshade;
+
+/// <summary>
+/// Stands in for the D3D, GLSL or SPIR-V compiler, taking a chosen amount of time for every entry point and failing on chosen ones.
+/// </summary>
+class stub_compiler : public shader_compiler
+{
+public:
+	struct behavior
+	{
+		unsigned int delay_ms = 0;
+		bool fail = false;
+	};
+
+	explicit stub_compiler(std::vector<behavior> behaviors) : behaviors(std::move(behaviors)) {}
+
+	bool compile(const reshadefx::module &module, const reshadefx::entry_point &entry_point, std::string &cso, std::string &cso_text, std::string &errors) override
+	{
+		const behavior &b = behaviors[&entry_point - module.entry_points.data()];
+
+		const size_t running = ++num_running;
+		for (size_t prev = max_running; prev < running && !max_running.compare_exchange_weak(prev, running);)
+			continue;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(b.delay_ms));
+
+		num_running--;
+		num_compiled++;
+
+		cso = "cso " + entry_point.name;
+		cso_text = "disassembly " + entry_point.name;
+		errors = entry_point.name + (b.fail ? ": error\n" : ": warning\n");
+		return !b.fail;
+	}
+
+	const std::vector<behavior> behaviors;
+	std::atomic<size_t> num_running = 0;
+	std::atomic<size_t> max_running = 0;
+	std::atomic<size_t> num_compiled = 0;
+};
+
+static reshadefx::module make_module(size_t num_entry_points)
+{
+	reshadefx::module module;
+	for (size_t i = 0; i < num_entry_points; ++i)
+		module.entry_points.push_back({ "main" + std::to_string(i), reshadefx::shader_type::ps, {} });
+	return module;
+}
+
+static void test_parallel()
+{
+	task_scheduler scheduler(4);
+	stub_compiler compiler({ { 100 }, { 100 }, { 100 }, { 100 } });
+	const reshadefx::module module = make_module(4);
+
+	std::unordered_map<std::string, std::pair<std::string, std::string>> assembly;
+	std::string errors;
+
+	reshade::test::timer timer;
+	CHECK(compile_entry_points(scheduler, compiler, module, assembly, errors));
+	const double elapsed_ms = timer.elapsed_ms();
+
+	// Tasks sleep rather than spin, so they overlap even on a single core
+	CHECK(compiler.max_running >= 2);
+	CHECK(elapsed_ms < 4 * 100);
+	CHECK(assembly.size() == 4);
+	CHECK(assembly["main2"].first == "cso main2" && assembly["main2"].second == "disassembly main2");
+}
+
+static void test_error_order()
+{
+	task_scheduler scheduler(4);
+	// Earlier entry points take longer, so that their tasks finish last
+	stub_compiler compiler({ { 120 }, { 80 }, { 40 }, { 0 } });
+	const reshadefx::module module = make_module(4);
+
+	std::unordered_map<std::string, std::pair<std::string, std::string>> assembly;
+	std::string errors = "preprocessor: warning\n";
+
+	CHECK(compile_entry_points(scheduler, compiler, module, assembly, errors));
+	CHECK(errors == "preprocessor: warning\nmain0: warning\nmain1: warning\nmain2: warning\nmain3: warning\n");
+}
+
+static void test_first_failure()
+{
+	task_scheduler scheduler(4);
+	// The failing entry point finishes first, the ones after it finish before the ones before it
+	stub_compiler compiler({ { 100 }, { 0, true }, { 50 }, { 50, true } });
+	const reshadefx::module module = make_module(4);
+
+	std::unordered_map<std::string, std::pair<std::string, std::string>> assembly;
+	std::string errors;
+
+	CHECK(!compile_entry_points(scheduler, compiler, module, assembly, errors));
+	CHECK(errors == "main0: warning\nmain1: error\n");
+	CHECK(assembly.size() == 1 && assembly.count("main0") != 0);
+
+	// All tasks still have to finish before returning, since they reference the module
+	CHECK(compiler.num_compiled == 4);
+}
+
+static void test_nested()
+{
+	// With a single worker, the task calling "compile_entry_points" occupies the only thread, so it has to execute the compilation tasks itself
+	// The scheduler is leaked if this dead-locks, since its destructor would block on the stuck worker
+	for (size_t num_threads : { 1, 2 })
+	{
+		auto scheduler = std::make_unique<task_scheduler>(num_threads);
+		stub_compiler compiler({ { 10 }, { 10 }, { 10 } });
+		const reshadefx::module module = make_module(3);
+
+		std::promise<bool> promise;
+		std::future<bool> future = promise.get_future();
+
+		scheduler->submit([&]() {
+			std::unordered_map<std::string, std::pair<std::string, std::string>> assembly;
+			std::string errors;
+			promise.set_value(compile_entry_points(*scheduler, compiler, module, assembly, errors) && assembly.size() == 3);
+		});
+
+		const bool finished = future.wait_for(std::chrono::seconds(10)) == std::future_status::ready;
+		CHECK(finished);
+		if (!finished)
+		{
+			scheduler.release();
+			return;
+		}
+
+		CHECK(future.get());
+		scheduler->wait_idle();
+	}
+}
+
+int main()
+{
+	test_parallel();
+	test_error_order();
+	test_first_failure();
+	test_nested();
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Runs the per-frame update of special uniforms (like in "runtime::render_effects") over many uniforms, once looking up the controlling annotations by name every frame and once using the parameters parsed by "uniform::parse_special_annotations" at load time.
+// Usage: runtime_special_uniform_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include <cstddef>
+#include "reshade_api_pipeline.hpp"
+#include "runtime_objects.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace reshade;
+
+static reshadefx::annotation make_annotation(const char *name, float value0, float value1 = 0.0f)
+{
+	reshadefx::annotation annotation;
+	annotation.name = name;
+	annotation.type = { reshadefx::type::t_float, 2, 1 };
+	annotation.value.as_float[0] = value0;
+	annotation.value.as_float[1] = value1;
+	return annotation;
+}
+static reshadefx::annotation make_annotation(const char *name, int value)
+{
+	reshadefx::annotation annotation;
+	annotation.name = name;
+	annotation.type = { reshadefx::type::t_int, 1, 1 };
+	annotation.value.as_int[0] = value;
+	return annotation;
+}
+static reshadefx::annotation make_annotation(const char *name, const char *value)
+{
+	reshadefx::annotation annotation;
+	annotation.name = name;
+	annotation.type = { reshadefx::type::t_string, 0, 0 };
+	annotation.value.string_data = value;
+	return annotation;
+}
+
+/// <summary>
+/// Creates a uniform of every kind of special uniform whose update depends on annotations, with the UI annotations most uniforms in real effects have in front of those.
+/// </summary>
+static uniform make_uniform(size_t index)
+{
+	reshadefx::uniform_info info;
+	info.name = "Uniform" + std::to_string(index);
+	info.type = { reshadefx::type::t_float, 2, 1, reshadefx::type::q_uniform };
+	info.annotations.push_back(make_annotation("ui_type", "drag"));
+	info.annotations.push_back(make_annotation("ui_label", "Label"));
+	info.annotations.push_back(make_annotation("ui_tooltip", "Tooltip explaining what this uniform does"));
+	info.annotations.push_back(make_annotation("ui_category", "Category"));
+
+	switch (index % 5)
+	{
+	case 0:
+		info.annotations.push_back(make_annotation("source", "random"));
+		info.annotations.push_back(make_annotation("min", -10));
+		info.annotations.push_back(make_annotation("max", 10));
+		break;
+	case 1:
+		info.annotations.push_back(make_annotation("source", "pingpong"));
+		info.annotations.push_back(make_annotation("min", 0.0f));
+		info.annotations.push_back(make_annotation("max", 10.0f));
+		info.annotations.push_back(make_annotation("step", 2.0f, 4.0f));
+		info.annotations.push_back(make_annotation("smoothing", 0.5f));
+		break;
+	case 2:
+		info.annotations.push_back(make_annotation("source", "key"));
+		info.annotations.push_back(make_annotation("keycode", 0x20 + static_cast<int>(index % 32)));
+		info.annotations.push_back(make_annotation("mode", index % 3 == 0 ? "toggle" : index % 3 == 1 ? "press" : ""));
+		break;
+	case 3:
+		info.annotations.push_back(make_annotation("source", "mousebutton"));
+		info.annotations.push_back(make_annotation("keycode", static_cast<int>(index % 5)));
+		info.annotations.push_back(make_annotation("toggle", static_cast<int>(index % 2)));
+		break;
+	case 4:
+		info.annotations.push_back(make_annotation("source", "mousewheel"));
+		info.annotations.push_back(make_annotation("min", -5.0f));
+		info.annotations.push_back(make_annotation("max", 5.0f));
+		break;
+	}
+
+	uniform variable(info);
+	variable.parse_special_annotations();
+	return variable;
+}
+
+/// <summary>
+/// Looks up the annotations controlling a special uniform by name, the way the update loop did every frame before they were parsed at load time.
+/// </summary>
+static special_uniform_params lookup_special_params(const uniform &variable)
+{
+	special_uniform_params params;
+
+	switch (variable.special)
+	{
+	case special_uniform::random:
+		params.min_int = variable.annotation_as_int("min", 0, 0);
+		params.max_int = variable.annotation_as_int("max", 0, RAND_MAX);
+		break;
+	case special_uniform::ping_pong:
+		params.min = variable.annotation_as_float("min", 0, 0.0f);
+		params.max = variable.annotation_as_float("max", 0, 1.0f);
+		params.step[0] = variable.annotation_as_float("step", 0);
+		params.step[1] = variable.annotation_as_float("step", 1);
+		params.smoothing = variable.annotation_as_float("smoothing");
+		break;
+	case special_uniform::key:
+	case special_uniform::mouse_button:
+		params.keycode = variable.annotation_as_int("keycode");
+		if (const std::string_view mode = variable.annotation_as_string("mode");
+			mode == "toggle" || variable.annotation_as_int("toggle"))
+			params.mode = special_uniform_params::key_mode::toggle;
+		else if (mode == "press")
+			params.mode = special_uniform_params::key_mode::press;
+		else
+			params.mode = special_uniform_params::key_mode::down;
+		break;
+	case special_uniform::mouse_wheel:
+		params.min = variable.annotation_as_float("min");
+		params.max = variable.annotation_as_float("max");
+		params.step[0] = variable.annotation_as_float("step");
+		if (params.step[0] == 0.0f)
+			params.step[0] = 1.0f;
+		break;
+	default:
+		break;
+	}
+
+	return params;
+}
+
+static bool operator==(const special_uniform_params &lhs, const special_uniform_params &rhs)
+{
+	return lhs.min_int == rhs.min_int && lhs.max_int == rhs.max_int && lhs.min == rhs.min && lhs.max == rhs.max && lhs.step[0] == rhs.step[0] && lhs.step[1] == rhs.step[1] && lhs.smoothing == rhs.smoothing && lhs.keycode == rhs.keycode && lhs.mode == rhs.mode;
+}
+
+/// <summary>
+/// Input state of a frame, standing in for "reshade::input".
+/// </summary>
+struct frame_input
+{
+	bool keys_down[256];
+	bool keys_pressed[256];
+	float wheel_delta;
+	float frame_time;
+};
+
+/// <summary>
+/// Updates the value of a special uniform like "runtime::render_effects" does, using the specified parameters.
+/// </summary>
+static void update_special_uniform(const uniform &variable, const special_uniform_params &params, const frame_input &input, int random, float value[2])
+{
+	switch (variable.special)
+	{
+	case special_uniform::random:
+		value[0] = static_cast<float>(params.min_int + (random % (std::abs(params.max_int - params.min_int) + 1)));
+		break;
+	case special_uniform::ping_pong:
+	{
+		float increment = params.step[1] == 0 ? params.step[0] : (params.step[0] + std::fmod(static_cast<float>(random), params.step[1] - params.step[0] + 1));
+		if (value[1] >= 0)
+		{
+			increment = std::max(increment - std::max(0.0f, params.smoothing - (params.max - value[0])), 0.05f) * input.frame_time;
+			if ((value[0] += increment) >= params.max)
+				value[0] = params.max, value[1] = -1;
+		}
+		else
+		{
+			increment = std::max(increment - std::max(0.0f, params.smoothing - (value[0] - params.min)), 0.05f) * input.frame_time;
+			if ((value[0] -= increment) <= params.min)
+				value[0] = params.min, value[1] = +1;
+		}
+		break;
+	}
+	case special_uniform::key:
+	case special_uniform::mouse_button:
+		if (params.mode == special_uniform_params::key_mode::toggle)
+			value[0] = input.keys_pressed[params.keycode] ? 1.0f - value[0] : value[0];
+		else if (params.mode == special_uniform_params::key_mode::press)
+			value[0] = input.keys_pressed[params.keycode];
+		else
+			value[0] = input.keys_down[params.keycode];
+		break;
+	case special_uniform::mouse_wheel:
+		value[0] = std::min(std::max(value[0] + input.wheel_delta * params.step[0], params.min), params.max);
+		value[1] = input.wheel_delta;
+		break;
+	default:
+		break;
+	}
+}
+
+template <bool lookup>
+static double run_frames(const std::vector<uniform> &uniforms, size_t num_frames, std::vector<float> &values)
+{
+	values.assign(uniforms.size() * 2, 0.0f);
+
+	frame_input input = {};
+	input.frame_time = 0.016f;
+
+	reshade::test::timer timer;
+	for (size_t frame = 0; frame < num_frames; ++frame)
+	{
+		input.keys_down[0x20 + frame % 32] = (frame % 3) == 0;
+		input.keys_pressed[0x20 + frame % 32] = (frame % 7) == 0;
+		input.wheel_delta = (frame % 11) == 0 ? 1.0f : 0.0f;
+
+		for (size_t i = 0; i < uniforms.size(); ++i)
+		{
+			const uniform &variable = uniforms[i];
+
+			// Use a deterministic sequence instead of "std::rand", so that both runs compute the same values
+			const int random = static_cast<int>((frame * 7919 + i * 104729) % 32768);
+
+			if constexpr (lookup)
+				update_special_uniform(variable, lookup_special_params(variable), input, random, &values[i * 2]);
+			else
+				update_special_uniform(variable, variable.special_params, input, random, &values[i * 2]);
+		}
+	}
+	return timer.elapsed_ms();
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const size_t num_uniforms = quick ? 100 : 1000;
+	const size_t num_frames = quick ? 100 : 10000;
+
+	std::vector<uniform> uniforms;
+	for (size_t i = 0; i < num_uniforms; ++i)
+		uniforms.push_back(make_uniform(i));
+
+	// The parameters parsed at load time have to be the same as what looking them up every frame results in
+	size_t num_mismatches = 0;
+	for (const uniform &variable : uniforms)
+		if (variable.special == special_uniform::none || variable.special == special_uniform::unknown || !(variable.special_params == lookup_special_params(variable)))
+			num_mismatches++;
+	CHECK(num_mismatches == 0);
+
+	std::vector<float> lookup_values, parsed_values;
+	const double lookup_ms = run_frames<true>(uniforms, num_frames, lookup_values);
+	const double parsed_ms = run_frames<false>(uniforms, num_frames, parsed_values);
+
+	CHECK(lookup_values == parsed_values);
+
+	std::printf("%zu special uniforms over %zu frames: looking up annotations every frame %.1f ms (%.2f us per frame), parsed at load time %.1f ms (%.2f us per frame)\n",
+		num_uniforms, num_frames, lookup_ms, lookup_ms * 1000 / num_frames, parsed_ms, parsed_ms * 1000 / num_frames);
+
+	return reshade::test::finish();
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Loads PNG, JPEG and DDS images through the texture cache the runtime uses for texture sources, measuring decoding, loading from the cache and generating mipmaps on the CPU.
+// Usage: runtime_texture_cache_benchmark [--quick]
+
+#include "test_utils.hpp"
+#include "runtime_texture_cache.hpp"
+#include <fstream>
+#include <algorithm>
+#include <stb_image_write.h>
+
+static std::vector<uint8_t> generate_pixels(uint32_t width, uint32_t height)
+{
+	// Smooth gradients with some noise on top, so that the image neither compresses trivially nor is pure noise
+	std::vector<uint8_t> pixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+	uint32_t seed = 1;
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			seed = seed * 1664525 + 1013904223;
+			uint8_t *const pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+			pixel[0] = static_cast<uint8_t>(x * 255 / width);
+			pixel[1] = static_cast<uint8_t>(y * 255 / height);
+			pixel[2] = static_cast<uint8_t>((x ^ y) + (seed >> 29));
+			pixel[3] = 255;
+		}
+	}
+	return pixels;
+}
+
+static void append_to_vector(void *context, void *data, int size)
+{
+	const auto bytes = static_cast<const uint8_t *>(data);
+	static_cast<std::vector<uint8_t> *>(context)->insert(static_cast<std::vector<uint8_t> *>(context)->end(), bytes, bytes + size);
+}
+
+/// <summary>
+/// Encodes a BC1 (DXT1) compressed DDS file, which is what most texture sources in DDS format use.
+/// The blocks are made up from the four corners of every 4x4 block, which is good enough for benchmarking the decoder.
+/// </summary>
+static std::vector<uint8_t> encode_dds(const std::vector<uint8_t> &pixels, uint32_t width, uint32_t height)
+{
+	const auto to_565 = [](const uint8_t *pixel) {
+		return static_cast<uint16_t>(((pixel[0] >> 3) << 11) | ((pixel[1] >> 2) << 5) | (pixel[2] >> 3));
+	};
+
+	uint32_t header[32] = {};
+	header[0] = 0x20534444; // "DDS "
+	header[1] = 124; // dwSize
+	header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000; // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE
+	header[3] = height;
+	header[4] = width;
+	header[5] = ((width + 3) / 4) * ((height + 3) / 4) * 8;
+	header[19] = 32; // sPixelFormat.dwSize
+	header[20] = 0x4; // DDPF_FOURCC
+	header[21] = 0x31545844; // "DXT1"
+	header[27] = 0x1000; // DDSCAPS_TEXTURE
+
+	std::vector<uint8_t> data(reinterpret_cast<const uint8_t *>(header), reinterpret_cast<const uint8_t *>(header) + sizeof(header));
+
+	for (uint32_t y = 0; y < height; y += 4)
+	{
+		for (uint32_t x = 0; x < width; x += 4)
+		{
+			const uint8_t *const pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+			const uint16_t color0 = to_565(pixel);
+			const uint16_t color1 = to_565(pixel + (static_cast<size_t>(std::min(3u, height - 1 - y)) * width + std::min(3u, width - 1 - x)) * 4);
+
+			const uint8_t block[8] = {
+				static_cast<uint8_t>(color0), static_cast<uint8_t>(color0 >> 8),
+				static_cast<uint8_t>(color1), static_cast<uint8_t>(color1 >> 8),
+				0x50, 0xA5, 0xFA, 0xFF }; // Blend from the first to the second color across the block
+			data.insert(data.end(), block, block + 8);
+		}
+	}
+
+	return data;
+}
+
+static bool write_file(const std::filesystem::path &path, const std::vector<uint8_t> &data)
+{
+	std::ofstream file(path, std::ios::binary);
+	return !data.empty() && file.write(reinterpret_cast<const char *>(data.data()), data.size()).good();
+}
+
+int main(int argc, char *argv[])
+{
+	const bool quick = reshade::test::has_option(argc, argv, "--quick");
+	const uint32_t size = quick ? 256 : 2048;
+	const uint32_t levels = quick ? 9 : 12;
+	const size_t num_images = quick ? 2 : 8;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "reshade_texture_cache_benchmark";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	const std::vector<uint8_t> pixels = generate_pixels(size, size);
+
+	std::vector<uint8_t> png, jpg;
+	stbi_write_png_to_func(append_to_vector, &png, size, size, 4, pixels.data(), size * 4);
+	stbi_write_jpg_to_func(append_to_vector, &jpg, size, size, 4, pixels.data(), 90);
+	const std::vector<uint8_t> dds = encode_dds(pixels, size, size);
+
+	const struct { const char *name; const std::vector<uint8_t> &data; } formats[] = {
+		{ "png", png },
+		{ "jpg", jpg },
+		{ "dds", dds },
+	};
+
+	std::vector<uint8_t> mipmaps(reshade::mipmap_chain_size(size, size, levels));
+	std::vector<std::filesystem::path> all_paths;
+
+	for (const auto &format : formats)
+	{
+		// Keep going with the other formats if one could not be encoded
+		std::vector<std::filesystem::path> paths;
+		for (size_t i = 0; i < num_images; ++i)
+		{
+			std::filesystem::path path = directory / ("image" + std::to_string(i) + '.' + format.name);
+			if (write_file(path, format.data))
+				paths.push_back(std::move(path));
+		}
+
+		if (paths.empty())
+		{
+			std::printf("%s: could not be encoded, skipping\n", format.name);
+			continue;
+		}
+
+		reshade::texture_cache cache;
+
+		// The first load of every file decodes it, the second has to return the same image from the cache
+		std::vector<std::shared_ptr<const reshade::decoded_image>> images;
+		reshade::test::timer timer;
+		for (const std::filesystem::path &path : paths)
+			images.push_back(cache.load(path));
+		const double decode_ms = timer.elapsed_ms();
+
+		size_t num_cached = 0;
+		timer.reset();
+		for (size_t i = 0; i < paths.size(); ++i)
+			if (cache.load(paths[i]) == images[i])
+				num_cached++;
+		const double cached_ms = timer.elapsed_ms();
+
+		CHECK(num_cached == paths.size());
+
+		size_t num_decoded = 0;
+		for (const std::shared_ptr<const reshade::decoded_image> &image : images)
+			if (image != nullptr && image->width == size && image->height == size && image->pixels.size() == pixels.size())
+				num_decoded++;
+		CHECK(num_decoded == paths.size());
+
+		timer.reset();
+		for (const std::shared_ptr<const reshade::decoded_image> &image : images)
+			if (image != nullptr)
+				reshade::generate_mipmap_chain(image->pixels.data(), image->width, image->height, levels, mipmaps.data());
+		const double mipmap_ms = timer.elapsed_ms();
+
+		std::printf("%zu %ux%u %s images (%zu bytes each): decoding %.1f ms, from cache %.3f ms, generating %u mipmap levels %.1f ms\n",
+			paths.size(), size, size, format.name, format.data.size(), decode_ms, cached_ms, levels, mipmap_ms);
+
+		all_paths.insert(all_paths.end(), paths.begin(), paths.end());
+	}
+
+	CHECK(!all_paths.empty());
+
+	// A cache that only fits two images has to evict the least recently used ones, while the images that are still referenced stay alive
+	{
+		reshade::texture_cache cache(pixels.size() * 2);
+
+		std::vector<std::shared_ptr<const reshade::decoded_image>> images;
+		for (const std::filesystem::path &path : all_paths)
+		{
+			images.push_back(cache.load(path));
+			CHECK(cache.size() <= pixels.size() * 2);
+		}
+
+		size_t num_alive = 0;
+		for (const std::shared_ptr<const reshade::decoded_image> &image : images)
+			if (image != nullptr && image->pixels.size() == pixels.size())
+				num_alive++;
+		CHECK(num_alive == all_paths.size());
+
+		// The most recently loaded image is still cached, the first one was evicted and is decoded again
+		CHECK(cache.load(all_paths.back()) == images.back());
+		CHECK(all_paths.size() <= 2 || cache.load(all_paths.front()) != images.front());
+	}
+
+	std::filesystem::remove_all(directory);
+
+	return reshade::test::finish();
+}
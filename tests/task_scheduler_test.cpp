@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#include "test_utils.hpp"
+#include "task_scheduler.hpp"
+
+using namespace reshade;
+
+static void test_submit_and_wait_idle()
+{
+	std::atomic<size_t> count = 0;
+
+	task_scheduler scheduler(4);
+	for (size_t i = 0; i < 10000; ++i)
+		scheduler.submit([&count]() { count++; });
+	scheduler.wait_idle();
+
+	CHECK(count == 10000);
+	CHECK(scheduler.is_idle());
+}
+
+static void test_nested_submit()
+{
+	std::atomic<size_t> count = 0;
+
+	task_scheduler scheduler(4);
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		scheduler.submit([&scheduler, &count, i]() {
+			if (i % 10 == 0)
+				for (size_t k = 0; k < 5; ++k)
+					scheduler.submit([&count]() { count++; });
+			count++;
+		});
+	}
+	scheduler.wait_idle();
+
+	CHECK(count == 1000 + 100 * 5);
+	CHECK(scheduler.is_idle());
+}
+
+static void test_task_groups()
+{
+	std::atomic<size_t> outer_count = 0, inner_count = 0;
+
+	// Waiting on a group from within tasks must not dead-lock, even with a single worker
+	for (size_t num_threads : { 1, 3 })
+	{
+		task_scheduler scheduler(num_threads);
+		task_scheduler::task_group outer_group;
+
+		for (size_t i = 0; i < 64; ++i)
+		{
+			scheduler.submit(outer_group, [&]() {
+				task_scheduler::task_group inner_group;
+				for (size_t k = 0; k < 16; ++k)
+					scheduler.submit(inner_group, [&inner_count]() { inner_count++; });
+				scheduler.wait(inner_group);
+
+				outer_count++;
+			});
+		}
+		scheduler.wait(outer_group);
+		scheduler.wait_idle();
+	}
+
+	CHECK(outer_count == 2 * 64);
+	CHECK(inner_count == 2 * 64 * 16);
+}
+
+static void test_background_group()
+{
+	std::atomic<bool> release = false;
+	std::atomic<size_t> count = 0;
+
+	task_scheduler scheduler(2);
+	task_scheduler::task_group background_group(true);
+
+	// A background task that blocks must neither keep "wait_idle" from returning nor make the scheduler report being busy
+	scheduler.submit(background_group, [&release, &count]() {
+		while (!release)
+			std::this_thread::yield();
+		count++;
+	});
+	for (size_t i = 0; i < 100; ++i)
+		scheduler.submit([&count]() { count++; });
+	scheduler.wait_idle();
+
+	CHECK(scheduler.is_idle());
+	CHECK(count == 100);
+
+	release = true;
+	scheduler.wait(background_group);
+
+	CHECK(count == 101);
+}
+
+static void test_destructor_drains_queue()
+{
+	std::atomic<size_t> count = 0;
+
+	{
+		task_scheduler scheduler(2);
+		for (size_t i = 0; i < 1000; ++i)
+			scheduler.submit([&count]() { count++; });
+	}
+
+	CHECK(count == 1000);
+}
+
+static void test_repeated_bursts()
+{
+	// Workers pop tasks as soon as they are queued, so this catches queue counts that get out of sync with the actual queues (which would make "wait_idle" return early or workers spin)
+	task_scheduler scheduler(4);
+
+	for (size_t burst = 0; burst < 200; ++burst)
+	{
+		std::atomic<size_t> count = 0;
+		for (size_t i = 0; i < 50; ++i)
+			scheduler.submit([&count]() { count++; });
+		scheduler.wait_idle();
+
+		CHECK(count == 50);
+	}
+}
+
+int main()
+{
+	test_submit_and_wait_idle();
+	test_nested_submit();
+	test_task_groups();
+	test_background_group();
+	test_destructor_drains_queue();
+	test_repeated_bursts();
+
+	return reshade::test::finish();
+}
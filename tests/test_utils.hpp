@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace reshade::test
+{
+	inline int num_failures = 0;
+
+	/// <summary>
+	/// Measures wall time since construction (or the last call to <see cref="reset"/>).
+	/// </summary>
+	class timer
+	{
+	public:
+		timer() : _start(std::chrono::steady_clock::now()) {}
+
+		void reset() { _start = std::chrono::steady_clock::now(); }
+
+		double elapsed_ms() const { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count(); }
+
+	private:
+		std::chrono::steady_clock::time_point _start;
+	};
+
+	/// <summary>
+	/// Checks whether the specified option was passed on the command line.
+	/// Benchmarks are registered with CTest using "--quick", which makes them use small problem sizes so that they only check they still run.
+	/// </summary>
+	inline bool has_option(int argc, char *argv[], const char *name)
+	{
+		for (int i = 1; i < argc; ++i)
+			if (std::strcmp(argv[i], name) == 0)
+				return true;
+		return false;
+	}
+
+	/// <summary>
+	/// Reports the result of a test executable, to be returned from "main".
+	/// </summary>
+	inline int finish()
+	{
+		if (num_failures != 0)
+			std::fprintf(stderr, "%d check(s) failed\n", num_failures);
+		return num_failures != 0 ? 1 : 0;
+	}
+}
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+			++reshade::test::num_failures; \
+		} \
+	} while (0)
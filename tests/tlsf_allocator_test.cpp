@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2021 Patrick Mours
+ * SPDX-License-Identifier: BSD-3-Clause OR MIT
+ */
+
+// Replays a trace of allocations and frees against "tlsf_allocator" and checks it against a simple model of which indices are in use after every step.
+// Usage: tlsf_allocator_test [<trace file>]
+// A trace file has one event per line, either "a <id> <count>" to allocate a range of count indices or "f <id>" to free the range allocated with that id.
+// Without a trace file a synthetic one is generated, modeled after descriptor sets being allocated and freed in a descriptor heap.
+
+#include "test_utils.hpp"
+#include "tlsf_allocator.hpp"
+#include <random>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+struct trace_event
+{
+	bool allocate;
+	uint32_t id;
+	uint32_t count;
+};
+
+static std::vector<trace_event> load_trace(const char *path)
+{
+	std::vector<trace_event> trace;
+
+	std::ifstream file(path);
+	for (std::string type; file >> type;)
+	{
+		trace_event event = { type == "a", 0, 0 };
+		file >> event.id;
+		if (event.allocate)
+			file >> event.count;
+		trace.push_back(event);
+	}
+
+	return trace;
+}
+
+static std::vector<trace_event> generate_trace(size_t num_events)
+{
+	std::mt19937 rng(7);
+	std::vector<trace_event> trace;
+	std::vector<uint32_t> live;
+
+	for (uint32_t id = 0; trace.size() < num_events; ++id)
+	{
+		// Mostly small descriptor sets, some larger ones, with bursts of frees (like when an effect is unloaded)
+		if (live.empty() || rng() % 100 < 55)
+		{
+			const uint32_t count = (rng() % 10 == 0) ? (rng() % 255) + 1 : (rng() % 8) + 1;
+			trace.push_back({ true, id, count });
+			live.push_back(id);
+		}
+		else
+		{
+			for (uint32_t burst = (rng() % 50 == 0) ? 64 : 1; burst != 0 && !live.empty(); --burst)
+			{
+				const size_t index = rng() % live.size();
+				trace.push_back({ false, live[index], 0 });
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+	}
+
+	// Free everything at the end, after which all free ranges have to be merged back into one
+	for (const uint32_t id : live)
+		trace.push_back({ false, id, 0 });
+
+	return trace;
+}
+
+static uint32_t largest_free_run(const std::vector<bool> &used)
+{
+	uint32_t largest = 0;
+	for (uint32_t i = 0, run = 0; i < used.size(); ++i)
+		largest = std::max(largest, run = used[i] ? 0 : run + 1);
+	return largest;
+}
+
+static void replay(const std::vector<trace_event> &trace, uint32_t capacity)
+{
+	tlsf_allocator allocator(capacity);
+
+	std::vector<bool> used(capacity, false);
+	uint32_t used_count = 0;
+	std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> allocations;
+
+	size_t num_failed_allocations = 0, num_errors = 0;
+
+	for (size_t i = 0; i < trace.size(); ++i)
+	{
+		const trace_event &event = trace[i];
+
+		if (event.allocate)
+		{
+			uint32_t offset = 0;
+			if (!allocator.allocate(event.count, offset))
+			{
+				// Allocation may only fail if there really is no free range large enough
+				if (largest_free_run(used) >= event.count)
+					num_errors++;
+				num_failed_allocations++;
+				continue;
+			}
+
+			if (offset + event.count > capacity)
+			{
+				num_errors++;
+				continue;
+			}
+
+			for (uint32_t k = offset; k < offset + event.count; ++k)
+			{
+				if (used[k])
+					num_errors++; // Overlaps with another allocation
+				used[k] = true;
+			}
+
+			used_count += event.count;
+			allocations[event.id] = { offset, event.count };
+		}
+		else
+		{
+			const auto it = allocations.find(event.id);
+			if (it == allocations.end())
+				continue; // The allocation failed or the trace frees it twice
+
+			allocator.free(it->second.first, it->second.second);
+
+			for (uint32_t k = it->second.first; k < it->second.first + it->second.second; ++k)
+				used[k] = false;
+
+			used_count -= it->second.second;
+			allocations.erase(it);
+		}
+
+		if (allocator.free_size() != capacity - used_count)
+			num_errors++;
+
+		// Checking the largest free range walks the whole model, so only do so every now and then
+		if (i % 64 == 0 && allocator.largest_free_range() != largest_free_run(used))
+			num_errors++;
+	}
+
+	CHECK(num_errors == 0);
+
+	if (allocations.empty())
+	{
+		CHECK(allocator.free_size() == capacity);
+		CHECK(allocator.largest_free_range() == capacity);
+		CHECK(allocator.fragmentation() == 0.0f);
+	}
+
+	std::printf("Replayed %zu events on %u indices (%zu allocations failed because the allocator was full or too fragmented)\n", trace.size(), capacity, num_failed_allocations);
+}
+
+static void test_basic()
+{
+	tlsf_allocator allocator(100);
+
+	uint32_t a = 0, b = 0, c = 0;
+	CHECK(allocator.allocate(10, a) && allocator.allocate(20, b) && allocator.allocate(30, c));
+	CHECK(allocator.free_size() == 40);
+	CHECK(!allocator.allocate(41, a));
+	CHECK(!allocator.allocate(0, a));
+
+	// Freeing the middle range leaves two free ranges, which are merged once the one before is freed too
+	allocator.free(b, 20);
+	CHECK(allocator.largest_free_range() == 40);
+	CHECK(allocator.fragmentation() > 0.0f);
+	allocator.free(a, 10);
+	CHECK(allocator.largest_free_range() == 40);
+	allocator.free(c, 30);
+	CHECK(allocator.largest_free_range() == 100 && allocator.fragmentation() == 0.0f);
+
+	// Exactly filling the allocator has to work, which needs the fallback search in the size class of the request
+	CHECK(allocator.allocate(100, a) && a == 0 && allocator.free_size() == 0);
+}
+
+int main(int argc, char *argv[])
+{
+	test_basic();
+
+	if (argc > 1)
+	{
+		replay(load_trace(argv[1]), 2048);
+	}
+	else
+	{
+		// Replay on a small heap where allocations start failing, and on one large enough for all of them
+		const std::vector<trace_event> trace = generate_trace(100000);
+		replay(trace, 2048);
+		replay(trace, 1 << 16);
+	}
+
+	return reshade::test::finish();
+}
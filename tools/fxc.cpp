@@ -6,13 +6,18 @@
 #include "effect_parser.hpp"
 #include "effect_codegen.hpp"
 #include "effect_preprocessor.hpp"
+#include "task_scheduler.hpp"
 #include "version.h"
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 
 static void print_usage(const char *path)
 {
 	printf(R"(usage: %s [options] <filename>
+       %s [options] --batch <directory or manifest> --output-dir <directory>
 
 Options:
   -h, --help                Print this help.
@@ -36,30 +41,426 @@ Options:
   --vulkan-semantics        Generate GLSL/SPIR-V code under Vulkan semantics, instead of OpenGL semantics.
 
   -Zi                       Enable debug information.
-	)", path);
+
+Batch mode:
+  --batch <path>            Compile all effect files in a directory, or all permutations listed in a manifest file, to SPIR-V, GLSL and HLSL.
+                            A manifest contains one permutation per line: The effect file (relative to the manifest) followed by the
+                            '-D', '--width' and '--height' options to compile it with. Empty lines and lines starting with '#' are ignored.
+                            Options on a manifest line take precedence over those on the command line. In either place, a '-D' definition of
+                            'BUFFER_WIDTH' or 'BUFFER_HEIGHT' takes precedence over '--width' and '--height'.
+  --output-dir <path>       Directory to write the output files to. Every permutation produces '<name>.spv', '<name>.glsl' and '<name>.hlsl'.
+  --report <file>           Write a JSON report with per-stage timings and output sizes of every permutation to the given file.
+  -j <value>                Number of threads to compile with. Defaults to the number of hardware threads.
+	)", path, path);
 }
 
-int main(int argc, char *argv[])
+struct compile_options
 {
-	const char *filename = nullptr;
-	const char *preprocess = nullptr;
-	const char *errorfile = nullptr;
-	const char *objectfile = nullptr;
-	const char *buffer_width = "800";
-	const char *buffer_height = "600";
-	bool print_glsl = false;
-	bool print_hlsl = false;
 	bool debug_info = false;
 	bool invert_y_axis = false;
 	bool spec_constants = false;
 	bool vulkan_semantics = false;
 	unsigned int shader_model = 50;
+	std::string buffer_width = "800";
+	std::string buffer_height = "600";
+	std::vector<std::filesystem::path> include_paths;
+	std::vector<std::pair<std::string, std::string>> macros;
+};
 
-	reshadefx::parser parser;
+struct permutation
+{
+	std::filesystem::path path;
+	std::string name;
+	// Values of the '--width' and '--height' options on the manifest line, or empty to use those from the command line
+	std::string buffer_width;
+	std::string buffer_height;
+	std::vector<std::pair<std::string, std::string>> macros;
+};
+struct permutation_result
+{
+	struct output
+	{
+		bool success = false;
+		double parse_time = 0.0;
+		double codegen_time = 0.0;
+		size_t size = 0;
+		size_t num_instructions = 0; // Only counted for SPIR-V
+	};
+
+	bool success = false;
+	double preprocess_time = 0.0;
+	output outputs[3]; // SPIR-V, GLSL, HLSL
+	std::string errors;
+};
+
+static double elapsed_milliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static std::string escape_json(const std::string &s)
+{
+	std::string result;
+	result.reserve(s.size());
+
+	for (const char c : s)
+	{
+		switch (c)
+		{
+		case '"':
+			result += "\\\"";
+			break;
+		case '\\':
+			result += "\\\\";
+			break;
+		case '\n':
+			result += "\\n";
+			break;
+		case '\r':
+			result += "\\r";
+			break;
+		case '\t':
+			result += "\\t";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char code[7];
+				snprintf(code, sizeof(code), "\\u%04x", c);
+				result += code;
+			}
+			else
+			{
+				result += c;
+			}
+			break;
+		}
+	}
+
+	return result;
+}
+
+static bool parse_macro_argument(std::string macro, std::vector<std::pair<std::string, std::string>> &macros)
+{
+	if (const size_t value_offset = macro.find('='); value_offset != std::string::npos)
+		macros.emplace_back(macro.substr(0, value_offset), macro.substr(value_offset + 1));
+	else
+		macros.emplace_back(std::move(macro), "1");
+	return !macros.back().first.empty();
+}
+
+static bool read_manifest(const std::filesystem::path &manifest_path, std::vector<permutation> &permutations)
+{
+	std::ifstream manifest(manifest_path);
+	if (!manifest)
+	{
+		std::cout << "error: Failed to open manifest file " << manifest_path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	for (unsigned int line_number = 1; std::getline(manifest, line); ++line_number)
+	{
+		// Split line into arguments, allowing quotes around arguments that contain spaces
+		std::vector<std::string> args;
+		for (size_t offset = 0; offset < line.size();)
+		{
+			offset = line.find_first_not_of(" \t\r", offset);
+			if (offset == std::string::npos)
+				break;
+
+			if (line[offset] == '"')
+			{
+				const size_t end = line.find('"', offset + 1);
+				args.push_back(line.substr(offset + 1, end - (offset + 1)));
+				offset = (end != std::string::npos) ? end + 1 : line.size();
+			}
+			else
+			{
+				const size_t end = line.find_first_of(" \t\r", offset);
+				args.push_back(line.substr(offset, end - offset));
+				offset = end;
+			}
+		}
+
+		if (args.empty() || args[0][0] == '#')
+			continue;
+
+		permutation &permutation = permutations.emplace_back();
+		permutation.path = manifest_path.parent_path() / std::filesystem::u8path(args[0]);
+
+		for (size_t i = 1; i < args.size(); ++i)
+		{
+			if (i + 1 < args.size() && args[i] == "-D" && parse_macro_argument(args[i + 1], permutation.macros))
+				++i;
+			else if (i + 1 < args.size() && args[i] == "--width")
+				permutation.buffer_width = args[++i];
+			else if (i + 1 < args.size() && args[i] == "--height")
+				permutation.buffer_height = args[++i];
+			else
+			{
+				std::cout << manifest_path.u8string() << '(' << line_number << "): error: Invalid argument '" << args[i] << '\'' << std::endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static void compile_permutation(const permutation &permutation, const compile_options &options, const std::filesystem::path &output_dir, reshadefx::include_cache &include_cache, permutation_result &result)
+{
 	reshadefx::preprocessor pp;
+	pp.set_include_cache(&include_cache);
 	pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
 	pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
 
+	for (const std::filesystem::path &include_path : options.include_paths)
+		pp.add_include_path(include_path);
+
+	// Add the most specific definitions first, since 'add_macro_definition' keeps the first definition of a macro:
+	// The manifest line overrides the command line, and in either place '-D' overrides '--width' and '--height' (same as when compiling a single file)
+	for (const std::pair<std::string, std::string> &macro : permutation.macros)
+		pp.add_macro_definition(macro.first, macro.second);
+	if (!permutation.buffer_width.empty())
+		pp.add_macro_definition("BUFFER_WIDTH", permutation.buffer_width);
+	if (!permutation.buffer_height.empty())
+		pp.add_macro_definition("BUFFER_HEIGHT", permutation.buffer_height);
+
+	for (const std::pair<std::string, std::string> &macro : options.macros)
+		pp.add_macro_definition(macro.first, macro.second);
+
+	pp.add_macro_definition("BUFFER_WIDTH", options.buffer_width);
+	pp.add_macro_definition("BUFFER_HEIGHT", options.buffer_height);
+	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
+	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
+
+	const auto preprocess_start = std::chrono::high_resolution_clock::now();
+	const bool preprocess_success = pp.append_file(permutation.path);
+	result.preprocess_time = elapsed_milliseconds(preprocess_start);
+	result.errors = pp.errors();
+
+	if (!preprocess_success)
+		return;
+
+	result.success = true;
+
+	for (size_t i = 0; i < std::size(result.outputs); ++i)
+	{
+		permutation_result::output &output = result.outputs[i];
+
+		std::unique_ptr<reshadefx::codegen> backend;
+		switch (i)
+		{
+		case 0:
+			backend.reset(reshadefx::create_codegen_spirv(options.vulkan_semantics, options.debug_info, options.spec_constants, false, options.invert_y_axis));
+			break;
+		case 1:
+			backend.reset(reshadefx::create_codegen_glsl(options.vulkan_semantics, options.debug_info, options.spec_constants, options.invert_y_axis));
+			break;
+		case 2:
+			backend.reset(reshadefx::create_codegen_hlsl(options.shader_model, options.debug_info, options.spec_constants));
+			break;
+		}
+
+		reshadefx::parser parser;
+
+		const auto parse_start = std::chrono::high_resolution_clock::now();
+		output.success = parser.parse(pp.output(), backend.get());
+		output.parse_time = elapsed_milliseconds(parse_start);
+
+		// Errors are the same for all code generators, so only report them once
+		if (i == 0)
+			result.errors += parser.errors();
+
+		if (!output.success)
+		{
+			result.success = false;
+			continue;
+		}
+
+		reshadefx::module module;
+
+		const auto codegen_start = std::chrono::high_resolution_clock::now();
+		backend->write_result(module);
+		output.codegen_time = elapsed_milliseconds(codegen_start);
+
+		std::ofstream file(output_dir / std::filesystem::u8path(permutation.name + (i == 0 ? ".spv" : i == 1 ? ".glsl" : ".hlsl")), std::ios::binary);
+		if (i == 0)
+		{
+			output.size = module.spirv.size() * sizeof(uint32_t);
+			file.write(reinterpret_cast<const char *>(module.spirv.data()), output.size);
+
+			// Skip the header and then step over each instruction using the word count in its first word
+			for (size_t offset = 5; offset < module.spirv.size() && (module.spirv[offset] >> 16) != 0; offset += module.spirv[offset] >> 16)
+				output.num_instructions++;
+		}
+		else
+		{
+			output.size = module.hlsl.size();
+			file.write(module.hlsl.data(), output.size);
+		}
+
+		if (!file)
+		{
+			result.errors += "error: Failed to write output file for " + permutation.name + '\n';
+			output.success = result.success = false;
+		}
+	}
+}
+
+static int compile_batch(const std::filesystem::path &batch_path, const compile_options &options, const std::filesystem::path &output_dir, const char *reportfile, size_t num_threads)
+{
+	std::vector<permutation> permutations;
+
+	std::error_code ec;
+	if (std::filesystem::is_directory(batch_path, ec))
+	{
+		for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(batch_path, ec))
+		{
+			if (entry.is_regular_file(ec) && entry.path().extension() == ".fx")
+				permutations.emplace_back().path = entry.path();
+		}
+
+		// Directory iteration order is unspecified, so sort to get a reproducible output
+		std::sort(permutations.begin(), permutations.end(),
+			[](const permutation &lhs, const permutation &rhs) { return lhs.path < rhs.path; });
+	}
+	else if (!read_manifest(batch_path, permutations))
+	{
+		return 1;
+	}
+
+	if (permutations.empty())
+	{
+		std::cout << "error: No effect files found in " << batch_path << std::endl;
+		return 1;
+	}
+
+	// Name outputs after the effect file, numbering them in case there are multiple permutations of the same file
+	for (permutation &permutation : permutations)
+	{
+		const std::string stem = permutation.path.stem().u8string();
+
+		size_t index = 0, count = 0;
+		for (const struct permutation &other : permutations)
+		{
+			if (other.path == permutation.path)
+			{
+				if (&other < &permutation)
+					index++;
+				count++;
+			}
+		}
+
+		permutation.name = count > 1 ? stem + '.' + std::to_string(index) : stem;
+	}
+
+	if (!std::filesystem::create_directories(output_dir, ec) && ec)
+	{
+		std::cout << "error: Failed to create output directory " << output_dir << std::endl;
+		return 1;
+	}
+
+	std::vector<permutation_result> results(permutations.size());
+	reshadefx::include_cache include_cache;
+
+	const auto batch_start = std::chrono::high_resolution_clock::now();
+
+	{	reshade::task_scheduler scheduler(num_threads != 0 ? num_threads : std::max(std::thread::hardware_concurrency(), 1u));
+
+		for (size_t i = 0; i < permutations.size(); ++i)
+			scheduler.submit([&, i]() { compile_permutation(permutations[i], options, output_dir, include_cache, results[i]); });
+
+		scheduler.wait_idle();
+		num_threads = scheduler.num_threads();
+	}
+
+	const double batch_time = elapsed_milliseconds(batch_start);
+
+	size_t num_failed = 0;
+	for (size_t i = 0; i < permutations.size(); ++i)
+	{
+		if (!results[i].success)
+			num_failed++;
+		if (!results[i].errors.empty())
+			std::cout << results[i].errors;
+	}
+
+	std::cout << "Compiled " << (permutations.size() - num_failed) << " of " << permutations.size() << " permutations in " << static_cast<unsigned int>(batch_time) << " ms using " << num_threads << " threads." << std::endl;
+
+	if (reportfile != nullptr)
+	{
+		std::ofstream report(reportfile);
+
+		report << "{\n";
+		report << "  \"threads\": " << num_threads << ",\n";
+		report << "  \"total_time_ms\": " << batch_time << ",\n";
+		report << "  \"permutations\": [";
+
+		for (size_t i = 0; i < permutations.size(); ++i)
+		{
+			const permutation &permutation = permutations[i];
+			const permutation_result &result = results[i];
+
+			report << (i == 0 ? "\n" : ",\n") << "    {\n";
+			report << "      \"name\": \"" << escape_json(permutation.name) << "\",\n";
+			report << "      \"file\": \"" << escape_json(permutation.path.u8string()) << "\",\n";
+			report << "      \"defines\": {";
+			report << " \"BUFFER_WIDTH\": \"" << escape_json(permutation.buffer_width.empty() ? options.buffer_width : permutation.buffer_width) << "\", \"BUFFER_HEIGHT\": \"" << escape_json(permutation.buffer_height.empty() ? options.buffer_height : permutation.buffer_height) << '\"';
+			for (const std::pair<std::string, std::string> &macro : permutation.macros)
+				report << ", \"" << escape_json(macro.first) << "\": \"" << escape_json(macro.second) << '\"';
+			report << " },\n";
+			report << "      \"success\": " << (result.success ? "true" : "false") << ",\n";
+			report << "      \"preprocess_time_ms\": " << result.preprocess_time << ",\n";
+			report << "      \"outputs\": {";
+
+			for (size_t k = 0; k < std::size(result.outputs); ++k)
+			{
+				const permutation_result::output &output = result.outputs[k];
+
+				report << (k == 0 ? "\n" : ",\n");
+				report << "        \"" << (k == 0 ? "spirv" : k == 1 ? "glsl" : "hlsl") << "\": { ";
+				report << "\"success\": " << (output.success ? "true" : "false") << ", ";
+				report << "\"parse_time_ms\": " << output.parse_time << ", ";
+				report << "\"codegen_time_ms\": " << output.codegen_time << ", ";
+				report << "\"size\": " << output.size;
+				if (k == 0)
+					report << ", \"instructions\": " << output.num_instructions;
+				report << " }";
+			}
+
+			report << "\n      },\n";
+			report << "      \"errors\": \"" << escape_json(result.errors) << "\"\n";
+			report << "    }";
+		}
+
+		report << "\n  ]\n}\n";
+
+		if (!report)
+		{
+			std::cout << "error: Failed to write report file " << reportfile << std::endl;
+			return 1;
+		}
+	}
+
+	return num_failed != 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *filename = nullptr;
+	const char *preprocess = nullptr;
+	const char *errorfile = nullptr;
+	const char *objectfile = nullptr;
+	const char *batch_path = nullptr;
+	const char *output_dir = nullptr;
+	const char *reportfile = nullptr;
+	bool print_glsl = false;
+	bool print_hlsl = false;
+	size_t num_threads = 0;
+	compile_options options;
+
 	// Parse command-line arguments
 	for (int i = 1; i < argc; ++i)
 	{
@@ -78,31 +479,30 @@ int main(int argc, char *argv[])
 
 			if (0 == std::strcmp(arg, "-D"))
 			{
-				char *macro = argv[++i];
-				char *value = std::strchr(macro, '=');
-				if (value) *value++ = '\0';
-				pp.add_macro_definition(macro, value ? value : "1");
+				if (i + 1 < argc)
+					parse_macro_argument(argv[++i], options.macros);
 				continue;
 			}
 
 			if (0 == std::strcmp(arg, "-I"))
 			{
-				pp.add_include_path(argv[++i]);
+				if (i + 1 < argc)
+					options.include_paths.push_back(std::filesystem::u8path(argv[++i]));
 				continue;
 			}
 
 			if (0 == std::strcmp(arg, "-Zi"))
-				debug_info = true;
+				options.debug_info = true;
 			else if (0 == std::strcmp(arg, "--glsl"))
 				print_glsl = true;
 			else if (0 == std::strcmp(arg, "--hlsl"))
 				print_hlsl = true;
 			else if (0 == std::strcmp(arg, "--invert-y"))
-				invert_y_axis = true;
+				options.invert_y_axis = true;
 			else if (0 == std::strcmp(arg, "--spec-constants"))
-				spec_constants = true;
+				options.spec_constants = true;
 			else if (0 == std::strcmp(arg, "--vulkan-semantics"))
-				vulkan_semantics = true;
+				options.vulkan_semantics = true;
 
 			if (i + 1 >= argc)
 				continue;
@@ -113,11 +513,19 @@ int main(int argc, char *argv[])
 			else if (0 == std::strcmp(arg, "-Fo"))
 				objectfile = argv[++i];
 			else if (0 == std::strcmp(arg, "--shader-model"))
-				shader_model = std::strtol(argv[++i], nullptr, 10);
+				options.shader_model = std::strtol(argv[++i], nullptr, 10);
 			else if (0 == std::strcmp(arg, "--width"))
-				buffer_width = argv[++i];
+				options.buffer_width = argv[++i];
 			else if (0 == std::strcmp(arg, "--height"))
-				buffer_height = argv[++i];
+				options.buffer_height = argv[++i];
+			else if (0 == std::strcmp(arg, "--batch"))
+				batch_path = argv[++i];
+			else if (0 == std::strcmp(arg, "--output-dir"))
+				output_dir = argv[++i];
+			else if (0 == std::strcmp(arg, "--report"))
+				reportfile = argv[++i];
+			else if (0 == std::strcmp(arg, "-j"))
+				num_threads = std::strtoul(argv[++i], nullptr, 10);
 		}
 		else
 		{
@@ -131,14 +539,35 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (batch_path != nullptr)
+	{
+		if (filename != nullptr || output_dir == nullptr)
+		{
+			print_usage(argv[0]);
+			return 1;
+		}
+
+		return compile_batch(std::filesystem::u8path(batch_path), options, std::filesystem::u8path(output_dir), reportfile, num_threads);
+	}
+
 	if (filename == nullptr)
 	{
 		print_usage(argv[0]);
 		return 1;
 	}
 
-	pp.add_macro_definition("BUFFER_WIDTH", buffer_width);
-	pp.add_macro_definition("BUFFER_HEIGHT", buffer_height);
+	reshadefx::parser parser;
+	reshadefx::preprocessor pp;
+	pp.add_macro_definition("__RESHADE__", std::to_string(VERSION_MAJOR * 10000 + VERSION_MINOR * 100 + VERSION_REVISION));
+	pp.add_macro_definition("__RESHADE_PERFORMANCE_MODE__", "0");
+
+	for (const std::filesystem::path &include_path : options.include_paths)
+		pp.add_include_path(include_path);
+	for (const std::pair<std::string, std::string> &macro : options.macros)
+		pp.add_macro_definition(macro.first, macro.second);
+
+	pp.add_macro_definition("BUFFER_WIDTH", options.buffer_width);
+	pp.add_macro_definition("BUFFER_HEIGHT", options.buffer_height);
 	pp.add_macro_definition("BUFFER_RCP_WIDTH", "(1.0 / BUFFER_WIDTH)");
 	pp.add_macro_definition("BUFFER_RCP_HEIGHT", "(1.0 / BUFFER_HEIGHT)");
 
@@ -162,11 +591,11 @@ int main(int argc, char *argv[])
 
 	std::unique_ptr<reshadefx::codegen> backend;
 	if (print_glsl)
-		backend.reset(reshadefx::create_codegen_glsl(vulkan_semantics, debug_info, spec_constants, invert_y_axis));
+		backend.reset(reshadefx::create_codegen_glsl(options.vulkan_semantics, options.debug_info, options.spec_constants, options.invert_y_axis));
 	else if (print_hlsl)
-		backend.reset(reshadefx::create_codegen_hlsl(shader_model, debug_info, spec_constants));
+		backend.reset(reshadefx::create_codegen_hlsl(options.shader_model, options.debug_info, options.spec_constants));
 	else
-		backend.reset(reshadefx::create_codegen_spirv(vulkan_semantics, debug_info, spec_constants, invert_y_axis));
+		backend.reset(reshadefx::create_codegen_spirv(options.vulkan_semantics, options.debug_info, options.spec_constants, false, options.invert_y_axis));
 
 	if (!parser.parse(pp.output(), backend.get()))
 	{